@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include "bench_util.hpp"
+#include "telnet_server.hpp"
+#include "tokenizer.hpp"
+#include <sys/socket.h>
+#include <thread>
+
+using namespace dungeon_merc;
+using namespace dungeon_merc::bench;
+
+static void BM_IsValidDirection(benchmark::State& state) {
+    const std::vector<std::string> inputs = {"north", "S", "east", "w", "Up", "down", "look", "players"};
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(is_valid_direction(inputs[i++ % inputs.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IsValidDirection);
+
+static void BM_StringToDirection(benchmark::State& state) {
+    const std::vector<std::string> inputs = {"north", "S", "east", "w", "Up", "down"};
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(string_to_direction(inputs[i++ % inputs.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringToDirection);
+
+// Argument: number of words in the command line
+static void BM_Split(benchmark::State& state) {
+    std::string line = "tell";
+    for (int64_t i = 1; i < state.range(0); ++i) {
+        line += " word" + std::to_string(i);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(split(line, ' '));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Split)->Arg(1)->Arg(4)->Arg(16);
+
+// Same lines through the allocation-free tokenizer
+static void BM_Tokenize(benchmark::State& state) {
+    std::string line = "tell";
+    for (int64_t i = 1; i < state.range(0); ++i) {
+        line += " word" + std::to_string(i);
+    }
+
+    for (auto _ : state) {
+        Tokenizer tokenizer(line);
+        std::string_view token;
+        while (tokenizer.next(token)) {
+            benchmark::DoNotOptimize(token);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Tokenize)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_Trim(benchmark::State& state) {
+    const std::string line = "  \tlook at the rusted terminal \r\n";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(trim(line));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trim);
+
+static void BM_TrimView(benchmark::State& state) {
+    const std::string line = "  \tlook at the rusted terminal \r\n";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(trim_view(line));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrimView);
+
+// Argument: message length. The peer end of the socket pair is drained by
+// a background thread so the send buffer never fills.
+static void BM_TelnetSendMessage(benchmark::State& state) {
+    silence_logging();
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        state.SkipWithError("socketpair failed");
+        return;
+    }
+
+    std::thread drain([fd = fds[1]]() {
+        char buffer[65536];
+        while (recv(fd, buffer, sizeof(buffer), 0) > 0) {
+        }
+    });
+
+    {
+        TelnetConnection connection(fds[0], "bench");
+        connection.initialize();
+        // The connection is non-blocking, so wait for the drain thread instead of dropping messages
+        int flags = fcntl(fds[0], F_GETFL, 0);
+        fcntl(fds[0], F_SETFL, flags & ~O_NONBLOCK);
+
+        const std::string message(static_cast<size_t>(state.range(0)), 'x');
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(connection.send_message(message));
+        }
+        state.SetBytesProcessed(state.iterations() * (state.range(0) + 2));
+    }
+
+    ::shutdown(fds[1], SHUT_RDWR);
+    drain.join();
+    ::close(fds[1]);
+}
+BENCHMARK(BM_TelnetSendMessage)->Arg(2)->Arg(64)->Arg(1024);
+
+static void BM_HashPassword(benchmark::State& state) {
+    const std::string password = "delve-deep-get-paid";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TelnetServer::hash_password(password));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HashPassword);
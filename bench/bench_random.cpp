@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include "random.hpp"
+#include "item.hpp"
+#include <random>
+
+using namespace dungeon_merc;
+
+// Baseline: the mt19937 + uniform_int_distribution pair the generator replaced
+static void BM_Mt19937DieRoll(benchmark::State& state) {
+    std::mt19937 engine(42);
+    for (auto _ : state) {
+        std::uniform_int_distribution<int> dist(1, 20);
+        benchmark::DoNotOptimize(dist(engine));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mt19937DieRoll);
+
+static void BM_RandomDieRoll(benchmark::State& state) {
+    RandomGenerator rng(42);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rng.random_int(1, 20));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomDieRoll);
+
+static void BM_RandomThreadInstance(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(RandomGenerator::get_instance().random_int(1, 20));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomThreadInstance);
+
+static void BM_RandomFillInt(benchmark::State& state) {
+    RandomGenerator rng(42);
+    std::vector<int> rolls(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        rng.fill_int(rolls.data(), rolls.size(), 1, 100);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RandomFillInt)->Arg(1024);
+
+// Argument: entries in the table. An alias roll costs the same at any size.
+static void BM_LootTableRoll(benchmark::State& state) {
+    std::vector<LootEntry> entries;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        entries.push_back(LootEntry{static_cast<ItemId>(i + 1), static_cast<uint32_t>(1 + i % 37), 1, 1, 0});
+    }
+    LootTable table;
+    table.build(entries);
+    RandomGenerator rng(42);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.roll(rng).item);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LootTableRoll)->Arg(4)->Arg(64)->Arg(1024);
+
+// A cleared dungeon: 'drops' rolls of the built-in dungeon table shared out
+// over a party of four
+static void BM_LootDungeonClear(benchmark::State& state) {
+    ItemCatalog catalog;
+    const LootTable* table = catalog.find_loot_table("dungeon");
+    InventoryPool pool;
+    RandomGenerator rng(42);
+    for (auto _ : state) {
+        for (int64_t drop = 0; drop < state.range(0); ++drop) {
+            ItemStack stack = table->roll_stack(rng);
+            if (const ItemTemplate* item = catalog.get(stack.item)) {
+                pool.add(static_cast<uint32_t>(drop % 4), *item, stack.count, stack.mods);
+            }
+        }
+        for (uint32_t owner = 0; owner < 4; ++owner) {
+            pool.clear(owner);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LootDungeonClear)->Arg(200);
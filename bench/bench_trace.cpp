@@ -0,0 +1,30 @@
+#include <benchmark/benchmark.h>
+#include "trace.hpp"
+
+using namespace dungeon_merc;
+
+// Cost of a trace marker while recording is switched off
+static void BM_TraceScopeDisabled(benchmark::State& state) {
+    TraceRecorder::get_instance().stop();
+
+    for (auto _ : state) {
+        TRACE_SCOPE("bench.disabled");
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceScopeDisabled);
+
+static void BM_TraceScopeEnabled(benchmark::State& state) {
+    Logger::get_instance().set_min_level(LogLevel::ERROR);
+    TraceRecorder::get_instance().start();
+
+    for (auto _ : state) {
+        TRACE_SCOPE("bench.enabled");
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    TraceRecorder::get_instance().stop();
+}
+BENCHMARK(BM_TraceScopeEnabled);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common.hpp"
+#include "game_world.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dungeon_merc {
+namespace bench {
+
+// Room ids used by the synthetic benchmark area, well clear of the starting areas
+constexpr int BENCH_ROOM_ID = 1000;
+constexpr int BENCH_NEIGHBOR_ROOM_ID = 1001;
+
+// Player creation and movement log at INFO; keep that out of the timings
+inline void silence_logging() {
+    Logger::get_instance().set_min_level(LogLevel::ERROR);
+}
+
+// A pair of connected rooms with a description of the requested size and
+// a crowd of players standing in the first one
+struct BenchWorld {
+    std::shared_ptr<GameWorld> world;
+    std::shared_ptr<Room> room;
+    std::vector<PlayerId> players;
+};
+
+inline BenchWorld make_bench_world(size_t description_length, size_t player_count) {
+    silence_logging();
+
+    BenchWorld bench;
+    bench.world = std::make_shared<GameWorld>();
+
+    std::string description;
+    const std::string filler = "Rusted pipes drip onto cracked tiles. ";
+    while (description.size() < description_length) {
+        description += filler;
+    }
+    description.resize(description_length);
+
+    bench.room = std::make_shared<Room>(BENCH_ROOM_ID, "Benchmark Hall", description);
+    auto neighbor = std::make_shared<Room>(BENCH_NEIGHBOR_ROOM_ID, "Benchmark Annex", description);
+    bench.room->add_exit(Direction::NORTH, BENCH_NEIGHBOR_ROOM_ID);
+    bench.room->add_exit(Direction::EAST, 1);
+    neighbor->add_exit(Direction::SOUTH, BENCH_ROOM_ID);
+    bench.world->add_room(bench.room);
+    bench.world->add_room(neighbor);
+
+    for (size_t i = 0; i < player_count; ++i) {
+        bench.players.push_back(bench.world->create_player("Merc_" + std::to_string(i), CharacterClass::SCOUT,
+                                                           BENCH_ROOM_ID));
+    }
+
+    return bench;
+}
+
+} // namespace bench
+} // namespace dungeon_merc
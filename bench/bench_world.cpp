@@ -0,0 +1,205 @@
+#include <benchmark/benchmark.h>
+#include "bench_util.hpp"
+
+using namespace dungeon_merc;
+using namespace dungeon_merc::bench;
+
+// Arguments: {description length, players in the room}
+static void WorldArguments(benchmark::internal::Benchmark* b) {
+    for (int description : {256, 2048}) {
+        for (int players : {1, 16, 256}) {
+            b->Args({description, players});
+        }
+    }
+}
+
+static void BM_GameWorldMovePlayer(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+    auto mover = bench.players.front();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bench.world->move_player(mover, Direction::NORTH));
+        benchmark::DoNotOptimize(bench.world->move_player(mover, Direction::SOUTH));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_GameWorldMovePlayer)->Apply(WorldArguments);
+
+static void BM_GameWorldHandleMoveCommand(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+    auto mover = bench.players.front();
+
+    Arena& arena = tick_arena();
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.world->handle_move_command(mover, "north", out);
+        bench.world->handle_move_command(mover, "south", out);
+        benchmark::DoNotOptimize(out.view());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_GameWorldHandleMoveCommand)->Apply(WorldArguments);
+
+static void BM_GameWorldHandleLookCommand(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+    auto looker = bench.players.front();
+
+    Arena& arena = tick_arena();
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.world->handle_look_command(looker, out);
+        benchmark::DoNotOptimize(out.view());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GameWorldHandleLookCommand)->Apply(WorldArguments);
+
+// Same command once the room's text is in a published snapshot
+static void BM_GameWorldHandleLookSnapshot(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+    auto looker = bench.players.front();
+    bench.world->publish_snapshot();
+
+    Arena& arena = tick_arena();
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.world->handle_look_command(looker, out);
+        benchmark::DoNotOptimize(out.view());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GameWorldHandleLookSnapshot)->Apply(WorldArguments);
+
+// A tick in which one player moved: two rooms and one chunk are rebuilt
+static void BM_PublishSnapshot(benchmark::State& state) {
+    auto bench = make_bench_world(256, state.range(0));
+    auto mover = bench.players.front();
+    bench.world->publish_snapshot();
+    Direction step = Direction::NORTH;
+
+    for (auto _ : state) {
+        bench.world->move_player(mover, step);
+        step = step == Direction::NORTH ? Direction::SOUTH : Direction::NORTH;
+        bench.world->publish_snapshot();
+        tick_arena().reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishSnapshot)->Arg(16)->Arg(10000);
+
+// Readers on other threads rendering 'look' straight from the snapshot
+static void BM_SnapshotLookThreads(benchmark::State& state) {
+    // Shared by every thread and run, so it is built once
+    static BenchWorld bench = [] {
+        BenchWorld world = make_bench_world(2048, 256);
+        world.world->publish_snapshot();
+        return world;
+    }();
+    Arena arena;
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        if (auto snapshot = bench.world->read_snapshot()) {
+            snapshot->render_look(bench.players.front(), out);
+        }
+        benchmark::DoNotOptimize(out.view());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotLookThreads)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_RoomGetFullDescription(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+
+    for (auto _ : state) {
+        std::string description = bench.room->get_full_description(bench.world->get_players());
+        benchmark::DoNotOptimize(description);
+        state.counters["bytes"] = static_cast<double>(description.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RoomGetFullDescription)->Apply(WorldArguments);
+
+// Same rendering into the tick arena, as the command path does it
+static void BM_RoomRenderDescription(benchmark::State& state) {
+    auto bench = make_bench_world(state.range(0), state.range(1));
+    Arena& arena = tick_arena();
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.room->render_description(out, bench.world->get_players());
+        benchmark::DoNotOptimize(out.view());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RoomRenderDescription)->Apply(WorldArguments);
+
+// Argument: players online
+static void BM_FindPlayerByName(benchmark::State& state) {
+    auto bench = make_bench_world(256, state.range(0));
+    std::string target = "MERC_" + std::to_string(state.range(0) / 2);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bench.world->find_player_by_name(target));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindPlayerByName)->Arg(100)->Arg(10000);
+
+static void BM_WhoCommand(benchmark::State& state) {
+    auto bench = make_bench_world(256, state.range(0));
+    Arena arena;
+    WhoFilter filter;
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.world->handle_who_command(filter, out);
+        benchmark::DoNotOptimize(out.view().data());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WhoCommand)->Arg(100)->Arg(10000);
+
+// The hub's most frequent query. Argument: players online, all in the hub.
+static void BM_ContractsCommand(benchmark::State& state) {
+    auto bench = make_bench_world(256, state.range(0));
+    bench.world->get_contracts().refresh(std::chrono::steady_clock::now());
+    Arena arena;
+
+    for (auto _ : state) {
+        ArenaString out(arena);
+        bench.world->handle_contracts_command(bench.players[0], out);
+        benchmark::DoNotOptimize(out.view().data());
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ContractsCommand)->Arg(100)->Arg(10000);
+
+// Cost of walking into a region that is not resident, with the budget
+// forcing an eviction for every load. Argument: regions in the world.
+static void BM_RegionLoadEvict(benchmark::State& state) {
+    silence_logging();
+    GameWorld world;
+    int regions = static_cast<int>(state.range(0));
+    world.set_region_source(std::make_unique<WorldGenerator>(regions * WORLD_REGION_ROOMS));
+    PlayerId merc = world.create_player("Merc", CharacterClass::SCOUT, 1);
+    world.set_region_limits(world.get_resident_bytes(), std::chrono::seconds(3600));
+    int region = 0;
+
+    for (auto _ : state) {
+        region = region % regions + 1;
+        benchmark::DoNotOptimize(world.place_player(merc, region * WORLD_REGION_ROOMS));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegionLoadEvict)->Arg(16)->Arg(4096);
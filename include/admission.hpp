@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.hpp"
+#include <chrono>
+
+namespace dungeon_merc {
+
+// When to stop letting new players into the game
+struct AdmissionLimits {
+    size_t max_players = MAX_PLAYERS;
+    std::chrono::microseconds max_tick_time{50000};  // Smoothed tick duration
+    size_t max_output_bytes = 16 * 1024 * 1024;      // Output queued to clients that haven't taken it yet
+    size_t admits_per_tick = 16;                      // Spreads a login storm over several ticks
+    size_t max_queue = 1000;                          // Beyond this, clients are turned away
+    std::chrono::seconds notice_interval{5};          // How often queued clients hear their position
+};
+
+// Decides whether the server has room for one more player. Besides the
+// player count it watches the load signals the main loop reports each tick,
+// so a server that is already slow stops admitting before it hits the cap.
+class AdmissionController {
+public:
+    explicit AdmissionController(const AdmissionLimits& limits = AdmissionLimits()) : limits_(limits) {}
+
+    void set_limits(const AdmissionLimits& limits) { limits_ = limits; }
+    const AdmissionLimits& get_limits() const { return limits_; }
+
+    // Called once per tick with how long it took and how much output is
+    // still queued to clients across all connections
+    void record_tick(std::chrono::microseconds tick_time, size_t output_bytes);
+
+    bool has_capacity(size_t players) const;
+
+    // Short reason for the first limit that is hit, or null when there is room
+    const char* saturation_reason(size_t players) const;
+
+    std::chrono::microseconds get_tick_time() const {
+        return std::chrono::microseconds(static_cast<int64_t>(tick_time_us_));
+    }
+    size_t get_output_bytes() const { return output_bytes_; }
+
+private:
+    AdmissionLimits limits_;
+    double tick_time_us_ = 0.0;  // Exponentially weighted moving average
+    size_t output_bytes_ = 0;
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace dungeon_merc {
+
+constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+// Bump-pointer allocator for data that lives at most one tick. Allocating is
+// a pointer increment, nothing is freed individually, and reset() rewinds
+// everything at once. Chunks survive resets (and are merged into one on
+// reset), so once the arena has grown to a tick's working set it stops
+// calling malloc altogether.
+class Arena {
+public:
+    explicit Arena(size_t chunk_size = ARENA_CHUNK_SIZE);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 'align' is a power of two; the address is aligned, not just the offset
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t offset = align_offset(used_, align);
+        if (offset + size > capacity_) {
+            return allocate_slow(size, align);
+        }
+        used_ = offset + size;
+        return base_ + offset;
+    }
+
+    // Grow the newest allocation in place when it ends at the bump pointer
+    bool try_extend(void* ptr, size_t old_size, size_t new_size) {
+        char* p = static_cast<char*>(ptr);
+        if (p + old_size != base_ + used_ || p + new_size > base_ + capacity_) {
+            return false;
+        }
+        used_ = static_cast<size_t>(p - base_) + new_size;
+        return true;
+    }
+
+    // Copy text into the arena; the view stays valid until reset()
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        char* copy = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(copy, text.data(), text.size());
+        return std::string_view(copy, text.size());
+    }
+
+    // Release everything allocated since the last reset
+    void reset();
+
+    // Position to roll back to, for scratch work inside a longer-lived tick
+    struct Checkpoint {
+        size_t chunk_count;
+        size_t used;
+        size_t retired;
+    };
+    Checkpoint checkpoint() const { return Checkpoint{chunks_.size(), used_, retired_}; }
+    void rewind(const Checkpoint& checkpoint);
+
+    size_t bytes_used() const { return retired_ + used_; }
+    size_t bytes_reserved() const;
+    size_t high_water() const { return high_water_; }
+
+private:
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t chunk_size_;
+    std::vector<Chunk> chunks_;
+    char* base_;       // Current chunk
+    size_t capacity_;
+    size_t used_;
+    size_t retired_;   // Bytes handed out from earlier chunks this cycle
+    size_t high_water_;
+
+    // Offset from base_ at or after 'used' whose address is a multiple of 'align'
+    size_t align_offset(size_t used, size_t align) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(base_) + used;
+        return used + ((align - (address & (align - 1))) & (align - 1));
+    }
+
+    void* allocate_slow(size_t size, size_t align);
+    void add_chunk(size_t size);
+};
+
+// Arena for the current thread's tick. The main loop resets it once per
+// tick, so anything allocated here must not be kept past the tick.
+Arena& tick_arena();
+
+// Standard allocator over an arena, for containers that only live one tick
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : arena_(&tick_arena()) {}
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) noexcept {}
+
+    Arena* arena() const { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena(); }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    Arena* arena_;
+};
+
+// Lines of output for one tick
+using ArenaLines = std::vector<std::string_view, ArenaAllocator<std::string_view>>;
+
+// Append-only string built directly in an arena, used in place of
+// std::stringstream and operator+ chains on the command path
+class ArenaString {
+public:
+    explicit ArenaString(Arena& arena = tick_arena())
+        : arena_(&arena), data_(nullptr), size_(0), capacity_(0) {}
+
+    ArenaString& append(std::string_view text) {
+        reserve(size_ + text.size());
+        if (!text.empty()) {
+            std::memcpy(data_ + size_, text.data(), text.size());
+            size_ += text.size();
+        }
+        return *this;
+    }
+
+    ArenaString& append(char c) {
+        reserve(size_ + 1);
+        data_[size_++] = c;
+        return *this;
+    }
+
+    template<typename T>
+    ArenaString& append_number(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+    }
+
+    ArenaString& operator<<(std::string_view text) { return append(text); }
+    ArenaString& operator<<(char c) { return append(c); }
+
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> &&
+                                                     !std::is_same_v<T, char> &&
+                                                     !std::is_same_v<T, bool>>>
+    ArenaString& operator<<(T value) { return append_number(value); }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    void clear() { size_ = 0; }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+    std::string str() const { return std::string(data_, size_); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Arena& arena() const { return *arena_; }
+
+private:
+    Arena* arena_;
+    char* data_;
+    size_t size_;
+    size_t capacity_;
+
+    void grow(size_t min_capacity);
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "common.hpp"
+#include "arena.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dungeon_merc {
+
+class GameWorld;
+
+constexpr size_t CHAT_SCROLLBACK = 32;        // Messages kept per channel
+constexpr size_t CHAT_SHARDS = 16;            // Channel table shards, each with its own lock
+constexpr size_t CHAT_MAX_MESSAGE = 400;      // Longer messages are cut
+constexpr size_t CHAT_MAX_CHANNEL_NAME = 15;  // Fits std::string's inline buffer
+constexpr size_t CHAT_MAX_PLAYER_CHANNELS = 16;  // Channels one player can be on at once
+constexpr size_t CHAT_MAX_CHANNELS = 4096;       // Channels in existence at once
+constexpr const char* GLOBAL_CHANNEL = "global";  // Every player joins it; 'shout' posts here
+
+struct ChatMessage {
+    uint64_t seq = 0;
+    PlayerId sender;
+    std::string sender_name;
+    std::string text;
+};
+
+// Fixed-size ring of a channel's most recent messages. Slots are assigned
+// in place, so once the ring has wrapped posting reuses string capacity.
+class ChatScrollback {
+public:
+    const ChatMessage& push(PlayerId sender, std::string_view sender_name, std::string_view text);
+
+    uint64_t next_seq() const { return next_seq_; }
+    size_t size() const { return static_cast<size_t>(std::min<uint64_t>(next_seq_, CHAT_SCROLLBACK)); }
+
+    // Visit retained messages with seq >= from_seq, oldest first
+    template<typename Fn>
+    void for_each_since(uint64_t from_seq, Fn&& fn) const {
+        uint64_t first = next_seq_ > CHAT_SCROLLBACK ? next_seq_ - CHAT_SCROLLBACK : 0;
+        for (uint64_t seq = std::max(first, from_seq); seq < next_seq_; ++seq) {
+            fn(slots_[seq % CHAT_SCROLLBACK]);
+        }
+    }
+
+private:
+    std::array<ChatMessage, CHAT_SCROLLBACK> slots_;
+    uint64_t next_seq_ = 0;
+};
+
+// A named topic with its subscriber index. Subscribers are kept in a dense
+// vector for fan-out, with a position map for O(1) unsubscribe.
+class ChatChannel {
+public:
+    explicit ChatChannel(const std::string& name) : name_(name) {}
+
+    const std::string& get_name() const { return name_; }
+
+    bool subscribe(PlayerId player);
+    bool unsubscribe(PlayerId player);
+    bool is_subscribed(PlayerId player) const { return positions_.count(player) != 0; }
+    const std::vector<PlayerId>& get_subscribers() const { return subscribers_; }
+
+    ChatScrollback& get_scrollback() { return scrollback_; }
+    const ChatScrollback& get_scrollback() const { return scrollback_; }
+
+private:
+    std::string name_;
+    std::vector<PlayerId> subscribers_;
+    std::unordered_map<PlayerId, size_t> positions_;
+    ChatScrollback scrollback_;
+};
+
+// Receives one formatted line for one player during ChatHub::flush()
+using ChatDelivery = std::function<void(PlayerId, std::string_view)>;
+
+// Player communication: room 'say', private 'tell' and named channels.
+// Posting only records the message (a scrollback append and an entry in
+// its shard's pending list for channels); fan-out to subscribers happens in
+// flush() once per tick, so a sender never pays for the size of the
+// audience.
+//
+// Channels are public: anyone may join any name, so there are no private
+// guild or party channels. A channel is created by its first join and
+// dropped, scrollback and all, at the flush after its last member leaves.
+class ChatHub {
+public:
+    explicit ChatHub(const GameWorld& world) : world_(world) {}
+
+    ChatHub(const ChatHub&) = delete;
+    ChatHub& operator=(const ChatHub&) = delete;
+
+    // Channel names are case-insensitive, lowercase alphanumerics plus '-' and '_'
+    static bool is_valid_channel_name(std::string_view name);
+
+    // Membership. join() creates the channel on first use, and fails for
+    // members, players on CHAT_MAX_PLAYER_CHANNELS already, and new
+    // channels past CHAT_MAX_CHANNELS.
+    bool join(PlayerId player, std::string_view channel);
+    bool leave(PlayerId player, std::string_view channel);
+    bool is_member(PlayerId player, std::string_view channel) const;
+    std::vector<std::string> get_channels(PlayerId player) const;
+    // Join and leave until the player is on exactly 'channels', e.g. when
+    // restoring one saved by a hot reboot or zone handoff
+    void set_channels(PlayerId player, const std::vector<std::string>& channels);
+
+    // Forget a player entirely, e.g. on logout
+    void remove_player(PlayerId player);
+
+    // Queue messages for the next flush. post() fails for non-members.
+    bool post(PlayerId sender, std::string_view sender_name, std::string_view channel, std::string_view text);
+    void post_room(int room_id, PlayerId sender, std::string_view sender_name, std::string_view text);
+    void post_direct(PlayerId recipient, std::string_view sender_name, std::string_view text);
+
+    // Server-written line for everyone in a room but 'exclude', sent as is
+    void post_room_notice(int room_id, PlayerId exclude, std::string_view text);
+
+    // Recent channel messages as display lines, for catching up after join
+    void get_scrollback(std::string_view channel, ArenaLines& lines) const;
+
+    // Deliver everything queued since the last flush, then drop channels
+    // left empty. Lines are built in the tick arena and stay valid until it
+    // is reset.
+    void flush(const ChatDelivery& deliver);
+
+    size_t channel_count() const;
+
+private:
+    struct PendingPost {
+        ChatChannel* channel = nullptr;  // Empty channels are only dropped after posts are flushed
+        PlayerId sender;
+        std::string sender_name;
+        std::string text;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<ChatChannel>> channels;
+        // Channel messages not yet fanned out, in posting order. Kept apart
+        // from the scrollback ring so a burst longer than the ring still
+        // reaches everyone. Entries are reused between ticks, so only the
+        // first post_count are live.
+        std::vector<PendingPost> posts;
+        size_t post_count = 0;
+        std::vector<std::string> emptied;  // Channels whose last member left since the last flush
+    };
+
+    struct PendingLine {
+        int room_id = 0;          // Room messages only
+        PlayerId sender;          // Skipped during room fan-out
+        PlayerId recipient;       // Direct messages only
+        bool notice = false;      // Text is sent without a speaker
+        std::string sender_name;
+        std::string text;
+    };
+
+    const GameWorld& world_;
+    std::array<Shard, CHAT_SHARDS> shards_;  // Channels by hash of name
+    std::atomic<size_t> channel_total_{0};
+
+    mutable std::mutex members_mutex_;
+    std::unordered_map<PlayerId, std::vector<std::string>> memberships_;  // Player -> channel names
+
+    // Room and direct messages. Entries are reused between ticks, so only
+    // the first pending_count_ are live.
+    std::mutex pending_mutex_;
+    std::vector<PendingLine> pending_;
+    size_t pending_count_ = 0;
+
+    static size_t shard_index(std::string_view channel);
+    Shard& shard_for(std::string_view channel) { return shards_[shard_index(channel)]; }
+    const Shard& shard_for(std::string_view channel) const { return shards_[shard_index(channel)]; }
+    PendingLine& next_pending();
+    // With the shard locked, after a member left 'channel'
+    static void note_if_empty(Shard& shard, const ChatChannel& channel);
+};
+
+// Copy of text with control characters removed and length capped
+void sanitize_chat_text(std::string_view text, std::string& out);
+
+} // namespace dungeon_merc
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "common.hpp"
+#include "game_world.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "arena.hpp"
+#include "tokenizer.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace dungeon_merc {
+
+class TelnetConnection;
+
+// Everything a command handler can see and produce. The dispatcher never
+// touches a socket, so the same handlers run for telnet clients and offline tools.
+struct CommandContext {
+    PlayerId player;  // Invalid when no player is attached
+    TelnetConnection* connection = nullptr;  // Null when there is no live client
+    bool is_admin = false;
+
+    // Lines to send back, in order. They live in the tick arena and must be
+    // consumed before it is reset.
+    ArenaLines output;
+    bool disconnect = false;  // Close the connection after sending output
+
+    void reply(std::string_view line) { output.push_back(output.get_allocator().arena()->store(line)); }
+
+    // Builders already in the output arena are referenced without copying
+    void reply(const ArenaString& line) {
+        if (&line.arena() == output.get_allocator().arena()) {
+            output.push_back(line.view());
+        } else {
+            reply(line.view());
+        }
+    }
+};
+
+// Maps command words to handlers and times every call
+class CommandDispatcher {
+public:
+    using Handler = std::function<void(CommandContext&, std::string_view args)>;
+
+    explicit CommandDispatcher(std::shared_ptr<GameWorld> game_world = nullptr);
+
+    void set_game_world(std::shared_ptr<GameWorld> game_world) { game_world_ = game_world; }
+    std::shared_ptr<GameWorld> get_game_world() const { return game_world_; }
+
+    // Register a command. Commands with empty help text are hidden from 'help'.
+    // Aliases share the latency histogram of the command named by metric_name.
+    void register_command(const std::string& name, const std::string& help, Handler handler,
+                          bool admin_only = false, const std::string& metric_name = "");
+
+    // Run one line of player input. Returns false if the command was not recognized.
+    bool dispatch(CommandContext& ctx, std::string_view line);
+
+private:
+    struct Command {
+        std::string name;
+        std::string help;
+        Handler handler;
+        bool admin_only;
+        LatencyHistogram* latency;
+        const char* trace_name;
+    };
+
+    std::shared_ptr<GameWorld> game_world_;
+    std::vector<Command> commands_;
+    std::unordered_map<std::string, size_t> command_index_;  // Name -> commands_ slot
+
+    std::string lookup_key_;  // Reused for the lowercased verb so lookups do not allocate
+
+    Counter& commands_total_;
+    Counter& commands_unknown_;
+
+    void register_builtin_commands();
+    void register_chat_commands();
+    void handle_help(CommandContext& ctx);
+
+    // "5" or "3-10"
+    static bool parse_level_range(std::string_view text, int& min_level, int& max_level);
+
+    // Player behind a context, or null when there is no world or player
+    const Player* current_player(const CommandContext& ctx) const;
+};
+
+} // namespace dungeon_merc
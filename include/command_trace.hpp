@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstdio>
+#include <string>
+
+namespace dungeon_merc {
+
+// Compact binary log of everything players typed, for offline replay.
+//
+// A trace is one or more segments. Each segment starts with a fixed header
+// (magic, version, RNG seed, wall clock start) followed by records:
+//
+//   u8 type | varint connection id | varint microseconds since previous record | payload
+//
+//   CONNECT     varint name length, name bytes, u8 class, varint room id
+//   COMMAND     varint text length, text bytes
+//   DISCONNECT  (no payload)
+//
+// A hot reboot appends a new segment to the same file, so a trace can span
+// several server images without losing connections. The reader reports each
+// segment after the first as a SEGMENT record carrying the new seed.
+enum class TraceEventType : uint8_t {
+    CONNECT = 1,
+    COMMAND = 2,
+    DISCONNECT = 3,
+    SEGMENT = 4
+};
+
+struct TraceRecord {
+    TraceEventType type = TraceEventType::COMMAND;
+    uint64_t connection_id = 0;
+    uint64_t timestamp_us = 0;  // Since the start of the trace
+    std::string text;           // Command text, or player name for CONNECT
+    CharacterClass character_class = CharacterClass::SCOUT;
+    int room_id = 1;
+    uint64_t seed = 0;          // SEGMENT only
+};
+
+class CommandRecorder {
+public:
+    CommandRecorder() = default;
+    ~CommandRecorder();
+
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    // Starts a new segment. With append=true an existing trace is extended.
+    bool open(const std::string& path, uint64_t seed, bool append = false);
+    void close();
+    void flush();
+    bool is_open() const { return file_ != nullptr; }
+
+    void record_connect(uint64_t connection_id, const std::string& player_name,
+                        CharacterClass character_class, int room_id);
+    void record_command(uint64_t connection_id, std::string_view text);
+    void record_disconnect(uint64_t connection_id);
+
+private:
+    std::FILE* file_ = nullptr;
+    std::chrono::steady_clock::time_point last_record_;
+
+    void write_record_prefix(TraceEventType type, uint64_t connection_id);
+    void write_varint(uint64_t value);
+    void write_bytes(std::string_view bytes);
+};
+
+// What to record or log for a line a player typed. Admin logins keep only
+// the verb; the verb is found the way CommandDispatcher finds it, so padding
+// or tabs can't slip a password past the check.
+std::string_view redact_command(std::string_view line);
+
+class CommandTraceReader {
+public:
+    CommandTraceReader() = default;
+    ~CommandTraceReader();
+
+    CommandTraceReader(const CommandTraceReader&) = delete;
+    CommandTraceReader& operator=(const CommandTraceReader&) = delete;
+
+    bool open(const std::string& path);
+
+    // Seed from the first segment header
+    uint64_t get_seed() const { return seed_; }
+
+    // Returns false at the end of the trace or on a corrupt record
+    bool next(TraceRecord& record);
+
+private:
+    std::FILE* file_ = nullptr;
+    uint64_t seed_ = 0;
+    uint64_t first_start_unix_us_ = 0;
+    uint64_t clock_us_ = 0;
+    bool have_header_ = false;
+
+    bool read_header(uint64_t& seed);
+    bool read_varint(uint64_t& value);
+    bool read_bytes(std::string& bytes);
+};
+
+} // namespace dungeon_merc
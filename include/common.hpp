@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <chrono>
@@ -16,16 +17,31 @@
 #include <sstream>
 #include <algorithm>
 #include <random>
+#include <iomanip>
 #include <cstdint>
 #include <cassert>
+#include "random.hpp"
 
 namespace dungeon_merc {
 
 // Forward declarations
 class Player;
 
+// Generational handle to a player in the world's player table. A slot's
+// generation changes when its player is destroyed, so an old handle to a
+// reused slot is detected as stale instead of aliasing the new player.
+struct PlayerId {
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool is_valid() const { return index != INVALID_INDEX; }
+    bool operator==(const PlayerId& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const PlayerId& other) const { return !(*this == other); }
+};
+
 // Type definitions
-using PlayerId = uint32_t;
 using Timestamp = std::chrono::system_clock::time_point;
 
 // Constants
@@ -34,6 +50,7 @@ constexpr int MAX_PLAYERS = 100;
 constexpr int DEFAULT_HEALTH = 100;
 constexpr int MAX_USERNAME_LENGTH = 32;
 constexpr int MAX_PASSWORD_LENGTH = 128;
+constexpr const char* DEFAULT_COPYOVER_FILE = "dungeon_merc.copyover";
 
 // Enums
 enum class Direction {
@@ -44,6 +61,7 @@ enum class Direction {
     UP,
     DOWN
 };
+constexpr size_t DIRECTION_COUNT = 6;
 
 enum class CharacterClass {
     SCOUT,
@@ -62,7 +80,7 @@ enum class GameState {
 };
 
 // Utility functions
-inline std::string direction_to_string(Direction dir) {
+inline std::string_view direction_name(Direction dir) {
     switch (dir) {
         case Direction::NORTH: return "north";
         case Direction::SOUTH: return "south";
@@ -74,18 +92,36 @@ inline std::string direction_to_string(Direction dir) {
     }
 }
 
-inline Direction string_to_direction(const std::string& str) {
-    std::string lower = str;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+inline std::string direction_to_string(Direction dir) {
+    return std::string(direction_name(dir));
+}
 
-    if (lower == "north" || lower == "n") return Direction::NORTH;
-    if (lower == "south" || lower == "s") return Direction::SOUTH;
-    if (lower == "east" || lower == "e") return Direction::EAST;
-    if (lower == "west" || lower == "w") return Direction::WEST;
-    if (lower == "up" || lower == "u") return Direction::UP;
-    if (lower == "down" || lower == "d") return Direction::DOWN;
+// Case-insensitive match of a direction or its one-letter abbreviation
+inline bool parse_direction(std::string_view str, Direction& dir) {
+    char lower[5];
+    if (str.empty() || str.size() > sizeof(lower)) {
+        return false;
+    }
+    for (size_t i = 0; i < str.size(); ++i) {
+        lower[i] = static_cast<char>(::tolower(static_cast<unsigned char>(str[i])));
+    }
+    std::string_view word(lower, str.size());
+
+    if (word == "north" || word == "n") { dir = Direction::NORTH; return true; }
+    if (word == "south" || word == "s") { dir = Direction::SOUTH; return true; }
+    if (word == "east" || word == "e") { dir = Direction::EAST; return true; }
+    if (word == "west" || word == "w") { dir = Direction::WEST; return true; }
+    if (word == "up" || word == "u") { dir = Direction::UP; return true; }
+    if (word == "down" || word == "d") { dir = Direction::DOWN; return true; }
+    return false;
+}
 
-    throw std::invalid_argument("Invalid direction: " + str);
+inline Direction string_to_direction(std::string_view str) {
+    Direction dir;
+    if (!parse_direction(str, dir)) {
+        throw std::invalid_argument("Invalid direction: " + std::string(str));
+    }
+    return dir;
 }
 
 inline std::string class_to_string(CharacterClass cls) {
@@ -98,43 +134,6 @@ inline std::string class_to_string(CharacterClass cls) {
     }
 }
 
-// Random number generation
-class RandomGenerator {
-public:
-    static RandomGenerator& get_instance() {
-        static RandomGenerator instance;
-        return instance;
-    }
-
-    int random_int(int min, int max) {
-        std::uniform_int_distribution<int> dist(min, max);
-        return dist(engine_);
-    }
-
-    double random_double(double min, double max) {
-        std::uniform_real_distribution<double> dist(min, max);
-        return dist(engine_);
-    }
-
-    bool random_bool(double probability = 0.5) {
-        return random_double(0.0, 1.0) < probability;
-    }
-
-    template<typename Container>
-    typename Container::value_type random_choice(const Container& container) {
-        if (container.empty()) {
-            throw std::runtime_error("Cannot choose from empty container");
-        }
-        auto it = container.begin();
-        std::advance(it, random_int(0, container.size() - 1));
-        return *it;
-    }
-
-private:
-    RandomGenerator() : engine_(std::chrono::system_clock::now().time_since_epoch().count()) {}
-    std::mt19937 engine_;
-};
-
 // Logging
 enum class LogLevel {
     DEBUG,
@@ -150,7 +149,16 @@ public:
         return instance;
     }
 
+    // Messages below this level are dropped before they are formatted
+    void set_min_level(LogLevel level) { min_level_.store(level, std::memory_order_relaxed); }
+    LogLevel get_min_level() const { return min_level_.load(std::memory_order_relaxed); }
+    bool is_enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+
     void log(LogLevel level, const std::string& message) {
+        if (!is_enabled(level)) {
+            return;
+        }
+
         std::lock_guard<std::mutex> lock(mutex_);
 
         auto now = std::chrono::system_clock::now();
@@ -176,13 +184,21 @@ public:
 
 private:
     std::mutex mutex_;
+    std::atomic<LogLevel> min_level_{LogLevel::DEBUG};
 };
 
-// Macros for easy logging
-#define LOG_DEBUG(msg) dungeon_merc::Logger::get_instance().debug(msg)
-#define LOG_INFO(msg) dungeon_merc::Logger::get_instance().info(msg)
-#define LOG_WARNING(msg) dungeon_merc::Logger::get_instance().warning(msg)
-#define LOG_ERROR(msg) dungeon_merc::Logger::get_instance().error(msg)
+// Macros for easy logging. The level check comes first so disabled messages
+// never pay for building their strings.
+#define DM_LOG_AT(level, msg) \
+    do { \
+        if (dungeon_merc::Logger::get_instance().is_enabled(level)) { \
+            dungeon_merc::Logger::get_instance().log(level, msg); \
+        } \
+    } while (0)
+#define LOG_DEBUG(msg) DM_LOG_AT(dungeon_merc::LogLevel::DEBUG, msg)
+#define LOG_INFO(msg) DM_LOG_AT(dungeon_merc::LogLevel::INFO, msg)
+#define LOG_WARNING(msg) DM_LOG_AT(dungeon_merc::LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) DM_LOG_AT(dungeon_merc::LogLevel::ERROR, msg)
 
 // Exception classes
 class GameException : public std::runtime_error {
@@ -201,22 +217,41 @@ public:
 };
 
 // Utility functions
-inline std::string trim(const std::string& str) {
+// Non-copying trim for hot paths; the result points into the argument
+inline std::string_view trim_view(std::string_view str) {
     size_t start = str.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) return "";
+    if (start == std::string_view::npos) return std::string_view();
     size_t end = str.find_last_not_of(" \t\r\n");
     return str.substr(start, end - start + 1);
 }
 
+inline std::string trim(const std::string& str) {
+    return std::string(trim_view(str));
+}
+
+inline bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (::tolower(static_cast<unsigned char>(a[i])) != ::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+// Allocates the result; command parsing should use Tokenizer (tokenizer.hpp)
 inline std::vector<std::string> split(const std::string& str, char delimiter) {
     std::vector<std::string> tokens;
-    std::stringstream ss(str);
-    std::string token;
+    std::string_view rest(str);
 
-    while (std::getline(ss, token, delimiter)) {
+    while (!rest.empty()) {
+        size_t end = rest.find(delimiter);
+        std::string_view token = rest.substr(0, end);
         if (!token.empty()) {
-            tokens.push_back(trim(token));
+            tokens.emplace_back(trim_view(token));
         }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(end + 1);
     }
 
     return tokens;
@@ -234,16 +269,18 @@ inline std::string to_upper(const std::string& str) {
     return result;
 }
 
-inline bool is_valid_direction(const std::string& str) {
-    std::string lower = str;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-
-    return (lower == "north" || lower == "n" ||
-            lower == "south" || lower == "s" ||
-            lower == "east" || lower == "e" ||
-            lower == "west" || lower == "w" ||
-            lower == "up" || lower == "u" ||
-            lower == "down" || lower == "d");
+inline bool is_valid_direction(std::string_view str) {
+    Direction dir;
+    return parse_direction(str, dir);
 }
 
 } // namespace dungeon_merc
+
+namespace std {
+template<>
+struct hash<dungeon_merc::PlayerId> {
+    size_t operator()(const dungeon_merc::PlayerId& id) const noexcept {
+        return std::hash<uint64_t>()((static_cast<uint64_t>(id.generation) << 32) | id.index);
+    }
+};
+} // namespace std
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "common.hpp"
+#include "epoch.hpp"
+#include "metrics.hpp"
+#include "random.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dungeon_merc {
+
+constexpr size_t CONTRACT_BOARD_SIZE = 12;  // Offers on the board at once
+constexpr int CONTRACT_TIERS = 5;
+constexpr std::chrono::seconds CONTRACT_LIFETIME(600);        // Unclaimed offers rotate out after this
+constexpr std::chrono::seconds CONTRACT_REFRESH_INTERVAL(5);  // Generator wakes at least this often
+
+// Mission modifiers, as bits in Contract::get_modifiers(). Each raises the pay.
+constexpr uint32_t CONTRACT_MOD_ARMORED = 1 << 0;
+constexpr uint32_t CONTRACT_MOD_TIMED = 1 << 1;
+constexpr uint32_t CONTRACT_MOD_SILENT = 1 << 2;
+constexpr uint32_t CONTRACT_MOD_HAZARD = 1 << 3;
+constexpr size_t CONTRACT_MOD_COUNT = 4;
+
+// One offer. Everything but the claim flag is fixed when the generator
+// makes it, including the line the board shows for it.
+class Contract {
+public:
+    uint32_t get_id() const { return id_; }
+    int get_tier() const { return tier_; }
+    int get_min_level() const { return min_level_; }
+    uint32_t get_modifiers() const { return modifiers_; }
+    int get_credits() const { return credits_; }
+    int get_experience() const { return experience_; }
+    const std::string& get_title() const { return title_; }
+    const std::string& get_line() const { return line_; }
+
+    bool is_claimed() const { return claimed_.load(std::memory_order_acquire); }
+
+private:
+    friend class ContractBoard;
+
+    uint32_t id_ = 0;
+    int tier_ = 1;
+    int min_level_ = 1;
+    uint32_t modifiers_ = 0;
+    int credits_ = 0;
+    int experience_ = 0;
+    std::string title_;
+    std::string line_;
+    std::chrono::steady_clock::time_point expires_;
+    std::atomic<bool> claimed_{false};
+};
+
+// One version of the board, never changed once published. Offers are
+// sorted by id; shared with the versions before and after, so keeping an
+// offer costs the next version a pointer copy.
+struct ContractList {
+    uint64_t version = 0;
+    std::vector<std::shared_ptr<Contract>> offers;
+};
+
+enum class ContractClaim {
+    CLAIMED,
+    TAKEN,        // Someone else got there first
+    NOT_FOUND,    // Never offered, or already rotated out
+    UNDER_LEVEL,
+};
+
+// The hub's contract board. A generator thread keeps it stocked from seeded
+// mission templates and publishes each version through an EpochPtr, so
+// reading the board never locks and never renders anything: every offer's
+// line was built by the generator. Claims flip the offer's flag with a
+// compare-and-swap, so of two players racing for one contract exactly one
+// wins, and wake the generator to replace it.
+class ContractBoard {
+public:
+    ContractBoard();
+    ~ContractBoard();
+    ContractBoard(const ContractBoard&) = delete;
+    ContractBoard& operator=(const ContractBoard&) = delete;
+
+    // Run the generator on its own thread. Without it the board stays as
+    // the last refresh() left it.
+    void start(uint64_t seed);
+    void stop();
+    bool is_running() const { return generator_.joinable(); }
+
+    // Any thread. Empty until the first version is published.
+    EpochPtr<ContractList>::Reader read() const { return board_.read(); }
+
+    // Any thread. On success 'contract' is the claimed offer.
+    ContractClaim claim(uint32_t id, int level, std::shared_ptr<const Contract>& contract);
+
+    // Writer only: drop claimed and expired offers, top the board back up
+    // and publish if anything changed. The generator thread calls this;
+    // with no generator running, tests and tools may call it directly.
+    void refresh(std::chrono::steady_clock::time_point now);
+    void seed(uint64_t value) { rng_.seed(value); }
+
+private:
+    EpochPtr<ContractList> board_;
+    RandomGenerator rng_;  // Generator thread only
+    uint32_t next_id_ = 1;
+    uint64_t next_version_ = 1;
+
+    std::thread generator_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool wake_requested_ = false;
+
+    Counter& generated_;
+    Counter& claims_;
+    Counter& claim_conflicts_;
+    Gauge& version_gauge_;
+
+    void run();
+    std::shared_ptr<Contract> generate(std::chrono::steady_clock::time_point now);
+};
+
+const char* contract_modifier_name(size_t bit);
+
+} // namespace dungeon_merc
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common.hpp"
+#include "item.hpp"
+#include <string>
+#include <vector>
+
+namespace dungeon_merc {
+
+// State carried across a hot reboot for a single live connection
+struct CopyoverConnection {
+    uint64_t connection_id = 0;
+    int socket_fd = -1;
+    std::string client_ip;
+    std::string player_name;
+    CharacterClass character_class = CharacterClass::SCOUT;
+    int health = DEFAULT_HEALTH;
+    int max_health = DEFAULT_HEALTH;
+    int level = 1;
+    int experience = 0;
+    int room_id = 1;
+    std::vector<std::string> channels;  // Chat channels the player was on
+    bool gmcp = false;                   // Client negotiated GMCP
+    uint8_t gmcp_modules = 0;
+    std::vector<ItemStack> items;        // Pack contents, in slot order
+};
+
+// Everything the next server image needs to rebuild TelnetServer and GameWorld
+struct CopyoverState {
+    int server_socket = -1;
+    uint64_t next_connection_id = 1;
+    std::string admin_password_hash;  // Empty if no admin password is set
+    std::vector<CopyoverConnection> connections;
+};
+
+// Handoff file I/O. The file is line based so it can be inspected by hand
+// when a reboot goes wrong.
+bool write_copyover_file(const std::string& path, const CopyoverState& state);
+bool read_copyover_file(const std::string& path, CopyoverState& state);
+
+// Make sure a descriptor survives exec()
+bool clear_close_on_exec(int fd);
+
+} // namespace dungeon_merc
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "common.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dungeon_merc {
+
+constexpr size_t EPOCH_MAX_READERS = 64;  // Readers that can hold a pin at once
+
+// Epoch-based reclamation for data with one writer and many readers. A
+// reader pins the current epoch for as long as it holds a pointer; the
+// writer retires what it replaces and frees it only once every pinned epoch
+// is newer, so readers never take a lock or touch a shared refcount.
+class EpochDomain {
+public:
+    // Keeps the epoch pinned until destroyed
+    class Guard {
+    public:
+        Guard() = default;
+        Guard(Guard&& other) noexcept : domain_(other.domain_), slot_(other.slot_) { other.domain_ = nullptr; }
+        Guard& operator=(Guard&& other) noexcept;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() { release(); }
+
+        bool is_pinned() const { return domain_ != nullptr; }
+
+    private:
+        friend class EpochDomain;
+        Guard(EpochDomain* domain, size_t slot) : domain_(domain), slot_(slot) {}
+
+        EpochDomain* domain_ = nullptr;
+        size_t slot_ = 0;
+
+        void release();
+    };
+
+    EpochDomain() = default;
+    ~EpochDomain();
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // Any thread. Not pinned if all EPOCH_MAX_READERS slots are in use.
+    Guard pin();
+
+    // Writer only: free 'object' once no reader can still see it
+    template<typename T>
+    void retire(const T* object) {
+        retire(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Writer only: free what no reader can still see; returns how many
+    size_t reclaim();
+
+    size_t get_retired_count() const { return retired_.size(); }
+
+private:
+    // Each reader slot gets its own cache line so pins do not contend
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};  // 0 when free
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    std::atomic<uint64_t> epoch_{1};
+    Slot slots_[EPOCH_MAX_READERS];
+    std::vector<Retired> retired_;
+
+    void retire(void* object, void (*deleter)(void*));
+};
+
+// A pointer that readers load under an epoch pin while one writer replaces it
+template<typename T>
+class EpochPtr {
+public:
+    // The value as of read(); stays valid while the reader lives
+    class Reader {
+    public:
+        Reader() = default;
+
+        const T* get() const { return value_; }
+        const T* operator->() const { return value_; }
+        const T& operator*() const { return *value_; }
+        explicit operator bool() const { return value_ != nullptr; }
+
+    private:
+        friend class EpochPtr;
+        Reader(EpochDomain::Guard guard, const T* value) : guard_(std::move(guard)), value_(value) {}
+
+        EpochDomain::Guard guard_;
+        const T* value_ = nullptr;
+    };
+
+    EpochPtr() = default;
+    ~EpochPtr() { delete current_.load(std::memory_order_relaxed); }
+    EpochPtr(const EpochPtr&) = delete;
+    EpochPtr& operator=(const EpochPtr&) = delete;
+
+    // Any thread. Empty when nothing is published or no reader slot is free.
+    Reader read() const {
+        EpochDomain::Guard guard = domain_.pin();
+        if (!guard.is_pinned()) {
+            return Reader();
+        }
+        const T* value = current_.load(std::memory_order_seq_cst);
+        return value ? Reader(std::move(guard), value) : Reader();
+    }
+
+    // Writer only: make 'value' current and retire the old one
+    void publish(std::unique_ptr<const T> value) {
+        const T* old = current_.exchange(value.release(), std::memory_order_seq_cst);
+        if (old) {
+            domain_.retire(old);
+        }
+        domain_.reclaim();
+    }
+
+    // Writer only: the current value without pinning. Safe because only the
+    // writer ever frees anything.
+    const T* peek() const { return current_.load(std::memory_order_relaxed); }
+
+    size_t get_retired_count() const { return domain_.get_retired_count(); }
+
+private:
+    mutable EpochDomain domain_;
+    std::atomic<const T*> current_{nullptr};
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace dungeon_merc {
+
+using FloodClock = std::chrono::steady_clock;
+
+constexpr size_t INPUT_BUFFER_LIMIT = 4096;     // Unprocessed input held per connection; also the longest line
+constexpr size_t MAX_COMMANDS_PER_TICK = 1024;  // Across all connections, so a tick stays bounded
+
+// Per-connection input limits. A rate of zero disables that limit.
+struct FloodLimits {
+    double commands_per_second = 10.0;
+    double command_burst = 20.0;
+    double bytes_per_second = 4096.0;
+    double byte_burst = 8192.0;
+
+    // A client that stays throttled this long is disconnected
+    std::chrono::seconds abuse_grace{10};
+
+    static FloodLimits unlimited() {
+        FloodLimits limits;
+        limits.commands_per_second = 0.0;
+        limits.bytes_per_second = 0.0;
+        return limits;
+    }
+};
+
+// Classic token bucket: holds up to 'burst' tokens and refills at 'rate'
+// per second. A zero rate means unlimited.
+class TokenBucket {
+public:
+    TokenBucket() = default;
+    TokenBucket(double rate, double burst) { configure(rate, burst); }
+
+    void configure(double rate, double burst) {
+        rate_ = rate;
+        burst_ = burst;
+        tokens_ = burst;
+    }
+
+    bool unlimited() const { return rate_ <= 0.0; }
+
+    void refill(FloodClock::time_point now) {
+        if (last_refill_ != FloodClock::time_point{}) {
+            double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+            tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+        }
+        last_refill_ = now;
+    }
+
+    // Whole tokens that can be taken right now
+    size_t available(size_t cap) const {
+        return unlimited() ? cap : std::min(cap, static_cast<size_t>(std::max(0.0, tokens_)));
+    }
+
+    bool try_take(double count = 1.0) {
+        if (unlimited()) {
+            return true;
+        }
+        if (tokens_ < count) {
+            return false;
+        }
+        tokens_ -= count;
+        return true;
+    }
+
+private:
+    double rate_ = 0.0;
+    double burst_ = 0.0;
+    double tokens_ = 0.0;
+    FloodClock::time_point last_refill_{};
+};
+
+} // namespace dungeon_merc
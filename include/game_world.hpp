@@ -1,45 +1,205 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include <string>
 #include "room.hpp"
+#include "world_region.hpp"
 #include "player.hpp"
+#include "player_table.hpp"
+#include "player_directory.hpp"
+#include "leaderboard.hpp"
+#include "item.hpp"
+#include "contract_board.hpp"
+#include "chat.hpp"
+#include "triggers.hpp"
+#include "zone_map.hpp"
+#include "world_snapshot.hpp"
+#include "epoch.hpp"
+#include "arena.hpp"
 
 namespace dungeon_merc {
 
-class GameWorld {
+// Observes its own players to keep the directory and leaderboard current
+class GameWorld : private PlayerObserver {
 public:
     GameWorld();
-    ~GameWorld() = default;
+    ~GameWorld() override = default;
 
-    // Room management
+    // Room management. Rooms added here stay resident; rooms from the
+    // region source come and go with their region.
     void add_room(std::shared_ptr<Room> room);
     std::shared_ptr<Room> get_room(int room_id) const;
-    std::shared_ptr<Room> get_player_room(std::shared_ptr<Player> player) const;
+    std::shared_ptr<Room> get_player_room(PlayerId player) const;
 
-    // Player management
-    void add_player(std::shared_ptr<Player> player, int starting_room_id = 1);
-    void remove_player(std::shared_ptr<Player> player);
-    bool move_player(std::shared_ptr<Player> player, Direction direction);
+    // Lookups for the per-tick paths that skip shared_ptr refcounting. Only
+    // resident rooms are found; every occupied room is resident.
+    Room* find_room(int room_id) const;
+    Room* find_player_room(PlayerId player) const;
 
-    // Game commands
-    std::string handle_look_command(std::shared_ptr<Player> player);
-    std::string handle_move_command(std::shared_ptr<Player> player, const std::string& direction);
-    std::string handle_players_command(std::shared_ptr<Player> player);
+    // Where rooms come from, a region at a time, on first entry. The world
+    // starts with the built-in starting area. Replace the source before
+    // anyone joins: rooms loaded from the old one are dropped.
+    void set_region_source(std::unique_ptr<RegionSource> source);
+
+    // Regions nobody is in are evicted once idle for 'idle_timeout', and
+    // sooner, least recently used first, while resident rooms take more
+    // than 'budget_bytes' (0 for no budget). Occupied regions always stay.
+    void set_region_limits(size_t budget_bytes, std::chrono::seconds idle_timeout);
+
+    // Simulation thread, between ticks only: about once a second, and after
+    // every tick that left the world over budget. Rooms never go away
+    // while a command or trigger is running.
+    void evict_idle_regions(std::chrono::steady_clock::time_point now);
+    bool needs_region_eviction() const { return over_budget_; }  // A load went over budget since the last pass
+    size_t get_resident_regions() const { return resident_regions_; }
+    size_t get_resident_bytes() const { return resident_bytes_; }
+
+    // Player management. The world owns every player; everyone else holds
+    // PlayerId handles, which go stale once the player is removed.
+    PlayerId create_player(const std::string& name, CharacterClass character_class, int starting_room_id = 1);
+    void remove_player(PlayerId player);
+    bool move_player(PlayerId player, Direction direction);
+
+    // Put a player straight into a room, e.g. a scripted teleport. No triggers fire.
+    bool place_player(PlayerId player, int room_id);
+    Player* get_player(PlayerId player) { return players_.get(player); }
+    const Player* get_player(PlayerId player) const { return players_.get(player); }
+    const PlayerTable& get_players() const { return players_; }
+    PlayerTable& get_players() { return players_; }
+
+    // Case-insensitive lookup of an online player; invalid handle if not found
+    PlayerId find_player_by_name(std::string_view name) const { return directory_.find(name); }
+    const PlayerDirectory& get_directory() const { return directory_; }
+
+    // Everyone seen since the board was last loaded, online or not
+    Leaderboard& get_leaderboard() { return leaderboard_; }
+    const Leaderboard& get_leaderboard() const { return leaderboard_; }
+
+    // Item templates, loot tables and everyone's inventory
+    const ItemCatalog& get_items() const { return items_; }
+    InventoryPool& get_inventories() { return inventories_; }
+    const InventoryPool& get_inventories() const { return inventories_; }
+
+    // Roll a loot table once into a player's pack and say what they found.
+    // False if the player or table does not exist.
+    bool grant_loot(PlayerId player, std::string_view table, RandomGenerator& rng, ArenaString& out);
+
+    // Carry a pack across a hot reboot or zone handoff. Unknown items are dropped.
+    void copy_inventory(PlayerId player, std::vector<ItemStack>& items) const;
+    void restore_inventory(PlayerId player, const std::vector<ItemStack>& items);
+
+    // The hub's contract board; its generator is started by the server
+    ContractBoard& get_contracts() { return contracts_; }
+
+    // Player communication
+    ChatHub& get_chat() { return chat_; }
+
+    // Room triggers. Loading replaces the current set only if the whole file compiles.
+    bool load_triggers(const std::string& path, std::string& error);
+    TriggerRegistry& get_triggers() { return triggers_; }
+
+    // Run the player's room's triggers for a verb; true if one blocked the built-in command
+    bool run_command_triggers(PlayerId player, std::string_view verb, ArenaString& out);
+
+    // Fire timer triggers that are due
+    void run_timers(TriggerClock::time_point now);
+
+    // Multi-process mode: this world hosts only the rooms 'zone' owns. A
+    // player who walks or is teleported out of them is left in no room here
+    // and queued as a departure for the zone server to hand off.
+    void set_zone(const ZoneMap& map, int zone);
+    bool is_local_room(int room_id) const { return zone_ < 0 || zone_map_.zone_of(room_id) == zone_; }
+    void take_departures(std::vector<PlayerId>& departures);
+
+    // Show a player the room they just arrived in and fire its enter triggers
+    void handle_arrival(PlayerId player, ArenaString& out);
+
+    // Game commands. Responses are appended to a tick-arena string.
+    void handle_look_command(PlayerId player, ArenaString& out);
+    void handle_move_command(PlayerId player, std::string_view direction, ArenaString& out);
+    void handle_players_command(PlayerId player, ArenaString& out);
+    void handle_who_command(const WhoFilter& filter, ArenaString& out);
+    void handle_finger_command(std::string_view name, ArenaString& out);
+    void handle_status_command(PlayerId player, ArenaString& out);
+    void handle_rank_command(PlayerId player, std::string_view name, ArenaString& out);
+    void handle_top_command(size_t page, ArenaString& out);
+    void handle_inventory_command(PlayerId player, ArenaString& out);
+    void handle_contracts_command(PlayerId player, ArenaString& out);
+    void handle_claim_command(PlayerId player, uint32_t contract_id, ArenaString& out);
+    void handle_abandon_command(PlayerId player, ArenaString& out);
+
+    // Read-only view of the world for other threads, refreshed by
+    // publish_snapshot() once per tick. Drop readers promptly: a replaced
+    // snapshot is only freed once nobody still reads it.
+    EpochPtr<WorldSnapshot>::Reader read_snapshot() const { return snapshot_.read(); }
+
+    // Simulation thread, end of tick. Publishes nothing if nothing changed.
+    void publish_snapshot();
 
     // World initialization
     void initialize_world();
 
-    // Utility
+    // Utility. A room id is valid whether or not its region is resident;
+    // the room list shows resident rooms only.
     bool is_valid_room_id(int room_id) const;
     std::string get_room_list() const;
 
 private:
-    std::unordered_map<int, std::shared_ptr<Room>> rooms_;
-    std::unordered_map<std::shared_ptr<Player>, int> player_locations_; // Player -> Room ID
+    // One region's bookkeeping, kept after eviction so a reloaded room
+    // resumes its players version
+    struct Region {
+        bool resident = false;
+        size_t bytes = 0;
+        std::chrono::steady_clock::time_point last_active;
+        std::vector<std::pair<int, uint32_t>> rooms;  // Id, players version at eviction
+    };
+
+    std::unordered_map<int, std::shared_ptr<Room>> rooms_;  // Resident rooms only
+    std::unique_ptr<RegionSource> region_source_;
+    std::unordered_map<int, Region> regions_;
+    size_t region_budget_ = 0;
+    bool over_budget_ = false;
+    std::chrono::seconds region_idle_timeout_{300};
+    size_t resident_regions_ = 0;
+    size_t resident_bytes_ = 0;
+    PlayerTable players_;  // Each player's room is Player::get_current_room_id()
+    PlayerDirectory directory_;
+    Leaderboard leaderboard_;
+    ItemCatalog items_;
+    InventoryPool inventories_;  // Indexed by PlayerId::index
+    ContractBoard contracts_;
+    std::vector<std::shared_ptr<const Contract>> active_contracts_;  // Indexed by PlayerId::index
+    ChatHub chat_;
+    TriggerRegistry triggers_;
+    ZoneMap zone_map_;
+    int zone_ = -1;  // -1 when this process hosts the whole world
+    std::vector<PlayerId> departures_;
+    std::vector<const Room*> room_order_;  // Sorted by id, for snapshots
+    WorldSnapshotBuilder snapshot_builder_;
+    EpochPtr<WorldSnapshot> snapshot_;
+
+    // Snapshot text for a room if it is still current. The simulation
+    // thread's read commands use it to skip rendering.
+    const RoomView* current_room_view(const Room& room) const;
+
+    // Run one trigger for an optional acting player. Lines for the actor go to 'out'.
+    ScriptResult fire_trigger(const Trigger& trigger, PlayerId actor, ArenaString* out);
+    bool fire_room_triggers(TriggerEvent event, int room_id, PlayerId actor, std::string_view argument,
+                            ArenaString& out);
+
+    // Find a room, loading its region first if needed. Null for ids that do
+    // not exist and for rooms another zone server hosts.
+    Room* load_room(int room_id);
+    bool load_region(int region);
+    void evict_region(Region& entry);
+    bool is_region_occupied(const Region& entry) const;
+    void install_room(const std::shared_ptr<Room>& room);
+    void uninstall_room(int room_id);
 
-    void create_starting_areas();
+    void on_level_changed(const Player& player, int old_level) override;
+    void on_progress_changed(const Player& player) override;
 };
 
 } // namespace dungeon_merc
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "common.hpp"
+#include "arena.hpp"
+#include "player_table.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dungeon_merc {
+
+class Room;
+
+// Telnet command bytes (RFC 854) and the GMCP option number
+namespace telnet {
+constexpr uint8_t IAC = 255;
+constexpr uint8_t DONT = 254;
+constexpr uint8_t DO = 253;
+constexpr uint8_t WONT = 252;
+constexpr uint8_t WILL = 251;
+constexpr uint8_t SB = 250;
+constexpr uint8_t SE = 240;
+constexpr uint8_t GMCP = 201;
+} // namespace telnet
+
+// Longest subnegotiation kept; anything longer is dropped
+constexpr size_t TELNET_SUBNEGOTIATION_LIMIT = 8192;
+
+// Receives the telnet commands TelnetFilter takes out of the input
+class TelnetOptionHandler {
+public:
+    virtual ~TelnetOptionHandler() = default;
+    virtual void on_option(uint8_t command, uint8_t option) = 0;  // WILL, WONT, DO or DONT
+    virtual void on_subnegotiation(uint8_t option, std::string_view data) = 0;
+};
+
+// Strips telnet commands from received bytes in place, so line framing only
+// ever sees text. A command may be split across reads.
+class TelnetFilter {
+public:
+    // Returns how many bytes of text are left at the front of 'data'
+    size_t filter(char* data, size_t size, TelnetOptionHandler& handler);
+
+private:
+    enum class State : uint8_t {
+        DATA,
+        IAC,
+        OPTION,
+        SUBNEGOTIATION,
+        SUBNEGOTIATION_IAC,
+    };
+
+    State state_ = State::DATA;
+    uint8_t command_ = 0;
+    std::string subnegotiation_;
+};
+
+// GMCP modules a client can ask for with Core.Supports
+constexpr uint8_t GMCP_CHAR = 1 << 0;  // Char.Vitals
+constexpr uint8_t GMCP_ROOM = 1 << 1;  // Room.Info, Room.Players, Room.AddPlayer, Room.RemovePlayer
+constexpr uint8_t GMCP_ALL = GMCP_CHAR | GMCP_ROOM;
+
+// One connection's GMCP state: whether the client agreed to it, which
+// modules it wants and what it was last told, so each tick sends only what
+// changed since.
+class GmcpSession {
+public:
+    bool is_enabled() const { return enabled_; }
+    void set_enabled(bool enabled);
+    uint8_t get_modules() const { return modules_; }
+    void set_modules(uint8_t modules);
+
+    // A message from the client, "Package.Name [json]"
+    void handle_message(std::string_view message);
+
+    // Append a frame for each change since the last call. 'room' is the
+    // player's current room, if it exists.
+    bool collect(PlayerId self, const Player& player, const Room* room, const PlayerTable& players, ArenaString& out);
+
+    // Forget what was sent, so the next collect() reports everything
+    void reset();
+
+private:
+    struct SentPlayer {
+        PlayerId id;
+        std::string name;  // Kept for Room.RemovePlayer after the player is gone
+    };
+
+    bool enabled_ = false;
+    uint8_t modules_ = GMCP_ALL;
+    bool full_ = true;
+
+    int health_ = 0;
+    int max_health_ = 0;
+    int level_ = 0;
+    int experience_ = 0;
+    int room_id_ = -1;
+    uint32_t room_version_ = 0;
+    std::vector<SentPlayer> room_players_;  // Sorted by id; excludes the player itself
+    std::vector<SentPlayer> previous_players_;
+    std::vector<PlayerId> scratch_;
+
+    void collect_vitals(const Player& player, ArenaString& out);
+    void collect_room(PlayerId self, const Room& room, const PlayerTable& players, ArenaString& out);
+};
+
+// Frame one message as IAC SB GMCP <package> [json] IAC SE
+void append_gmcp(ArenaString& out, std::string_view package, std::string_view json);
+
+// Append 'text' as a quoted JSON string
+void append_json_string(ArenaString& out, std::string_view text);
+
+} // namespace dungeon_merc
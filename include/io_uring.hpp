@@ -0,0 +1,139 @@
+#pragma once
+
+#include "metrics.hpp"
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+namespace dungeon_merc {
+
+constexpr unsigned URING_ENTRIES = 4096;
+constexpr unsigned URING_BUFFER_COUNT = 1024;  // Receive buffers shared by every socket
+constexpr unsigned URING_BUFFER_SIZE = 2048;
+constexpr size_t URING_OUTPUT_LIMIT = 256 * 1024;  // Unsent output before writes start failing
+constexpr std::chrono::seconds URING_CLOSE_TIMEOUT(10);  // How long a released socket waits on a stuck send
+
+// Socket I/O through an io_uring, talking to the kernel with the raw
+// syscalls. One multishot accept covers the listening socket and one
+// multishot recv per connection fills buffers from a ring registered with
+// the kernel, so input arrives without any syscall per client. Output is
+// collected per socket during the tick and every send goes out in a
+// single io_uring_enter from submit().
+//
+// Sockets are named by connection id. read() and write() have the same
+// contract as TlsSession's: bytes, 0 for nothing ready, -1 once the peer
+// is gone. Single-threaded: the tick thread drives everything.
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Set up the rings and check the kernel has what we need (5.19+ for the
+    // buffer ring, 6.0+ for multishot recv). False, with the reason logged,
+    // if not.
+    bool initialize();
+
+    // New connections on 'listen_fd' are collected by poll()
+    void watch_listener(int listen_fd);
+    std::vector<int> take_accepted();
+
+    void attach(uint64_t id, int fd);
+    // Stop reading, send what is queued, and close the socket once the
+    // kernel is done with it. Whatever the client hasn't taken within
+    // URING_CLOSE_TIMEOUT is dropped.
+    void release(uint64_t id);
+
+    ssize_t read(uint64_t id, char* buffer, size_t length);
+    ssize_t write(uint64_t id, const struct iovec* iov, int count);
+
+    // Pick up completions; enters the kernel only when it asks us to
+    void poll();
+    // Start this tick's sends and re-arm receives in one io_uring_enter
+    void submit();
+    // Cancel accepts and receives and wait up to 'timeout' for output to
+    // drain, so every socket is idle before exec. poll() re-arms them.
+    void quiesce(std::chrono::milliseconds timeout);
+
+    size_t get_socket_count() const { return sockets_.size(); }
+    // Output accepted by write() that the kernel hasn't sent yet
+    size_t get_queued_bytes(uint64_t id) const;
+
+private:
+    struct Socket {
+        int fd = -1;
+        std::string input;     // Received, not yet read
+        std::string output;    // Written this tick, not yet submitted
+        std::string sending;   // Owned by the kernel until its send completes
+        size_t sent = 0;
+        bool receiving = false;
+        bool in_send = false;
+        bool eof = false;
+        bool released = false;
+        std::chrono::steady_clock::time_point released_at;
+    };
+
+    int ring_fd_;
+    bool ready_;
+
+    // Submission and completion rings, shared with the kernel
+    void* sq_map_;
+    size_t sq_map_size_;
+    void* cq_map_;
+    size_t cq_map_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_flags_;
+    unsigned sq_mask_;
+    unsigned* sq_array_;
+    io_uring_sqe* sqes_;
+    size_t sqes_size_;
+    unsigned sq_pending_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+
+    // Provided receive buffers
+    io_uring_buf* buffer_ring_;
+    std::vector<char> buffers_;
+    uint16_t buffer_tail_;
+
+    int listen_fd_;
+    bool accepting_;
+    std::vector<int> accepted_;
+    std::unordered_map<uint64_t, Socket> sockets_;
+    std::vector<uint64_t> pending_sends_;  // Sockets written to since the last submit()
+    std::vector<uint64_t> closing_;        // Released with a send still in flight
+
+    Counter& enters_;
+    Counter& completions_;
+    Counter& dropped_bytes_;
+
+    io_uring_sqe* get_sqe();
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+    void reap();
+    void handle(const io_uring_cqe& cqe);
+    void arm_accept();
+    void arm_recv(uint64_t id, Socket& socket);
+    void send_output(uint64_t id, Socket& socket);
+    void start_send(uint64_t id, Socket& socket);
+    void drop_output(uint64_t id, size_t bytes, const char* reason);
+    void expire_closing();
+    void cancel(uint64_t user_data);
+    void recycle_buffer(uint16_t buffer_id);
+    void close_if_idle(std::unordered_map<uint64_t, Socket>::iterator it);
+    bool probe_multishot_recv();
+    void teardown();
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "common.hpp"
+#include "random.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dungeon_merc {
+
+// Items are split flyweight style: what never changes (name, kind, stack
+// size) lives once in an ItemTemplate, and every item anyone carries is an
+// 8-byte ItemStack naming its template.
+
+using ItemId = uint16_t;
+constexpr ItemId NO_ITEM = 0;  // Empty slot; also a loot roll that drops nothing
+
+enum class ItemKind : uint8_t {
+    CREDITS,
+    AMMO,
+    MEDKIT,
+    WEAPON,
+    WEAPON_MOD,
+};
+
+// Mods fitted to a weapon instance, as bits in ItemStack::mods
+constexpr uint32_t ITEM_MOD_SCOPE = 1 << 0;
+constexpr uint32_t ITEM_MOD_SUPPRESSOR = 1 << 1;
+constexpr uint32_t ITEM_MOD_EXTENDED_MAG = 1 << 2;
+constexpr uint32_t ITEM_MOD_SMARTLINK = 1 << 3;
+constexpr size_t ITEM_MOD_COUNT = 4;
+
+const char* item_mod_name(size_t bit);
+
+struct ItemTemplate {
+    ItemId id = NO_ITEM;
+    std::string name;
+    ItemKind kind = ItemKind::CREDITS;
+    uint16_t max_stack = 1;
+    int value = 0;  // Credits
+};
+
+// One carried item or stack. Stacks merge only when template and mods match.
+struct ItemStack {
+    ItemId item = NO_ITEM;
+    uint16_t count = 0;
+    uint32_t mods = 0;
+};
+
+static_assert(std::is_trivially_copyable<ItemStack>::value, "ItemStack is copied around as plain bytes");
+static_assert(sizeof(ItemStack) == 8, "ItemStack should stay two words");
+
+struct LootEntry {
+    ItemId item = NO_ITEM;
+    uint32_t weight = 1;
+    uint16_t min_count = 1;
+    uint16_t max_count = 1;
+    uint32_t mods = 0;
+};
+
+// Weighted drop table sampled with Vose's alias method: one random number
+// picks a column and decides between the column's own entry and its alias,
+// so a roll costs the same however long the table is. Weights are kept as
+// integers, so the odds are exact rather than rounded through doubles.
+class LootTable {
+public:
+    // False (and the table left empty) if there are no entries, too many,
+    // or the weights add up to zero or more than 2^32 - 1
+    bool build(std::vector<LootEntry> entries);
+
+    bool empty() const { return entries_.empty(); }
+    const std::vector<LootEntry>& get_entries() const { return entries_; }
+
+    // Must not be called on an empty table
+    const LootEntry& roll(RandomGenerator& rng) const;
+
+    // Roll an entry and then its count. An empty stack means no drop.
+    ItemStack roll_stack(RandomGenerator& rng) const;
+
+private:
+    std::vector<LootEntry> entries_;
+    std::vector<uint64_t> keep_;     // Out of total_weight_: chance a column keeps its own entry
+    std::vector<uint32_t> alias_;    // Entry used otherwise
+    uint64_t total_weight_ = 0;
+};
+
+// Every item template and loot table the server knows. Built once at
+// startup and read-only afterwards. Template ids are assigned in order, so
+// the built-in set has the same ids in every server image.
+class ItemCatalog {
+public:
+    ItemCatalog();  // Built-in templates and loot tables
+
+    ItemId add_template(const std::string& name, ItemKind kind, uint16_t max_stack, int value);
+    const ItemTemplate* get(ItemId item) const {
+        return (item != NO_ITEM && item < templates_.size()) ? &templates_[item] : nullptr;
+    }
+    const ItemTemplate* find(std::string_view name) const;
+    size_t size() const { return templates_.size() - 1; }
+
+    // Entries must name known templates (or NO_ITEM)
+    bool add_loot_table(const std::string& name, std::vector<LootEntry> entries);
+    const LootTable* find_loot_table(std::string_view name) const;
+
+private:
+    std::vector<ItemTemplate> templates_;  // Indexed by id; [0] is NO_ITEM
+    std::vector<std::pair<std::string, LootTable>> loot_tables_;  // Few enough to scan without allocating a key
+
+    void add_builtin_items();
+};
+
+constexpr size_t INVENTORY_SLOTS = 16;
+
+// Inventories for every player, INVENTORY_SLOTS stacks each, back to back
+// in one array indexed by the owner's PlayerTable slot. An inventory costs
+// the same 128 bytes however full it is and never allocates once its slot
+// exists. Used stacks are kept at the front, in the order they were picked up.
+class InventoryPool {
+public:
+    // Adds up to 'count', topping up matching stacks before starting new
+    // ones. Returns how many fit.
+    uint16_t add(uint32_t owner, const ItemTemplate& item, uint16_t count, uint32_t mods = 0);
+
+    // Removes up to 'count' of an item, any mods; returns how many were taken
+    uint16_t take(uint32_t owner, ItemId item, uint16_t count);
+    uint32_t count_of(uint32_t owner, ItemId item) const;
+
+    // The owner's used stacks are [slots, slots + used)
+    const ItemStack* slots(uint32_t owner) const;
+    size_t used(uint32_t owner) const;
+
+    void clear(uint32_t owner);
+
+private:
+    std::vector<ItemStack> slots_;
+
+    ItemStack* slots_for(uint32_t owner);
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "common.hpp"
+#include "random.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dungeon_merc {
+
+constexpr size_t LEADERBOARD_PAGE_SIZE = 10;  // Lines shown by one 'top'
+
+// Every player the server has seen, ranked by level and then experience
+// (best first), with ties broken by name. An order-statistic treap keeps
+// each node's subtree size, so a progress update, rank-of-player and the
+// start of any page all cost O(log n); a page then costs O(page) more.
+//
+// Entries outlive logouts and are keyed case-insensitively by name. The
+// file written by save() is in rank order, so load() builds the tree in
+// one linear pass instead of re-sorting everyone at startup.
+class Leaderboard {
+public:
+    struct Entry {
+        std::string name;
+        int level = 1;
+        int experience = 0;
+    };
+
+    Leaderboard();
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Insert or move a player. Cheap when nothing changed.
+    void update(std::string_view name, int level, int experience);
+
+    // 1-based rank, or 0 if the name is unknown
+    size_t rank_of(std::string_view name) const;
+    const Entry* find(std::string_view name) const;
+
+    size_t size() const { return nodes_[root_].size; }
+
+    // Visit up to 'count' entries as (rank, entry), starting after 'offset'
+    template<typename Fn>
+    void for_each_page(size_t offset, size_t count, Fn&& fn) const {
+        size_t rank = 0;
+        visit(root_, offset, count, rank, fn);
+    }
+
+    // Set by update(), cleared by a successful save()
+    bool is_dirty() const { return dirty_; }
+
+    // Atomic replace via a temporary file, like the copyover file
+    bool save(const std::string& path);
+
+    // Replaces the current contents. A missing file is an empty board.
+    bool load(const std::string& path);
+
+private:
+    static constexpr uint32_t NIL = 0;  // nodes_[0]: empty subtree, size 0
+
+    struct Node {
+        Entry entry;
+        uint32_t left = NIL;
+        uint32_t right = NIL;
+        uint32_t size = 0;
+        uint32_t priority = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, uint32_t> by_name_;  // Lowercased name -> node
+    uint32_t root_ = NIL;
+    Xoshiro256StarStar priorities_;
+    bool dirty_ = false;
+    mutable std::string lookup_key_;  // Reused so lookups do not allocate
+
+    // True if 'a' ranks above 'b'
+    static bool ranks_above(const Entry& a, const Entry& b);
+
+    const std::string& key_for(std::string_view name) const;
+    uint32_t allocate(Entry entry);
+    void update_size(uint32_t node) {
+        nodes_[node].size = 1 + nodes_[nodes_[node].left].size + nodes_[nodes_[node].right].size;
+    }
+
+    // Treap primitives; each returns the new subtree root
+    void split(uint32_t node, const Entry& key, uint32_t& above, uint32_t& rest);
+    uint32_t merge(uint32_t above, uint32_t below);
+    uint32_t insert(uint32_t node, uint32_t item);
+    uint32_t erase(uint32_t node, const Entry& key);
+
+    // Rebuild from entries already in rank order in O(n)
+    void build_sorted(std::vector<Entry>& entries);
+    uint32_t fix_sizes(uint32_t node);
+
+    template<typename Fn>
+    void visit(uint32_t node, size_t& skip, size_t& remaining, size_t& rank, Fn& fn) const {
+        if (node == NIL || remaining == 0) {
+            return;
+        }
+        const Node& n = nodes_[node];
+        // Whole subtrees before the page are skipped by size
+        if (skip >= n.size) {
+            skip -= n.size;
+            rank += n.size;
+            return;
+        }
+        visit(n.left, skip, remaining, rank, fn);
+        if (remaining == 0) {
+            return;
+        }
+        ++rank;
+        if (skip > 0) {
+            --skip;
+        } else {
+            fn(rank, n.entry);
+            --remaining;
+        }
+        visit(n.right, skip, remaining, rank, fn);
+    }
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "common.hpp"
+#include <array>
+#include <map>
+
+namespace dungeon_merc {
+
+// Number of independent slots a counter is spread across. Each thread writes
+// to its own slot so hot counters never bounce a cache line between cores.
+constexpr size_t METRICS_COUNTER_SHARDS = 16;
+
+// Maximum number of metrics the shared-memory export has room for
+constexpr size_t METRICS_EXPORT_MAX_ENTRIES = 256;
+constexpr size_t METRICS_EXPORT_NAME_LENGTH = 48;
+
+// Slot index of the calling thread, assigned on first use
+size_t metrics_thread_shard();
+
+// Monotonic counter, sharded per thread
+class Counter {
+public:
+    void add(uint64_t amount = 1) {
+        shards_[metrics_thread_shard()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, METRICS_COUNTER_SHARDS> shards_;
+};
+
+// Point-in-time value such as a connection count
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t amount) { value_.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// HDR-style log-linear histogram. Every power of two is split into 16 linear
+// sub-buckets, so any recorded value is reported within ~6% of its true value
+// while the whole histogram stays a fixed ~5 KB array.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 40;  // ~18 minutes in nanoseconds
+    static constexpr int BUCKET_COUNT = SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 1);
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Value at the given percentile (0-100), rounded down to its bucket
+    uint64_t percentile(double pct) const;
+
+    void reset();
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_lower_bound(int index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Records the lifetime of a scope into a histogram, in nanoseconds
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        histogram_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Layout of the memory-mapped stats file. External tools map the file
+// read-only and use the sequence number as a seqlock: read it, copy the
+// entries, and retry if it was odd or changed in the meantime.
+enum class MetricType : uint32_t {
+    COUNTER = 1,
+    GAUGE = 2,
+    HISTOGRAM = 3
+};
+
+struct MetricsExportEntry {
+    char name[METRICS_EXPORT_NAME_LENGTH];
+    uint32_t type;
+    uint32_t reserved;
+    int64_t value;   // Counter or gauge value, histogram sum
+    uint64_t count;  // Histogram sample count
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+};
+
+struct MetricsExportHeader {
+    char magic[8];  // "DMSTATS"
+    uint32_t version;
+    uint32_t entry_count;
+    std::atomic<uint64_t> sequence;
+    uint64_t updated_unix_ns;
+};
+
+// Process-wide registry. Metrics are created once by name and the returned
+// references stay valid for the life of the process, so hot paths look them
+// up at construction time and never touch the registry again.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& get_instance() {
+        static MetricsRegistry instance;
+        return instance;
+    }
+
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    LatencyHistogram& histogram(const std::string& name);
+
+    // Shared-memory export
+    bool open_export(const std::string& path);
+    void publish();
+    void close_export();
+
+    // Human readable summary for the in-game stats command
+    std::vector<std::string> format_report() const;
+
+private:
+    MetricsRegistry() = default;
+    ~MetricsRegistry();
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms_;
+
+    MetricsExportHeader* export_header_ = nullptr;
+    size_t export_size_ = 0;
+};
+
+} // namespace dungeon_merc
@@ -7,7 +7,27 @@
 
 namespace dungeon_merc {
 
+class Player;
 
+// Notified of player changes that indexes elsewhere depend on
+class PlayerObserver {
+public:
+    virtual ~PlayerObserver() = default;
+    virtual void on_level_changed(const Player& player, int old_level) = 0;
+
+    // Level or experience moved; called once the player is consistent again
+    virtual void on_progress_changed(const Player& player) = 0;
+};
+
+// Dirty bits for state clients track out of band (GMCP). Set on every
+// change and cleared once the player's connection has reported it.
+constexpr uint8_t PLAYER_DIRTY_VITALS = 1 << 0;
+constexpr uint8_t PLAYER_DIRTY_ROOM = 1 << 1;
+constexpr uint8_t PLAYER_DIRTY_GMCP = PLAYER_DIRTY_VITALS | PLAYER_DIRTY_ROOM;
+
+// Set alongside either bit above and cleared by the world snapshot, which
+// is published independently of any connection
+constexpr uint8_t PLAYER_DIRTY_SNAPSHOT = 1 << 2;
 
 // Player class
 class Player {
@@ -16,6 +36,7 @@ public:
     ~Player() = default;
 
     // Basic properties
+    // Owned, not pooled: clients pick names, and the pool never frees anything
     const std::string& get_name() const { return name_; }
     CharacterClass get_character_class() const { return character_class_; }
     int get_health() const { return health_; }
@@ -32,7 +53,14 @@ public:
     void gain_experience(int amount);
     void level_up();
 
+    // Reapply saved progress (used when state is carried across a hot reboot)
+    void restore_progress(int level, int experience, int health, int max_health);
+
+    // At most one observer; it must outlive the player or be cleared first
+    void set_observer(PlayerObserver* observer) { observer_ = observer; }
 
+    uint8_t get_dirty() const { return dirty_; }
+    void clear_dirty(uint8_t bits) { dirty_ &= static_cast<uint8_t>(~bits); }
 
     // Game state
     GameState get_game_state() const { return game_state_; }
@@ -40,7 +68,10 @@ public:
 
     // Room management
     int get_current_room_id() const { return current_room_id_; }
-    void set_current_room_id(int room_id) { current_room_id_ = room_id; }
+    void set_current_room_id(int room_id) {
+        current_room_id_ = room_id;
+        mark_dirty(PLAYER_DIRTY_ROOM);
+    }
 
     // Timestamps
     Timestamp get_last_login() const { return last_login_; }
@@ -54,8 +85,8 @@ private:
     int level_;
     int experience_;
     int experience_to_next_level_;
-
-
+    PlayerObserver* observer_ = nullptr;
+    uint8_t dirty_ = PLAYER_DIRTY_GMCP | PLAYER_DIRTY_SNAPSHOT;
 
     GameState game_state_;
     int current_room_id_;
@@ -63,6 +94,7 @@ private:
 
     // Helper methods
     void calculate_experience_to_next_level();
+    void mark_dirty(uint8_t bits) { dirty_ |= bits | PLAYER_DIRTY_SNAPSHOT; }
 };
 
 } // namespace dungeon_merc
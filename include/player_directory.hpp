@@ -0,0 +1,119 @@
+#pragma once
+
+#include "common.hpp"
+#include "player.hpp"
+#include "tokenizer.hpp"
+#include <array>
+#include <limits>
+#include <set>
+#include <string_view>
+
+namespace dungeon_merc {
+
+constexpr size_t CHARACTER_CLASS_COUNT = 4;
+constexpr size_t WHO_PAGE_SIZE = 50;  // Lines shown by one 'who'
+
+// Optional restrictions for a who listing
+struct WhoFilter {
+    bool any_class = true;
+    CharacterClass character_class = CharacterClass::SCOUT;
+    int min_level = 1;
+    int max_level = std::numeric_limits<int>::max();
+};
+
+// Index of online players, kept up to date as players log in, log out and
+// level. Names are not copied: keys view the Player's own name, which is
+// stable until the player is removed. Lookups are case-insensitive.
+//
+// The who list is kept sorted by level (highest first) then name, overall
+// and per class, so a filtered page costs O(log n + page) rather than a
+// scan and sort of everyone online.
+class PlayerDirectory {
+public:
+    PlayerDirectory() = default;
+    PlayerDirectory(const PlayerDirectory&) = delete;
+    PlayerDirectory& operator=(const PlayerDirectory&) = delete;
+
+    // remove() before the player is destroyed
+    void add(PlayerId id, const Player& player);
+    void remove(PlayerId id, const Player& player);
+
+    // First online player with this name, ignoring case
+    PlayerId find(std::string_view name) const;
+
+    size_t size() const { return by_name_.size(); }
+
+    // Bumped whenever the who order changes: a login, logout or level
+    uint64_t get_version() const { return version_; }
+
+    // Visit players matching the filter in who order until fn returns false
+    template<typename Fn>
+    void for_each_who(const WhoFilter& filter, Fn&& fn) const {
+        const WhoSet& list = filter.any_class ? who_ : who_by_class_[class_slot(filter.character_class)];
+        for (auto it = list.lower_bound(WhoProbe{filter.max_level}); it != list.end(); ++it) {
+            if (it->level < filter.min_level || !fn(it->id, *it->player)) {
+                break;
+            }
+        }
+    }
+
+    // The world forwards this from its PlayerObserver
+    void on_level_changed(const Player& player, int old_level);
+
+private:
+    struct NameEntry {
+        std::string_view name;
+        const Player* player;  // Tie-break for players sharing a name
+        PlayerId id;
+    };
+
+    struct WhoEntry {
+        int level;
+        std::string_view name;
+        const Player* player;
+        PlayerId id;
+    };
+
+    // Heterogeneous keys: a bare name, or the first entry at a level
+    struct NameProbe { std::string_view name; };
+    struct WhoProbe { int level; };
+
+    struct NameLess {
+        using is_transparent = void;
+        bool operator()(const NameEntry& a, const NameEntry& b) const {
+            int cmp = icompare(a.name, b.name);
+            return cmp != 0 ? cmp < 0 : a.player < b.player;
+        }
+        bool operator()(const NameEntry& a, const NameProbe& b) const { return icompare(a.name, b.name) < 0; }
+        bool operator()(const NameProbe& a, const NameEntry& b) const { return icompare(a.name, b.name) < 0; }
+    };
+
+    struct WhoLess {
+        using is_transparent = void;
+        bool operator()(const WhoEntry& a, const WhoEntry& b) const {
+            if (a.level != b.level) {
+                return a.level > b.level;
+            }
+            int cmp = icompare(a.name, b.name);
+            return cmp != 0 ? cmp < 0 : a.player < b.player;
+        }
+        bool operator()(const WhoEntry& a, const WhoProbe& b) const { return a.level > b.level; }
+        bool operator()(const WhoProbe& a, const WhoEntry& b) const { return a.level > b.level; }
+    };
+
+    using WhoSet = std::set<WhoEntry, WhoLess>;
+
+    std::set<NameEntry, NameLess> by_name_;
+    WhoSet who_;
+    std::array<WhoSet, CHARACTER_CLASS_COUNT> who_by_class_;
+    uint64_t version_ = 0;
+
+    static size_t class_slot(CharacterClass cls) { return static_cast<size_t>(cls); }
+
+    PlayerId id_of(const Player& player) const;
+};
+
+// Case-insensitive class name or prefix, e.g. "en" for Enforcer
+bool parse_character_class(std::string_view text, CharacterClass& cls);
+
+} // namespace dungeon_merc
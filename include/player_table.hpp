@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common.hpp"
+#include "player.hpp"
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace dungeon_merc {
+
+// Owns every live Player, addressed by generational PlayerId handles.
+// Freed slots are recycled through a free list; each reuse bumps the slot's
+// generation so lookups through an old handle return null. Slots live in a
+// deque, so a Player* stays valid until that player is destroyed.
+class PlayerTable {
+public:
+    PlayerTable() = default;
+    PlayerTable(const PlayerTable&) = delete;
+    PlayerTable& operator=(const PlayerTable&) = delete;
+
+    PlayerId create(const std::string& name, CharacterClass character_class);
+
+    // Returns false if the handle was already stale
+    bool destroy(PlayerId id);
+
+    Player* get(PlayerId id) {
+        return contains(id) ? &*slots_[id.index].player : nullptr;
+    }
+
+    const Player* get(PlayerId id) const {
+        return contains(id) ? &*slots_[id.index].player : nullptr;
+    }
+
+    bool contains(PlayerId id) const {
+        return id.index < slots_.size() &&
+               slots_[id.index].generation == id.generation &&
+               slots_[id.index].player.has_value();
+    }
+
+    // Handle of whoever holds a slot, or an invalid handle if it is free
+    PlayerId id_at(uint32_t index) const {
+        return (index < slots_.size() && slots_[index].player) ? PlayerId{index, slots_[index].generation} : PlayerId{};
+    }
+
+    size_t size() const { return live_count_; }
+    size_t capacity() const { return slots_.size(); }
+
+    // Visit every live player as (PlayerId, Player&)
+    template<typename Fn>
+    void for_each(Fn&& fn) {
+        for (uint32_t index = 0; index < slots_.size(); ++index) {
+            Slot& slot = slots_[index];
+            if (slot.player) {
+                fn(PlayerId{index, slot.generation}, *slot.player);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (uint32_t index = 0; index < slots_.size(); ++index) {
+            const Slot& slot = slots_[index];
+            if (slot.player) {
+                fn(PlayerId{index, slot.generation}, *slot.player);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::optional<Player> player;
+        uint32_t generation = 1;
+    };
+
+    std::deque<Slot> slots_;
+    std::vector<uint32_t> free_slots_;
+    size_t live_count_ = 0;
+};
+
+} // namespace dungeon_merc
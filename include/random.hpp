@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace dungeon_merc {
+
+// SplitMix64 step, used to expand a single seed into generator state and to
+// derive independent stream seeds
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** by Blackman and Vigna: 32 bytes of state, a few cycles per
+// number, and a jump function for carving out non-overlapping streams.
+// Satisfies UniformRandomBitGenerator so it also works with <random>.
+class Xoshiro256StarStar {
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256StarStar(uint64_t seed_value = 0) { seed(seed_value); }
+
+    void seed(uint64_t seed_value) {
+        uint64_t sm = seed_value;
+        for (auto& word : state_) {
+            word = splitmix64(sm);
+        }
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+
+        return result;
+    }
+
+    // Advance by 2^128 steps; the skipped range can be handed to another stream
+    void jump() {
+        static const uint64_t JUMP[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+            0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (uint64_t word : JUMP) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (1ULL << bit)) {
+                    s0 ^= state_[0];
+                    s1 ^= state_[1];
+                    s2 ^= state_[2];
+                    s3 ^= state_[3];
+                }
+                (*this)();
+            }
+        }
+        state_[0] = s0;
+        state_[1] = s1;
+        state_[2] = s2;
+        state_[3] = s3;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+private:
+    uint64_t state_[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Random number generation. Each instance is a small independent stream.
+// get_instance() hands every thread its own instance, so no locking is needed.
+// A thread's instance follows the global seed only once the thread names its
+// stream (set_global_seed() does so for the calling thread); the rolls then
+// don't depend on which thread started first. Simulation code that must be
+// reproducible can also own an explicitly seeded generator (or a split() of one).
+//
+// Bounded integers use Lemire's multiply-shift method rather than
+// std::uniform_int_distribution, so a seed produces the same rolls on every
+// standard library.
+class RandomGenerator {
+public:
+    static RandomGenerator& get_instance() {
+        thread_local RandomGenerator instance(thread_seed());
+        return instance;
+    }
+
+    // Base seed for per-thread instances. The calling thread's instance is
+    // reseeded with the seed itself.
+    static void set_global_seed(uint64_t seed_value) {
+        global_seed().store(seed_value, std::memory_order_relaxed);
+        thread_stream() = MAIN_STREAM;
+        get_instance().seed(seed_value);
+    }
+
+    // Tie the calling thread's instance to stream 'stream' of the global
+    // seed. Use a fixed number per thread role, distinct from other
+    // stream_seed() users of the same seed.
+    static void set_thread_stream(uint64_t stream) {
+        thread_stream() = stream;
+        get_instance().seed(thread_seed());
+    }
+
+    // Seed for stream number 'stream' of a base seed, e.g. one per dungeon instance
+    static uint64_t stream_seed(uint64_t base_seed, uint64_t stream) {
+        uint64_t state = base_seed ^ (stream * 0xd1b54a32d192ed03ULL);
+        splitmix64(state);
+        return splitmix64(state);
+    }
+
+    explicit RandomGenerator(uint64_t seed_value = 0) : engine_(seed_value) {}
+
+    void seed(uint64_t value) { engine_.seed(value); }
+
+    // Independent child stream. The child takes the current sequence and this
+    // generator jumps 2^128 ahead, so the two never overlap.
+    RandomGenerator split() {
+        RandomGenerator child(*this);
+        engine_.jump();
+        return child;
+    }
+
+    uint64_t next_u64() { return engine_(); }
+
+    // Uniform in [0, range); range must not be zero
+    uint64_t random_below(uint64_t range) { return bounded(range); }
+
+    int random_int(int min, int max) {
+        if (max <= min) {
+            return min;
+        }
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+        return static_cast<int>(static_cast<int64_t>(min) + static_cast<int64_t>(bounded(range)));
+    }
+
+    double random_double(double min, double max) {
+        return min + unit_double() * (max - min);
+    }
+
+    bool random_bool(double probability = 0.5) {
+        return unit_double() < probability;
+    }
+
+    template<typename Container>
+    typename Container::value_type random_choice(const Container& container) {
+        if (container.empty()) {
+            throw std::runtime_error("Cannot choose from empty container");
+        }
+        auto it = container.begin();
+        std::advance(it, static_cast<std::ptrdiff_t>(bounded(static_cast<uint64_t>(container.size()))));
+        return *it;
+    }
+
+    // Bulk rolls for loot and spawn tables
+    void fill_int(int* out, size_t count, int min, int max) {
+        if (max <= min) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = min;
+            }
+            return;
+        }
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<int>(static_cast<int64_t>(min) + static_cast<int64_t>(bounded(range)));
+        }
+    }
+
+    void fill_double(double* out, size_t count, double min, double max) {
+        double span = max - min;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = min + unit_double() * span;
+        }
+    }
+
+    Xoshiro256StarStar& engine() { return engine_; }
+
+private:
+    Xoshiro256StarStar engine_;
+
+    // Uniform in [0, range) without modulo bias
+    uint64_t bounded(uint64_t range) {
+        __uint128_t product = static_cast<__uint128_t>(engine_()) * range;
+        uint64_t low = static_cast<uint64_t>(product);
+        if (low < range) {
+            uint64_t threshold = (0 - range) % range;
+            while (low < threshold) {
+                product = static_cast<__uint128_t>(engine_()) * range;
+                low = static_cast<uint64_t>(product);
+            }
+        }
+        return static_cast<uint64_t>(product >> 64);
+    }
+
+    // Uniform in [0, 1) with 53 bits of precision
+    double unit_double() {
+        return static_cast<double>(engine_() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static std::atomic<uint64_t>& global_seed() {
+        static std::atomic<uint64_t> seed_value(
+            static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()));
+        return seed_value;
+    }
+
+    static constexpr uint64_t MAIN_STREAM = ~0ULL;     // The thread that set the global seed
+    static constexpr uint64_t UNNAMED_STREAM = ~0ULL - 1;
+
+    static uint64_t& thread_stream() {
+        thread_local uint64_t stream = UNNAMED_STREAM;
+        return stream;
+    }
+
+    static uint64_t thread_seed() {
+        uint64_t base = global_seed().load(std::memory_order_relaxed);
+        uint64_t stream = thread_stream();
+        if (stream == MAIN_STREAM) {
+            return base;
+        }
+        if (stream == UNNAMED_STREAM) {
+            // Distinct per thread, but not reproducible
+            return stream_seed(base ^ static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())),
+                               stream);
+        }
+        return stream_seed(base, stream);
+    }
+};
+
+} // namespace dungeon_merc
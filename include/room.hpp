@@ -1,21 +1,83 @@
 #pragma once
 
+#include <array>
+#include <iterator>
 #include <string>
-#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 #include "player.hpp"
+#include "player_table.hpp"
+#include "arena.hpp"
+#include "string_pool.hpp"
 
 namespace dungeon_merc {
 
+constexpr int NO_EXIT = -1;
+
+// A room's exits as (direction, room id) pairs in direction order,
+// skipping directions that lead nowhere
+class RoomExits {
+public:
+    using Targets = std::array<int32_t, DIRECTION_COUNT>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<Direction, int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        iterator(const Targets& targets, size_t index) : targets_(&targets), index_(index) { settle(); }
+
+        reference operator*() const { return current_; }
+        pointer operator->() const { return &current_; }
+        iterator& operator++() {
+            ++index_;
+            settle();
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const Targets* targets_;
+        size_t index_;
+        value_type current_{Direction::NORTH, NO_EXIT};
+
+        void settle() {
+            while (index_ < DIRECTION_COUNT && (*targets_)[index_] == NO_EXIT) {
+                ++index_;
+            }
+            if (index_ < DIRECTION_COUNT) {
+                current_ = {static_cast<Direction>(index_), (*targets_)[index_]};
+            }
+        }
+    };
+
+    explicit RoomExits(const Targets& targets) : targets_(targets) {}
+    iterator begin() const { return iterator(targets_, 0); }
+    iterator end() const { return iterator(targets_, DIRECTION_COUNT); }
+    bool empty() const { return begin() == end(); }
+
+private:
+    const Targets& targets_;
+};
+
+// Text lives in the string pool, so a room is a few ids, its exits and its
+// occupants: generated rooms that share names and descriptions share them.
 class Room {
 public:
-    Room(int id, const std::string& name, const std::string& description);
+    Room(int id, std::string_view name, std::string_view description);
+    Room(int id, StringId name, StringId description);
 
     // Getters
     int get_id() const { return id_; }
-    const std::string& get_name() const { return name_; }
-    const std::string& get_description() const { return description_; }
+    const std::string& get_name() const { return StringPool::get_instance().get(name_); }
+    std::string get_description() const { return StringPool::get_instance().copy(description_); }
+    StringId get_name_id() const { return name_; }
+    StringId get_description_id() const { return description_; }
 
     // Exit management
     void add_exit(Direction dir, int target_room_id);
@@ -23,22 +85,43 @@ public:
     int get_exit_room_id(Direction dir) const;
     std::string get_exit_description(Direction dir) const;
     std::vector<std::string> get_available_exits() const;
+    RoomExits get_exits() const { return RoomExits(exits_); }
 
-    // Player management
-    void add_player(std::shared_ptr<Player> player);
-    void remove_player(std::shared_ptr<Player> player);
-    const std::vector<std::shared_ptr<Player>>& get_players() const { return players_; }
+    // Player management. The room only lists handles; GameWorld owns the players.
+    void add_player(PlayerId player);
+    void remove_player(PlayerId player);
+    const std::vector<PlayerId>& get_players() const { return players_; }
 
-    // Room display
-    std::string get_full_description() const;
+    // Bumped whenever someone enters or leaves. Many connections watch the
+    // same room, so each remembers the last version it reported instead of
+    // sharing a dirty bit.
+    uint32_t get_players_version() const { return players_version_; }
+
+    // A room reloaded after eviction carries on from the version it was
+    // evicted at, so nobody mistakes it for one they have already seen
+    void resume_players_version(uint32_t version) { players_version_ = version; }
+
+    // Rough footprint, for the world's memory budget. Text is shared
+    // through the string pool and not counted.
+    size_t get_memory_usage() const;
+
+    // Room display. Player names are resolved through the world's table.
+    std::string get_full_description(const PlayerTable& players) const;
     std::string get_exits_list() const;
 
+    // Allocation-free forms used on the command path
+    void render_description(ArenaString& out, const PlayerTable& players) const;
+    void render_occupants(ArenaString& out, const PlayerTable& players) const;
+    void append_exits(ArenaString& out) const;
+
 private:
+    // Ordered to pack into 64 bytes
     int id_;
-    std::string name_;
-    std::string description_;
-    std::map<Direction, int> exits_;  // Direction -> target room ID
-    std::vector<std::shared_ptr<Player>> players_;
+    StringId name_;
+    StringId description_;
+    uint32_t players_version_ = 0;
+    RoomExits::Targets exits_;  // Indexed by Direction; NO_EXIT where there is none
+    std::vector<PlayerId> players_;
 };
 
 } // namespace dungeon_merc
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dungeon_merc {
+
+// Trigger scripts are compiled once into bytecode for a small register
+// machine. The language itself is described in docs/TRIGGERS.md.
+
+constexpr size_t SCRIPT_REGISTERS = 32;
+constexpr uint32_t DEFAULT_SCRIPT_BUDGET = 1000;  // Instructions per run
+constexpr size_t SCRIPT_MAX_NESTING = 64;         // Parentheses, unary operators and blocks
+
+enum class ScriptOp : uint8_t {
+    HALT,
+    LOADK,     // R[a] = K[bx]
+    MOVE,      // R[a] = R[b]
+    ADD, SUB, MUL, DIV, MOD,
+    EQ, NE, LT, LE,
+    AND, OR,   // R[a] = R[b] && R[c], R[b] || R[c]
+    NOT,       // R[a] = !R[b]
+    NEG,       // R[a] = -R[b]
+    GET,       // R[a] = value of builtin bx
+    RANDOM,    // R[a] = random integer in [R[b], R[c]]
+    JMP,       // pc = bx
+    JMPF,      // if R[a] == 0, pc = bx
+    SEND,      // Tell the acting player string bx
+    ECHO,      // Tell everyone else in the room string bx
+    HEAL,      // Actor gains R[a] health
+    DAMAGE,    // Actor loses R[a] health
+    XP,        // Actor gains R[a] experience
+    TELEPORT,  // Actor moves to room R[a]
+    LOOT,      // Actor rolls the loot table named by string bx
+    BLOCK,     // Cancel the action that fired the trigger
+};
+
+// Values scripts can read
+enum class ScriptBuiltin : uint16_t {
+    LEVEL,
+    HEALTH,
+    MAX_HEALTH,
+    XP,
+    ROOM,
+    PLAYERS,  // Players in the trigger's room
+    CLASS,
+};
+
+struct ScriptInstruction {
+    ScriptOp op;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+
+    uint16_t bx() const { return static_cast<uint16_t>((b << 8) | c); }
+};
+
+struct CompiledScript {
+    std::vector<ScriptInstruction> code;
+    std::vector<int32_t> constants;
+    std::vector<std::string> strings;
+};
+
+// Compile a trigger body. On failure 'error' names the offending line,
+// counted from 'first_line'.
+bool compile_script(std::string_view source, int first_line, CompiledScript& script, std::string& error);
+
+// What a running script can see and do. Implemented by the game world for
+// the player (if any) and room that fired the trigger.
+class ScriptHost {
+public:
+    virtual ~ScriptHost() = default;
+    virtual int32_t get(ScriptBuiltin builtin) = 0;
+    virtual void send(std::string_view text) = 0;
+    virtual void echo(std::string_view text) = 0;
+    virtual void heal(int32_t amount) = 0;
+    virtual void damage(int32_t amount) = 0;
+    virtual void add_experience(int32_t amount) = 0;
+    virtual void teleport(int32_t room_id) = 0;
+    virtual void loot(std::string_view table) = 0;
+};
+
+struct ScriptResult {
+    bool blocked = false;
+    bool budget_exceeded = false;
+    bool failed = false;  // Runtime error such as division by zero
+    uint32_t instructions = 0;
+};
+
+// Run a compiled script for at most 'budget' instructions
+ScriptResult run_script(const CompiledScript& script, ScriptHost& host, uint32_t budget);
+
+} // namespace dungeon_merc
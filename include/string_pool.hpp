@@ -0,0 +1,93 @@
+#pragma once
+
+#include "arena.hpp"
+#include "metrics.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace dungeon_merc {
+
+using StringId = uint32_t;
+constexpr StringId EMPTY_STRING_ID = 0;  // Always interned as ""
+
+// Every distinct room name and description, stored once and referred to by
+// a 4-byte id. Generated dungeons repeat the same text
+// thousands of times, so a room holds ids instead of strings.
+//
+// Strings are never freed or moved: looking one up by id takes no lock, and
+// get() references stay valid for the life of the process. Interning takes
+// a lock and is for load time, not the per-command path.
+//
+// Built with zstd, long descriptive text (intern_text) is kept compressed
+// against a dictionary trained on the first few hundred texts, and
+// decompressed on demand into a small most-recently-used cache. Without it
+// text is stored as is.
+class StringPool {
+public:
+    static StringPool& get_instance() {
+        static StringPool instance;
+        return instance;
+    }
+
+    StringPool();
+    ~StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Names and other short strings; always readable through get()
+    StringId intern(std::string_view text);
+
+    // Descriptions and other long text; read it with append() or copy()
+    StringId intern_text(std::string_view text);
+
+    // Any thread. Only for ids from intern().
+    const std::string& get(StringId id) const;
+
+    // Any thread, any id
+    void append(StringId id, ArenaString& out) const;
+    std::string copy(StringId id) const;
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    size_t stored_bytes() const { return stored_bytes_.load(std::memory_order_relaxed); }
+    static bool compression_available();
+
+private:
+    static constexpr size_t PAGE_BITS = 12;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    static constexpr size_t MAX_PAGES = 4096;  // 16M strings
+
+    struct Entry {
+        std::string data;  // The text, or a zstd frame once compressed
+        uint32_t size = 0;  // Length of the text
+        bool text = false;  // From intern_text()
+        bool compressed = false;
+    };
+    struct Compression;  // zstd state; only defined when built with it
+
+    std::array<std::atomic<Entry*>, MAX_PAGES> pages_{};
+    std::atomic<size_t> count_{0};
+    std::atomic<size_t> stored_bytes_{0};
+
+    mutable std::mutex mutex_;  // Interning, and reading compressible text
+    std::unordered_multimap<size_t, StringId> index_;  // Hash of the text -> candidates
+    std::unique_ptr<Compression> compression_;
+
+    Counter& dedup_hits_;
+    Gauge& strings_gauge_;
+    Gauge& bytes_gauge_;
+
+    StringId add(std::string_view text, bool is_text);
+    Entry& entry(StringId id) const;
+    bool matches(StringId id, const Entry& entry, std::string_view text) const;
+
+    // Plain text of a compressible entry. Caller holds mutex_.
+    const std::string& plain_text(StringId id, const Entry& entry) const;
+};
+
+} // namespace dungeon_merc
@@ -2,21 +2,43 @@
 
 #include "common.hpp"
 #include "game_world.hpp"
+#include "copyover.hpp"
+#include "command_dispatcher.hpp"
+#include "metrics.hpp"
+#include "command_trace.hpp"
+#include "flood_control.hpp"
+#include "admission.hpp"
+#include "gmcp.hpp"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <deque>
 #include <vector>
 #include <memory>
 #include <functional>
 
 namespace dungeon_merc {
 
+// Lines framed into a single writev call
+constexpr size_t SEND_BATCH_LINES = 32;
+constexpr size_t SOCKET_OUTPUT_LIMIT = 256 * 1024;  // Unsent output held per plain socket before writes fail
+
 // Forward declarations
 class Player;
 class TelnetConnection;
+class ZoneGateway;
+class TlsContext;
+class TlsSession;
+class IoUring;
+
+// How plain telnet sockets are read and written
+enum class IoBackend {
+    SOCKETS,  // recv and writev per connection per tick
+    URING     // io_uring: multishot receive, all sends in one submission per tick
+};
 
 // Telnet connection state
 enum class TelnetConnectionState {
@@ -28,7 +50,7 @@ enum class TelnetConnectionState {
 };
 
 // Telnet connection class
-class TelnetConnection {
+class TelnetConnection : public TelnetOptionHandler {
 public:
     TelnetConnection(int socket_fd, const std::string& client_ip);
     ~TelnetConnection();
@@ -42,42 +64,123 @@ public:
     bool authenticate(const std::string& username, const std::string& password);
     bool is_authenticated() const;
 
-    // I/O operations
-    bool send_message(const std::string& message);
+    // Admin privileges
+    bool is_admin() const { return is_admin_; }
+    void set_admin(bool admin) { is_admin_ = admin; }
+
+    // I/O operations. Each line is sent with a trailing CRLF.
+    bool send_message(std::string_view message);
+    bool send_lines(const std::string_view* lines, size_t count);
     std::string receive_message();
     bool has_data() const;
 
+    // Input is buffered until a full line arrives. Reads stop while the
+    // buffer is full or the byte bucket is empty, so a flooding client backs
+    // up in its own TCP window instead of in server memory.
+    void set_flood_limits(const FloodLimits& limits);
+    ssize_t read_input(FloodClock::time_point now);  // Bytes read, -1 once the peer is gone
+    bool has_line() const { return input_.find('\n', input_consumed_) != std::string::npos; }
+    bool next_line(std::string_view& line);         // Valid until the next read_input()
+    bool input_overflowed() const { return input_.size() - input_consumed_ >= INPUT_BUFFER_LIMIT && !has_line(); }
+    bool take_command_token();
+    bool is_throttled() const { return denied_this_tick_; }  // A bucket ran dry this tick
+
+    // End-of-tick bookkeeping: false once the client has been throttled for
+    // longer than the grace period
+    bool update_flood_state(FloodClock::time_point now);
+
+    // Lines from other players, held until the end of the tick and sent in
+    // one batch with a fresh prompt. Views must outlive the tick arena reset.
+    void queue_line(std::string_view line) { queued_lines_.push_back(line); }
+    bool has_queued_lines() const { return !queued_lines_.empty(); }
+    bool flush_queued_lines();
+
+    // GMCP (telnet option 201). The server offers it when the client
+    // connects; structured updates only flow once the client accepts.
+    void offer_gmcp();
+    GmcpSession& get_gmcp() { return gmcp_; }
+    const GmcpSession& get_gmcp() const { return gmcp_; }
+    bool send_raw(std::string_view data);  // No CRLF framing
+
+    // Encryption. Set before the first byte is exchanged; all I/O then goes
+    // through the session.
+    void set_tls(std::unique_ptr<TlsSession> tls);
+    TlsSession* get_tls() const { return tls_.get(); }
+    bool is_encrypted() const { return tls_ != nullptr; }
+
+    // Hand the socket to an io_uring; it reads, writes and finally closes it.
+    // The ring must outlive the connection.
+    void attach_uring(IoUring* ring);
+
+    // Plain sockets keep what the kernel would not take yet and send it
+    // ahead of later output. False once the peer is gone.
+    bool has_pending_output() const { return !pending_output_.empty(); }
+    bool flush_pending_output();
+    // Everything written that the client hasn't taken yet, whichever path it is queued on
+    size_t get_queued_output_bytes() const;
+
+    // Telnet negotiation seen in the input
+    void on_option(uint8_t command, uint8_t option) override;
+    void on_subnegotiation(uint8_t option, std::string_view data) override;
+
     // Player association
-    void set_player(std::shared_ptr<Player> player);
-    std::shared_ptr<Player> get_player() const;
+    void set_player(PlayerId player);
+    PlayerId get_player() const { return player_; }
 
     // Getters
+    uint64_t get_id() const { return id_; }
+    void set_id(uint64_t id) { id_ = id; }
     int get_socket_fd() const { return socket_fd_; }
     const std::string& get_client_ip() const { return client_ip_; }
     const std::string& get_username() const { return username_; }
     TelnetConnectionState get_state() const { return state_; }
 
+    // Welcome banner tracking
+    bool is_welcome_sent() const { return welcome_sent_; }
+    void mark_welcome_sent() { welcome_sent_ = true; }
+
     // Event callbacks
     using MessageCallback = std::function<void(const std::string&)>;
     void set_message_callback(MessageCallback callback) { message_callback_ = callback; }
 
 private:
+    uint64_t id_;  // Unique for the life of the server, survives hot reboots
     int socket_fd_;
     std::string client_ip_;
     std::string username_;
     TelnetConnectionState state_;
+    bool welcome_sent_;
+    bool is_admin_;
 
     // Player association
-    std::shared_ptr<Player> player_;
+    PlayerId player_;  // Owned by the game world
 
     // Callbacks
     MessageCallback message_callback_;
 
-    // Buffer for receiving data
-    std::vector<char> receive_buffer_;
+    // Input not yet executed; bytes before input_consumed_ are done
+    std::string input_;
+    size_t input_consumed_;
+
+    // Flood control
+    FloodLimits flood_limits_;
+    TokenBucket command_tokens_;
+    TokenBucket byte_tokens_;
+    bool denied_this_tick_;
+    FloodClock::time_point throttled_since_;
+
+    std::vector<std::string_view> queued_lines_;
+
+    TelnetFilter telnet_filter_;
+    GmcpSession gmcp_;
+    std::unique_ptr<TlsSession> tls_;
+    IoUring* uring_;
+    std::string pending_output_;  // Plain sockets only: written but not yet taken by the kernel
 
     // Helper methods
     bool set_nonblocking();
+    ssize_t write_iov(const struct iovec* iov, int count);
+    ssize_t write_socket(const struct iovec* iov, int count);
 };
 
 // Telnet server class
@@ -100,10 +203,65 @@ public:
     void process_connections();
     void remove_disconnected_connections();
 
+    // Take over a socket that is already connected, as if it had just been
+    // accepted on the telnet port: it is admitted or joins the login queue
+    bool adopt_connection(int socket_fd, const std::string& client_ip);
+
+    // Limits applied to connections accepted from now on
+    void set_flood_limits(const FloodLimits& limits) { flood_limits_ = limits; }
+
+    // Admission control. Clients arriving while the server is at capacity
+    // wait in a login queue and are told their position until there is room.
+    void set_admission_limits(const AdmissionLimits& limits) { admission_.set_limits(limits); }
+    void record_tick(std::chrono::microseconds tick_time, size_t output_bytes);
+    // Output queued to all connections, for record_tick()
+    size_t get_queued_output_bytes() const;
+    size_t get_login_queue_length() const { return login_queue_.size(); }
+
+    // Optional TLS listener next to the telnet port. Encrypted clients take
+    // the same login path once their handshake is done. Call after
+    // initialize() or restore_from_copyover().
+    bool enable_tls(int port, const std::string& cert_file, const std::string& key_file);
+    int get_tls_port() const { return tls_port_; }
+
+    // Switch plain telnet sockets, including ones already open, to another
+    // I/O backend. Call after initialize() or restore_from_copyover(); false
+    // if the kernel can't support it, leaving the current backend in place.
+    bool set_io_backend(IoBackend backend);
+    IoBackend get_io_backend() const { return uring_ ? IoBackend::URING : IoBackend::SOCKETS; }
+
+    // Start the output queued this tick, and retry output plain sockets
+    // could not take earlier
+    void flush_output();
+
+    // Multi-process mode: players live in zone servers behind 'gateway'
+    // instead of a local game world
+    void set_gateway(ZoneGateway* gateway) { gateway_ = gateway; }
+
+    // Hand this tick's chat traffic to the connections it is addressed to
+    void flush_chat();
+
+    // Send each GMCP client what changed for its player this tick
+    void flush_gmcp();
+
+    // Hot reboot (copyover)
+    CopyoverState prepare_copyover();
+    bool restore_from_copyover(const CopyoverState& state);
+
     // Authentication
     bool add_user(const std::string& username, const std::string& password_hash);
     bool remove_user(const std::string& username);
     bool validate_credentials(const std::string& username, const std::string& password);
+    void set_admin_password(const std::string& password);
+
+    // Command handling
+    CommandDispatcher& get_dispatcher() { return dispatcher_; }
+
+    // Optional recording of accepted commands for offline replay
+    void set_command_recorder(std::shared_ptr<CommandRecorder> recorder) { recorder_ = recorder; }
+
+    // SHA-256 hex digest used for stored credentials
+    static std::string hash_password(const std::string& password);
 
     // Event callbacks
     using ConnectionCallback = std::function<void(std::shared_ptr<TelnetConnection>)>;
@@ -122,14 +280,57 @@ private:
     int server_socket_;
     bool running_;
 
+    // Declared ahead of everything holding connections so it outlives them
+    std::unique_ptr<IoUring> uring_;
+
     // Active connections
     std::vector<std::shared_ptr<TelnetConnection>> connections_;
 
+    // Connection playing each player, indexed by PlayerId::index
+    std::vector<TelnetConnection*> player_connections_;
+    std::vector<TelnetConnection*> chat_recipients_;
+
     // User database (simple in-memory for now)
     std::unordered_map<std::string, std::string> users_; // username -> password_hash
 
     // Game world
     std::shared_ptr<GameWorld> game_world_;
+    CommandDispatcher dispatcher_;
+    std::shared_ptr<CommandRecorder> recorder_;
+    ZoneGateway* gateway_;
+    uint64_t next_connection_id_;
+    FloodLimits flood_limits_;
+    size_t round_robin_start_;
+
+    // TLS listener and the connections still shaking hands on it
+    struct PendingHandshake {
+        std::shared_ptr<TelnetConnection> connection;
+        FloodClock::time_point deadline;
+    };
+    int tls_port_;
+    int tls_socket_;
+    std::unique_ptr<TlsContext> tls_context_;
+    std::vector<PendingHandshake> tls_handshakes_;
+
+    // Admission control; queued connections have no player yet
+    AdmissionController admission_;
+    std::deque<std::shared_ptr<TelnetConnection>> login_queue_;
+    size_t admitted_this_tick_;
+    FloodClock::time_point next_queue_notice_;
+
+    // Metrics
+    Counter& bytes_in_;
+    Counter& connections_accepted_;
+    Gauge& connections_gauge_;
+    Counter& throttled_;
+    Counter& flood_disconnects_;
+    Gauge& login_queue_gauge_;
+    Counter& logins_rejected_;
+    Counter& gmcp_bytes_;
+    Counter& tls_handshakes_done_;
+    Counter& tls_resumed_;
+    Counter& tls_kernel_offload_;
+    Counter& tls_failures_;
 
     // Callbacks
     ConnectionCallback connection_callback_;
@@ -138,7 +339,19 @@ private:
     // Helper methods
     bool create_server_socket();
     bool set_socket_options();
-    std::string hash_password(const std::string& password);
+    void register_server_commands();
+    void register_trace_command();
+    void register_connection(const std::shared_ptr<TelnetConnection>& connection);
+    void accept_uring_connections();
+    void accept_tls_connections();
+    void advance_tls_handshakes();
+    bool can_admit() const;
+    void admit_connection(const std::shared_ptr<TelnetConnection>& connection);
+    void enqueue_login(const std::shared_ptr<TelnetConnection>& connection);
+    void service_login_queue();
+    void execute_line(const std::shared_ptr<TelnetConnection>& connection, std::string_view line);
+    void bind_player(TelnetConnection* connection, PlayerId player);
+    TelnetConnection* find_player_connection(PlayerId player) const;
     bool verify_password(const std::string& password, const std::string& hash);
 
     // Thread safety
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+namespace dungeon_merc {
+
+constexpr std::chrono::seconds TLS_HANDSHAKE_TIMEOUT(10);
+constexpr size_t TLS_PENDING_LIMIT = 256 * 1024;  // Unsent output before we give up on a client
+
+enum class TlsHandshake {
+    DONE,
+    PENDING,  // Waiting on the socket; call again next tick
+    FAILED
+};
+
+class TlsSession;
+
+// Server TLS settings shared by every encrypted connection: the certificate
+// and key, a session cache and tickets so returning clients resume without
+// a full handshake, and kernel TLS where OpenSSL and the kernel support it.
+class TlsContext {
+public:
+    TlsContext();
+    ~TlsContext();
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    // PEM files; the certificate file may carry the whole chain
+    bool load(const std::string& cert_file, const std::string& key_file);
+
+    // Start the server side of a handshake on a connected socket. Null on failure.
+    std::unique_ptr<TlsSession> accept(int socket_fd);
+
+    // Whether this OpenSSL build can hand records to the kernel at all
+    static bool kernel_offload_available();
+
+private:
+    SSL_CTX* ctx_;
+};
+
+// One encrypted connection. Once the handshake is done and the kernel took
+// over the send side, write() is a plain sendmsg on the socket: the kernel
+// frames and encrypts, so batching and sendfile work as they do for
+// telnet. Otherwise OpenSSL encrypts in userspace and output it could not
+// send yet is kept and retried first.
+class TlsSession {
+public:
+    TlsSession(SSL* ssl, int socket_fd);
+    ~TlsSession();
+    TlsSession(const TlsSession&) = delete;
+    TlsSession& operator=(const TlsSession&) = delete;
+
+    // Non-blocking; drive it until it stops returning PENDING
+    TlsHandshake handshake();
+    bool is_established() const { return established_; }
+    bool is_resumed() const;
+    bool kernel_send() const { return kernel_send_; }
+    bool kernel_recv() const { return kernel_recv_; }
+    std::string describe() const;  // "TLSv1.3 TLS_AES_256_GCM_SHA384, resumed, kernel tx"
+
+    // Bytes read, 0 if nothing is ready, -1 once the peer is gone or broke the protocol
+    ssize_t read(char* buffer, size_t length);
+
+    // Bytes accepted (all of them, or -1 on failure). Anything the socket
+    // could not take yet goes out ahead of the next write or read.
+    ssize_t write(const struct iovec* iov, int count);
+
+    // Output accepted by write() that the socket has not taken yet
+    size_t pending_bytes() const { return pending_.size(); }
+
+    // Best-effort close_notify before the socket is closed
+    void shutdown();
+
+    // Take the kernel send path without kTLS underneath, so a full socket
+    // can be driven over a socketpair (used by tests)
+    void force_kernel_send() { kernel_send_ = true; }
+
+private:
+    SSL* ssl_;
+    int socket_fd_;
+    bool established_ = false;
+    bool kernel_send_ = false;
+    bool kernel_recv_ = false;
+    std::string pending_;  // Output not sent yet; goes out through OpenSSL first
+
+    ssize_t write_kernel(const struct iovec* iov, int count);
+    bool flush(std::string& buffer);
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "common.hpp"
+#include <charconv>
+#include <string_view>
+
+namespace dungeon_merc {
+
+// Splits a command line into arguments without allocating. Words are
+// separated by whitespace, and single or double quotes group several words
+// into one argument ("rusty key"). Tokens are views into the input line.
+class Tokenizer {
+public:
+    explicit Tokenizer(std::string_view input) : input_(input), pos_(0) {}
+
+    // Next argument, or false once the line is used up
+    bool next(std::string_view& token) {
+        skip_space();
+        if (pos_ >= input_.size()) {
+            return false;
+        }
+
+        char quote = input_[pos_];
+        if (quote == '"' || quote == '\'') {
+            size_t close = input_.find(quote, pos_ + 1);
+            size_t end = (close == std::string_view::npos) ? input_.size() : close;
+            token = input_.substr(pos_ + 1, end - pos_ - 1);
+            pos_ = (close == std::string_view::npos) ? end : close + 1;
+            return true;
+        }
+
+        size_t start = pos_;
+        while (pos_ < input_.size() && !is_space(input_[pos_])) {
+            ++pos_;
+        }
+        token = input_.substr(start, pos_ - start);
+        return true;
+    }
+
+    std::string_view next() {
+        std::string_view token;
+        next(token);
+        return token;
+    }
+
+    // Everything not consumed yet, trimmed; for free text such as a chat message
+    std::string_view rest() const {
+        return trim_view(input_.substr(std::min(pos_, input_.size())));
+    }
+
+    bool at_end() const {
+        size_t pos = pos_;
+        while (pos < input_.size() && is_space(input_[pos])) {
+            ++pos;
+        }
+        return pos >= input_.size();
+    }
+
+private:
+    std::string_view input_;
+    size_t pos_;
+
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    void skip_space() {
+        while (pos_ < input_.size() && is_space(input_[pos_])) {
+            ++pos_;
+        }
+    }
+};
+
+// Strict decimal integer; rejects empty input, signs on their own and trailing junk
+inline bool parse_int(std::string_view text, int& value) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Case-insensitive prefix test, so players can abbreviate ("sw" for "sword")
+inline bool istarts_with(std::string_view text, std::string_view prefix) {
+    return prefix.size() <= text.size() && iequals(text.substr(0, prefix.size()), prefix);
+}
+
+// Case-insensitive three-way compare: negative, zero or positive like
+// strcmp; a proper prefix sorts first. Orders player names everywhere.
+inline int icompare(std::string_view a, std::string_view b) {
+    size_t length = std::min(a.size(), b.size());
+    for (size_t i = 0; i < length; ++i) {
+        int ca = ::tolower(static_cast<unsigned char>(a[i]));
+        int cb = ::tolower(static_cast<unsigned char>(b[i]));
+        if (ca != cb) {
+            return ca - cb;
+        }
+    }
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+} // namespace dungeon_merc
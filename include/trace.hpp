@@ -0,0 +1,130 @@
+#pragma once
+
+#include "common.hpp"
+#include <unordered_set>
+
+namespace dungeon_merc {
+
+// Events kept per thread; older events are overwritten once a buffer wraps
+constexpr size_t TRACE_BUFFER_EVENTS = 1 << 16;
+
+constexpr const char* DEFAULT_TRACE_FILE = "dungeon_merc_trace.json";
+
+// Global switch read by every trace scope. Kept outside the recorder so the
+// disabled check compiles to a single relaxed load and branch.
+extern std::atomic<bool> g_trace_enabled;
+
+struct TraceEvent {
+    const char* name;  // Must outlive the recorder: a literal or TraceRecorder::intern()
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// Single-producer ring owned by one thread. The owner publishes with a
+// release store on head_; the dumper reads without ever blocking the owner.
+// Each slot is a tiny seqlock: its fields are relaxed atomics bracketed by
+// a sequence number, so a dump racing the owner can tell a slot it read
+// mid-rewrite and drop it instead of reporting a torn event.
+class ThreadTraceBuffer {
+public:
+    explicit ThreadTraceBuffer(uint32_t thread_id);
+
+    void push(const char* name, uint64_t start_ns, uint64_t duration_ns) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head % TRACE_BUFFER_EVENTS];
+        slot.sequence.store(0, std::memory_order_relaxed);  // Being rewritten
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start_ns.store(start_ns, std::memory_order_relaxed);
+        slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+        slot.sequence.store(head + 1, std::memory_order_release);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    uint32_t get_thread_id() const { return thread_id_; }
+
+    // Copy out whatever survived in the ring, oldest first
+    void snapshot(std::vector<TraceEvent>& out) const;
+    void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};  // Event index + 1 once written, 0 while rewriting
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+    };
+
+    uint32_t thread_id_;
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};  // Events before this were cleared by start()
+    std::unique_ptr<Slot[]> slots_;
+};
+
+// Collects scoped timing events from every thread and writes them as
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+class TraceRecorder {
+public:
+    static TraceRecorder& get_instance() {
+        static TraceRecorder instance;
+        return instance;
+    }
+
+    void start();
+    void stop();
+    bool is_enabled() const { return g_trace_enabled.load(std::memory_order_relaxed); }
+
+    // Write all buffered events; returns the number written or -1 on error
+    long dump(const std::string& path);
+
+    // Stable copy of a dynamic name for use in events
+    const char* intern(const std::string& name);
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void record(const char* name, uint64_t start_ns, uint64_t duration_ns) {
+        thread_buffer().push(name, start_ns, duration_ns);
+    }
+
+private:
+    TraceRecorder() = default;
+
+    ThreadTraceBuffer& thread_buffer();
+
+    std::mutex mutex_;  // Guards registration, interning and dumping; never taken by record()
+    std::vector<std::unique_ptr<ThreadTraceBuffer>> buffers_;
+    std::unordered_set<std::string> interned_names_;
+};
+
+// Times the enclosing scope when tracing is on. When it is off the cost is
+// the load and branch in the constructor plus a test of a local on exit.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name), start_ns_(0) {
+        if (__builtin_expect(g_trace_enabled.load(std::memory_order_relaxed), 0)) {
+            start_ns_ = TraceRecorder::now_ns();
+        }
+    }
+
+    ~TraceScope() {
+        if (__builtin_expect(start_ns_ != 0, 0)) {
+            TraceRecorder::get_instance().record(name_, start_ns_, TraceRecorder::now_ns() - start_ns_);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+#define DM_TRACE_CONCAT_INNER(a, b) a##b
+#define DM_TRACE_CONCAT(a, b) DM_TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) dungeon_merc::TraceScope DM_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+} // namespace dungeon_merc
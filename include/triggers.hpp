@@ -0,0 +1,86 @@
+#pragma once
+
+#include "common.hpp"
+#include "script.hpp"
+#include <array>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dungeon_merc {
+
+using TriggerClock = std::chrono::steady_clock;
+
+enum class TriggerEvent {
+    ENTER,    // A player arrived in the room
+    EXIT,     // A player is about to leave; 'block' keeps them in place
+    COMMAND,  // A player in the room typed the verb; 'block' skips the built-in command
+    TIMER,    // Every N seconds while someone is in the room
+};
+
+constexpr size_t TRIGGER_EVENT_COUNT = 4;
+
+struct Trigger {
+    TriggerEvent event = TriggerEvent::ENTER;
+    int room_id = 0;
+    std::string argument;  // Lowercase verb or direction; empty matches any exit
+    std::chrono::milliseconds interval{0};
+    uint32_t budget = DEFAULT_SCRIPT_BUDGET;
+    std::string location;  // "file:line" of the header, for log messages
+    CompiledScript script;
+    mutable uint64_t failures = 0;
+};
+
+// Every trigger loaded from a script file, indexed by room and event.
+// A file is a list of triggers, each a header line followed by its body:
+//
+//     on enter 1
+//         send "Welcome back, $n."
+//
+// Loading is all or nothing: a syntax error anywhere leaves the previous
+// set in place.
+class TriggerRegistry {
+public:
+    bool load_file(const std::string& path, std::string& error);
+    bool load(std::string_view text, const std::string& source_name, std::string& error);
+    void clear();
+
+    size_t size() const { return triggers_.size(); }
+    bool empty() const { return triggers_.empty(); }
+    const std::string& get_path() const { return path_; }
+
+    // Visit a room's triggers for one event, in file order
+    template<typename Fn>
+    void for_each(int room_id, TriggerEvent event, Fn&& fn) const {
+        auto it = rooms_.find(room_id);
+        if (it == rooms_.end()) {
+            return;
+        }
+        for (uint32_t index : it->second[static_cast<size_t>(event)]) {
+            fn(triggers_[index]);
+        }
+    }
+
+    // Visit timers that are due and schedule their next run
+    void run_due_timers(TriggerClock::time_point now, const std::function<void(const Trigger&)>& fn);
+
+private:
+    struct TimerEntry {
+        TriggerClock::time_point due;
+        uint32_t trigger;
+        bool operator>(const TimerEntry& other) const { return due > other.due; }
+    };
+
+    using RoomIndex = std::array<std::vector<uint32_t>, TRIGGER_EVENT_COUNT>;
+
+    std::vector<Trigger> triggers_;
+    std::unordered_map<int, RoomIndex> rooms_;
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timers_;
+    bool timers_scheduled_ = false;
+    std::string path_;
+};
+
+} // namespace dungeon_merc
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.hpp"
+#include "room.hpp"
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dungeon_merc {
+
+// The world is loaded and evicted a region at a time: room ids
+// [n * WORLD_REGION_ROOMS, (n + 1) * WORLD_REGION_ROOMS) make up region n.
+// Regions are a memory unit only; they have nothing to do with the zone
+// servers of a multi-process world.
+constexpr int WORLD_REGION_ROOMS = 64;
+
+inline int region_of(int room_id) { return room_id / WORLD_REGION_ROOMS; }
+
+// Where rooms come from. GameWorld asks for a region the first time
+// someone enters one of its rooms, and drops it again once it has been idle.
+class RegionSource {
+public:
+    virtual ~RegionSource() = default;
+
+    // Cheap: must not build anything
+    virtual bool has_room(int room_id) const = 0;
+
+    // Append every room of 'region'; false if there are none. Loading the
+    // same region twice must give the same rooms.
+    virtual bool load_region(int region, std::vector<std::shared_ptr<Room>>& rooms) = 0;
+};
+
+// The hand-built starting area (region 0), optionally with a generated
+// dungeon below the Ancient Chamber. Generated rooms are a grid of sites
+// built on demand from the room id and a seed, so a world of millions of
+// rooms costs nothing until someone walks into it.
+class WorldGenerator : public RegionSource {
+public:
+    static constexpr int FIRST_GENERATED_ROOM = WORLD_REGION_ROOMS;  // Region 1 onward
+    static constexpr int GRID_WIDTH = 16;
+    // Keeps every room id and its south neighbour within int
+    static constexpr int MAX_GENERATED_ROOMS = INT_MAX - FIRST_GENERATED_ROOM - GRID_WIDTH;
+    static constexpr uint64_t DEFAULT_SEED = 0x6d657263;  // Layouts stay put across restarts
+
+    explicit WorldGenerator(int generated_rooms = 0, uint64_t seed = DEFAULT_SEED);
+
+    bool has_room(int room_id) const override;
+    bool load_region(int region, std::vector<std::shared_ptr<Room>>& rooms) override;
+
+    int get_generated_rooms() const { return generated_rooms_; }
+
+private:
+    int generated_rooms_;
+    uint64_t seed_;
+
+    void create_starting_area(std::vector<std::shared_ptr<Room>>& rooms) const;
+    std::shared_ptr<Room> generate_room(int room_id) const;
+};
+
+} // namespace dungeon_merc
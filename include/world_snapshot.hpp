@@ -0,0 +1,131 @@
+#pragma once
+
+#include "common.hpp"
+#include "player_table.hpp"
+#include "player_directory.hpp"
+#include "arena.hpp"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dungeon_merc {
+
+constexpr size_t SNAPSHOT_CHUNK_SIZE = 64;  // Player slots per shared chunk
+
+// A room as read-only commands show it, rendered once when it was published
+struct RoomView {
+    int id = 0;
+    uint32_t players_version = 0;  // Room::get_players_version() at render time
+    std::string description;       // What 'look' prints
+    std::string occupants;         // What 'players' prints
+};
+
+// One player's public state when the snapshot was taken
+class PlayerView {
+public:
+    const std::string& get_name() const { return name_; }
+    CharacterClass get_character_class() const { return character_class_; }
+    int get_level() const { return level_; }
+    int get_health() const { return health_; }
+    int get_max_health() const { return max_health_; }
+    int get_experience() const { return experience_; }
+    int get_current_room_id() const { return room_id_; }
+
+private:
+    friend class WorldSnapshot;
+    friend class WorldSnapshotBuilder;
+
+    uint32_t generation_ = 0;  // 0 for a free slot
+    std::string name_;
+    CharacterClass character_class_ = CharacterClass::SCOUT;
+    int level_ = 0;
+    int health_ = 0;
+    int max_health_ = 0;
+    int experience_ = 0;
+    int room_id_ = 0;
+};
+
+// 'status' output. A template so the live Player and a PlayerView print alike.
+template<typename P>
+void render_status(const P& player, ArenaString& out) {
+    out << player.get_name() << ", level " << player.get_level() << ' '
+        << class_to_string(player.get_character_class())
+        << "\nHealth: " << player.get_health() << '/' << player.get_max_health()
+        << "\nExperience: " << player.get_experience();
+}
+
+// Immutable picture of what read-only commands show: room occupancy,
+// player vitals and the who list. The simulation publishes one per tick
+// through an EpochPtr, so any thread can answer 'look', 'players', 'who'
+// and 'status' from it without touching the live world.
+//
+// Consecutive snapshots share everything that did not change: rooms nobody
+// entered or left, chunks of SNAPSHOT_CHUNK_SIZE players none of whom
+// changed, and the who list while nobody logged in, out or levelled.
+class WorldSnapshot {
+public:
+    uint64_t get_sequence() const { return sequence_; }
+    uint64_t get_directory_version() const { return directory_version_; }
+    size_t get_player_count() const { return who_ ? who_->all.size() : 0; }
+
+    const RoomView* find_room(int room_id) const;
+    const PlayerView* find_player(PlayerId player) const;
+
+    // The same text the live GameWorld handlers produce
+    void render_look(PlayerId player, ArenaString& out) const;
+    void render_players(PlayerId player, ArenaString& out) const;
+    void render_who(const WhoFilter& filter, ArenaString& out) const;
+    void render_status(PlayerId player, ArenaString& out) const;
+
+private:
+    friend class WorldSnapshotBuilder;
+
+    struct PlayerChunk {
+        std::array<PlayerView, SNAPSHOT_CHUNK_SIZE> players;
+    };
+
+    struct WhoEntry {
+        int level;
+        PlayerId id;
+    };
+
+    // Who order (highest level first, then name), overall and per class
+    struct WhoIndex {
+        std::vector<WhoEntry> all;
+        std::array<std::vector<WhoEntry>, CHARACTER_CLASS_COUNT> by_class;
+    };
+
+    uint64_t sequence_ = 0;
+    uint64_t directory_version_ = 0;
+    std::vector<std::shared_ptr<const RoomView>> rooms_;  // Sorted by id
+    std::vector<std::shared_ptr<const PlayerChunk>> chunks_;
+    std::shared_ptr<const WhoIndex> who_;
+
+    const std::shared_ptr<const RoomView>* find_room_entry(int room_id) const;
+};
+
+class Room;
+
+// Makes each snapshot from the live world and the one before it, re-rendering
+// only what changed. Belongs to the simulation thread.
+class WorldSnapshotBuilder {
+public:
+    // A freed slot leaves no dirty bit behind, so removals are reported here
+    void note_removed(PlayerId player);
+
+    // Null when nothing changed since 'previous'. Clears the players'
+    // PLAYER_DIRTY_SNAPSHOT bits. 'rooms' must be sorted by id.
+    std::unique_ptr<const WorldSnapshot> build(const std::vector<const Room*>& rooms, PlayerTable& players,
+                                               const PlayerDirectory& directory, const WorldSnapshot* previous);
+
+private:
+    uint64_t sequence_ = 0;
+    std::vector<uint8_t> stale_chunks_;  // Chunks that lost a player since the last build
+
+    std::shared_ptr<const RoomView> build_room(const Room& room, const PlayerTable& players) const;
+    std::shared_ptr<const WorldSnapshot::PlayerChunk> build_chunk(size_t chunk, PlayerTable& players) const;
+    std::shared_ptr<const WorldSnapshot::WhoIndex> build_who(const PlayerDirectory& directory) const;
+};
+
+} // namespace dungeon_merc
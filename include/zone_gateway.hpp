@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common.hpp"
+#include "zone_map.hpp"
+#include "zone_protocol.hpp"
+#include "metrics.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dungeon_merc {
+
+class TelnetConnection;
+
+// Multi-process mode, client side: the telnet server keeps the sockets and
+// hands every line to the zone server hosting the player. Replies come
+// back here and are written to the client; when a player walks into
+// another zone the old zone returns their state and the gateway attaches
+// them to the new one.
+class ZoneGateway {
+public:
+    explicit ZoneGateway(const ZoneMap& map);
+
+    // Connect to every zone server, in zone order
+    bool connect_zones(const std::vector<std::string>& paths);
+
+    // Use an already connected socket for the next zone (used by tests)
+    void add_zone_link(int fd);
+    size_t get_zone_count() const { return zones_.size(); }
+
+    // Sessions are keyed by connection id
+    void attach(const std::shared_ptr<TelnetConnection>& connection, const std::string& name,
+                CharacterClass character_class);
+    void forward(uint64_t session, std::string_view line);
+    void detach(uint64_t session);
+
+    // Relay replies, notices and handoffs from the zones
+    void poll();
+
+    size_t get_session_count() const { return sessions_.size(); }
+
+private:
+    struct Session {
+        std::weak_ptr<TelnetConnection> connection;
+        int zone;
+    };
+
+    ZoneMap map_;
+    std::vector<std::unique_ptr<ZoneLink>> zones_;
+    std::unordered_map<uint64_t, Session> sessions_;
+    std::vector<std::string_view> lines_;
+    std::vector<TelnetConnection*> notice_recipients_;
+
+    Counter& handoffs_;
+    Gauge& sessions_gauge_;
+
+    ZoneLink* zone_link(int zone) const;
+    void handle_frame(const ZoneFrame& frame);
+    void relay_output(uint64_t session, FrameReader& reader);
+    void hand_off(uint64_t session, FrameReader& reader);
+    void drop_session(uint64_t session, std::string_view reason);
+    void zone_lost(int zone);
+};
+
+} // namespace dungeon_merc
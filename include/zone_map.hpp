@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dungeon_merc {
+
+// Which zone server process owns each room. The spec lists rooms per zone
+// in zone order, e.g. "1-3,4-5": zone 0 owns rooms 1 to 3 and zone 1 rooms
+// 4 and 5. A zone can join ranges with '+' ("1-3+9,4-8"). Rooms that are not
+// listed belong to zone 0.
+class ZoneMap {
+public:
+    bool parse(std::string_view spec, std::string& error);
+
+    int zone_of(int room_id) const;
+    size_t zone_count() const { return zone_count_; }
+
+private:
+    struct Range {
+        int first;
+        int last;
+        int zone;
+    };
+
+    std::vector<Range> ranges_;
+    size_t zone_count_ = 1;
+};
+
+} // namespace dungeon_merc
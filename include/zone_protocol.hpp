@@ -0,0 +1,131 @@
+#pragma once
+
+#include "common.hpp"
+#include "copyover.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace dungeon_merc {
+
+// Gateway <-> zone server protocol. Every frame is
+//
+//     u32 length | u8 type | u64 session | payload
+//
+// with integers little-endian and 'length' covering everything after it.
+// Strings are a u32 length followed by the bytes. A session is the
+// gateway's connection id and names one player for its whole stay.
+enum class ZoneMessage : uint8_t {
+    ATTACH = 1,   // gateway -> zone: u8 flags, player record
+    COMMAND,      // gateway -> zone: string line
+    DETACH,       // gateway -> zone: the client is gone
+    OUTPUT,       // zone -> gateway: u8 flags, u32 count, count strings
+    HANDOFF,      // zone -> gateway: player record; the player walked into another zone
+    REROUTE,      // zone -> gateway: string line that arrived after a handoff
+};
+
+// ATTACH flags
+constexpr uint8_t ZONE_ATTACH_NEW = 1 << 0;      // Create a fresh character from name and class only
+constexpr uint8_t ZONE_ATTACH_ARRIVAL = 1 << 1;  // Describe the room; the player just walked in
+
+// OUTPUT flags
+constexpr uint8_t ZONE_OUTPUT_PROMPT = 1 << 0;      // Reply to a command; follow it with a prompt
+constexpr uint8_t ZONE_OUTPUT_NOTICE = 1 << 1;      // Unprompted lines, batched with one prompt per tick
+constexpr uint8_t ZONE_OUTPUT_DISCONNECT = 1 << 2;  // Close the client after sending
+
+constexpr size_t ZONE_FRAME_HEADER = 4 + 1 + 8;
+constexpr size_t ZONE_MAX_FRAME = 1024 * 1024;
+constexpr size_t ZONE_MAX_BACKLOG = 64 * 1024 * 1024;  // Unsent bytes before a link is given up on
+
+// Appends one frame to a buffer. The length is filled in by finish().
+class FrameWriter {
+public:
+    FrameWriter(std::string& buffer, ZoneMessage type, uint64_t session);
+
+    FrameWriter& u8(uint8_t value);
+    FrameWriter& u32(uint32_t value);
+    FrameWriter& i32(int32_t value) { return u32(static_cast<uint32_t>(value)); }
+    FrameWriter& u64(uint64_t value);
+    FrameWriter& str(std::string_view value);
+
+    void finish();
+
+private:
+    std::string& buffer_;
+    size_t start_;
+};
+
+struct ZoneFrame {
+    ZoneMessage type;
+    uint64_t session;
+    std::string_view payload;
+};
+
+// Reads a payload front to back. Any read past the end fails and leaves
+// ok() false, so callers can check once at the end.
+class FrameReader {
+public:
+    explicit FrameReader(std::string_view payload) : data_(payload) {}
+
+    bool u8(uint8_t& value);
+    bool u32(uint32_t& value);
+    bool i32(int32_t& value);
+    bool u64(uint64_t& value);
+    bool str(std::string_view& value);
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return data_.empty(); }
+
+private:
+    std::string_view data_;
+    bool ok_ = true;
+
+    bool take(size_t size, std::string_view& bytes);
+};
+
+// A handoff carries the same per-player state a hot reboot does; the
+// socket fields are unused.
+void write_player_record(FrameWriter& writer, const CopyoverConnection& record);
+bool read_player_record(FrameReader& reader, CopyoverConnection& record);
+
+// One end of a gateway <-> zone connection over a non-blocking Unix stream
+// socket. Frames are queued in memory and written by flush().
+class ZoneLink {
+public:
+    explicit ZoneLink(int fd);
+    ~ZoneLink();
+    ZoneLink(const ZoneLink&) = delete;
+    ZoneLink& operator=(const ZoneLink&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    int get_fd() const { return fd_; }
+    void close();
+
+    // Buffer the frame is appended to
+    std::string& output() { return output_; }
+    bool has_output() const { return output_.size() > output_sent_; }
+
+    // Write as much as the socket takes; false once the peer is gone
+    bool flush();
+
+    // Read what has arrived; false once the peer is gone. Frames from the
+    // previous read are released here.
+    bool read();
+
+    // Next complete frame, valid until the next read(). False when none is
+    // complete or the stream is corrupt (check is_open()).
+    bool next_frame(ZoneFrame& frame);
+
+private:
+    int fd_;
+    std::string input_;
+    size_t input_consumed_;
+    std::string output_;
+    size_t output_sent_;
+};
+
+// Unix socket helpers. Both return -1 and log on failure.
+int listen_unix_socket(const std::string& path);
+int connect_unix_socket(const std::string& path);
+
+} // namespace dungeon_merc
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common.hpp"
+#include "game_world.hpp"
+#include "command_dispatcher.hpp"
+#include "zone_protocol.hpp"
+#include <poll.h>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace dungeon_merc {
+
+// Runs one zone of the world as its own process. It has no telnet clients
+// of its own: the gateway attaches players, forwards what they type and
+// relays the replies. A player who walks into another zone's room is
+// removed here and handed back to the gateway with their full state.
+//
+// Chat, who and tell only see the players of this zone.
+class ZoneServer {
+public:
+    ZoneServer(std::shared_ptr<GameWorld> game_world, int zone);
+    ~ZoneServer();
+
+    bool listen(const std::string& path);
+    void shutdown();
+
+    // Take over an already connected gateway socket (used by tests)
+    void add_link(int fd);
+
+    // Wait up to 'timeout' for gateway traffic, then handle all of it
+    void poll(std::chrono::milliseconds timeout);
+
+    // Send chat, room notices and timer output gathered this tick
+    void flush_notices();
+
+    CommandDispatcher& get_dispatcher() { return dispatcher_; }
+    size_t get_session_count() const { return sessions_.size(); }
+
+private:
+    struct Session {
+        ZoneLink* link;
+        PlayerId player;
+    };
+
+    std::shared_ptr<GameWorld> game_world_;
+    CommandDispatcher dispatcher_;
+    int zone_;
+    int listen_fd_;
+    std::string socket_path_;
+
+    std::vector<std::unique_ptr<ZoneLink>> links_;
+    std::unordered_map<uint64_t, Session> sessions_;
+    std::vector<uint64_t> player_sessions_;  // Session of each player, by PlayerId::index
+    std::vector<PlayerId> departures_;
+    std::vector<pollfd> poll_fds_;
+
+    Counter& handoffs_out_;
+    Counter& handoffs_in_;
+    Gauge& sessions_gauge_;
+
+    void accept_links();
+    void handle_frame(ZoneLink& link, const ZoneFrame& frame);
+    void attach(ZoneLink& link, uint64_t session, FrameReader& reader);
+    void execute(ZoneLink& link, uint64_t session, std::string_view line);
+    void send_output(ZoneLink& link, uint64_t session, uint8_t flags, const std::string_view* lines, size_t count);
+    void hand_off_departures();
+    Session* find_player_session(PlayerId player, uint64_t& session);
+    void detach(uint64_t session);
+    void drop_link(ZoneLink& link);
+};
+
+} // namespace dungeon_merc
@@ -102,6 +102,17 @@ run_tests() {
     fi
 }
 
+# Function to run benchmarks
+run_benchmarks() {
+    print_status "Running benchmarks..."
+    if [ -f "build/bin/dungeon_merc_bench" ]; then
+        ./build/bin/dungeon_merc_bench --benchmark_out=build/bench_results.json --benchmark_out_format=json
+        print_success "Benchmark results written to build/bench_results.json"
+    else
+        print_warning "Benchmark executable not found. Install Google Benchmark and run build first."
+    fi
+}
+
 # Function to install
 install_binary() {
     print_status "Installing binary..."
@@ -124,6 +135,7 @@ show_help() {
     echo "  build          Build the project (default)"
     echo "  clean          Clean build directory"
     echo "  test           Run tests"
+    echo "  bench          Run benchmarks and write JSON results"
     echo "  install        Install binary to /usr/local/bin"
     echo "  all            Clean, build, test, and install"
     echo "  help           Show this help message"
@@ -148,6 +160,9 @@ main() {
         "test")
             run_tests
             ;;
+        "bench")
+            run_benchmarks
+            ;;
         "install")
             install_binary
             ;;
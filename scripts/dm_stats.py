@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Read the memory-mapped stats file written by dungeon_merc --stats-file.
+
+The layout mirrors MetricsExportHeader / MetricsExportEntry in include/metrics.hpp.
+Reads never make a request to the server; the sequence number is used as a
+seqlock so a snapshot is only accepted if no publish happened while copying.
+"""
+
+import mmap
+import struct
+import sys
+import time
+
+HEADER = struct.Struct("<8sIIQQ")
+ENTRY = struct.Struct("<48sIIqQQQQQQ")
+TYPES = {1: "counter", 2: "gauge", 3: "histogram"}
+
+
+def read_snapshot(mapping):
+    while True:
+        magic, version, count, seq_before, updated = HEADER.unpack_from(mapping, 0)
+        if magic.rstrip(b"\0") != b"DMSTATS" or version != 1:
+            raise SystemExit("not a dungeon_merc stats file")
+        if seq_before & 1:
+            time.sleep(0.001)
+            continue
+        data = mapping[HEADER.size:HEADER.size + count * ENTRY.size]
+        seq_after = HEADER.unpack_from(mapping, 0)[3]
+        if seq_before == seq_after:
+            return updated, [ENTRY.unpack_from(data, i * ENTRY.size) for i in range(count)]
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: dm_stats.py STATS_FILE")
+
+    with open(sys.argv[1], "rb") as f:
+        mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        updated, entries = read_snapshot(mapping)
+
+    print("updated %.3fs ago" % (time.time() - updated / 1e9))
+    for name, kind, _, value, count, p50, p90, p99, p999, peak in entries:
+        name = name.rstrip(b"\0").decode()
+        if kind == 3:
+            print("%-40s n=%d p50=%dns p90=%dns p99=%dns p999=%dns max=%dns"
+                  % (name, count, p50, p90, p99, p999, peak))
+        else:
+            print("%-40s %s %d" % (name, TYPES.get(kind, "?"), value))
+
+
+if __name__ == "__main__":
+    main()
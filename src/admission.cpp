@@ -0,0 +1,35 @@
+#include "admission.hpp"
+
+namespace dungeon_merc {
+
+namespace {
+
+// Weight of the newest tick; about the last 20 ticks dominate the average
+constexpr double TICK_SMOOTHING = 0.05;
+
+} // namespace
+
+void AdmissionController::record_tick(std::chrono::microseconds tick_time, size_t output_bytes) {
+    double sample = static_cast<double>(tick_time.count());
+    tick_time_us_ += (sample - tick_time_us_) * TICK_SMOOTHING;
+    output_bytes_ = output_bytes;
+}
+
+bool AdmissionController::has_capacity(size_t players) const {
+    return saturation_reason(players) == nullptr;
+}
+
+const char* AdmissionController::saturation_reason(size_t players) const {
+    if (players >= limits_.max_players) {
+        return "player limit";
+    }
+    if (get_tick_time() > limits_.max_tick_time) {
+        return "tick time";
+    }
+    if (output_bytes_ > limits_.max_output_bytes) {
+        return "output memory";
+    }
+    return nullptr;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,96 @@
+#include "arena.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+Arena::Arena(size_t chunk_size)
+    : chunk_size_(chunk_size)
+    , base_(nullptr)
+    , capacity_(0)
+    , used_(0)
+    , retired_(0)
+    , high_water_(0) {
+}
+
+void Arena::reset() {
+    high_water_ = std::max(high_water_, bytes_used());
+
+    // A tick spilled into extra chunks: replace them with one chunk big
+    // enough for the whole tick so the next one stays on the fast path
+    if (chunks_.size() > 1) {
+        size_t total = bytes_reserved();
+        chunks_.clear();
+        add_chunk(total);
+    }
+
+    used_ = 0;
+    retired_ = 0;
+}
+
+void Arena::rewind(const Checkpoint& checkpoint) {
+    high_water_ = std::max(high_water_, bytes_used());
+
+    // Keep the first chunk even when rewinding an empty arena, so repeated
+    // scratch use does not allocate and free it every time
+    size_t keep = std::max<size_t>(checkpoint.chunk_count, 1);
+    if (chunks_.size() > keep) {
+        chunks_.resize(keep);
+        base_ = chunks_.back().data.get();
+        capacity_ = chunks_.back().size;
+    }
+    used_ = checkpoint.used;
+    retired_ = checkpoint.retired;
+}
+
+size_t Arena::bytes_reserved() const {
+    size_t total = 0;
+    for (const auto& chunk : chunks_) {
+        total += chunk.size;
+    }
+    return total;
+}
+
+void* Arena::allocate_slow(size_t size, size_t align) {
+    retired_ += used_;
+    // new[] only promises alignment for fundamental types; leave room to
+    // round up to anything stricter
+    size_t slack = align > alignof(std::max_align_t) ? align - 1 : 0;
+    add_chunk(std::max(chunk_size_, size + slack));
+
+    size_t offset = align_offset(0, align);
+    used_ = offset + size;
+    return base_ + offset;
+}
+
+void Arena::add_chunk(size_t size) {
+    Chunk chunk;
+    chunk.data.reset(new char[size]);
+    chunk.size = size;
+    base_ = chunk.data.get();
+    capacity_ = size;
+    used_ = 0;
+    chunks_.push_back(std::move(chunk));
+}
+
+Arena& tick_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+void ArenaString::grow(size_t min_capacity) {
+    size_t capacity = std::max<size_t>({min_capacity, capacity_ * 2, 64});
+
+    if (data_ && arena_->try_extend(data_, capacity_, capacity)) {
+        capacity_ = capacity;
+        return;
+    }
+
+    char* data = static_cast<char*>(arena_->allocate(capacity, 1));
+    if (size_ > 0) {
+        std::memcpy(data, data_, size_);
+    }
+    data_ = data;
+    capacity_ = capacity;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,364 @@
+#include "chat.hpp"
+#include "game_world.hpp"
+#include "trace.hpp"
+
+namespace dungeon_merc {
+
+namespace {
+
+// Lowercase copy of a channel name; false if the name is not allowed
+bool normalize_channel_name(std::string_view name, std::string& out) {
+    if (!ChatHub::is_valid_channel_name(name)) {
+        return false;
+    }
+    out.assign(name.data(), name.size());
+    std::transform(out.begin(), out.end(), out.begin(), ::tolower);
+    return true;
+}
+
+void append_channel_line(ArenaString& line, const std::string& channel, std::string_view sender_name,
+                         std::string_view text) {
+    line << '[' << channel << "] " << sender_name << ": " << text;
+}
+
+} // namespace
+
+void sanitize_chat_text(std::string_view text, std::string& out) {
+    out.clear();
+    for (char c : text) {
+        if (out.size() >= CHAT_MAX_MESSAGE) {
+            break;
+        }
+        unsigned char byte = static_cast<unsigned char>(c);
+        // Drop control characters and telnet IAC so players can't inject escapes
+        if (byte >= 0x20 && byte != 0x7f && byte != 0xff) {
+            out.push_back(c);
+        }
+    }
+}
+
+const ChatMessage& ChatScrollback::push(PlayerId sender, std::string_view sender_name, std::string_view text) {
+    ChatMessage& slot = slots_[next_seq_ % CHAT_SCROLLBACK];
+    slot.seq = next_seq_++;
+    slot.sender = sender;
+    slot.sender_name.assign(sender_name.data(), sender_name.size());
+    sanitize_chat_text(text, slot.text);
+    return slot;
+}
+
+bool ChatChannel::subscribe(PlayerId player) {
+    if (!positions_.emplace(player, subscribers_.size()).second) {
+        return false;
+    }
+    subscribers_.push_back(player);
+    return true;
+}
+
+bool ChatChannel::unsubscribe(PlayerId player) {
+    auto it = positions_.find(player);
+    if (it == positions_.end()) {
+        return false;
+    }
+
+    // Swap the last subscriber into the hole
+    size_t position = it->second;
+    PlayerId last = subscribers_.back();
+    subscribers_[position] = last;
+    positions_[last] = position;
+    subscribers_.pop_back();
+    positions_.erase(player);
+    return true;
+}
+
+bool ChatHub::is_valid_channel_name(std::string_view name) {
+    if (name.empty() || name.size() > CHAT_MAX_CHANNEL_NAME) {
+        return false;
+    }
+    for (char c : name) {
+        if (!::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ChatHub::shard_index(std::string_view channel) {
+    // Names are normalized before lookup, so a plain FNV-1a over the bytes is enough
+    uint32_t hash = 2166136261u;
+    for (char c : channel) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash % CHAT_SHARDS;
+}
+
+bool ChatHub::join(PlayerId player, std::string_view channel) {
+    std::string name;
+    if (!normalize_channel_name(channel, name)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        auto it = memberships_.find(player);
+        if (it != memberships_.end() && it->second.size() >= CHAT_MAX_PLAYER_CHANNELS) {
+            return false;
+        }
+    }
+
+    Shard& shard = shard_for(name);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.channels.find(name);
+        if (it == shard.channels.end()) {
+            if (channel_total_.fetch_add(1, std::memory_order_relaxed) >= CHAT_MAX_CHANNELS) {
+                channel_total_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            it = shard.channels.emplace(name, std::make_unique<ChatChannel>(name)).first;
+        }
+        if (!it->second->subscribe(player)) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    memberships_[player].push_back(name);
+    return true;
+}
+
+bool ChatHub::leave(PlayerId player, std::string_view channel) {
+    std::string name;
+    if (!normalize_channel_name(channel, name)) {
+        return false;
+    }
+
+    Shard& shard = shard_for(name);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.channels.find(name);
+        if (it == shard.channels.end() || !it->second->unsubscribe(player)) {
+            return false;
+        }
+        note_if_empty(shard, *it->second);
+    }
+
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    auto it = memberships_.find(player);
+    if (it != memberships_.end()) {
+        auto& names = it->second;
+        names.erase(std::remove(names.begin(), names.end(), name), names.end());
+        if (names.empty()) {
+            memberships_.erase(it);
+        }
+    }
+    return true;
+}
+
+bool ChatHub::is_member(PlayerId player, std::string_view channel) const {
+    std::string name;
+    if (!normalize_channel_name(channel, name)) {
+        return false;
+    }
+
+    const Shard& shard = shard_for(name);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.channels.find(name);
+    return it != shard.channels.end() && it->second->is_subscribed(player);
+}
+
+std::vector<std::string> ChatHub::get_channels(PlayerId player) const {
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    auto it = memberships_.find(player);
+    return it != memberships_.end() ? it->second : std::vector<std::string>();
+}
+
+void ChatHub::set_channels(PlayerId player, const std::vector<std::string>& channels) {
+    for (const auto& name : get_channels(player)) {
+        if (std::find(channels.begin(), channels.end(), name) == channels.end()) {
+            leave(player, name);
+        }
+    }
+    for (const auto& name : channels) {
+        join(player, name);
+    }
+}
+
+void ChatHub::remove_player(PlayerId player) {
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        auto it = memberships_.find(player);
+        if (it == memberships_.end()) {
+            return;
+        }
+        names = std::move(it->second);
+        memberships_.erase(it);
+    }
+
+    for (const auto& name : names) {
+        Shard& shard = shard_for(name);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.channels.find(name);
+        if (it != shard.channels.end() && it->second->unsubscribe(player)) {
+            note_if_empty(shard, *it->second);
+        }
+    }
+}
+
+void ChatHub::note_if_empty(Shard& shard, const ChatChannel& channel) {
+    if (channel.get_subscribers().empty()) {
+        shard.emptied.push_back(channel.get_name());
+    }
+}
+
+bool ChatHub::post(PlayerId sender, std::string_view sender_name, std::string_view channel, std::string_view text) {
+    std::string name;
+    if (!normalize_channel_name(channel, name)) {
+        return false;
+    }
+
+    Shard& shard = shard_for(name);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.channels.find(name);
+    if (it == shard.channels.end() || !it->second->is_subscribed(sender)) {
+        return false;
+    }
+
+    ChatChannel& target = *it->second;
+    const ChatMessage& message = target.get_scrollback().push(sender, sender_name, text);
+    if (shard.post_count == shard.posts.size()) {
+        shard.posts.emplace_back();
+    }
+    PendingPost& pending = shard.posts[shard.post_count++];
+    pending.channel = &target;
+    pending.sender = sender;
+    pending.sender_name = message.sender_name;
+    pending.text = message.text;
+    return true;
+}
+
+ChatHub::PendingLine& ChatHub::next_pending() {
+    if (pending_count_ == pending_.size()) {
+        pending_.emplace_back();
+    }
+    return pending_[pending_count_++];
+}
+
+void ChatHub::post_room(int room_id, PlayerId sender, std::string_view sender_name, std::string_view text) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    PendingLine& line = next_pending();
+    line.room_id = room_id;
+    line.sender = sender;
+    line.recipient = PlayerId{};
+    line.notice = false;
+    line.sender_name.assign(sender_name.data(), sender_name.size());
+    sanitize_chat_text(text, line.text);
+}
+
+void ChatHub::post_room_notice(int room_id, PlayerId exclude, std::string_view text) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    PendingLine& line = next_pending();
+    line.room_id = room_id;
+    line.sender = exclude;
+    line.recipient = PlayerId{};
+    line.notice = true;
+    line.sender_name.clear();
+    line.text.assign(text.data(), text.size());
+}
+
+void ChatHub::post_direct(PlayerId recipient, std::string_view sender_name, std::string_view text) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    PendingLine& line = next_pending();
+    line.room_id = 0;
+    line.sender = PlayerId{};
+    line.recipient = recipient;
+    line.notice = false;
+    line.sender_name.assign(sender_name.data(), sender_name.size());
+    sanitize_chat_text(text, line.text);
+}
+
+void ChatHub::get_scrollback(std::string_view channel, ArenaLines& lines) const {
+    std::string name;
+    if (!normalize_channel_name(channel, name)) {
+        return;
+    }
+
+    const Shard& shard = shard_for(name);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.channels.find(name);
+    if (it == shard.channels.end()) {
+        return;
+    }
+
+    Arena& arena = *lines.get_allocator().arena();
+    it->second->get_scrollback().for_each_since(0, [&](const ChatMessage& message) {
+        ArenaString line(arena);
+        append_channel_line(line, name, message.sender_name, message.text);
+        lines.push_back(line.view());
+    });
+}
+
+void ChatHub::flush(const ChatDelivery& deliver) {
+    TRACE_SCOPE("chat.flush");
+    Arena& arena = tick_arena();
+
+    // Each message is formatted once and the same line goes to every subscriber
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (size_t i = 0; i < shard.post_count; ++i) {
+            const PendingPost& post = shard.posts[i];
+            ArenaString line(arena);
+            append_channel_line(line, post.channel->get_name(), post.sender_name, post.text);
+            for (PlayerId subscriber : post.channel->get_subscribers()) {
+                if (subscriber != post.sender) {
+                    deliver(subscriber, line.view());
+                }
+            }
+        }
+        shard.post_count = 0;
+
+        // Nothing points at these any more; skip any joined again since
+        for (const auto& name : shard.emptied) {
+            auto it = shard.channels.find(name);
+            if (it != shard.channels.end() && it->second->get_subscribers().empty()) {
+                shard.channels.erase(it);
+                channel_total_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        shard.emptied.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (size_t i = 0; i < pending_count_; ++i) {
+        const PendingLine& pending = pending_[i];
+        ArenaString line(arena);
+
+        if (pending.recipient.is_valid()) {
+            line << pending.sender_name << " tells you: " << pending.text;
+            deliver(pending.recipient, line.view());
+            continue;
+        }
+
+        auto room = world_.get_room(pending.room_id);
+        if (!room) {
+            continue;
+        }
+        if (pending.notice) {
+            line << pending.text;
+        } else {
+            line << pending.sender_name << " says: " << pending.text;
+        }
+        for (PlayerId listener : room->get_players()) {
+            if (listener != pending.sender) {
+                deliver(listener, line.view());
+            }
+        }
+    }
+    pending_count_ = 0;
+}
+
+size_t ChatHub::channel_count() const {
+    return channel_total_.load(std::memory_order_relaxed);
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,456 @@
+#include "command_dispatcher.hpp"
+#include "command_trace.hpp"
+
+namespace dungeon_merc {
+
+CommandDispatcher::CommandDispatcher(std::shared_ptr<GameWorld> game_world)
+    : game_world_(game_world)
+    , commands_total_(MetricsRegistry::get_instance().counter("commands.total"))
+    , commands_unknown_(MetricsRegistry::get_instance().counter("commands.unknown")) {
+    lookup_key_.reserve(32);
+    register_builtin_commands();
+}
+
+void CommandDispatcher::register_command(const std::string& name, const std::string& help, Handler handler,
+                                         bool admin_only, const std::string& metric_name) {
+    std::string metric_base = "command." + (metric_name.empty() ? name : metric_name);
+
+    Command command;
+    command.name = name;
+    command.help = help;
+    command.handler = std::move(handler);
+    command.admin_only = admin_only;
+    command.latency = &MetricsRegistry::get_instance().histogram(metric_base + ".latency");
+    command.trace_name = TraceRecorder::get_instance().intern(metric_base);
+
+    auto it = command_index_.find(name);
+    if (it != command_index_.end()) {
+        commands_[it->second] = std::move(command);
+        return;
+    }
+
+    command_index_[name] = commands_.size();
+    commands_.push_back(std::move(command));
+}
+
+bool CommandDispatcher::dispatch(CommandContext& ctx, std::string_view line) {
+    std::string_view input = trim_view(line);
+    if (input.empty()) {
+        return true;
+    }
+
+    Tokenizer tokenizer(input);
+    std::string_view verb = tokenizer.next();
+    std::string_view args = tokenizer.rest();
+
+    lookup_key_.assign(verb.data(), verb.size());
+    std::transform(lookup_key_.begin(), lookup_key_.end(), lookup_key_.begin(), ::tolower);
+
+    commands_total_.add();
+
+    // Room scripts see the command first and may replace it
+    if (game_world_ && ctx.player.is_valid() && !game_world_->get_triggers().empty()) {
+        ArenaString out(*ctx.output.get_allocator().arena());
+        bool blocked = game_world_->run_command_triggers(ctx.player, lookup_key_, out);
+        if (!out.empty()) {
+            ctx.reply(out);
+        }
+        if (blocked) {
+            return true;
+        }
+    }
+
+    auto it = command_index_.find(lookup_key_);
+    if (it == command_index_.end() || (commands_[it->second].admin_only && !ctx.is_admin)) {
+        commands_unknown_.add();
+        LOG_DEBUG("Unknown command: " + std::string(redact_command(input)));
+        ArenaString message(*ctx.output.get_allocator().arena());
+        message << "Unknown command: " << input;
+        ctx.reply(message);
+        ctx.reply("Type 'help' for available commands.");
+        return false;
+    }
+
+    const Command& command = commands_[it->second];
+    ScopedLatency timer(*command.latency);
+    TRACE_SCOPE(command.trace_name);
+    command.handler(ctx, args);
+    return true;
+}
+
+void CommandDispatcher::handle_help(CommandContext& ctx) {
+    ctx.reply("Available commands:");
+    for (const auto& command : commands_) {
+        if (command.help.empty() || (command.admin_only && !ctx.is_admin)) {
+            continue;
+        }
+        ArenaString line(*ctx.output.get_allocator().arena());
+        line << "  " << command.help;
+        ctx.reply(line);
+    }
+}
+
+void CommandDispatcher::register_builtin_commands() {
+    register_command("help", "help - Show this help",
+        [this](CommandContext& ctx, std::string_view) {
+            handle_help(ctx);
+        });
+
+    register_command("look", "look - Look around the current room",
+        [this](CommandContext& ctx, std::string_view) {
+            if (game_world_ && ctx.player.is_valid()) {
+                ArenaString out(*ctx.output.get_allocator().arena());
+                game_world_->handle_look_command(ctx.player, out);
+                ctx.reply(out);
+            } else {
+                ctx.reply("You are lost in the void...");
+            }
+        });
+
+    // Every direction and its abbreviation share one 'move' entry
+    auto move_handler = [this](CommandContext& ctx, std::string_view direction) {
+        if (game_world_ && ctx.player.is_valid()) {
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_move_command(ctx.player, direction, out);
+            ctx.reply(out);
+        } else {
+            ctx.reply("You can't move right now.");
+        }
+    };
+    const Direction directions[] = {
+        Direction::NORTH, Direction::SOUTH, Direction::EAST,
+        Direction::WEST, Direction::UP, Direction::DOWN
+    };
+    for (Direction dir : directions) {
+        std::string name = direction_to_string(dir);
+        std::string help = (dir == Direction::NORTH)
+            ? "north/south/east/west/up/down - Move in that direction" : "";
+        auto handler = [move_handler, dir](CommandContext& ctx, std::string_view) {
+            move_handler(ctx, direction_name(dir));
+        };
+        register_command(name, help, handler, false, "move");
+        register_command(name.substr(0, 1), "", handler, false, "move");
+    }
+
+    register_command("players", "players - Show players in current room",
+        [this](CommandContext& ctx, std::string_view) {
+            if (game_world_ && ctx.player.is_valid()) {
+                ArenaString out(*ctx.output.get_allocator().arena());
+                game_world_->handle_players_command(ctx.player, out);
+                ctx.reply(out);
+            } else {
+                ctx.reply("You are alone.");
+            }
+        });
+
+    register_command("quit", "quit - Disconnect from server",
+        [](CommandContext& ctx, std::string_view) {
+            ctx.reply("Goodbye!");
+            ctx.disconnect = true;
+        });
+
+    register_command("status", "status - Show your status",
+        [this](CommandContext& ctx, std::string_view) {
+            if (game_world_ && ctx.player.is_valid()) {
+                ArenaString out(*ctx.output.get_allocator().arena());
+                game_world_->handle_status_command(ctx.player, out);
+                ctx.reply(out);
+            } else {
+                ctx.reply("You are connected to Dungeon Merc!");
+            }
+        });
+
+    register_command("who", "who [class] [level|min-max] - List mercs online",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+
+            WhoFilter filter;
+            Tokenizer tokenizer(args);
+            std::string_view token;
+            while (tokenizer.next(token)) {
+                if (parse_character_class(token, filter.character_class)) {
+                    filter.any_class = false;
+                } else if (!parse_level_range(token, filter.min_level, filter.max_level)) {
+                    ctx.reply("Usage: who [class] [level|min-max]");
+                    return;
+                }
+            }
+
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_who_command(filter, out);
+            ctx.reply(out);
+        });
+
+    register_command("finger", "finger <player> - Show a merc's record",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            std::string_view name = Tokenizer(args).next();
+            if (name.empty()) {
+                ctx.reply("Finger whom?");
+                return;
+            }
+
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_finger_command(name, out);
+            ctx.reply(out);
+        });
+
+    register_command("rank", "rank [player] - Show a merc's place on the leaderboard",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_rank_command(ctx.player, Tokenizer(args).next(), out);
+            ctx.reply(out);
+        });
+
+    register_command("top", "top [page] - Show the leaderboard",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            std::string_view token = Tokenizer(args).next();
+            int page = 1;
+            if (!token.empty() && (!parse_int(token, page) || page < 1)) {
+                ctx.reply("Usage: top [page]");
+                return;
+            }
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_top_command(static_cast<size_t>(page), out);
+            ctx.reply(out);
+        });
+
+    auto inventory = [this](CommandContext& ctx, std::string_view) {
+        if (!game_world_) {
+            ctx.reply("No game world loaded.");
+            return;
+        }
+        ArenaString out(*ctx.output.get_allocator().arena());
+        game_world_->handle_inventory_command(ctx.player, out);
+        ctx.reply(out);
+    };
+    register_command("inventory", "inventory - Show what you are carrying", inventory);
+    register_command("i", "", inventory, false, "inventory");
+
+    register_command("contracts", "contracts - Show the contract board",
+        [this](CommandContext& ctx, std::string_view) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_contracts_command(ctx.player, out);
+            ctx.reply(out);
+        });
+
+    register_command("claim", "claim <number> - Take a contract from the board",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            std::string_view token = Tokenizer(args).next();
+            if (!token.empty() && token[0] == '#') {
+                token.remove_prefix(1);
+            }
+            int id = 0;
+            if (!parse_int(token, id) || id < 1) {
+                ctx.reply("Usage: claim <number>");
+                return;
+            }
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_claim_command(ctx.player, static_cast<uint32_t>(id), out);
+            ctx.reply(out);
+        });
+
+    register_command("abandon", "abandon - Give up your contract so you can claim another",
+        [this](CommandContext& ctx, std::string_view) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+            ArenaString out(*ctx.output.get_allocator().arena());
+            game_world_->handle_abandon_command(ctx.player, out);
+            ctx.reply(out);
+        });
+
+    register_chat_commands();
+}
+
+bool CommandDispatcher::parse_level_range(std::string_view text, int& min_level, int& max_level) {
+    size_t dash = text.find('-');
+    if (dash == std::string_view::npos) {
+        int level;
+        if (!parse_int(text, level)) {
+            return false;
+        }
+        min_level = max_level = level;
+        return true;
+    }
+
+    int low, high;
+    if (!parse_int(text.substr(0, dash), low) || !parse_int(text.substr(dash + 1), high) || low > high) {
+        return false;
+    }
+    min_level = low;
+    max_level = high;
+    return true;
+}
+
+const Player* CommandDispatcher::current_player(const CommandContext& ctx) const {
+    return (game_world_ && ctx.player.is_valid()) ? game_world_->get_player(ctx.player) : nullptr;
+}
+
+void CommandDispatcher::register_chat_commands() {
+    register_command("say", "say <message> - Talk to everyone in the room",
+        [this](CommandContext& ctx, std::string_view args) {
+            const Player* player = current_player(ctx);
+            if (!player) {
+                ctx.reply("Nobody can hear you.");
+                return;
+            }
+            if (args.empty()) {
+                ctx.reply("Say what?");
+                return;
+            }
+            game_world_->get_chat().post_room(player->get_current_room_id(), ctx.player, player->get_name(), args);
+
+            ArenaString line(*ctx.output.get_allocator().arena());
+            line << "You say: " << args;
+            ctx.reply(line);
+        });
+
+    register_command("tell", "tell <player> <message> - Send a private message",
+        [this](CommandContext& ctx, std::string_view args) {
+            const Player* player = current_player(ctx);
+            if (!player) {
+                ctx.reply("Nobody can hear you.");
+                return;
+            }
+
+            Tokenizer tokenizer(args);
+            std::string_view name = tokenizer.next();
+            std::string_view message = tokenizer.rest();
+            if (name.empty() || message.empty()) {
+                ctx.reply("Usage: tell <player> <message>");
+                return;
+            }
+
+            PlayerId target = game_world_->find_player_by_name(name);
+            const Player* recipient = game_world_->get_player(target);
+            ArenaString line(*ctx.output.get_allocator().arena());
+            if (!recipient) {
+                line << "No player named " << name << " is online.";
+            } else if (target == ctx.player) {
+                line << "You mutter to yourself.";
+            } else {
+                game_world_->get_chat().post_direct(target, player->get_name(), message);
+                line << "You tell " << recipient->get_name() << ": " << message;
+            }
+            ctx.reply(line);
+        });
+
+    register_command("shout", "shout <message> - Talk on the global channel",
+        [this](CommandContext& ctx, std::string_view args) {
+            const Player* player = current_player(ctx);
+            if (!player) {
+                ctx.reply("Nobody can hear you.");
+                return;
+            }
+            if (args.empty()) {
+                ctx.reply("Shout what?");
+                return;
+            }
+            if (!game_world_->get_chat().post(ctx.player, player->get_name(), GLOBAL_CHANNEL, args)) {
+                ctx.reply("You are not on the global channel. Use 'channel join global'.");
+                return;
+            }
+
+            ArenaString line(*ctx.output.get_allocator().arena());
+            line << '[' << GLOBAL_CHANNEL << "] You: " << args;
+            ctx.reply(line);
+        });
+
+    register_command("channel", "channel [join|leave <name>] | channel <name> <message> - Public chat channels",
+        [this](CommandContext& ctx, std::string_view args) {
+            const Player* player = current_player(ctx);
+            if (!player) {
+                ctx.reply("Nobody can hear you.");
+                return;
+            }
+
+            ChatHub& chat = game_world_->get_chat();
+            Tokenizer tokenizer(args);
+            std::string_view action = tokenizer.next();
+            ArenaString line(*ctx.output.get_allocator().arena());
+
+            if (action.empty()) {
+                auto channels = chat.get_channels(ctx.player);
+                if (channels.empty()) {
+                    ctx.reply("You are not on any channels.");
+                    return;
+                }
+                line << "Your channels: ";
+                for (size_t i = 0; i < channels.size(); ++i) {
+                    if (i > 0) line << ", ";
+                    line << channels[i];
+                }
+                ctx.reply(line);
+                return;
+            }
+
+            bool joining = iequals(action, "join");
+            if (joining || iequals(action, "leave")) {
+                std::string_view name = tokenizer.next();
+                if (!ChatHub::is_valid_channel_name(name)) {
+                    ctx.reply("Channel names are up to 15 letters, digits, '-' or '_'.");
+                    return;
+                }
+                if (joining) {
+                    if (!chat.join(ctx.player, name)) {
+                        if (chat.is_member(ctx.player, name)) {
+                            ctx.reply("You are already on that channel.");
+                        } else if (chat.get_channels(ctx.player).size() >= CHAT_MAX_PLAYER_CHANNELS) {
+                            ctx.reply("You are on too many channels; leave one first.");
+                        } else {
+                            ctx.reply("No more channels can be opened right now.");
+                        }
+                        return;
+                    }
+                    line << "You join " << name << '.';
+                    ctx.reply(line);
+                    chat.get_scrollback(name, ctx.output);
+                } else {
+                    ctx.reply(chat.leave(ctx.player, name) ? "You leave the channel." : "You are not on that channel.");
+                }
+                return;
+            }
+
+            std::string_view message = tokenizer.rest();
+            if (message.empty()) {
+                ctx.reply("Usage: channel <name> <message>");
+                return;
+            }
+            if (!chat.post(ctx.player, player->get_name(), action, message)) {
+                ctx.reply("You are not on that channel.");
+                return;
+            }
+            line << '[';
+            for (char c : action) {
+                line << static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+            }
+            line << "] You: " << message;
+            ctx.reply(line);
+        });
+}
+
+} // namespace dungeon_merc
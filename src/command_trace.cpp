@@ -0,0 +1,248 @@
+#include "command_trace.hpp"
+#include "tokenizer.hpp"
+#include <cstring>
+
+namespace dungeon_merc {
+
+namespace {
+
+constexpr char TRACE_MAGIC[8] = {'D', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t TRACE_VERSION = 1;
+
+// Text longer than this in a single record means the file is corrupt
+constexpr uint64_t MAX_TRACE_TEXT = 1 << 20;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t start_unix_us;
+};
+
+uint64_t unix_now_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+CommandRecorder::~CommandRecorder() {
+    close();
+}
+
+bool CommandRecorder::open(const std::string& path, uint64_t seed, bool append) {
+    close();
+
+    file_ = std::fopen(path.c_str(), append ? "abe" : "wbe");
+    if (!file_) {
+        LOG_ERROR("Failed to open command trace: " + path);
+        return false;
+    }
+
+    // Records are tiny; a large stdio buffer keeps this to one write() every few thousand commands
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 16);
+
+    TraceHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.reserved = 0;
+    header.seed = seed;
+    header.start_unix_us = unix_now_us();
+    std::fwrite(&header, sizeof(header), 1, file_);
+
+    last_record_ = std::chrono::steady_clock::now();
+    LOG_INFO("Recording commands to " + path);
+    return true;
+}
+
+void CommandRecorder::close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void CommandRecorder::flush() {
+    if (file_) {
+        std::fflush(file_);
+    }
+}
+
+void CommandRecorder::record_connect(uint64_t connection_id, const std::string& player_name,
+                                     CharacterClass character_class, int room_id) {
+    if (!file_) {
+        return;
+    }
+    write_record_prefix(TraceEventType::CONNECT, connection_id);
+    write_bytes(player_name);
+    std::fputc(static_cast<int>(character_class), file_);
+    write_varint(static_cast<uint64_t>(std::max(0, room_id)));
+}
+
+void CommandRecorder::record_command(uint64_t connection_id, std::string_view text) {
+    if (!file_) {
+        return;
+    }
+    write_record_prefix(TraceEventType::COMMAND, connection_id);
+    write_bytes(text);
+}
+
+std::string_view redact_command(std::string_view line) {
+    std::string_view verb = Tokenizer(trim_view(line)).next();
+    return iequals(verb, "admin") ? std::string_view("admin") : line;
+}
+
+void CommandRecorder::record_disconnect(uint64_t connection_id) {
+    if (!file_) {
+        return;
+    }
+    write_record_prefix(TraceEventType::DISCONNECT, connection_id);
+}
+
+void CommandRecorder::write_record_prefix(TraceEventType type, uint64_t connection_id) {
+    auto now = std::chrono::steady_clock::now();
+    auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - last_record_).count();
+    last_record_ = now;
+
+    std::fputc(static_cast<int>(type), file_);
+    write_varint(connection_id);
+    write_varint(static_cast<uint64_t>(std::max<int64_t>(0, delta)));
+}
+
+void CommandRecorder::write_varint(uint64_t value) {
+    while (value >= 0x80) {
+        std::fputc(static_cast<int>((value & 0x7f) | 0x80), file_);
+        value >>= 7;
+    }
+    std::fputc(static_cast<int>(value), file_);
+}
+
+void CommandRecorder::write_bytes(std::string_view bytes) {
+    write_varint(bytes.size());
+    std::fwrite(bytes.data(), 1, bytes.size(), file_);
+}
+
+CommandTraceReader::~CommandTraceReader() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool CommandTraceReader::open(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        LOG_ERROR("Failed to open command trace: " + path);
+        return false;
+    }
+
+    uint64_t seed = 0;
+    if (!read_header(seed)) {
+        LOG_ERROR("Not a command trace: " + path);
+        return false;
+    }
+    return true;
+}
+
+bool CommandTraceReader::read_header(uint64_t& seed) {
+    TraceHeader header;
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION) {
+        return false;
+    }
+
+    if (!have_header_) {
+        seed_ = header.seed;
+        first_start_unix_us_ = header.start_unix_us;
+        have_header_ = true;
+    }
+    seed = header.seed;
+
+    // Later segments continue on the wall clock of the first one
+    clock_us_ = header.start_unix_us > first_start_unix_us_ ? header.start_unix_us - first_start_unix_us_ : clock_us_;
+    return true;
+}
+
+bool CommandTraceReader::next(TraceRecord& record) {
+    if (!file_) {
+        return false;
+    }
+
+    int type = std::fgetc(file_);
+    if (type == EOF) {
+        return false;
+    }
+
+    // Another segment header: a hot reboot happened here
+    if (type == TRACE_MAGIC[0]) {
+        std::ungetc(type, file_);
+        if (!read_header(record.seed)) {
+            LOG_ERROR("Corrupt segment header in command trace");
+            return false;
+        }
+        record.type = TraceEventType::SEGMENT;
+        record.connection_id = 0;
+        record.timestamp_us = clock_us_;
+        record.text.clear();
+        return true;
+    }
+
+    uint64_t delta = 0;
+    if (!read_varint(record.connection_id) || !read_varint(delta)) {
+        return false;
+    }
+    clock_us_ += delta;
+    record.timestamp_us = clock_us_;
+    record.type = static_cast<TraceEventType>(type);
+
+    switch (record.type) {
+        case TraceEventType::CONNECT: {
+            uint64_t room = 0;
+            if (!read_bytes(record.text)) {
+                return false;
+            }
+            int cls = std::fgetc(file_);
+            if (cls == EOF || !read_varint(room)) {
+                return false;
+            }
+            record.character_class = static_cast<CharacterClass>(cls);
+            record.room_id = static_cast<int>(room);
+            return true;
+        }
+        case TraceEventType::COMMAND:
+            return read_bytes(record.text);
+        case TraceEventType::DISCONNECT:
+            record.text.clear();
+            return true;
+        default:
+            LOG_ERROR("Unknown record type in command trace: " + std::to_string(type));
+            return false;
+    }
+}
+
+bool CommandTraceReader::read_varint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = std::fgetc(file_);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CommandTraceReader::read_bytes(std::string& bytes) {
+    uint64_t length = 0;
+    if (!read_varint(length) || length > MAX_TRACE_TEXT) {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(length));
+    return length == 0 || std::fread(&bytes[0], 1, bytes.size(), file_) == bytes.size();
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,210 @@
+#include "contract_board.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+namespace {
+
+// What the job is; the site is rolled separately
+struct ContractTemplate {
+    const char* objective;
+    int credits;     // Per tier, before modifiers
+    int experience;  // Per tier, before modifiers
+};
+
+const ContractTemplate CONTRACT_TEMPLATES[] = {
+    {"Recover the keycards from", 60, 25},
+    {"Destroy the server racks in", 80, 30},
+    {"Free the prisoners held in", 90, 40},
+    {"Extract the data core from", 110, 35},
+    {"Clear the rogue drones out of", 70, 45},
+    {"Silence the cult broadcast in", 85, 40},
+};
+
+const char* const CONTRACT_SITES[] = {
+    "a ruined lab", "a haunted bunker", "an alien mine", "a corporate facility",
+};
+
+struct ContractModifier {
+    const char* name;
+    int bonus_percent;
+};
+
+const ContractModifier CONTRACT_MODIFIERS[CONTRACT_MOD_COUNT] = {
+    {"armored", 25},
+    {"timed", 20},
+    {"silent", 30},
+    {"hazard", 15},
+};
+
+template<typename T, size_t N>
+const T& pick(RandomGenerator& rng, const T (&table)[N]) {
+    return table[rng.random_int(0, static_cast<int>(N) - 1)];
+}
+
+} // namespace
+
+const char* contract_modifier_name(size_t bit) {
+    return bit < CONTRACT_MOD_COUNT ? CONTRACT_MODIFIERS[bit].name : "unknown";
+}
+
+ContractBoard::ContractBoard()
+    : generated_(MetricsRegistry::get_instance().counter("contracts.generated"))
+    , claims_(MetricsRegistry::get_instance().counter("contracts.claims"))
+    , claim_conflicts_(MetricsRegistry::get_instance().counter("contracts.claim_conflicts"))
+    , version_gauge_(MetricsRegistry::get_instance().gauge("contracts.version")) {
+}
+
+ContractBoard::~ContractBoard() {
+    stop();
+}
+
+void ContractBoard::start(uint64_t seed_value) {
+    if (generator_.joinable()) {
+        return;
+    }
+    rng_.seed(seed_value);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = false;
+        wake_requested_ = false;
+    }
+    generator_ = std::thread(&ContractBoard::run, this);
+    LOG_INFO("Contract board generator started");
+}
+
+void ContractBoard::stop() {
+    if (!generator_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    generator_.join();
+}
+
+ContractClaim ContractBoard::claim(uint32_t id, int level, std::shared_ptr<const Contract>& contract) {
+    auto board = board_.read();
+    if (!board) {
+        return ContractClaim::NOT_FOUND;
+    }
+
+    const auto& offers = board->offers;
+    auto it = std::lower_bound(offers.begin(), offers.end(), id,
+                               [](const std::shared_ptr<Contract>& offer, uint32_t key) { return offer->id_ < key; });
+    if (it == offers.end() || (*it)->id_ != id) {
+        return ContractClaim::NOT_FOUND;
+    }
+    Contract& offer = **it;
+    if (level < offer.min_level_) {
+        return ContractClaim::UNDER_LEVEL;
+    }
+
+    bool expected = false;
+    if (!offer.claimed_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        claim_conflicts_.add();
+        return ContractClaim::TAKEN;
+    }
+    contract = *it;
+    claims_.add();
+
+    // Get a replacement up without waiting out the refresh interval
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_requested_ = true;
+    }
+    wake_.notify_one();
+    return ContractClaim::CLAIMED;
+}
+
+void ContractBoard::refresh(std::chrono::steady_clock::time_point now) {
+    TRACE_SCOPE("contracts.refresh");
+    const ContractList* current = board_.peek();
+    auto next = std::make_unique<ContractList>();
+    next->offers.reserve(CONTRACT_BOARD_SIZE);
+    bool changed = current == nullptr;
+
+    if (current) {
+        for (const auto& offer : current->offers) {
+            if (!offer->is_claimed() && offer->expires_ > now) {
+                next->offers.push_back(offer);
+            } else {
+                changed = true;
+            }
+        }
+    }
+    // New ids are always the highest, so appending keeps the list sorted
+    while (next->offers.size() < CONTRACT_BOARD_SIZE) {
+        next->offers.push_back(generate(now));
+        changed = true;
+    }
+
+    if (!changed) {
+        return;
+    }
+    next->version = next_version_++;
+    version_gauge_.set(static_cast<int64_t>(next->version));
+    board_.publish(std::move(next));
+}
+
+std::shared_ptr<Contract> ContractBoard::generate(std::chrono::steady_clock::time_point now) {
+    auto contract = std::make_shared<Contract>();
+    const ContractTemplate& job = pick(rng_, CONTRACT_TEMPLATES);
+    contract->id_ = next_id_++;
+    contract->tier_ = rng_.random_int(1, CONTRACT_TIERS);
+    contract->min_level_ = 1 + (contract->tier_ - 1) * 2;
+    contract->title_ = std::string(job.objective) + " " + pick(rng_, CONTRACT_SITES);
+
+    // Harder tiers pile on more modifiers
+    int bonus = 100;
+    double modifier_chance = 0.1 + 0.05 * contract->tier_;
+    for (size_t bit = 0; bit < CONTRACT_MOD_COUNT; ++bit) {
+        if (rng_.random_bool(modifier_chance)) {
+            contract->modifiers_ |= 1u << bit;
+            bonus += CONTRACT_MODIFIERS[bit].bonus_percent;
+        }
+    }
+    contract->credits_ = job.credits * contract->tier_ * bonus / 100;
+    contract->experience_ = job.experience * contract->tier_ * bonus / 100;
+
+    // Staggered so the board turns over a few offers at a time
+    auto lifetime = std::chrono::duration_cast<std::chrono::milliseconds>(CONTRACT_LIFETIME);
+    contract->expires_ = now + lifetime / 2 +
+                         std::chrono::milliseconds(rng_.random_int(0, static_cast<int>(lifetime.count() / 2)));
+
+    std::string& line = contract->line_;
+    line = "#" + std::to_string(contract->id_) + " [tier " + std::to_string(contract->tier_) + ", level " +
+           std::to_string(contract->min_level_) + "+] " + contract->title_;
+    if (contract->modifiers_ != 0) {
+        line += " (";
+        bool first = true;
+        for (size_t bit = 0; bit < CONTRACT_MOD_COUNT; ++bit) {
+            if (contract->modifiers_ & (1u << bit)) {
+                line += first ? "" : ", ";
+                line += CONTRACT_MODIFIERS[bit].name;
+                first = false;
+            }
+        }
+        line += ")";
+    }
+    line += " - " + std::to_string(contract->credits_) + " cr, " + std::to_string(contract->experience_) + " xp";
+
+    generated_.add();
+    return contract;
+}
+
+void ContractBoard::run() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        refresh(std::chrono::steady_clock::now());
+        lock.lock();
+        wake_.wait_for(lock, CONTRACT_REFRESH_INTERVAL, [this] { return stopping_ || wake_requested_; });
+        wake_requested_ = false;
+    }
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,196 @@
+#include "copyover.hpp"
+#include "chat.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cstdio>
+
+namespace dungeon_merc {
+
+namespace {
+
+constexpr const char* COPYOVER_MAGIC = "DMCOPYOVER";
+// Version 1 predates connection ids, version 2 chat channels, version 3
+// GMCP, version 4 inventories and version 5 the admin password; all are
+// still accepted so a running older build can hand off to this one
+constexpr int COPYOVER_VERSION = 6;
+
+bool parse_class(int value, CharacterClass& cls) {
+    switch (value) {
+        case static_cast<int>(CharacterClass::SCOUT):
+        case static_cast<int>(CharacterClass::ENFORCER):
+        case static_cast<int>(CharacterClass::TECH):
+        case static_cast<int>(CharacterClass::GHOST):
+            cls = static_cast<CharacterClass>(value);
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+bool write_copyover_file(const std::string& path, const CopyoverState& state) {
+    // Write to a temporary file first so a crash never leaves a half-written handoff
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("Failed to open copyover file: " + tmp_path);
+            return false;
+        }
+        // Holds the admin password hash
+        ::chmod(tmp_path.c_str(), S_IRUSR | S_IWUSR);
+
+        out << COPYOVER_MAGIC << " " << COPYOVER_VERSION << "\n";
+        out << "server " << state.server_socket << "\n";
+        out << "next_id " << state.next_connection_id << "\n";
+        out << "admin " << (state.admin_password_hash.empty() ? "-" : state.admin_password_hash) << "\n";
+        out << "connections " << state.connections.size() << "\n";
+        for (const auto& conn : state.connections) {
+            // Player names and IPs never contain whitespace, so a space separated line is enough
+            out << conn.connection_id << " "
+                << conn.socket_fd << " "
+                << conn.client_ip << " "
+                << conn.player_name << " "
+                << static_cast<int>(conn.character_class) << " "
+                << conn.health << " "
+                << conn.max_health << " "
+                << conn.level << " "
+                << conn.experience << " "
+                << conn.room_id << " "
+                << conn.channels.size();
+            for (const auto& channel : conn.channels) {
+                out << " " << channel;
+            }
+            out << " " << (conn.gmcp ? 1 : 0) << " " << static_cast<int>(conn.gmcp_modules);
+            out << " " << conn.items.size();
+            for (const auto& stack : conn.items) {
+                out << " " << stack.item << " " << stack.count << " " << stack.mods;
+            }
+            out << "\n";
+        }
+
+        if (!out.good()) {
+            LOG_ERROR("Failed to write copyover file: " + tmp_path);
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to move copyover file into place: " + path);
+        return false;
+    }
+
+    return true;
+}
+
+bool read_copyover_file(const std::string& path, CopyoverState& state) {
+    std::ifstream in(path);
+    if (!in) {
+        LOG_ERROR("Failed to open copyover file: " + path);
+        return false;
+    }
+
+    std::string magic;
+    int version = 0;
+    if (!(in >> magic >> version) || magic != COPYOVER_MAGIC || version < 1 || version > COPYOVER_VERSION) {
+        LOG_ERROR("Unrecognized copyover file format: " + path);
+        return false;
+    }
+
+    std::string label;
+    size_t count = 0;
+    if (!(in >> label >> state.server_socket) || label != "server") {
+        LOG_ERROR("Copyover file is missing the server socket");
+        return false;
+    }
+    if (version >= 2 && (!(in >> label >> state.next_connection_id) || label != "next_id")) {
+        LOG_ERROR("Copyover file is missing the next connection id");
+        return false;
+    }
+    if (version >= 6) {
+        if (!(in >> label >> state.admin_password_hash) || label != "admin") {
+            LOG_ERROR("Copyover file is missing the admin password");
+            return false;
+        }
+        if (state.admin_password_hash == "-") {
+            state.admin_password_hash.clear();
+        }
+    }
+    if (!(in >> label >> count) || label != "connections") {
+        LOG_ERROR("Copyover file is missing the connection table");
+        return false;
+    }
+
+    state.connections.clear();
+    state.connections.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        CopyoverConnection conn;
+        int cls = 0;
+        if (version >= 2) {
+            in >> conn.connection_id;
+        } else {
+            conn.connection_id = state.next_connection_id++;
+        }
+        if (!(in >> conn.socket_fd >> conn.client_ip >> conn.player_name >> cls
+                 >> conn.health >> conn.max_health >> conn.level >> conn.experience >> conn.room_id)
+            || !parse_class(cls, conn.character_class)) {
+            LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+            return false;
+        }
+        if (version >= 3) {
+            size_t channel_count = 0;
+            if (!(in >> channel_count)) {
+                LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+                return false;
+            }
+            conn.channels.resize(channel_count);
+            for (auto& channel : conn.channels) {
+                if (!(in >> channel)) {
+                    LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+                    return false;
+                }
+            }
+        } else {
+            // Before channels were saved everyone stayed on the one they start on
+            conn.channels.push_back(GLOBAL_CHANNEL);
+        }
+        if (version >= 4) {
+            int gmcp = 0;
+            int modules = 0;
+            if (!(in >> gmcp >> modules)) {
+                LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+                return false;
+            }
+            conn.gmcp = gmcp != 0;
+            conn.gmcp_modules = static_cast<uint8_t>(modules);
+        }
+        if (version >= 5) {
+            size_t item_count = 0;
+            if (!(in >> item_count) || item_count > INVENTORY_SLOTS) {
+                LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+                return false;
+            }
+            conn.items.resize(item_count);
+            for (auto& stack : conn.items) {
+                if (!(in >> stack.item >> stack.count >> stack.mods)) {
+                    LOG_ERROR("Corrupt copyover entry " + std::to_string(i));
+                    return false;
+                }
+            }
+        }
+        state.connections.push_back(conn);
+    }
+
+    return true;
+}
+
+bool clear_close_on_exec(int fd) {
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0) {
+        return false;
+    }
+    return fcntl(fd, F_SETFD, flags & ~FD_CLOEXEC) == 0;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,73 @@
+#include "epoch.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+EpochDomain::Guard& EpochDomain::Guard::operator=(Guard&& other) noexcept {
+    if (this != &other) {
+        release();
+        domain_ = other.domain_;
+        slot_ = other.slot_;
+        other.domain_ = nullptr;
+    }
+    return *this;
+}
+
+void EpochDomain::Guard::release() {
+    if (domain_) {
+        domain_->slots_[slot_].epoch.store(0, std::memory_order_release);
+        domain_ = nullptr;
+    }
+}
+
+EpochDomain::~EpochDomain() {
+    // Nobody can be reading any more
+    for (const Retired& retired : retired_) {
+        retired.deleter(retired.object);
+    }
+}
+
+EpochDomain::Guard EpochDomain::pin() {
+    // An epoch that moves on before the slot is claimed leaves the pin older
+    // than necessary, which only delays reclamation
+    uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+    for (size_t i = 0; i < EPOCH_MAX_READERS; ++i) {
+        uint64_t expected = 0;
+        if (slots_[i].epoch.load(std::memory_order_relaxed) == 0 &&
+            slots_[i].epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst)) {
+            return Guard(this, i);
+        }
+    }
+    return Guard();
+}
+
+void EpochDomain::retire(void* object, void (*deleter)(void*)) {
+    // Readers that pin after this bump can only have loaded the replacement
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+    retired_.push_back(Retired{object, deleter, epoch});
+}
+
+size_t EpochDomain::reclaim() {
+    if (retired_.empty()) {
+        return 0;
+    }
+
+    uint64_t oldest = UINT64_MAX;
+    for (const Slot& slot : slots_) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+
+    auto keep = std::partition(retired_.begin(), retired_.end(),
+                               [oldest](const Retired& retired) { return retired.epoch >= oldest; });
+    size_t freed = static_cast<size_t>(retired_.end() - keep);
+    for (auto it = keep; it != retired_.end(); ++it) {
+        it->deleter(it->object);
+    }
+    retired_.erase(keep, retired_.end());
+    return freed;
+}
+
+} // namespace dungeon_merc
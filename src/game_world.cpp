@@ -1,55 +1,469 @@
 #include "game_world.hpp"
 #include "common.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
 
 using namespace dungeon_merc;
 
-GameWorld::GameWorld() {
+namespace {
+
+// 1234567 -> "1,234,567"
+void append_grouped(ArenaString& out, uint64_t value) {
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(value));
+    for (int i = 0; i < length; ++i) {
+        if (i > 0 && (length - i) % 3 == 0) {
+            out << ',';
+        }
+        out << digits[i];
+    }
+}
+
+// "sidearm (scope, suppressor)", "9mm rounds x24"
+void append_stack(ArenaString& out, const ItemTemplate& item, const ItemStack& stack) {
+    out << item.name;
+    if (item.max_stack > 1) {
+        out << " x" << static_cast<int>(stack.count);
+    }
+    if (stack.mods != 0) {
+        out << " (";
+        bool first = true;
+        for (size_t bit = 0; bit < ITEM_MOD_COUNT; ++bit) {
+            if (stack.mods & (1u << bit)) {
+                out << (first ? "" : ", ") << item_mod_name(bit);
+                first = false;
+            }
+        }
+        out << ')';
+    }
+}
+
+// What trigger scripts see: the acting player (if any) and the room the
+// trigger belongs to. "$n" in text becomes the actor's name.
+class WorldScriptHost : public ScriptHost {
+public:
+    WorldScriptHost(GameWorld& world, PlayerId actor, Room* room, ArenaString* out)
+        : world_(world), actor_id_(actor), actor_(world.get_player(actor)), room_(room), out_(out) {}
+
+    int32_t get(ScriptBuiltin builtin) override {
+        switch (builtin) {
+            case ScriptBuiltin::LEVEL: return actor_ ? actor_->get_level() : 0;
+            case ScriptBuiltin::HEALTH: return actor_ ? actor_->get_health() : 0;
+            case ScriptBuiltin::MAX_HEALTH: return actor_ ? actor_->get_max_health() : 0;
+            case ScriptBuiltin::XP: return actor_ ? actor_->get_experience() : 0;
+            case ScriptBuiltin::ROOM: return room_ ? room_->get_id() : 0;
+            case ScriptBuiltin::PLAYERS: return room_ ? static_cast<int32_t>(room_->get_players().size()) : 0;
+            case ScriptBuiltin::CLASS: return actor_ ? static_cast<int32_t>(actor_->get_character_class()) : -1;
+        }
+        return 0;
+    }
+
+    void send(std::string_view text) override {
+        // Without an actor (timers) there is nobody to reply to, so tell the room
+        if (!out_ || !actor_) {
+            echo(text);
+            return;
+        }
+        if (!out_->empty()) {
+            *out_ << '\n';
+        }
+        expand(*out_, text);
+    }
+
+    void echo(std::string_view text) override {
+        if (!room_) {
+            return;
+        }
+        ArenaString line(tick_arena());
+        expand(line, text);
+        world_.get_chat().post_room_notice(room_->get_id(), actor_id_, line.view());
+    }
+
+    void heal(int32_t amount) override {
+        if (actor_) actor_->heal(amount);
+    }
+
+    void damage(int32_t amount) override {
+        if (actor_) actor_->take_damage(amount);
+    }
+
+    void add_experience(int32_t amount) override {
+        if (actor_) actor_->gain_experience(amount);
+    }
+
+    void teleport(int32_t room_id) override {
+        if (actor_) world_.place_player(actor_id_, room_id);
+    }
+
+    void loot(std::string_view table) override {
+        // Loot goes into a pack, so timers (no actor) have nobody to give it to
+        if (!actor_ || !out_) {
+            return;
+        }
+        if (!out_->empty()) {
+            *out_ << '\n';
+        }
+        if (!world_.grant_loot(actor_id_, table, RandomGenerator::get_instance(), *out_)) {
+            LOG_WARNING("Trigger in room " + std::to_string(room_ ? room_->get_id() : 0) +
+                        " rolls unknown loot table " + std::string(table));
+        }
+    }
+
+private:
+    GameWorld& world_;
+    PlayerId actor_id_;
+    Player* actor_;
+    Room* room_;
+    ArenaString* out_;
+
+    void expand(ArenaString& out, std::string_view text) const {
+        size_t pos;
+        while ((pos = text.find("$n")) != std::string_view::npos) {
+            out << text.substr(0, pos) << (actor_ ? std::string_view(actor_->get_name()) : "someone");
+            text.remove_prefix(pos + 2);
+        }
+        out << text;
+    }
+};
+
+} // namespace
+
+GameWorld::GameWorld()
+    : chat_(*this) {
     initialize_world();
 }
 
 void GameWorld::add_room(std::shared_ptr<Room> room) {
+    // A hand-placed room outlives its region, so the region forgets it
+    auto region = regions_.find(region_of(room->get_id()));
+    if (region != regions_.end()) {
+        auto& ids = region->second.rooms;
+        ids.erase(std::remove_if(ids.begin(), ids.end(),
+                                 [&room](const std::pair<int, uint32_t>& entry) { return entry.first == room->get_id(); }),
+                  ids.end());
+    }
+    install_room(room);
+}
+
+void GameWorld::install_room(const std::shared_ptr<Room>& room) {
+    auto it = std::lower_bound(room_order_.begin(), room_order_.end(), room->get_id(),
+                               [](const Room* r, int id) { return r->get_id() < id; });
+    if (it != room_order_.end() && (*it)->get_id() == room->get_id()) {
+        *it = room.get();
+    } else {
+        room_order_.insert(it, room.get());
+    }
     rooms_[room->get_id()] = room;
 }
 
+void GameWorld::uninstall_room(int room_id) {
+    auto it = std::lower_bound(room_order_.begin(), room_order_.end(), room_id,
+                               [](const Room* r, int id) { return r->get_id() < id; });
+    if (it != room_order_.end() && (*it)->get_id() == room_id) {
+        room_order_.erase(it);
+    }
+    rooms_.erase(room_id);
+}
+
 std::shared_ptr<Room> GameWorld::get_room(int room_id) const {
     auto it = rooms_.find(room_id);
     return (it != rooms_.end()) ? it->second : nullptr;
 }
 
-std::shared_ptr<Room> GameWorld::get_player_room(std::shared_ptr<Player> player) const {
-    auto it = player_locations_.find(player);
-    if (it == player_locations_.end()) {
+std::shared_ptr<Room> GameWorld::get_player_room(PlayerId player) const {
+    const Player* p = players_.get(player);
+    return p ? get_room(p->get_current_room_id()) : nullptr;
+}
+
+Room* GameWorld::find_room(int room_id) const {
+    auto it = rooms_.find(room_id);
+    return (it != rooms_.end()) ? it->second.get() : nullptr;
+}
+
+Room* GameWorld::find_player_room(PlayerId player) const {
+    const Player* p = players_.get(player);
+    return p ? find_room(p->get_current_room_id()) : nullptr;
+}
+
+Room* GameWorld::load_room(int room_id) {
+    if (Room* room = find_room(room_id)) {
+        return room;
+    }
+    if (!is_local_room(room_id) || !load_region(region_of(room_id))) {
         return nullptr;
     }
-    return get_room(it->second);
+    return find_room(room_id);
 }
 
-void GameWorld::add_player(std::shared_ptr<Player> player, int starting_room_id) {
+bool GameWorld::load_region(int region) {
+    static Counter& loads = MetricsRegistry::get_instance().counter("world.region_loads");
+
+    auto existing = regions_.find(region);
+    if (existing != regions_.end() && existing->second.resident) {
+        return true;
+    }
+
+    std::vector<std::shared_ptr<Room>> rooms;
+    if (!region_source_ || !region_source_->load_region(region, rooms)) {
+        return false;
+    }
+
+    TRACE_SCOPE("world.load_region");
+    Region& entry = regions_[region];
+    std::vector<std::pair<int, uint32_t>> saved;
+    saved.swap(entry.rooms);
+    entry.bytes = 0;
+    for (const auto& room : rooms) {
+        if (rooms_.count(room->get_id()) != 0) {
+            continue;  // A room added by hand takes precedence
+        }
+        for (const auto& previous : saved) {
+            if (previous.first == room->get_id()) {
+                room->resume_players_version(previous.second);
+                break;
+            }
+        }
+        entry.rooms.emplace_back(room->get_id(), room->get_players_version());
+        entry.bytes += room->get_memory_usage();
+        install_room(room);
+    }
+    entry.resident = true;
+    entry.last_active = std::chrono::steady_clock::now();
+    resident_bytes_ += entry.bytes;
+    ++resident_regions_;
+    loads.add();
+    over_budget_ = over_budget_ || (region_budget_ != 0 && resident_bytes_ > region_budget_);
+
+    // Going over budget is dealt with between ticks by evict_idle_regions(),
+    // never here: callers up the stack, such as a trigger that teleports,
+    // may still hold rooms of a region that just emptied
+    return true;
+}
+
+bool GameWorld::is_region_occupied(const Region& entry) const {
+    for (const auto& room : entry.rooms) {
+        Room* resident = find_room(room.first);
+        if (resident && !resident->get_players().empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GameWorld::evict_region(Region& entry) {
+    static Counter& evictions = MetricsRegistry::get_instance().counter("world.region_evictions");
+
+    // Rooms hold no state besides their occupants (none) and the players
+    // version, so the version is all there is to persist
+    for (auto& room : entry.rooms) {
+        if (Room* resident = find_room(room.first)) {
+            room.second = resident->get_players_version();
+        }
+        uninstall_room(room.first);
+    }
+    entry.resident = false;
+    resident_bytes_ -= entry.bytes;
+    entry.bytes = 0;
+    --resident_regions_;
+    evictions.add();
+}
+
+void GameWorld::evict_idle_regions(std::chrono::steady_clock::time_point now) {
+    static Gauge& regions_gauge = MetricsRegistry::get_instance().gauge("world.regions_resident");
+    static Gauge& bytes_gauge = MetricsRegistry::get_instance().gauge("world.resident_bytes");
+
+    TRACE_SCOPE("world.evict_regions");
+    over_budget_ = false;
+    std::vector<std::pair<std::chrono::steady_clock::time_point, int>> candidates;
+    for (auto& [region, entry] : regions_) {
+        if (!entry.resident) {
+            continue;
+        }
+        // Timer triggers only run in occupied rooms, so occupancy covers them too
+        if (is_region_occupied(entry)) {
+            entry.last_active = now;
+        } else if (now - entry.last_active >= region_idle_timeout_) {
+            evict_region(entry);
+        } else {
+            candidates.emplace_back(entry.last_active, region);
+        }
+    }
+
+    if (region_budget_ != 0 && resident_bytes_ > region_budget_) {
+        std::sort(candidates.begin(), candidates.end());
+        for (const auto& candidate : candidates) {
+            if (resident_bytes_ <= region_budget_) {
+                break;
+            }
+            evict_region(regions_[candidate.second]);
+        }
+    }
+
+    regions_gauge.set(static_cast<int64_t>(resident_regions_));
+    bytes_gauge.set(static_cast<int64_t>(resident_bytes_));
+}
+
+void GameWorld::set_region_source(std::unique_ptr<RegionSource> source) {
+    for (auto& [region, entry] : regions_) {
+        for (const auto& room : entry.rooms) {
+            uninstall_room(room.first);
+        }
+    }
+    regions_.clear();
+    resident_regions_ = 0;
+    resident_bytes_ = 0;
+    region_source_ = std::move(source);
+    load_room(1);
+}
+
+void GameWorld::set_region_limits(size_t budget_bytes, std::chrono::seconds idle_timeout) {
+    region_budget_ = budget_bytes;
+    region_idle_timeout_ = idle_timeout;
+}
+
+PlayerId GameWorld::create_player(const std::string& name, CharacterClass character_class, int starting_room_id) {
     if (!is_valid_room_id(starting_room_id)) {
         starting_room_id = 1; // Default to room 1 if invalid
     }
 
-    player_locations_[player] = starting_room_id;
+    PlayerId id = players_.create(name, character_class);
+    Player* player = players_.get(id);
+    player->set_current_room_id(starting_room_id);
+    directory_.add(id, *player);
+    player->set_observer(this);
+    leaderboard_.update(player->get_name(), player->get_level(), player->get_experience());
 
-    auto room = get_room(starting_room_id);
+    Room* room = load_room(starting_room_id);
     if (room) {
-        room->add_player(player);
+        room->add_player(id);
     }
+
+    chat_.join(id, GLOBAL_CHANNEL);
+    return id;
 }
 
-void GameWorld::remove_player(std::shared_ptr<Player> player) {
-    auto current_room = get_player_room(player);
+void GameWorld::remove_player(PlayerId player) {
+    Room* current_room = find_player_room(player);
     if (current_room) {
         current_room->remove_player(player);
     }
 
-    player_locations_.erase(player);
+    chat_.remove_player(player);
+    inventories_.clear(player.index);
+    if (player.index < active_contracts_.size()) {
+        active_contracts_[player.index].reset();
+    }
+    if (Player* p = players_.get(player)) {
+        directory_.remove(player, *p);
+        p->set_observer(nullptr);
+        snapshot_builder_.note_removed(player);
+    }
+    players_.destroy(player);
+}
+
+bool GameWorld::place_player(PlayerId player, int room_id) {
+    Player* p = players_.get(player);
+    if (!p || !is_valid_room_id(room_id)) {
+        return false;
+    }
+    // Rooms another zone server hosts are never entered here
+    bool local = is_local_room(room_id);
+    Room* target_room = local ? load_room(room_id) : nullptr;
+    if (local && !target_room) {
+        return false;
+    }
+
+    if (Room* current_room = find_room(p->get_current_room_id())) {
+        current_room->remove_player(player);
+    }
+    p->set_current_room_id(room_id);
+    if (!target_room) {
+        departures_.push_back(player);
+        return true;
+    }
+    target_room->add_player(player);
+    return true;
+}
+
+void GameWorld::set_zone(const ZoneMap& map, int zone) {
+    zone_map_ = map;
+    zone_ = zone;
+}
+
+void GameWorld::take_departures(std::vector<PlayerId>& departures) {
+    departures.clear();
+    departures.swap(departures_);
+}
+
+bool GameWorld::load_triggers(const std::string& path, std::string& error) {
+    if (!triggers_.load_file(path, error)) {
+        return false;
+    }
+    LOG_INFO("Loaded " + std::to_string(triggers_.size()) + " triggers from " + path);
+    return true;
+}
+
+ScriptResult GameWorld::fire_trigger(const Trigger& trigger, PlayerId actor, ArenaString* out) {
+    static Counter& runs = MetricsRegistry::get_instance().counter("script.runs");
+    static Counter& instructions = MetricsRegistry::get_instance().counter("script.instructions");
+    static Counter& aborted = MetricsRegistry::get_instance().counter("script.aborted");
+
+    WorldScriptHost host(*this, actor, find_room(trigger.room_id), out);
+    ScriptResult result = run_script(trigger.script, host, trigger.budget);
+    runs.add();
+    instructions.add(result.instructions);
+
+    if (result.budget_exceeded || result.failed) {
+        aborted.add();
+        // Report each broken trigger once rather than every time it fires
+        if (trigger.failures++ == 0) {
+            LOG_WARNING("Trigger at " + trigger.location +
+                        (result.failed ? " failed (division by zero)" : " ran out of instruction budget"));
+        }
+    }
+    return result;
+}
+
+bool GameWorld::fire_room_triggers(TriggerEvent event, int room_id, PlayerId actor, std::string_view argument,
+                                   ArenaString& out) {
+    bool blocked = false;
+    triggers_.for_each(room_id, event, [&](const Trigger& trigger) {
+        if (!blocked && (trigger.argument.empty() || trigger.argument == argument)) {
+            blocked = fire_trigger(trigger, actor, &out).blocked;
+        }
+    });
+    return blocked;
 }
 
-bool GameWorld::move_player(std::shared_ptr<Player> player, Direction direction) {
-    auto current_room = get_player_room(player);
+bool GameWorld::run_command_triggers(PlayerId player, std::string_view verb, ArenaString& out) {
+    const Player* p = players_.get(player);
+    if (!p || triggers_.empty()) {
+        return false;
+    }
+    return fire_room_triggers(TriggerEvent::COMMAND, p->get_current_room_id(), player, verb, out);
+}
+
+void GameWorld::run_timers(TriggerClock::time_point now) {
+    if (triggers_.empty()) {
+        return;
+    }
+
+    TRACE_SCOPE("world.timers");
+    triggers_.run_due_timers(now, [this](const Trigger& trigger) {
+        // Nobody to see it, so don't spend the instructions
+        Room* room = find_room(trigger.room_id);
+        if (room && !room->get_players().empty()) {
+            fire_trigger(trigger, PlayerId{}, nullptr);
+        }
+    });
+}
+
+bool GameWorld::move_player(PlayerId player, Direction direction) {
+    Player* p = players_.get(player);
+    Room* current_room = p ? find_room(p->get_current_room_id()) : nullptr;
     if (!current_room) {
         return false;
     }
@@ -59,131 +473,411 @@ bool GameWorld::move_player(std::shared_ptr<Player> player, Direction direction)
     }
 
     int target_room_id = current_room->get_exit_room_id(direction);
-    auto target_room = get_room(target_room_id);
-    if (!target_room) {
+    if (!is_valid_room_id(target_room_id)) {
+        return false;
+    }
+    bool local = is_local_room(target_room_id);
+    Room* target_room = local ? load_room(target_room_id) : nullptr;
+    if (local && !target_room) {
         return false;
     }
 
     // Remove player from current room
     current_room->remove_player(player);
 
+    if (!target_room) {
+        // Another zone server takes it from here
+        p->set_current_room_id(target_room_id);
+        departures_.push_back(player);
+        return true;
+    }
+
     // Add player to new room
     target_room->add_player(player);
-    player_locations_[player] = target_room_id;
+    p->set_current_room_id(target_room_id);
 
     return true;
 }
 
-std::string GameWorld::handle_look_command(std::shared_ptr<Player> player) {
-    auto room = get_player_room(player);
+void GameWorld::handle_look_command(PlayerId player, ArenaString& out) {
+    TRACE_SCOPE("world.look");
+    Room* room = find_player_room(player);
     if (!room) {
-        return "You are lost in the void...";
+        out << "You are lost in the void...";
+        return;
     }
 
-    return room->get_full_description();
+    // Nobody came or went since the last publish, so its text is still right
+    if (const RoomView* view = current_room_view(*room)) {
+        out << view->description;
+        return;
+    }
+    room->render_description(out, players_);
 }
 
-std::string GameWorld::handle_move_command(std::shared_ptr<Player> player, const std::string& direction) {
-    if (!is_valid_direction(direction)) {
-        return "You can't go that way. Try: north, south, east, west, up, down";
+void GameWorld::handle_move_command(PlayerId player, std::string_view direction, ArenaString& out) {
+    TRACE_SCOPE("world.move");
+    Direction dir;
+    if (!parse_direction(direction, dir)) {
+        out << "You can't go that way. Try: north, south, east, west, up, down";
+        return;
     }
 
-    Direction dir = string_to_direction(direction);
-    auto current_room = get_player_room(player);
+    Room* current_room = find_player_room(player);
 
     if (!current_room) {
-        return "You are lost in the void...";
+        out << "You are lost in the void...";
+        return;
     }
 
     if (!current_room->has_exit(dir)) {
-        return "There is no exit in that direction.";
+        out << "There is no exit in that direction.";
+        return;
+    }
+
+    if (!triggers_.empty()) {
+        if (fire_room_triggers(TriggerEvent::EXIT, current_room->get_id(), player, direction_name(dir), out)) {
+            if (out.empty()) {
+                out << "Something stops you from going that way.";
+            }
+            return;
+        }
+        // A script may have moved the player somewhere else already
+        if (find_player_room(player) != current_room) {
+            return;
+        }
     }
 
     if (move_player(player, dir)) {
-        auto new_room = get_player_room(player);
-        return "You move " + direction_to_string(dir) + ".\n\n" + new_room->get_full_description();
+        if (!out.empty()) {
+            out << '\n';
+        }
+        out << "You move " << direction_name(dir) << '.';
+        // Across a zone boundary the next zone server describes the room
+        if (is_local_room(players_.get(player)->get_current_room_id())) {
+            out << "\n\n";
+            handle_arrival(player, out);
+        }
+        return;
     }
 
-    return "You can't go that way.";
+    out << "You can't go that way.";
 }
 
-std::string GameWorld::handle_players_command(std::shared_ptr<Player> player) {
-    auto room = get_player_room(player);
+void GameWorld::handle_arrival(PlayerId player, ArenaString& out) {
+    Room* room = find_player_room(player);
     if (!room) {
-        return "You are lost in the void...";
+        out << "You are lost in the void...";
+        return;
     }
 
-    const auto& players = room->get_players();
-    if (players.empty()) {
-        return "You are alone here.";
+    room->render_description(out, players_);
+    if (!triggers_.empty()) {
+        fire_room_triggers(TriggerEvent::ENTER, room->get_id(), player, {}, out);
     }
+}
 
-    std::stringstream ss;
-    ss << "Players in this room: ";
-    for (size_t i = 0; i < players.size(); ++i) {
-        if (i > 0) ss << ", ";
-        ss << players[i]->get_name();
+void GameWorld::handle_who_command(const WhoFilter& filter, ArenaString& out) {
+    TRACE_SCOPE("world.who");
+    const WorldSnapshot* snapshot = snapshot_.peek();
+    if (snapshot && snapshot->get_directory_version() == directory_.get_version()) {
+        snapshot->render_who(filter, out);
+        return;
     }
 
-    return ss.str();
+    out << "Mercs online: " << static_cast<uint64_t>(directory_.size());
+
+    size_t shown = 0;
+    bool truncated = false;
+    directory_.for_each_who(filter, [&](PlayerId, const Player& player) {
+        if (shown == WHO_PAGE_SIZE) {
+            truncated = true;
+            return false;
+        }
+        out << "\n  [" << player.get_level() << ' ' << class_to_string(player.get_character_class())
+            << "] " << player.get_name();
+        ++shown;
+        return true;
+    });
+
+    if (shown == 0) {
+        out << "\nNobody matches.";
+    } else if (truncated) {
+        out << "\n  ...and more. Narrow it down with 'who <class> <level>'.";
+    }
 }
 
-void GameWorld::initialize_world() {
-    create_starting_areas();
+void GameWorld::handle_finger_command(std::string_view name, ArenaString& out) {
+    TRACE_SCOPE("world.finger");
+    const Player* player = players_.get(directory_.find(name));
+    if (!player) {
+        out << "No player named " << name << " is online.";
+        return;
+    }
+
+    out << player->get_name() << ", level " << player->get_level() << ' '
+        << class_to_string(player->get_character_class());
+    const Room* room = find_room(player->get_current_room_id());
+    if (room) {
+        out << ", last seen in " << room->get_name();
+    }
+    out << '.';
 }
 
-bool GameWorld::is_valid_room_id(int room_id) const {
-    return rooms_.find(room_id) != rooms_.end();
+void GameWorld::handle_players_command(PlayerId player, ArenaString& out) {
+    TRACE_SCOPE("world.players");
+    Room* room = find_player_room(player);
+    if (!room) {
+        out << "You are lost in the void...";
+        return;
+    }
+
+    if (const RoomView* view = current_room_view(*room)) {
+        out << view->occupants;
+        return;
+    }
+    room->render_occupants(out, players_);
 }
 
-std::string GameWorld::get_room_list() const {
-    std::stringstream ss;
-    ss << "Available rooms:\n";
-    for (const auto& room_pair : rooms_) {
-        ss << "  " << room_pair.first << ": " << room_pair.second->get_name() << "\n";
+void GameWorld::handle_status_command(PlayerId player, ArenaString& out) {
+    const Player* p = players_.get(player);
+    if (!p) {
+        out << "You are lost in the void...";
+        return;
     }
-    return ss.str();
+    render_status(*p, out);
+}
+
+void GameWorld::handle_rank_command(PlayerId player, std::string_view name, ArenaString& out) {
+    TRACE_SCOPE("world.rank");
+    const Player* self = players_.get(player);
+    if (name.empty()) {
+        if (!self) {
+            out << "Rank whom?";
+            return;
+        }
+        name = self->get_name();
+    }
+
+    size_t rank = leaderboard_.rank_of(name);
+    const Leaderboard::Entry* entry = leaderboard_.find(name);
+    if (rank == 0 || !entry) {
+        out << "Nobody named " << name << " is on the leaderboard.";
+        return;
+    }
+
+    if (self && iequals(name, self->get_name())) {
+        out << "You are";
+    } else {
+        out << entry->name << " is";
+    }
+    out << " #";
+    append_grouped(out, rank);
+    out << " of ";
+    append_grouped(out, leaderboard_.size());
+    out << " (level " << entry->level << ", " << entry->experience << " xp).";
+}
+
+void GameWorld::handle_top_command(size_t page, ArenaString& out) {
+    TRACE_SCOPE("world.top");
+    size_t pages = (leaderboard_.size() + LEADERBOARD_PAGE_SIZE - 1) / LEADERBOARD_PAGE_SIZE;
+    if (pages == 0) {
+        out << "Nobody is on the leaderboard yet.";
+        return;
+    }
+    if (page == 0 || page > pages) {
+        out << "Pages run from 1 to " << static_cast<uint64_t>(pages) << '.';
+        return;
+    }
+
+    out << "Top mercs, page " << static_cast<uint64_t>(page) << " of " << static_cast<uint64_t>(pages) << ':';
+    leaderboard_.for_each_page((page - 1) * LEADERBOARD_PAGE_SIZE, LEADERBOARD_PAGE_SIZE,
+                               [&out](size_t rank, const Leaderboard::Entry& entry) {
+        out << "\n  #";
+        append_grouped(out, rank);
+        out << ' ' << entry.name << " - level " << entry.level << ", " << entry.experience << " xp";
+    });
 }
 
-void GameWorld::create_starting_areas() {
-    // Create a simple starting area with a few connected rooms
+void GameWorld::handle_inventory_command(PlayerId player, ArenaString& out) {
+    TRACE_SCOPE("world.inventory");
+    size_t used = players_.get(player) ? inventories_.used(player.index) : 0;
+    if (used == 0) {
+        out << "You are carrying nothing.";
+        return;
+    }
 
-    // Room 1: Town Square
-    auto town_square = std::make_shared<Room>(1, "Town Square",
-        "You stand in the bustling town square of Dungeon Merc. The cobblestone streets are worn smooth by countless adventurers who have passed through here. A fountain bubbles in the center, and you can see various shops and inns lining the square.");
-    add_room(town_square);
+    const ItemStack* stacks = inventories_.slots(player.index);
+    out << "You are carrying:";
+    for (size_t slot = 0; slot < used; ++slot) {
+        if (const ItemTemplate* item = items_.get(stacks[slot].item)) {
+            out << "\n  ";
+            append_stack(out, *item, stacks[slot]);
+        }
+    }
+    out << "\n(" << static_cast<uint64_t>(used) << " of " << static_cast<uint64_t>(INVENTORY_SLOTS)
+        << " slots used)";
+}
 
-    // Room 2: Tavern
-    auto tavern = std::make_shared<Room>(2, "The Rusty Sword Tavern",
-        "The warm glow of candlelight fills this cozy tavern. The air is thick with the smell of ale and roasted meat. Adventurers gather here to share tales of their exploits and plan their next dungeon dive.");
-    add_room(tavern);
+void GameWorld::handle_contracts_command(PlayerId player, ArenaString& out) {
+    TRACE_SCOPE("world.contracts");
+    // Every line was rendered by the generator; this only copies them
+    auto board = contracts_.read();
+    size_t shown = 0;
+    if (board) {
+        for (const auto& offer : board->offers) {
+            if (offer->is_claimed()) {
+                continue;
+            }
+            out << (shown == 0 ? "Contracts on offer:" : "") << "\n  " << offer->get_line();
+            ++shown;
+        }
+    }
+    if (shown == 0) {
+        out << "The contract board is empty. Check back soon.";
+    }
 
-    // Room 3: Blacksmith
-    auto blacksmith = std::make_shared<Room>(3, "Ironforge Blacksmith",
-        "The clang of hammer on anvil echoes through this workshop. The blacksmith's forge glows red-hot, and weapons and armor of all kinds hang from the walls. The air is thick with the smell of burning coal and hot metal.");
-    add_room(blacksmith);
+    if (player.index < active_contracts_.size() && active_contracts_[player.index]) {
+        out << "\nYour contract: " << active_contracts_[player.index]->get_line();
+    } else if (shown > 0) {
+        out << "\nTake one with 'claim <number>'.";
+    }
+}
 
-    // Room 4: Dungeon Entrance
-    auto dungeon_entrance = std::make_shared<Room>(4, "Dungeon Entrance",
-        "A dark opening in the earth yawns before you. Ancient stone steps lead down into the depths, and a cold breeze carries the scent of damp earth and mystery from below. This is where the real adventure begins.");
-    add_room(dungeon_entrance);
+void GameWorld::handle_claim_command(PlayerId player, uint32_t contract_id, ArenaString& out) {
+    TRACE_SCOPE("world.claim");
+    const Player* p = players_.get(player);
+    if (!p) {
+        out << "You are lost in the void...";
+        return;
+    }
+    if (player.index < active_contracts_.size() && active_contracts_[player.index]) {
+        out << "You already have a contract: " << active_contracts_[player.index]->get_title() << '.';
+        return;
+    }
 
-    // Room 5: First Dungeon Chamber
-    auto dungeon_chamber = std::make_shared<Room>(5, "Ancient Chamber",
-        "You find yourself in a large, circular chamber carved from solid stone. Torches flicker on the walls, casting dancing shadows. Ancient runes are carved into the walls, telling tales of forgotten heroes and lost treasures.");
-    add_room(dungeon_chamber);
+    std::shared_ptr<const Contract> contract;
+    switch (contracts_.claim(contract_id, p->get_level(), contract)) {
+        case ContractClaim::CLAIMED:
+            if (player.index >= active_contracts_.size()) {
+                active_contracts_.resize(player.index + 1);
+            }
+            active_contracts_[player.index] = contract;
+            out << "You take contract #" << static_cast<uint64_t>(contract_id) << ": " << contract->get_title() << '.';
+            break;
+        case ContractClaim::TAKEN:
+            out << "Someone beat you to contract #" << static_cast<uint64_t>(contract_id) << '.';
+            break;
+        case ContractClaim::UNDER_LEVEL:
+            out << "The fixer looks you over. 'Come back when you have more experience.'";
+            break;
+        case ContractClaim::NOT_FOUND:
+            out << "There is no contract #" << static_cast<uint64_t>(contract_id) << " on the board.";
+            break;
+    }
+}
 
-    // Connect the rooms
-    town_square->add_exit(Direction::NORTH, 2);  // To tavern
-    town_square->add_exit(Direction::EAST, 3);   // To blacksmith
-    town_square->add_exit(Direction::SOUTH, 4);  // To dungeon entrance
+void GameWorld::handle_abandon_command(PlayerId player, ArenaString& out) {
+    TRACE_SCOPE("world.abandon");
+    if (player.index >= active_contracts_.size() || !active_contracts_[player.index]) {
+        out << "You have no contract to abandon.";
+        return;
+    }
+    // The offer left the board when it was claimed, so nobody else can take it up
+    out << "You walk away from " << active_contracts_[player.index]->get_title() << ". The fixer won't pay for it.";
+    active_contracts_[player.index].reset();
+}
 
-    tavern->add_exit(Direction::SOUTH, 1);       // Back to town square
+bool GameWorld::grant_loot(PlayerId player, std::string_view table, RandomGenerator& rng, ArenaString& out) {
+    const LootTable* loot = items_.find_loot_table(table);
+    if (!loot || !players_.get(player)) {
+        return false;
+    }
+
+    ItemStack stack = loot->roll_stack(rng);
+    const ItemTemplate* item = items_.get(stack.item);
+    if (!item || stack.count == 0) {
+        out << "You find nothing of use.";
+        return true;
+    }
 
-    blacksmith->add_exit(Direction::WEST, 1);    // Back to town square
+    uint16_t added = inventories_.add(player.index, *item, stack.count, stack.mods);
+    if (added == 0) {
+        out << "Your pack is full; you leave the ";
+        append_stack(out, *item, stack);
+        out << " behind.";
+        return true;
+    }
+    out << "You find ";
+    append_stack(out, *item, stack);
+    if (added < stack.count) {
+        out << ", but only " << static_cast<int>(added) << " fit in your pack";
+    }
+    out << '.';
+    return true;
+}
 
-    dungeon_entrance->add_exit(Direction::NORTH, 1);  // Back to town square
-    dungeon_entrance->add_exit(Direction::DOWN, 5);   // To dungeon chamber
+void GameWorld::copy_inventory(PlayerId player, std::vector<ItemStack>& items) const {
+    items.clear();
+    if (!players_.get(player)) {
+        return;
+    }
+    const ItemStack* stacks = inventories_.slots(player.index);
+    items.assign(stacks, stacks + inventories_.used(player.index));
+}
 
-    dungeon_chamber->add_exit(Direction::UP, 4);      // Back to dungeon entrance
+void GameWorld::restore_inventory(PlayerId player, const std::vector<ItemStack>& items) {
+    if (!players_.get(player)) {
+        return;
+    }
+    inventories_.clear(player.index);
+    for (const auto& stack : items) {
+        const ItemTemplate* item = items_.get(stack.item);
+        if (!item) {
+            LOG_WARNING("Dropping unknown item " + std::to_string(stack.item) + " from " +
+                        players_.get(player)->get_name() + "'s pack");
+            continue;
+        }
+        inventories_.add(player.index, *item, stack.count, stack.mods);
+    }
+}
+
+void GameWorld::on_level_changed(const Player& player, int old_level) {
+    directory_.on_level_changed(player, old_level);
+}
+
+void GameWorld::on_progress_changed(const Player& player) {
+    leaderboard_.update(player.get_name(), player.get_level(), player.get_experience());
+}
+
+void GameWorld::publish_snapshot() {
+    std::unique_ptr<const WorldSnapshot> next = snapshot_builder_.build(room_order_, players_, directory_,
+                                                                        snapshot_.peek());
+    if (next) {
+        snapshot_.publish(std::move(next));
+    }
+}
+
+const RoomView* GameWorld::current_room_view(const Room& room) const {
+    // Only the simulation thread gets here, and it is the one that publishes
+    const WorldSnapshot* snapshot = snapshot_.peek();
+    const RoomView* view = snapshot ? snapshot->find_room(room.get_id()) : nullptr;
+    return (view && view->players_version == room.get_players_version()) ? view : nullptr;
+}
+
+void GameWorld::initialize_world() {
+    set_region_source(std::make_unique<WorldGenerator>());
+}
+
+bool GameWorld::is_valid_room_id(int room_id) const {
+    return rooms_.find(room_id) != rooms_.end() || (region_source_ && region_source_->has_room(room_id));
+}
+
+std::string GameWorld::get_room_list() const {
+    std::stringstream ss;
+    ss << "Available rooms:\n";
+    for (const auto& room_pair : rooms_) {
+        ss << "  " << room_pair.first << ": " << room_pair.second->get_name() << "\n";
+    }
+    return ss.str();
 }
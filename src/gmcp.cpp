@@ -0,0 +1,326 @@
+#include "gmcp.hpp"
+#include "player.hpp"
+#include "room.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+namespace {
+
+bool id_less(PlayerId a, PlayerId b) {
+    return a.index != b.index ? a.index < b.index : a.generation < b.generation;
+}
+
+std::string_view exit_key(Direction dir) {
+    switch (dir) {
+        case Direction::NORTH: return "n";
+        case Direction::SOUTH: return "s";
+        case Direction::EAST: return "e";
+        case Direction::WEST: return "w";
+        case Direction::UP: return "u";
+        case Direction::DOWN: return "d";
+    }
+    return "?";
+}
+
+uint8_t parse_module(std::string_view entry) {
+    // Entries look like "Char 1"; removals may leave off the version
+    std::string_view name = entry.substr(0, entry.find(' '));
+    if (iequals(name, "Char")) {
+        return GMCP_CHAR;
+    }
+    if (iequals(name, "Room")) {
+        return GMCP_ROOM;
+    }
+    return 0;
+}
+
+// Modules named in a JSON array of strings such as ["Char 1", "Room 1"]
+uint8_t parse_module_list(std::string_view json) {
+    uint8_t modules = 0;
+    size_t pos = 0;
+    while ((pos = json.find('"', pos)) != std::string_view::npos) {
+        size_t end = json.find('"', pos + 1);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        modules |= parse_module(json.substr(pos + 1, end - pos - 1));
+        pos = end + 1;
+    }
+    return modules;
+}
+
+void append_field(ArenaString& json, std::string_view key, int value) {
+    json << (json.size() > 1 ? "," : "") << '"' << key << "\":" << value;
+}
+
+} // namespace
+
+size_t TelnetFilter::filter(char* data, size_t size, TelnetOptionHandler& handler) {
+    size_t kept = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint8_t byte = static_cast<uint8_t>(data[i]);
+        switch (state_) {
+            case State::DATA:
+                if (byte == telnet::IAC) {
+                    state_ = State::IAC;
+                } else {
+                    data[kept++] = data[i];
+                }
+                break;
+
+            case State::IAC:
+                if (byte == telnet::IAC) {
+                    // Escaped 0xFF data byte
+                    data[kept++] = data[i];
+                    state_ = State::DATA;
+                } else if (byte >= telnet::WILL && byte <= telnet::DONT) {
+                    command_ = byte;
+                    state_ = State::OPTION;
+                } else if (byte == telnet::SB) {
+                    subnegotiation_.clear();
+                    state_ = State::SUBNEGOTIATION;
+                } else {
+                    // NOP, GA, AYT and friends carry nothing we act on
+                    state_ = State::DATA;
+                }
+                break;
+
+            case State::OPTION:
+                handler.on_option(command_, byte);
+                state_ = State::DATA;
+                break;
+
+            case State::SUBNEGOTIATION:
+                if (byte == telnet::IAC) {
+                    state_ = State::SUBNEGOTIATION_IAC;
+                } else if (subnegotiation_.size() < TELNET_SUBNEGOTIATION_LIMIT) {
+                    subnegotiation_.push_back(data[i]);
+                }
+                break;
+
+            case State::SUBNEGOTIATION_IAC:
+                if (byte == telnet::SE) {
+                    // The first byte is the option; oversized payloads were truncated, so drop them
+                    if (!subnegotiation_.empty() && subnegotiation_.size() < TELNET_SUBNEGOTIATION_LIMIT) {
+                        std::string_view payload(subnegotiation_);
+                        handler.on_subnegotiation(static_cast<uint8_t>(payload[0]), payload.substr(1));
+                    }
+                    state_ = State::DATA;
+                } else {
+                    if (byte == telnet::IAC && subnegotiation_.size() < TELNET_SUBNEGOTIATION_LIMIT) {
+                        subnegotiation_.push_back(data[i]);
+                    }
+                    state_ = State::SUBNEGOTIATION;
+                }
+                break;
+        }
+    }
+    return kept;
+}
+
+void GmcpSession::set_enabled(bool enabled) {
+    enabled_ = enabled;
+    if (enabled) {
+        modules_ = GMCP_ALL;
+        reset();
+    }
+}
+
+void GmcpSession::set_modules(uint8_t modules) {
+    // Newly added modules need their full state
+    if (modules & ~modules_) {
+        reset();
+    }
+    modules_ = modules;
+}
+
+void GmcpSession::reset() {
+    full_ = true;
+    room_id_ = -1;
+    room_players_.clear();
+}
+
+void GmcpSession::handle_message(std::string_view message) {
+    size_t space = message.find(' ');
+    std::string_view package = message.substr(0, space);
+    std::string_view json = space == std::string_view::npos ? std::string_view() : message.substr(space + 1);
+
+    if (iequals(package, "Core.Supports.Set")) {
+        set_modules(parse_module_list(json));
+    } else if (iequals(package, "Core.Supports.Add")) {
+        set_modules(modules_ | parse_module_list(json));
+    } else if (iequals(package, "Core.Supports.Remove")) {
+        set_modules(modules_ & ~parse_module_list(json));
+    } else if (iequals(package, "Core.Hello")) {
+        LOG_DEBUG("GMCP client hello: " + std::string(json));
+    }
+}
+
+bool GmcpSession::collect(PlayerId self, const Player& player, const Room* room,
+                          const PlayerTable& players, ArenaString& out) {
+    if (!enabled_) {
+        return false;
+    }
+    // Idle players are the common case: nothing dirty and nobody came or went
+    if (!full_ && !(player.get_dirty() & PLAYER_DIRTY_GMCP) &&
+        (!room || room->get_players_version() == room_version_)) {
+        return false;
+    }
+
+    size_t start = out.size();
+    if (modules_ & GMCP_CHAR) {
+        collect_vitals(player, out);
+    }
+    if ((modules_ & GMCP_ROOM) && room) {
+        collect_room(self, *room, players, out);
+    }
+    full_ = false;
+    return out.size() > start;
+}
+
+void GmcpSession::collect_vitals(const Player& player, ArenaString& out) {
+    if (!full_ && !(player.get_dirty() & PLAYER_DIRTY_VITALS)) {
+        return;
+    }
+
+    // Only the fields that moved, e.g. {"hp":70} after a hit
+    ArenaString json(out.arena());
+    json << '{';
+    if (full_ || player.get_health() != health_) {
+        append_field(json, "hp", player.get_health());
+    }
+    if (full_ || player.get_max_health() != max_health_) {
+        append_field(json, "maxhp", player.get_max_health());
+    }
+    if (full_ || player.get_level() != level_) {
+        append_field(json, "level", player.get_level());
+    }
+    if (full_ || player.get_experience() != experience_) {
+        append_field(json, "xp", player.get_experience());
+    }
+    json << '}';
+
+    health_ = player.get_health();
+    max_health_ = player.get_max_health();
+    level_ = player.get_level();
+    experience_ = player.get_experience();
+
+    if (json.size() > 2) {
+        append_gmcp(out, "Char.Vitals", json.view());
+    }
+}
+
+void GmcpSession::collect_room(PlayerId self, const Room& room, const PlayerTable& players, ArenaString& out) {
+    bool moved = room.get_id() != room_id_;
+    if (!moved && room.get_players_version() == room_version_) {
+        return;
+    }
+    room_version_ = room.get_players_version();
+
+    scratch_.clear();
+    for (PlayerId id : room.get_players()) {
+        if (id != self) {
+            scratch_.push_back(id);
+        }
+    }
+    std::sort(scratch_.begin(), scratch_.end(), id_less);
+
+    ArenaString json(out.arena());
+    if (moved) {
+        room_id_ = room.get_id();
+        json << "{\"num\":" << room.get_id() << ",\"name\":";
+        append_json_string(json, room.get_name());
+        json << ",\"exits\":{";
+        bool first = true;
+        for (const auto& exit : room.get_exits()) {
+            json << (first ? "\"" : ",\"") << exit_key(exit.first) << "\":" << exit.second;
+            first = false;
+        }
+        json << "}}";
+        append_gmcp(out, "Room.Info", json.view());
+
+        // A new room gets the whole list
+        json.clear();
+        json << '[';
+        room_players_.clear();
+        for (PlayerId id : scratch_) {
+            const Player* other = players.get(id);
+            if (!other) {
+                continue;
+            }
+            json << (room_players_.empty() ? "{\"name\":" : ",{\"name\":");
+            append_json_string(json, other->get_name());
+            json << '}';
+            room_players_.push_back(SentPlayer{id, other->get_name()});
+        }
+        json << ']';
+        append_gmcp(out, "Room.Players", json.view());
+        return;
+    }
+
+    // Same room: walk both sorted lists and report only arrivals and departures
+    std::vector<SentPlayer>& previous = previous_players_;
+    previous.swap(room_players_);
+    room_players_.clear();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < previous.size() || j < scratch_.size()) {
+        if (j == scratch_.size() || (i < previous.size() && id_less(previous[i].id, scratch_[j]))) {
+            json.clear();
+            append_json_string(json, previous[i].name);
+            append_gmcp(out, "Room.RemovePlayer", json.view());
+            ++i;
+        } else if (i == previous.size() || id_less(scratch_[j], previous[i].id)) {
+            const Player* other = players.get(scratch_[j]);
+            if (other) {
+                json.clear();
+                json << "{\"name\":";
+                append_json_string(json, other->get_name());
+                json << '}';
+                append_gmcp(out, "Room.AddPlayer", json.view());
+                room_players_.push_back(SentPlayer{scratch_[j], other->get_name()});
+            }
+            ++j;
+        } else {
+            room_players_.push_back(std::move(previous[i]));
+            ++i;
+            ++j;
+        }
+    }
+    previous.clear();
+}
+
+void append_gmcp(ArenaString& out, std::string_view package, std::string_view json) {
+    out << static_cast<char>(telnet::IAC) << static_cast<char>(telnet::SB) << static_cast<char>(telnet::GMCP);
+    out << package;
+    if (!json.empty()) {
+        out << ' ';
+        for (char c : json) {
+            // A literal 0xFF would end the frame early, so double it
+            if (static_cast<uint8_t>(c) == telnet::IAC) {
+                out << c;
+            }
+            out << c;
+        }
+    }
+    out << static_cast<char>(telnet::IAC) << static_cast<char>(telnet::SE);
+}
+
+void append_json_string(ArenaString& out, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    for (char c : text) {
+        uint8_t byte = static_cast<uint8_t>(c);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (byte < 0x20) {
+            out << "\\u00" << hex[byte >> 4] << hex[byte & 0xf];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,649 @@
+#include "io_uring.hpp"
+#include "common.hpp"
+#include "flood_control.hpp"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+namespace dungeon_merc {
+
+namespace {
+
+// user_data carries what a request was in its top byte and the connection
+// id below it, so a completion for a socket that is already gone is harmless
+enum class Request : uint64_t {
+    ACCEPT = 1,
+    RECV = 2,
+    SEND = 3,
+    CANCEL = 4
+};
+constexpr int REQUEST_SHIFT = 56;
+constexpr uint64_t ID_MASK = (uint64_t(1) << REQUEST_SHIFT) - 1;
+constexpr uint64_t PROBE_ID = ID_MASK;  // Never a real connection id
+constexpr uint16_t BUFFER_GROUP = 0;
+
+uint64_t make_user_data(Request request, uint64_t id) {
+    return (static_cast<uint64_t>(request) << REQUEST_SHIFT) | (id & ID_MASK);
+}
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template<typename T>
+T* ring_field(void* map, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(map) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring()
+    : ring_fd_(-1)
+    , ready_(false)
+    , sq_map_(MAP_FAILED)
+    , sq_map_size_(0)
+    , cq_map_(MAP_FAILED)
+    , cq_map_size_(0)
+    , sq_head_(nullptr)
+    , sq_tail_(nullptr)
+    , sq_flags_(nullptr)
+    , sq_mask_(0)
+    , sq_array_(nullptr)
+    , sqes_(nullptr)
+    , sqes_size_(0)
+    , sq_pending_(0)
+    , cq_head_(nullptr)
+    , cq_tail_(nullptr)
+    , cq_mask_(0)
+    , cqes_(nullptr)
+    , buffer_ring_(nullptr)
+    , buffer_tail_(0)
+    , listen_fd_(-1)
+    , accepting_(false)
+    , enters_(MetricsRegistry::get_instance().counter("uring.enters"))
+    , completions_(MetricsRegistry::get_instance().counter("uring.completions"))
+    , dropped_bytes_(MetricsRegistry::get_instance().counter("uring.dropped_bytes")) {
+}
+
+IoUring::~IoUring() {
+    teardown();
+}
+
+bool IoUring::initialize() {
+    // Completions are picked up once per tick, so there is no point in the
+    // kernel interrupting the tick to post them
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+    params.cq_entries = URING_ENTRIES * 4;  // Multishot requests post many completions each
+    ring_fd_ = sys_io_uring_setup(URING_ENTRIES, &params);
+    if (ring_fd_ < 0) {
+        LOG_WARNING("io_uring is unavailable: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+        sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+    }
+    sq_map_ = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQ_RING);
+    cq_map_ = single_map ? sq_map_
+                         : mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                ring_fd_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sq_map_ == MAP_FAILED || cq_map_ == MAP_FAILED || sqes == MAP_FAILED) {
+        LOG_ERROR("Failed to map the io_uring rings: " + std::string(strerror(errno)));
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size_);
+        }
+        teardown();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = ring_field<unsigned>(sq_map_, params.sq_off.head);
+    sq_tail_ = ring_field<unsigned>(sq_map_, params.sq_off.tail);
+    sq_flags_ = ring_field<unsigned>(sq_map_, params.sq_off.flags);
+    sq_mask_ = *ring_field<unsigned>(sq_map_, params.sq_off.ring_mask);
+    sq_array_ = ring_field<unsigned>(sq_map_, params.sq_off.array);
+    cq_head_ = ring_field<unsigned>(cq_map_, params.cq_off.head);
+    cq_tail_ = ring_field<unsigned>(cq_map_, params.cq_off.tail);
+    cq_mask_ = *ring_field<unsigned>(cq_map_, params.cq_off.ring_mask);
+    cqes_ = ring_field<io_uring_cqe>(cq_map_, params.cq_off.cqes);
+
+    // Receive buffers the kernel picks from as data arrives, so an idle
+    // connection pins no memory
+    void* ring = mmap(nullptr, URING_BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        LOG_ERROR("Failed to allocate the io_uring buffer ring");
+        teardown();
+        return false;
+    }
+    buffer_ring_ = static_cast<io_uring_buf*>(ring);
+    io_uring_buf_reg registration;
+    memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<uint64_t>(ring);
+    registration.ring_entries = URING_BUFFER_COUNT;
+    registration.bgid = BUFFER_GROUP;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        LOG_WARNING("io_uring needs Linux 5.19 or later for buffer rings: " + std::string(strerror(errno)));
+        teardown();
+        return false;
+    }
+    buffers_.resize(static_cast<size_t>(URING_BUFFER_COUNT) * URING_BUFFER_SIZE);
+    for (unsigned i = 0; i < URING_BUFFER_COUNT; ++i) {
+        recycle_buffer(static_cast<uint16_t>(i));
+    }
+
+    ready_ = true;
+    if (!probe_multishot_recv()) {
+        LOG_WARNING("io_uring needs Linux 6.0 or later for multishot receive");
+        teardown();
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::probe_multishot_recv() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+        return false;
+    }
+
+    // Older kernels reject the multishot flag outright; newer ones deliver
+    // and keep the request armed
+    attach(PROBE_ID, fds[0]);
+    enter(sq_pending_, 0, 0);
+    ::send(fds[1], "x", 1, MSG_NOSIGNAL);
+    for (int i = 0; i < 100 && sockets_[PROBE_ID].input.empty() && !sockets_[PROBE_ID].eof; ++i) {
+        enter(sq_pending_, 1, IORING_ENTER_GETEVENTS);
+        reap();
+    }
+    bool supported = sockets_[PROBE_ID].input == "x" && sockets_[PROBE_ID].receiving;
+
+    release(PROBE_ID);
+    for (int i = 0; i < 100 && sockets_.count(PROBE_ID) > 0; ++i) {
+        enter(sq_pending_, 1, IORING_ENTER_GETEVENTS);
+        reap();
+    }
+    ::close(fds[1]);
+    return supported && sockets_.empty();
+}
+
+void IoUring::teardown() {
+    ready_ = false;
+    for (auto& entry : sockets_) {
+        if (entry.second.released && entry.second.fd >= 0) {
+            ::close(entry.second.fd);
+        }
+    }
+    sockets_.clear();
+    for (int fd : accepted_) {
+        ::close(fd);
+    }
+    accepted_.clear();
+
+    if (buffer_ring_) {
+        munmap(buffer_ring_, URING_BUFFER_COUNT * sizeof(io_uring_buf));
+        buffer_ring_ = nullptr;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_map_ != MAP_FAILED && cq_map_ != sq_map_) {
+        munmap(cq_map_, cq_map_size_);
+    }
+    cq_map_ = MAP_FAILED;
+    if (sq_map_ != MAP_FAILED) {
+        munmap(sq_map_, sq_map_size_);
+        sq_map_ = MAP_FAILED;
+    }
+    // Closing the ring cancels whatever is still in flight
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+void IoUring::watch_listener(int listen_fd) {
+    listen_fd_ = listen_fd;
+    if (ready_) {
+        arm_accept();
+    }
+}
+
+std::vector<int> IoUring::take_accepted() {
+    std::vector<int> accepted;
+    accepted.swap(accepted_);
+    return accepted;
+}
+
+void IoUring::attach(uint64_t id, int fd) {
+    Socket& socket = sockets_[id];
+    socket.fd = fd;
+    arm_recv(id, socket);
+}
+
+void IoUring::release(uint64_t id) {
+    auto it = sockets_.find(id);
+    if (it == sockets_.end()) {
+        return;
+    }
+    Socket& socket = it->second;
+    socket.released = true;
+    socket.released_at = std::chrono::steady_clock::now();
+    socket.input.clear();
+
+    if (socket.receiving) {
+        cancel(make_user_data(Request::RECV, id));
+    }
+    // Output queued behind a send in flight follows it when it completes
+    if (!socket.in_send && !socket.output.empty()) {
+        send_output(id, socket);
+    }
+    if (socket.in_send) {
+        closing_.push_back(id);  // Until the client has taken it, or gives up
+    }
+    if (sq_pending_ > 0) {
+        enter(sq_pending_, 0, 0);
+    }
+    close_if_idle(it);
+}
+
+ssize_t IoUring::read(uint64_t id, char* buffer, size_t length) {
+    auto it = sockets_.find(id);
+    if (it == sockets_.end()) {
+        return -1;
+    }
+    Socket& socket = it->second;
+
+    size_t count = std::min(length, socket.input.size());
+    if (count > 0) {
+        memcpy(buffer, socket.input.data(), count);
+        socket.input.erase(0, count);
+    }
+    // Receiving stops while the buffer is full; start again now there is room
+    if (!socket.receiving && !socket.eof && !socket.released && socket.input.size() < INPUT_BUFFER_LIMIT) {
+        arm_recv(id, socket);
+    }
+    if (count > 0) {
+        return static_cast<ssize_t>(count);
+    }
+    return socket.eof ? -1 : 0;
+}
+
+size_t IoUring::get_queued_bytes(uint64_t id) const {
+    auto it = sockets_.find(id);
+    if (it == sockets_.end()) {
+        return 0;
+    }
+    const Socket& socket = it->second;
+    return socket.output.size() + (socket.sending.size() - socket.sent);
+}
+
+ssize_t IoUring::write(uint64_t id, const struct iovec* iov, int count) {
+    auto it = sockets_.find(id);
+    if (it == sockets_.end() || it->second.eof || it->second.released) {
+        return -1;
+    }
+    Socket& socket = it->second;
+
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        total += iov[i].iov_len;
+    }
+    if (socket.output.size() + (socket.sending.size() - socket.sent) + total > URING_OUTPUT_LIMIT) {
+        // Same outcome as a full socket buffer on a non-blocking write
+        errno = EAGAIN;
+        return -1;
+    }
+
+    if (socket.output.empty()) {
+        pending_sends_.push_back(id);
+    }
+    for (int i = 0; i < count; ++i) {
+        socket.output.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+void IoUring::poll() {
+    if (!ready_) {
+        return;
+    }
+    unsigned flags = __atomic_load_n(sq_flags_, __ATOMIC_RELAXED);
+    if (flags & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW)) {
+        enter(sq_pending_, 0, IORING_ENTER_GETEVENTS);
+    }
+    reap();
+    if (!closing_.empty()) {
+        expire_closing();
+    }
+    if (listen_fd_ >= 0 && !accepting_) {
+        arm_accept();
+    }
+}
+
+void IoUring::submit() {
+    if (!ready_) {
+        return;
+    }
+    for (uint64_t id : pending_sends_) {
+        auto it = sockets_.find(id);
+        if (it == sockets_.end()) {
+            continue;
+        }
+        Socket& socket = it->second;
+        // A socket with a send in flight goes again when it completes
+        if (socket.in_send || socket.released || socket.output.empty()) {
+            continue;
+        }
+        send_output(id, socket);
+    }
+    pending_sends_.clear();
+
+    if (sq_pending_ > 0) {
+        enter(sq_pending_, 0, 0);
+    }
+}
+
+void IoUring::quiesce(std::chrono::milliseconds timeout) {
+    if (!ready_) {
+        return;
+    }
+    if (accepting_) {
+        cancel(make_user_data(Request::ACCEPT, 0));
+    }
+    for (auto& entry : sockets_) {
+        if (entry.second.receiving) {
+            cancel(make_user_data(Request::RECV, entry.first));
+        }
+    }
+    submit();
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto busy = [this] {
+        return accepting_ || std::any_of(sockets_.begin(), sockets_.end(), [](const auto& entry) {
+            return entry.second.receiving || entry.second.in_send || !entry.second.output.empty();
+        });
+    };
+    while (busy() && std::chrono::steady_clock::now() < deadline) {
+        enter(sq_pending_, 0, IORING_ENTER_GETEVENTS);
+        reap();
+        submit();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+io_uring_sqe* IoUring::get_sqe() {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > sq_mask_) {
+        // Full: hand the kernel what we have and make room
+        enter(sq_pending_, 0, 0);
+        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > sq_mask_) {
+            LOG_ERROR("io_uring submission queue is full");
+            return nullptr;
+        }
+    }
+
+    // Without SQPOLL the kernel only reads the ring inside io_uring_enter,
+    // so the tail can move before the entry is filled in
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++sq_pending_;
+    return sqe;
+}
+
+int IoUring::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    int result = sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags);
+    enters_.add();
+    if (result < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            LOG_ERROR("io_uring_enter failed: " + std::string(strerror(errno)));
+        }
+        return result;
+    }
+    sq_pending_ -= std::min(sq_pending_, static_cast<unsigned>(result));
+    return result;
+}
+
+void IoUring::reap() {
+    unsigned head = *cq_head_;
+    uint64_t reaped = 0;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        io_uring_cqe cqe = cqes_[head & cq_mask_];
+        // Hand the slot back before handling, which may queue more work
+        __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+        handle(cqe);
+        ++reaped;
+    }
+    completions_.add(reaped);
+}
+
+void IoUring::handle(const io_uring_cqe& cqe) {
+    auto request = static_cast<Request>(cqe.user_data >> REQUEST_SHIFT);
+    uint64_t id = cqe.user_data & ID_MASK;
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+    switch (request) {
+        case Request::ACCEPT:
+            if (!more) {
+                accepting_ = false;  // poll() re-arms it
+            }
+            if (cqe.res >= 0) {
+                accepted_.push_back(cqe.res);
+            } else if (cqe.res != -ECANCELED) {
+                LOG_WARNING("io_uring accept failed: " + std::string(strerror(-cqe.res)));
+            }
+            break;
+
+        case Request::RECV: {
+            auto it = sockets_.find(id);
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                auto buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                if (it != sockets_.end() && !it->second.released && cqe.res > 0) {
+                    it->second.input.append(&buffers_[static_cast<size_t>(buffer_id) * URING_BUFFER_SIZE],
+                                            static_cast<size_t>(cqe.res));
+                }
+                recycle_buffer(buffer_id);
+            }
+            if (it == sockets_.end()) {
+                break;
+            }
+
+            Socket& socket = it->second;
+            if (!more) {
+                socket.receiving = false;
+            }
+            if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED)) {
+                socket.eof = true;
+            }
+            if (socket.input.size() >= INPUT_BUFFER_LIMIT) {
+                // Leave further input in the kernel so TCP pushes back on the client
+                if (socket.receiving) {
+                    cancel(make_user_data(Request::RECV, id));
+                }
+            } else if (!socket.receiving && !socket.eof && !socket.released && cqe.res != -ECANCELED) {
+                arm_recv(id, socket);  // Ran out of buffers, or the kernel ended it
+            }
+            close_if_idle(it);
+            break;
+        }
+
+        case Request::SEND: {
+            auto it = sockets_.find(id);
+            if (it == sockets_.end()) {
+                break;
+            }
+            Socket& socket = it->second;
+            socket.in_send = false;
+            if (cqe.res < 0) {
+                if (cqe.res != -ECANCELED && cqe.res != -EAGAIN) {
+                    socket.eof = true;
+                }
+                size_t lost = socket.sending.size() - socket.sent;
+                socket.sending.clear();
+                socket.sent = 0;
+                if (socket.eof || socket.released) {
+                    lost += socket.output.size();
+                    socket.output.clear();
+                } else if (!socket.output.empty()) {
+                    pending_sends_.push_back(id);
+                }
+                drop_output(id, lost, strerror(-cqe.res));
+            } else {
+                socket.sent += static_cast<size_t>(cqe.res);
+                if (socket.sent < socket.sending.size()) {
+                    start_send(id, socket);  // Short write: the rest goes next
+                } else {
+                    socket.sending.clear();
+                    socket.sent = 0;
+                    if (socket.released && !socket.output.empty()) {
+                        send_output(id, socket);  // submit() skips released sockets
+                    } else if (!socket.output.empty()) {
+                        pending_sends_.push_back(id);
+                    }
+                }
+            }
+            close_if_idle(it);
+            break;
+        }
+
+        case Request::CANCEL:
+            break;
+    }
+}
+
+void IoUring::arm_accept() {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    // Close-on-exec until a hot reboot hands the socket on explicitly
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = make_user_data(Request::ACCEPT, 0);
+    accepting_ = true;
+}
+
+void IoUring::arm_recv(uint64_t id, Socket& socket) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = socket.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = make_user_data(Request::RECV, id);
+    socket.receiving = true;
+}
+
+void IoUring::send_output(uint64_t id, Socket& socket) {
+    socket.sending.swap(socket.output);
+    socket.output.clear();
+    socket.sent = 0;
+    start_send(id, socket);
+}
+
+void IoUring::start_send(uint64_t id, Socket& socket) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        drop_output(id, socket.sending.size() - socket.sent, "submission queue full");
+        socket.sending.clear();
+        socket.sent = 0;
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = socket.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(socket.sending.data() + socket.sent);
+    sqe->len = static_cast<uint32_t>(socket.sending.size() - socket.sent);
+    sqe->msg_flags = static_cast<uint32_t>(MSG_NOSIGNAL);
+    sqe->user_data = make_user_data(Request::SEND, id);
+    socket.in_send = true;
+}
+
+void IoUring::drop_output(uint64_t id, size_t bytes, const char* reason) {
+    if (bytes == 0) {
+        return;
+    }
+    dropped_bytes_.add(bytes);
+    LOG_WARNING("io_uring dropped " + std::to_string(bytes) + " bytes of output for connection " +
+                std::to_string(id) + ": " + reason);
+}
+
+void IoUring::expire_closing() {
+    auto now = std::chrono::steady_clock::now();
+    closing_.erase(std::remove_if(closing_.begin(), closing_.end(), [&](uint64_t id) {
+        auto it = sockets_.find(id);
+        if (it == sockets_.end() || !it->second.in_send) {
+            return true;
+        }
+        if (now - it->second.released_at < URING_CLOSE_TIMEOUT) {
+            return false;
+        }
+        // The client stopped reading; the completion drops the rest and closes
+        cancel(make_user_data(Request::SEND, id));
+        return true;
+    }), closing_.end());
+}
+
+void IoUring::cancel(uint64_t user_data) {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = user_data;
+    sqe->user_data = make_user_data(Request::CANCEL, 0);
+}
+
+void IoUring::recycle_buffer(uint16_t buffer_id) {
+    // The ring is a plain array of entries whose tail is the first entry's
+    // resv field. Indexed directly: io_uring_buf_ring's flexible array member
+    // does not start at offset 0 when the header is compiled as C++.
+    io_uring_buf& buffer = buffer_ring_[buffer_tail_ & (URING_BUFFER_COUNT - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(&buffers_[static_cast<size_t>(buffer_id) * URING_BUFFER_SIZE]);
+    buffer.len = URING_BUFFER_SIZE;
+    buffer.bid = buffer_id;
+    ++buffer_tail_;
+    __atomic_store_n(&buffer_ring_[0].resv, buffer_tail_, __ATOMIC_RELEASE);
+}
+
+void IoUring::close_if_idle(std::unordered_map<uint64_t, Socket>::iterator it) {
+    const Socket& socket = it->second;
+    if (!socket.released || socket.receiving || socket.in_send) {
+        return;
+    }
+    ::close(socket.fd);
+    sockets_.erase(it);
+}
+
+} // namespace dungeon_merc
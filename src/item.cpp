@@ -0,0 +1,274 @@
+#include "item.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace dungeon_merc {
+
+namespace {
+
+const char* const ITEM_MOD_NAMES[ITEM_MOD_COUNT] = {
+    "scope", "suppressor", "extended mag", "smartlink",
+};
+
+} // namespace
+
+const char* item_mod_name(size_t bit) {
+    return bit < ITEM_MOD_COUNT ? ITEM_MOD_NAMES[bit] : "unknown";
+}
+
+bool LootTable::build(std::vector<LootEntry> entries) {
+    entries_.clear();
+    keep_.clear();
+    alias_.clear();
+    total_weight_ = 0;
+
+    uint64_t total = 0;
+    for (const auto& entry : entries) {
+        total += entry.weight;
+    }
+    if (entries.empty() || entries.size() > std::numeric_limits<uint16_t>::max() || total == 0 ||
+        total > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    // Vose: every column holds total_weight_ worth of probability. Entries
+    // scaled by n are sorted into underfull and overfull; each underfull
+    // column is topped up from an overfull one, which becomes its alias.
+    size_t n = entries.size();
+    std::vector<uint64_t> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = static_cast<uint64_t>(entries[i].weight) * n;
+        (scaled[i] < total ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    keep_.assign(n, total);
+    alias_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        alias_[i] = static_cast<uint32_t>(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t under = small.back();
+        small.pop_back();
+        uint32_t over = large.back();
+        keep_[under] = scaled[under];
+        alias_[under] = over;
+        scaled[over] -= total - scaled[under];
+        if (scaled[over] < total) {
+            large.pop_back();
+            small.push_back(over);
+        }
+    }
+    // Whatever is left is exactly full; keep_ already says so
+
+    entries_ = std::move(entries);
+    total_weight_ = total;
+    return true;
+}
+
+const LootEntry& LootTable::roll(RandomGenerator& rng) const {
+    // One draw over n * total: the quotient is the column, the remainder the coin
+    uint64_t draw = rng.random_below(entries_.size() * total_weight_);
+    size_t column = static_cast<size_t>(draw / total_weight_);
+    uint64_t coin = draw % total_weight_;
+    return entries_[coin < keep_[column] ? column : alias_[column]];
+}
+
+ItemStack LootTable::roll_stack(RandomGenerator& rng) const {
+    const LootEntry& entry = roll(rng);
+    ItemStack stack;
+    if (entry.item == NO_ITEM) {
+        return stack;
+    }
+    stack.item = entry.item;
+    stack.count = static_cast<uint16_t>(rng.random_int(entry.min_count, entry.max_count));
+    stack.mods = entry.mods;
+    return stack;
+}
+
+ItemCatalog::ItemCatalog()
+    : templates_(1) {
+    add_builtin_items();
+}
+
+ItemId ItemCatalog::add_template(const std::string& name, ItemKind kind, uint16_t max_stack, int value) {
+    ItemTemplate item;
+    item.id = static_cast<ItemId>(templates_.size());
+    item.name = name;
+    item.kind = kind;
+    item.max_stack = std::max<uint16_t>(max_stack, 1);
+    item.value = value;
+    templates_.push_back(std::move(item));
+    return templates_.back().id;
+}
+
+const ItemTemplate* ItemCatalog::find(std::string_view name) const {
+    for (size_t i = 1; i < templates_.size(); ++i) {
+        if (iequals(templates_[i].name, name)) {
+            return &templates_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ItemCatalog::add_loot_table(const std::string& name, std::vector<LootEntry> entries) {
+    for (const auto& entry : entries) {
+        if (entry.item != NO_ITEM && !get(entry.item)) {
+            LOG_ERROR("Loot table " + name + " names unknown item " + std::to_string(entry.item));
+            return false;
+        }
+        if (entry.min_count > entry.max_count) {
+            LOG_ERROR("Loot table " + name + " has an entry with min_count above max_count");
+            return false;
+        }
+    }
+
+    LootTable table;
+    if (!table.build(std::move(entries))) {
+        LOG_ERROR("Loot table " + name + " has no usable weights");
+        return false;
+    }
+    for (auto& entry : loot_tables_) {
+        if (entry.first == name) {
+            entry.second = std::move(table);
+            return true;
+        }
+    }
+    loot_tables_.emplace_back(name, std::move(table));
+    return true;
+}
+
+const LootTable* ItemCatalog::find_loot_table(std::string_view name) const {
+    for (const auto& entry : loot_tables_) {
+        if (entry.first == name) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void ItemCatalog::add_builtin_items() {
+    // Append only: ids are carried across hot reboots and zone handoffs
+    ItemId credits = add_template("credits", ItemKind::CREDITS, 60000, 1);
+    ItemId rounds = add_template("9mm rounds", ItemKind::AMMO, 500, 1);
+    ItemId shells = add_template("shotgun shells", ItemKind::AMMO, 100, 2);
+    ItemId medkit = add_template("medkit", ItemKind::MEDKIT, 5, 40);
+    ItemId stim = add_template("stim patch", ItemKind::MEDKIT, 10, 15);
+    ItemId sidearm = add_template("sidearm", ItemKind::WEAPON, 1, 150);
+    ItemId scope = add_template("scope", ItemKind::WEAPON_MOD, 1, 80);
+    ItemId suppressor = add_template("suppressor", ItemKind::WEAPON_MOD, 1, 90);
+    ItemId magazine = add_template("extended mag", ItemKind::WEAPON_MOD, 1, 60);
+    ItemId smartlink = add_template("smartlink", ItemKind::WEAPON_MOD, 1, 250);
+
+    // A corner of a room worth searching
+    add_loot_table("debris", {
+        {NO_ITEM, 40, 1, 1, 0},
+        {credits, 30, 5, 25, 0},
+        {rounds, 20, 6, 18, 0},
+        {stim, 10, 1, 1, 0},
+    });
+
+    // What a cleared dungeon room gives up
+    add_loot_table("dungeon", {
+        {credits, 300, 20, 120, 0},
+        {rounds, 220, 12, 48, 0},
+        {shells, 120, 4, 16, 0},
+        {stim, 120, 1, 2, 0},
+        {medkit, 80, 1, 1, 0},
+        {sidearm, 40, 1, 1, 0},
+        {sidearm, 10, 1, 1, ITEM_MOD_SCOPE},
+        {sidearm, 5, 1, 1, ITEM_MOD_SUPPRESSOR | ITEM_MOD_EXTENDED_MAG},
+        {scope, 30, 1, 1, 0},
+        {suppressor, 30, 1, 1, 0},
+        {magazine, 40, 1, 1, 0},
+        {smartlink, 5, 1, 1, 0},
+    });
+}
+
+uint16_t InventoryPool::add(uint32_t owner, const ItemTemplate& item, uint16_t count, uint32_t mods) {
+    ItemStack* slots = slots_for(owner);
+    uint16_t added = 0;
+    size_t slot = 0;
+
+    for (; slot < INVENTORY_SLOTS && slots[slot].item != NO_ITEM && added < count; ++slot) {
+        ItemStack& stack = slots[slot];
+        if (stack.item == item.id && stack.mods == mods && stack.count < item.max_stack) {
+            uint16_t room = static_cast<uint16_t>(std::min<uint32_t>(item.max_stack - stack.count, count - added));
+            stack.count = static_cast<uint16_t>(stack.count + room);
+            added = static_cast<uint16_t>(added + room);
+        }
+    }
+    while (slot < INVENTORY_SLOTS && slots[slot].item != NO_ITEM) {
+        ++slot;
+    }
+    for (; slot < INVENTORY_SLOTS && added < count; ++slot) {
+        uint16_t room = static_cast<uint16_t>(std::min<uint32_t>(item.max_stack, count - added));
+        slots[slot] = ItemStack{item.id, room, mods};
+        added = static_cast<uint16_t>(added + room);
+    }
+    return added;
+}
+
+uint16_t InventoryPool::take(uint32_t owner, ItemId item, uint16_t count) {
+    if (owner >= slots_.size() / INVENTORY_SLOTS) {
+        return 0;
+    }
+    ItemStack* slots = slots_for(owner);
+    uint16_t taken = 0;
+
+    // From the newest stack back, closing any gap so used stacks stay in front
+    for (size_t slot = used(owner); slot-- > 0 && taken < count;) {
+        ItemStack& stack = slots[slot];
+        if (stack.item != item) {
+            continue;
+        }
+        uint16_t amount = std::min<uint16_t>(stack.count, static_cast<uint16_t>(count - taken));
+        stack.count = static_cast<uint16_t>(stack.count - amount);
+        taken = static_cast<uint16_t>(taken + amount);
+        if (stack.count == 0) {
+            std::copy(slots + slot + 1, slots + INVENTORY_SLOTS, slots + slot);
+            slots[INVENTORY_SLOTS - 1] = ItemStack();
+        }
+    }
+    return taken;
+}
+
+uint32_t InventoryPool::count_of(uint32_t owner, ItemId item) const {
+    const ItemStack* stacks = slots(owner);
+    uint32_t total = 0;
+    for (size_t slot = 0, end = used(owner); slot < end; ++slot) {
+        if (stacks[slot].item == item) {
+            total += stacks[slot].count;
+        }
+    }
+    return total;
+}
+
+const ItemStack* InventoryPool::slots(uint32_t owner) const {
+    return owner < slots_.size() / INVENTORY_SLOTS ? &slots_[owner * INVENTORY_SLOTS] : nullptr;
+}
+
+size_t InventoryPool::used(uint32_t owner) const {
+    const ItemStack* stacks = slots(owner);
+    size_t count = 0;
+    while (stacks && count < INVENTORY_SLOTS && stacks[count].item != NO_ITEM) {
+        ++count;
+    }
+    return count;
+}
+
+void InventoryPool::clear(uint32_t owner) {
+    if (owner < slots_.size() / INVENTORY_SLOTS) {
+        std::fill_n(&slots_[owner * INVENTORY_SLOTS], INVENTORY_SLOTS, ItemStack());
+    }
+}
+
+ItemStack* InventoryPool::slots_for(uint32_t owner) {
+    if (owner >= slots_.size() / INVENTORY_SLOTS) {
+        slots_.resize((static_cast<size_t>(owner) + 1) * INVENTORY_SLOTS);
+    }
+    return &slots_[owner * INVENTORY_SLOTS];
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,287 @@
+#include "leaderboard.hpp"
+#include "tokenizer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace dungeon_merc {
+
+namespace {
+
+constexpr const char* LEADERBOARD_MAGIC = "DMLEADERBOARD";
+constexpr int LEADERBOARD_VERSION = 1;
+constexpr uint64_t LEADERBOARD_SEED = 0x6c6561646572ULL;  // Fixed so tree shapes are reproducible
+
+} // namespace
+
+Leaderboard::Leaderboard()
+    : nodes_(1)
+    , priorities_(LEADERBOARD_SEED) {
+    lookup_key_.reserve(32);
+}
+
+bool Leaderboard::ranks_above(const Entry& a, const Entry& b) {
+    if (a.level != b.level) {
+        return a.level > b.level;
+    }
+    if (a.experience != b.experience) {
+        return a.experience > b.experience;
+    }
+    return icompare(a.name, b.name) < 0;
+}
+
+const std::string& Leaderboard::key_for(std::string_view name) const {
+    lookup_key_.assign(name.data(), name.size());
+    std::transform(lookup_key_.begin(), lookup_key_.end(), lookup_key_.begin(), ::tolower);
+    return lookup_key_;
+}
+
+uint32_t Leaderboard::allocate(Entry entry) {
+    Node node;
+    node.entry = std::move(entry);
+    node.size = 1;
+    node.priority = static_cast<uint32_t>(priorities_());
+    nodes_.push_back(std::move(node));
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void Leaderboard::update(std::string_view name, int level, int experience) {
+    auto it = by_name_.find(key_for(name));
+    if (it == by_name_.end()) {
+        uint32_t node = allocate(Entry{std::string(name), level, experience});
+        by_name_.emplace(lookup_key_, node);
+        root_ = insert(root_, node);
+        dirty_ = true;
+        return;
+    }
+
+    uint32_t node = it->second;
+    Entry& entry = nodes_[node].entry;
+    if (entry.level == level && entry.experience == experience) {
+        return;
+    }
+
+    // Re-key: take the node out, change it and put it back
+    root_ = erase(root_, entry);
+    entry.level = level;
+    entry.experience = experience;
+    nodes_[node].left = NIL;
+    nodes_[node].right = NIL;
+    nodes_[node].size = 1;
+    root_ = insert(root_, node);
+    dirty_ = true;
+}
+
+const Leaderboard::Entry* Leaderboard::find(std::string_view name) const {
+    auto it = by_name_.find(key_for(name));
+    return it != by_name_.end() ? &nodes_[it->second].entry : nullptr;
+}
+
+size_t Leaderboard::rank_of(std::string_view name) const {
+    const Entry* key = find(name);
+    if (!key) {
+        return 0;
+    }
+
+    size_t above = 0;
+    uint32_t node = root_;
+    while (node != NIL) {
+        const Node& n = nodes_[node];
+        if (ranks_above(*key, n.entry)) {
+            node = n.left;
+        } else if (ranks_above(n.entry, *key)) {
+            above += nodes_[n.left].size + 1;
+            node = n.right;
+        } else {
+            return above + nodes_[n.left].size + 1;
+        }
+    }
+    return 0;
+}
+
+void Leaderboard::split(uint32_t node, const Entry& key, uint32_t& above, uint32_t& rest) {
+    if (node == NIL) {
+        above = NIL;
+        rest = NIL;
+        return;
+    }
+    if (ranks_above(nodes_[node].entry, key)) {
+        split(nodes_[node].right, key, nodes_[node].right, rest);
+        above = node;
+    } else {
+        split(nodes_[node].left, key, above, nodes_[node].left);
+        rest = node;
+    }
+    update_size(node);
+}
+
+uint32_t Leaderboard::merge(uint32_t above, uint32_t below) {
+    if (above == NIL) {
+        return below;
+    }
+    if (below == NIL) {
+        return above;
+    }
+    if (nodes_[above].priority > nodes_[below].priority) {
+        nodes_[above].right = merge(nodes_[above].right, below);
+        update_size(above);
+        return above;
+    }
+    nodes_[below].left = merge(above, nodes_[below].left);
+    update_size(below);
+    return below;
+}
+
+uint32_t Leaderboard::insert(uint32_t node, uint32_t item) {
+    if (node == NIL) {
+        return item;
+    }
+    if (nodes_[item].priority > nodes_[node].priority) {
+        split(node, nodes_[item].entry, nodes_[item].left, nodes_[item].right);
+        update_size(item);
+        return item;
+    }
+    if (ranks_above(nodes_[item].entry, nodes_[node].entry)) {
+        nodes_[node].left = insert(nodes_[node].left, item);
+    } else {
+        nodes_[node].right = insert(nodes_[node].right, item);
+    }
+    update_size(node);
+    return node;
+}
+
+uint32_t Leaderboard::erase(uint32_t node, const Entry& key) {
+    if (node == NIL) {
+        return NIL;
+    }
+    Node& n = nodes_[node];
+    if (ranks_above(key, n.entry)) {
+        n.left = erase(n.left, key);
+    } else if (ranks_above(n.entry, key)) {
+        n.right = erase(n.right, key);
+    } else {
+        return merge(n.left, n.right);
+    }
+    update_size(node);
+    return node;
+}
+
+void Leaderboard::build_sorted(std::vector<Entry>& entries) {
+    nodes_.assign(1, Node());
+    nodes_.reserve(entries.size() + 1);
+    by_name_.clear();
+    by_name_.reserve(entries.size());
+    root_ = NIL;
+
+    // Cartesian tree over the ranked entries: the right spine lives on a
+    // stack, and each new node adopts whatever it outranks by priority
+    std::vector<uint32_t> spine;
+    for (Entry& entry : entries) {
+        if (by_name_.count(key_for(entry.name))) {
+            LOG_WARNING("Duplicate leaderboard entry for " + entry.name);
+            continue;
+        }
+        uint32_t node = allocate(std::move(entry));
+        by_name_.emplace(lookup_key_, node);
+
+        uint32_t last = NIL;
+        while (!spine.empty() && nodes_[spine.back()].priority < nodes_[node].priority) {
+            last = spine.back();
+            spine.pop_back();
+        }
+        nodes_[node].left = last;
+        if (!spine.empty()) {
+            nodes_[spine.back()].right = node;
+        }
+        spine.push_back(node);
+    }
+    root_ = spine.empty() ? NIL : spine.front();
+    fix_sizes(root_);
+}
+
+uint32_t Leaderboard::fix_sizes(uint32_t node) {
+    if (node == NIL) {
+        return 0;
+    }
+    nodes_[node].size = 1 + fix_sizes(nodes_[node].left) + fix_sizes(nodes_[node].right);
+    return nodes_[node].size;
+}
+
+bool Leaderboard::save(const std::string& path) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("Failed to open leaderboard file: " + tmp_path);
+            return false;
+        }
+
+        // Best first, so loading never has to sort. Names contain no whitespace.
+        out << LEADERBOARD_MAGIC << " " << LEADERBOARD_VERSION << "\n";
+        out << "entries " << size() << "\n";
+        for_each_page(0, size(), [&out](size_t, const Entry& entry) {
+            out << entry.level << " " << entry.experience << " " << entry.name << "\n";
+        });
+
+        if (!out.good()) {
+            LOG_ERROR("Failed to write leaderboard file: " + tmp_path);
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to move leaderboard file into place: " + path);
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool Leaderboard::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        LOG_INFO("No leaderboard at " + path + "; starting an empty one");
+        std::vector<Entry> none;
+        build_sorted(none);
+        dirty_ = false;
+        return true;
+    }
+
+    std::string magic;
+    int version = 0;
+    std::string label;
+    size_t count = 0;
+    if (!(in >> magic >> version) || magic != LEADERBOARD_MAGIC || version != LEADERBOARD_VERSION ||
+        !(in >> label >> count) || label != "entries") {
+        LOG_ERROR("Not a leaderboard file: " + path);
+        return false;
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(count);
+    bool sorted = true;
+    for (size_t i = 0; i < count; ++i) {
+        Entry entry;
+        if (!(in >> entry.level >> entry.experience >> entry.name)) {
+            LOG_ERROR("Truncated leaderboard file: " + path);
+            return false;
+        }
+        if (!entries.empty() && !ranks_above(entries.back(), entry)) {
+            sorted = false;
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    if (!sorted) {
+        // Hand edited, most likely; still usable
+        LOG_WARNING("Leaderboard file is out of order, sorting: " + path);
+        std::sort(entries.begin(), entries.end(), ranks_above);
+    }
+    build_sorted(entries);
+    dirty_ = false;
+    LOG_INFO("Loaded " + std::to_string(size()) + " leaderboard entries from " + path);
+    return true;
+}
+
+} // namespace dungeon_merc
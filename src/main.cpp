@@ -2,22 +2,44 @@
 #include "telnet_server.hpp"
 #include "player.hpp"
 #include "game_world.hpp"
+#include "copyover.hpp"
+#include "metrics.hpp"
+#include "command_trace.hpp"
+#include "trace.hpp"
+#include "arena.hpp"
+#include "zone_server.hpp"
+#include "zone_gateway.hpp"
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
+#include <cstring>
+#include <climits>
 #include <memory>
+#include <sstream>
 
 using namespace dungeon_merc;
 
 // Global flag for graceful shutdown
 std::atomic<bool> g_shutdown_requested(false);
 
+// Global flag for hot reboot
+std::atomic<bool> g_copyover_requested(false);
+
+// Environment variable the admin password may be passed in
+constexpr const char* ADMIN_PASSWORD_ENV = "DUNGEON_MERC_ADMIN_PASSWORD";
+
 // Signal handler for graceful shutdown
 void signal_handler(int signal) {
     LOG_INFO("Received shutdown signal: " + std::to_string(signal));
     g_shutdown_requested = true;
 }
 
+// Signal handler for hot reboot
+void copyover_signal_handler(int signal) {
+    (void)signal;
+    g_copyover_requested = true;
+}
+
 // Function to print usage information
 void print_usage(const char* program_name) {
     std::cout << "Dungeon Merc - Telnet MUD Server\n";
@@ -25,6 +47,25 @@ void print_usage(const char* program_name) {
     std::cout << "Options:\n";
     std::cout << "  -p, --port PORT        Server port (default: " << DEFAULT_PORT << ")\n";
     std::cout << "  -m, --max-players NUM  Maximum players (default: " << MAX_PLAYERS << ")\n";
+    std::cout << "  -c, --copyover-file F  Hot reboot handoff file (default: " << DEFAULT_COPYOVER_FILE << ")\n";
+    std::cout << "      --admin-password-file F  Password for the in-game 'admin' command, first line of F\n";
+    std::cout << "  -s, --stats-file F     Export metrics to a memory-mapped file\n";
+    std::cout << "  -r, --record FILE      Record accepted commands for dungeon_merc_replay\n";
+    std::cout << "      --seed NUM         Seed the random generator (default: clock)\n";
+    std::cout << "  -t, --triggers FILE    Load room trigger scripts\n";
+    std::cout << "  -l, --leaderboard FILE Keep the XP leaderboard in FILE across restarts\n";
+    std::cout << "      --flood-limit NUM  Commands per second per connection, 0 to disable (default: 10)\n";
+    std::cout << "      --generate-rooms N Add N generated dungeon rooms below the Ancient Chamber\n";
+    std::cout << "      --world-budget MB  Evict idle world regions to keep rooms under MB (default: no limit)\n";
+    std::cout << "      --region-idle SECS Evict regions nobody has been in for SECS (default: 300)\n";
+    std::cout << "      --tls-port PORT    Also accept TLS clients on PORT; needs --tls-cert and --tls-key\n";
+    std::cout << "      --tls-cert FILE    PEM certificate chain for the TLS port\n";
+    std::cout << "      --tls-key FILE     PEM private key for the TLS port\n";
+    std::cout << "      --io-backend NAME  Telnet socket I/O: sockets or uring (default: sockets)\n";
+    std::cout << "      --zone-map SPEC    Rooms per zone server, e.g. 1-3,4-5 (zone 0, zone 1)\n";
+    std::cout << "      --zone NUM         Run as the server for one zone; needs --zone-socket\n";
+    std::cout << "      --zone-socket PATH Unix socket a zone server listens on\n";
+    std::cout << "      --gateway PATHS    Run as the gateway for the zone sockets, comma separated in zone order\n";
     std::cout << "  -d, --debug            Enable debug mode\n";
     std::cout << "  -v, --version          Show version information\n";
     std::cout << "  -h, --help             Show this help message\n\n";
@@ -32,6 +73,11 @@ void print_usage(const char* program_name) {
     std::cout << "  " << program_name << "                    # Start with default settings\n";
     std::cout << "  " << program_name << " --port 4000        # Start on port 4000\n";
     std::cout << "  " << program_name << " --debug            # Start in debug mode\n";
+    std::cout << "  " << program_name << " --zone 0 --zone-socket /tmp/dm0.sock --zone-map 1-3,4-5 &\n";
+    std::cout << "  " << program_name << " --zone 1 --zone-socket /tmp/dm1.sock --zone-map 1-3,4-5 &\n";
+    std::cout << "  " << program_name << " --gateway /tmp/dm0.sock,/tmp/dm1.sock --zone-map 1-3,4-5\n\n";
+    std::cout << "The admin password may also come from " << ADMIN_PASSWORD_ENV << ".\n";
+    std::cout << "Send SIGUSR1 to hot reboot into the current binary without dropping players.\n";
 }
 
 // Function to print version information
@@ -46,14 +92,76 @@ struct ServerConfig {
     int port = DEFAULT_PORT;
     int max_players = MAX_PLAYERS;
     bool debug_mode = false;
+    std::string copyover_file = DEFAULT_COPYOVER_FILE;
+    std::string copyover_restore_file;  // Set only when started by a hot reboot
+    std::string admin_password;
+    std::string stats_file;
+    std::string record_file;
+    std::string triggers_file;
+    std::string leaderboard_file;
+    uint64_t seed = 0;
+    bool has_seed = false;
+    FloodLimits flood_limits;
+
+    // Resident world
+    int generated_rooms = 0;
+    size_t world_budget_bytes = 0;  // 0 for no limit
+    int region_idle_seconds = 300;
+
+    IoBackend io_backend = IoBackend::SOCKETS;
+
+    // Encrypted listener, off unless tls_port is set
+    int tls_port = 0;
+    std::string tls_cert_file;
+    std::string tls_key_file;
+
+    // Multi-process mode
+    std::string zone_map;
+    int zone = -1;                           // Run as this zone's server
+    std::string zone_socket;
+    std::vector<std::string> gateway_zones;  // Run as the gateway in front of these zone sockets
+
+    // Used to re-exec ourselves on hot reboot
+    std::string executable_path;
+    std::vector<std::string> program_args;
 };
 
+// The first line of 'path', which must not be empty
+bool read_password_file(const std::string& path, std::string& password) {
+    std::ifstream in(path);
+    if (!in || !std::getline(in, password)) {
+        return false;
+    }
+    password = trim(password);
+    return !password.empty();
+}
+
 ServerConfig parse_arguments(int argc, char* argv[]) {
     ServerConfig config;
 
+    // Kept out of argv, where ps and /proc/PID/cmdline show it. Unset so it
+    // isn't handed to the next image either; a hot reboot carries the hash.
+    if (const char* password = getenv(ADMIN_PASSWORD_ENV)) {
+        config.admin_password = password;
+        unsetenv(ADMIN_PASSWORD_ENV);
+    }
+
+    char resolved[PATH_MAX];
+    config.executable_path = realpath(argv[0], resolved) ? resolved : "/proc/self/exe";
+
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
 
+        if (arg == "--copyover-restore") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Handoff file required after --copyover-restore");
+                exit(1);
+            }
+            config.copyover_restore_file = argv[++i];
+            continue;
+        }
+        config.program_args.push_back(arg);
+
         if (arg == "-h" || arg == "--help") {
             print_usage(argv[0]);
             exit(0);
@@ -65,6 +173,7 @@ ServerConfig parse_arguments(int argc, char* argv[]) {
                 LOG_ERROR("Port number required after --port");
                 exit(1);
             }
+            config.program_args.push_back(argv[i + 1]);
             try {
                 config.port = std::stoi(argv[++i]);
                 if (config.port <= 0 || config.port > 65535) {
@@ -79,6 +188,7 @@ ServerConfig parse_arguments(int argc, char* argv[]) {
                 LOG_ERROR("Player count required after --max-players");
                 exit(1);
             }
+            config.program_args.push_back(argv[i + 1]);
             try {
                 config.max_players = std::stoi(argv[++i]);
                 if (config.max_players <= 0) {
@@ -88,6 +198,200 @@ ServerConfig parse_arguments(int argc, char* argv[]) {
                 LOG_ERROR("Invalid player count: " + std::string(argv[i]));
                 exit(1);
             }
+        } else if (arg == "-c" || arg == "--copyover-file") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --copyover-file");
+                exit(1);
+            }
+            config.copyover_file = argv[++i];
+            config.program_args.push_back(config.copyover_file);
+        } else if (arg == "-a" || arg == "--admin-password") {
+            // Anyone on the box can read argv
+            LOG_ERROR(std::string("Pass the admin password with --admin-password-file or ") + ADMIN_PASSWORD_ENV);
+            exit(1);
+        } else if (arg == "--admin-password-file") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --admin-password-file");
+                exit(1);
+            }
+            if (!read_password_file(argv[++i], config.admin_password)) {
+                LOG_ERROR("Failed to read an admin password from " + std::string(argv[i]));
+                exit(1);
+            }
+            // The file may be gone by the next hot reboot, which carries the hash instead
+            config.program_args.pop_back();
+        } else if (arg == "-s" || arg == "--stats-file") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --stats-file");
+                exit(1);
+            }
+            config.stats_file = argv[++i];
+            config.program_args.push_back(config.stats_file);
+        } else if (arg == "-r" || arg == "--record") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --record");
+                exit(1);
+            }
+            config.record_file = argv[++i];
+            config.program_args.push_back(config.record_file);
+        } else if (arg == "-t" || arg == "--triggers") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --triggers");
+                exit(1);
+            }
+            config.triggers_file = argv[++i];
+            config.program_args.push_back(config.triggers_file);
+        } else if (arg == "-l" || arg == "--leaderboard") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after --leaderboard");
+                exit(1);
+            }
+            config.leaderboard_file = argv[++i];
+            config.program_args.push_back(config.leaderboard_file);
+        } else if (arg == "--seed") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Seed required after --seed");
+                exit(1);
+            }
+            config.program_args.push_back(argv[i + 1]);
+            try {
+                config.seed = std::stoull(argv[++i]);
+                config.has_seed = true;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Invalid seed: " + std::string(argv[i]));
+                exit(1);
+            }
+        } else if (arg == "--flood-limit") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Command rate required after --flood-limit");
+                exit(1);
+            }
+            config.program_args.push_back(argv[i + 1]);
+            try {
+                double rate = std::stod(argv[++i]);
+                if (rate < 0) {
+                    throw std::out_of_range("negative rate");
+                }
+                if (rate == 0) {
+                    config.flood_limits = FloodLimits::unlimited();
+                } else {
+                    // Scale the burst and byte allowance with the command rate
+                    double scale = rate / config.flood_limits.commands_per_second;
+                    config.flood_limits.commands_per_second = rate;
+                    config.flood_limits.command_burst *= scale;
+                    config.flood_limits.bytes_per_second *= scale;
+                    config.flood_limits.byte_burst *= scale;
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Invalid flood limit: " + std::string(argv[i]));
+                exit(1);
+            }
+        } else if (arg == "--generate-rooms" || arg == "--world-budget" || arg == "--region-idle") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Number required after " + arg);
+                exit(1);
+            }
+            config.program_args.push_back(argv[i + 1]);
+            try {
+                int value = std::stoi(argv[++i]);
+                if (value < 0) {
+                    throw std::out_of_range("negative value");
+                }
+                if (arg == "--generate-rooms") {
+                    if (value > WorldGenerator::MAX_GENERATED_ROOMS) {
+                        LOG_WARNING("--generate-rooms capped at " + std::to_string(WorldGenerator::MAX_GENERATED_ROOMS));
+                        value = WorldGenerator::MAX_GENERATED_ROOMS;
+                    }
+                    config.generated_rooms = value;
+                } else if (arg == "--world-budget") {
+                    config.world_budget_bytes = static_cast<size_t>(value) * 1024 * 1024;
+                } else {
+                    config.region_idle_seconds = value;
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Invalid value for " + arg + ": " + std::string(argv[i]));
+                exit(1);
+            }
+        } else if (arg == "--tls-port") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Port number required after --tls-port");
+                exit(1);
+            }
+            config.program_args.push_back(argv[i + 1]);
+            try {
+                config.tls_port = std::stoi(argv[++i]);
+                if (config.tls_port <= 0 || config.tls_port > 65535) {
+                    throw std::out_of_range("Port out of range");
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Invalid TLS port number: " + std::string(argv[i]));
+                exit(1);
+            }
+        } else if (arg == "--tls-cert" || arg == "--tls-key") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("File path required after " + arg);
+                exit(1);
+            }
+            (arg == "--tls-cert" ? config.tls_cert_file : config.tls_key_file) = argv[++i];
+            config.program_args.push_back(argv[i]);
+        } else if (arg == "--io-backend") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Backend name required after --io-backend");
+                exit(1);
+            }
+            std::string name = argv[++i];
+            config.program_args.push_back(name);
+            if (name == "sockets") {
+                config.io_backend = IoBackend::SOCKETS;
+            } else if (name == "uring") {
+                config.io_backend = IoBackend::URING;
+            } else {
+                LOG_ERROR("Unknown I/O backend: " + name + " (expected sockets or uring)");
+                exit(1);
+            }
+        } else if (arg == "--zone-map") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Zone map required after --zone-map");
+                exit(1);
+            }
+            config.zone_map = argv[++i];
+            config.program_args.push_back(config.zone_map);
+        } else if (arg == "--zone") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Zone number required after --zone");
+                exit(1);
+            }
+            config.program_args.push_back(argv[i + 1]);
+            try {
+                config.zone = std::stoi(argv[++i]);
+                if (config.zone < 0) {
+                    throw std::out_of_range("negative zone");
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("Invalid zone number: " + std::string(argv[i]));
+                exit(1);
+            }
+        } else if (arg == "--zone-socket") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Socket path required after --zone-socket");
+                exit(1);
+            }
+            config.zone_socket = argv[++i];
+            config.program_args.push_back(config.zone_socket);
+        } else if (arg == "--gateway") {
+            if (i + 1 >= argc) {
+                LOG_ERROR("Zone socket paths required after --gateway");
+                exit(1);
+            }
+            std::string paths = argv[++i];
+            config.program_args.push_back(paths);
+            std::stringstream list(paths);
+            std::string path;
+            while (std::getline(list, path, ',')) {
+                if (!path.empty()) {
+                    config.gateway_zones.push_back(path);
+                }
+            }
         } else if (arg == "-d" || arg == "--debug") {
             config.debug_mode = true;
         } else {
@@ -98,8 +402,147 @@ ServerConfig parse_arguments(int argc, char* argv[]) {
     return config;
 }
 
+// How often a changed leaderboard is written back while running
+constexpr std::chrono::seconds LEADERBOARD_SAVE_INTERVAL(60);
+constexpr uint64_t CONTRACT_SEED_STREAM = 1;  // Contract board stream of the server seed
+
+// Set up the world's rooms and how much of it stays resident
+void configure_world(GameWorld& world, const ServerConfig& config) {
+    if (config.generated_rooms > 0) {
+        world.set_region_source(std::make_unique<WorldGenerator>(config.generated_rooms));
+        LOG_INFO("Generated world: " + std::to_string(config.generated_rooms) + " rooms");
+    }
+    world.set_region_limits(config.world_budget_bytes, std::chrono::seconds(config.region_idle_seconds));
+}
+
+// Load the leaderboard named on the command line, if any
+bool load_leaderboard(GameWorld& world, const ServerConfig& config) {
+    return config.leaderboard_file.empty() || world.get_leaderboard().load(config.leaderboard_file);
+}
+
+// Write the leaderboard back if anyone's progress changed since the last save
+void save_leaderboard(GameWorld& world, const ServerConfig& config) {
+    if (!config.leaderboard_file.empty() && world.get_leaderboard().is_dirty()) {
+        world.get_leaderboard().save(config.leaderboard_file);
+    }
+}
+
+// Hand every live connection to a fresh copy of the binary. Only returns on failure.
+bool perform_copyover(TelnetServer& server, const ServerConfig& config, CommandRecorder* recorder) {
+    LOG_INFO("Starting hot reboot");
+
+    CopyoverState state = server.prepare_copyover();
+    if (!write_copyover_file(config.copyover_file, state)) {
+        return false;
+    }
+
+    std::vector<std::string> args;
+    args.push_back(config.executable_path);
+    args.insert(args.end(), config.program_args.begin(), config.program_args.end());
+    args.push_back("--copyover-restore");
+    args.push_back(config.copyover_file);
+
+    std::vector<char*> exec_argv;
+    for (auto& arg : args) {
+        exec_argv.push_back(&arg[0]);
+    }
+    exec_argv.push_back(nullptr);
+
+    // exec() discards stdio buffers, so push out any recorded commands first
+    if (recorder) {
+        recorder->flush();
+    }
+
+    LOG_INFO("Handing " + std::to_string(state.connections.size()) + " connections to " + config.executable_path);
+    execv(exec_argv[0], exec_argv.data());
+
+    // Still here, so the old image keeps serving everyone
+    LOG_ERROR("Hot reboot exec failed: " + std::string(strerror(errno)));
+    std::remove(config.copyover_file.c_str());
+    return false;
+}
+
+// Run one zone of a multi-process world. Commands arrive from the gateway,
+// so the loop waits on its socket instead of sleeping.
+int run_zone_server(const ServerConfig& config, const ZoneMap& zone_map) {
+    try {
+        LOG_INFO("Starting Dungeon Merc zone server " + std::to_string(config.zone));
+
+        auto game_world = std::make_shared<GameWorld>();
+        game_world->set_zone(zone_map, config.zone);
+        configure_world(*game_world, config);
+
+        if (!config.triggers_file.empty()) {
+            std::string error;
+            if (!game_world->load_triggers(config.triggers_file, error)) {
+                LOG_ERROR("Failed to load triggers: " + error);
+                return 1;
+            }
+        }
+        if (!load_leaderboard(*game_world, config)) {
+            return 1;
+        }
+
+        uint64_t seed = config.has_seed ? config.seed
+            : static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        RandomGenerator::set_global_seed(seed);
+        // The board lives in the hub, so only the zone that owns room 1 runs it
+        if (game_world->is_local_room(1)) {
+            game_world->get_contracts().start(RandomGenerator::stream_seed(seed, CONTRACT_SEED_STREAM));
+        }
+
+        ZoneServer zone_server(game_world, config.zone);
+        if (!zone_server.listen(config.zone_socket)) {
+            return 1;
+        }
+
+        auto& metrics = MetricsRegistry::get_instance();
+        if (!config.stats_file.empty() && !metrics.open_export(config.stats_file)) {
+            LOG_WARNING("Continuing without a stats file");
+        }
+        Arena& arena = tick_arena();
+        auto last_publish = std::chrono::steady_clock::now();
+        auto last_leaderboard_save = last_publish;
+
+        while (!g_shutdown_requested) {
+            if (g_copyover_requested.exchange(false)) {
+                LOG_WARNING("Hot reboot is not supported for zone servers");
+            }
+
+            zone_server.poll(std::chrono::milliseconds(10));
+            game_world->run_timers(std::chrono::steady_clock::now());
+            zone_server.flush_notices();
+            game_world->publish_snapshot();
+            arena.reset();
+
+            auto now = std::chrono::steady_clock::now();
+            if (game_world->needs_region_eviction()) {
+                game_world->evict_idle_regions(now);
+            }
+            if (now - last_publish >= std::chrono::seconds(1)) {
+                game_world->evict_idle_regions(now);
+                metrics.publish();
+                last_publish = now;
+            }
+            if (now - last_leaderboard_save >= LEADERBOARD_SAVE_INTERVAL) {
+                save_leaderboard(*game_world, config);
+                last_leaderboard_save = now;
+            }
+        }
+
+        zone_server.shutdown();
+        save_leaderboard(*game_world, config);
+        LOG_INFO("Zone server shutdown complete");
+        return 0;
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Zone server error: " + std::string(e.what()));
+        return 1;
+    }
+}
+
 // Main server initialization and run function
-int run_server(const ServerConfig& config) {
+int run_server(const ServerConfig& config, const ZoneMap& zone_map) {
     try {
         LOG_INFO("Starting Dungeon Merc Telnet MUD Server");
         LOG_INFO("Port: " + std::to_string(config.port));
@@ -108,31 +551,182 @@ int run_server(const ServerConfig& config) {
 
         // Initialize game world
         auto game_world = std::make_shared<GameWorld>();
+        configure_world(*game_world, config);
         LOG_INFO("Game world initialized");
 
+        if (!config.triggers_file.empty()) {
+            std::string error;
+            if (!game_world->load_triggers(config.triggers_file, error)) {
+                LOG_ERROR("Failed to load triggers: " + error);
+                return 1;
+            }
+        }
+        if (!load_leaderboard(*game_world, config)) {
+            return 1;
+        }
+
         // Initialize telnet server
         auto telnet_server = std::make_unique<TelnetServer>(config.port);
 
-        if (!telnet_server->initialize()) {
+        // Connect game world to telnet server, or hand players to zone servers
+        std::unique_ptr<ZoneGateway> gateway;
+        if (!config.gateway_zones.empty()) {
+            gateway = std::make_unique<ZoneGateway>(zone_map);
+            if (!gateway->connect_zones(config.gateway_zones)) {
+                LOG_ERROR("Failed to connect to the zone servers");
+                return 1;
+            }
+            telnet_server->set_gateway(gateway.get());
+        } else {
+            telnet_server->set_game_world(game_world);
+        }
+
+        // Seed explicitly so a recorded session can be replayed exactly
+        uint64_t seed = config.has_seed ? config.seed
+            : static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        RandomGenerator::set_global_seed(seed);
+        if (!gateway) {
+            game_world->get_contracts().start(RandomGenerator::stream_seed(seed, CONTRACT_SEED_STREAM));
+        }
+
+        std::shared_ptr<CommandRecorder> recorder;
+        if (!config.record_file.empty()) {
+            recorder = std::make_shared<CommandRecorder>();
+            // After a hot reboot keep extending the same trace
+            bool append = !config.copyover_restore_file.empty();
+            if (recorder->open(config.record_file, seed, append)) {
+                telnet_server->set_command_recorder(recorder);
+            } else {
+                LOG_WARNING("Continuing without command recording");
+            }
+        }
+
+        telnet_server->set_flood_limits(config.flood_limits);
+
+        AdmissionLimits admission;
+        admission.max_players = static_cast<size_t>(std::max(1, config.max_players));
+        telnet_server->set_admission_limits(admission);
+
+        if (!config.admin_password.empty()) {
+            telnet_server->set_admin_password(config.admin_password);
+        }
+
+        auto& metrics = MetricsRegistry::get_instance();
+        if (!config.stats_file.empty() && !metrics.open_export(config.stats_file)) {
+            LOG_WARNING("Continuing without a stats file");
+        }
+        auto& tick_latency = metrics.histogram("tick.duration");
+        auto& arena_reserved = metrics.gauge("tick.arena_reserved");
+        Arena& arena = tick_arena();
+        auto last_publish = std::chrono::steady_clock::now();
+        auto last_leaderboard_save = last_publish;
+
+        if (!config.copyover_restore_file.empty()) {
+            // Started by a hot reboot: adopt the inherited sockets instead of binding again
+            auto restore_start = std::chrono::steady_clock::now();
+            CopyoverState state;
+            bool restored = read_copyover_file(config.copyover_restore_file, state) &&
+                            telnet_server->restore_from_copyover(state);
+            std::remove(config.copyover_restore_file.c_str());
+            if (!restored) {
+                LOG_ERROR("Failed to restore from hot reboot");
+                return 1;
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - restore_start);
+            LOG_INFO("Hot reboot restore took " + std::to_string(elapsed.count()) + " us");
+        } else if (!telnet_server->initialize()) {
             LOG_ERROR("Failed to initialize telnet server");
             return 1;
         }
 
-        // Connect game world to telnet server
-        telnet_server->set_game_world(game_world);
+        // TLS sessions don't survive a hot reboot, so the listener is bound
+        // fresh by every image
+        if (config.tls_port > 0 &&
+            !telnet_server->enable_tls(config.tls_port, config.tls_cert_file, config.tls_key_file)) {
+            LOG_ERROR("Failed to start the TLS listener");
+            return 1;
+        }
+        // Also after a hot reboot: the ring doesn't survive exec, the sockets do
+        if (!telnet_server->set_io_backend(config.io_backend)) {
+            LOG_WARNING("Falling back to the sockets I/O backend");
+        }
 
         LOG_INFO("Telnet Server initialized successfully");
 
         // Main server loop
         while (!g_shutdown_requested) {
-            // Accept new connections
-            telnet_server->accept_connections();
+            // Hot reboot between ticks so no command is half processed
+            if (g_copyover_requested.exchange(false)) {
+                if (gateway) {
+                    LOG_WARNING("Hot reboot is not supported in gateway mode");
+                } else {
+                    save_leaderboard(*game_world, config);
+                    game_world->get_contracts().stop();
+                    if (!perform_copyover(*telnet_server, config, recorder.get())) {
+                        game_world->get_contracts().start(RandomGenerator::stream_seed(seed, CONTRACT_SEED_STREAM));
+                    }
+                }
+            }
+
+            auto tick_start = std::chrono::steady_clock::now();
+            {
+                ScopedLatency tick_timer(tick_latency);
+                TRACE_SCOPE("tick");
+
+                // Accept new connections
+                telnet_server->accept_connections();
 
-            // Process existing connections
-            telnet_server->process_connections();
+                // Timed room scripts run before input so their output leaves this tick
+                game_world->run_timers(std::chrono::steady_clock::now());
 
-            // Clean up disconnected connections
-            telnet_server->remove_disconnected_connections();
+                // Process existing connections
+                telnet_server->process_connections();
+
+                // Replies from zone servers
+                if (gateway) {
+                    gateway->poll();
+                }
+
+                // Clean up disconnected connections
+                telnet_server->remove_disconnected_connections();
+
+                // With io_uring, everything written this tick leaves in one submission
+                telnet_server->flush_output();
+
+                // What read-only commands see until the next tick
+                game_world->publish_snapshot();
+            }
+
+            // Output still waiting on slow clients counts against admission
+            telnet_server->record_tick(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           std::chrono::steady_clock::now() - tick_start),
+                                       telnet_server->get_queued_output_bytes());
+
+            // Everything built for this tick's responses is released at once
+            arena_reserved.set(static_cast<int64_t>(arena.bytes_reserved()));
+            arena.reset();
+
+            // Regions loaded this tick may have pushed the world over budget
+            auto now = std::chrono::steady_clock::now();
+            if (game_world->needs_region_eviction()) {
+                game_world->evict_idle_regions(now);
+            }
+
+            // Refresh the stats file about once a second
+            if (now - last_publish >= std::chrono::seconds(1)) {
+                game_world->evict_idle_regions(now);
+                metrics.publish();
+                if (recorder) {
+                    recorder->flush();
+                }
+                last_publish = now;
+            }
+            if (now - last_leaderboard_save >= LEADERBOARD_SAVE_INTERVAL) {
+                save_leaderboard(*game_world, config);
+                last_leaderboard_save = now;
+            }
 
             // Small delay to prevent busy waiting
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -140,6 +734,7 @@ int run_server(const ServerConfig& config) {
 
         LOG_INFO("Shutting down server...");
         telnet_server->shutdown();
+        save_leaderboard(*game_world, config);
         LOG_INFO("Server shutdown complete");
         return 0;
 
@@ -154,6 +749,9 @@ int main(int argc, char* argv[]) {
         // Set up signal handlers for graceful shutdown
         signal(SIGINT, signal_handler);
         signal(SIGTERM, signal_handler);
+        signal(SIGUSR1, copyover_signal_handler);
+        // OpenSSL writes with plain write(), so a vanished TLS client must not kill us
+        signal(SIGPIPE, SIG_IGN);
 
         // Parse command line arguments
         ServerConfig config = parse_arguments(argc, argv);
@@ -161,10 +759,35 @@ int main(int argc, char* argv[]) {
         // Set up logging
         if (config.debug_mode) {
             LOG_INFO("Debug mode enabled");
+        } else {
+            Logger::get_instance().set_min_level(LogLevel::INFO);
+        }
+
+        ZoneMap zone_map;
+        std::string error;
+        if (!config.zone_map.empty() && !zone_map.parse(config.zone_map, error)) {
+            LOG_ERROR("Invalid zone map: " + error);
+            return 1;
+        }
+
+        if (config.zone >= 0) {
+            if (config.zone_socket.empty() || static_cast<size_t>(config.zone) >= zone_map.zone_count()) {
+                LOG_ERROR("--zone needs --zone-socket and a zone that --zone-map defines");
+                return 1;
+            }
+            return run_zone_server(config, zone_map);
+        }
+        if (config.tls_port > 0 && (config.tls_cert_file.empty() || config.tls_key_file.empty())) {
+            LOG_ERROR("--tls-port needs --tls-cert and --tls-key");
+            return 1;
+        }
+        if (!config.gateway_zones.empty() && config.gateway_zones.size() != zone_map.zone_count()) {
+            LOG_ERROR("--gateway needs one socket per zone in --zone-map");
+            return 1;
         }
 
         // Run the server
-        return run_server(config);
+        return run_server(config, zone_map);
 
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
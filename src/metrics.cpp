@@ -0,0 +1,269 @@
+#include "metrics.hpp"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <iomanip>
+
+namespace dungeon_merc {
+
+namespace {
+
+constexpr uint32_t METRICS_EXPORT_VERSION = 1;
+
+std::atomic<size_t> g_next_metrics_shard(0);
+
+// Nanoseconds rendered with a unit that keeps the number short
+std::string format_duration(uint64_t ns) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns >= 1000000000ULL) {
+        ss << (ns / 1e9) << "s";
+    } else if (ns >= 1000000ULL) {
+        ss << (ns / 1e6) << "ms";
+    } else if (ns >= 1000ULL) {
+        ss << (ns / 1e3) << "us";
+    } else {
+        ss << ns << "ns";
+    }
+    return ss.str();
+}
+
+} // namespace
+
+size_t metrics_thread_shard() {
+    thread_local size_t shard = g_next_metrics_shard.fetch_add(1, std::memory_order_relaxed) % METRICS_COUNTER_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(value);
+    }
+
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    int sub_bucket = static_cast<int>(value >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return SUB_BUCKETS * (exponent - SUB_BUCKET_BITS + 1) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_lower_bound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+
+    int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t sub_bucket = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS);
+    return sub_bucket << (exponent - SUB_BUCKET_BITS);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value > current_max &&
+           !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double pct) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(pct / 100.0 * static_cast<double>(total));
+    if (target >= total) {
+        target = total - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen > target) {
+            return std::min(bucket_lower_bound(i), max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+MetricsRegistry::~MetricsRegistry() {
+    close_export();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = counters_[name];
+    if (!slot) {
+        slot = std::make_unique<Counter>();
+    }
+    return *slot;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = gauges_[name];
+    if (!slot) {
+        slot = std::make_unique<Gauge>();
+    }
+    return *slot;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = histograms_[name];
+    if (!slot) {
+        slot = std::make_unique<LatencyHistogram>();
+    }
+    return *slot;
+}
+
+bool MetricsRegistry::open_export(const std::string& path) {
+    close_export();
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open stats file: " + path);
+        return false;
+    }
+
+    size_t size = sizeof(MetricsExportHeader) + METRICS_EXPORT_MAX_ENTRIES * sizeof(MetricsExportEntry);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        LOG_ERROR("Failed to size stats file: " + path);
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Failed to map stats file: " + path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    export_header_ = static_cast<MetricsExportHeader*>(mapping);
+    export_size_ = size;
+    std::memcpy(export_header_->magic, "DMSTATS", 8);
+    export_header_->version = METRICS_EXPORT_VERSION;
+    export_header_->entry_count = 0;
+    export_header_->sequence.store(0, std::memory_order_relaxed);
+
+    LOG_INFO("Exporting metrics to " + path);
+    return true;
+}
+
+void MetricsRegistry::publish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!export_header_) {
+        return;
+    }
+
+    auto* entries = reinterpret_cast<MetricsExportEntry*>(export_header_ + 1);
+    uint32_t count = 0;
+
+    auto next_entry = [&](const std::string& name, MetricType type) -> MetricsExportEntry* {
+        if (count >= METRICS_EXPORT_MAX_ENTRIES) {
+            return nullptr;
+        }
+        MetricsExportEntry* entry = &entries[count++];
+        std::memset(entry, 0, sizeof(*entry));
+        std::strncpy(entry->name, name.c_str(), METRICS_EXPORT_NAME_LENGTH - 1);
+        entry->type = static_cast<uint32_t>(type);
+        return entry;
+    };
+
+    // Odd sequence tells readers a write is in progress
+    uint64_t sequence = export_header_->sequence.load(std::memory_order_relaxed);
+    export_header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (const auto& pair : counters_) {
+        if (auto* entry = next_entry(pair.first, MetricType::COUNTER)) {
+            entry->value = static_cast<int64_t>(pair.second->value());
+        }
+    }
+    for (const auto& pair : gauges_) {
+        if (auto* entry = next_entry(pair.first, MetricType::GAUGE)) {
+            entry->value = pair.second->value();
+        }
+    }
+    for (const auto& pair : histograms_) {
+        if (auto* entry = next_entry(pair.first, MetricType::HISTOGRAM)) {
+            const auto& histogram = *pair.second;
+            entry->value = static_cast<int64_t>(histogram.sum());
+            entry->count = histogram.count();
+            entry->p50 = histogram.percentile(50.0);
+            entry->p90 = histogram.percentile(90.0);
+            entry->p99 = histogram.percentile(99.0);
+            entry->p999 = histogram.percentile(99.9);
+            entry->max = histogram.max();
+        }
+    }
+
+    export_header_->entry_count = count;
+    export_header_->updated_unix_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+    std::atomic_thread_fence(std::memory_order_release);
+    export_header_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void MetricsRegistry::close_export() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (export_header_) {
+        munmap(export_header_, export_size_);
+        export_header_ = nullptr;
+        export_size_ = 0;
+    }
+}
+
+std::vector<std::string> MetricsRegistry::format_report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> lines;
+
+    for (const auto& pair : gauges_) {
+        lines.push_back("  " + pair.first + ": " + std::to_string(pair.second->value()));
+    }
+    for (const auto& pair : counters_) {
+        lines.push_back("  " + pair.first + ": " + std::to_string(pair.second->value()));
+    }
+    for (const auto& pair : histograms_) {
+        const auto& histogram = *pair.second;
+        if (histogram.count() == 0) {
+            continue;
+        }
+        lines.push_back("  " + pair.first + ": n=" + std::to_string(histogram.count()) +
+                        " p50=" + format_duration(histogram.percentile(50.0)) +
+                        " p99=" + format_duration(histogram.percentile(99.0)) +
+                        " p999=" + format_duration(histogram.percentile(99.9)) +
+                        " max=" + format_duration(histogram.max()));
+    }
+
+    return lines;
+}
+
+} // namespace dungeon_merc
@@ -41,10 +41,11 @@ void Player::take_damage(int amount) {
     }
 
     health_ = std::max(0, health_ - amount);
-    LOG_INFO("Player " + name_ + " took " + std::to_string(amount) + " damage. Health: " + std::to_string(health_));
+    mark_dirty(PLAYER_DIRTY_VITALS);
+    LOG_INFO("Player " + get_name() + " took " + std::to_string(amount) + " damage. Health: " + std::to_string(health_));
 
     if (!is_alive()) {
-        LOG_INFO("Player " + name_ + " has died!");
+        LOG_INFO("Player " + get_name() + " has died!");
     }
 }
 
@@ -54,7 +55,8 @@ void Player::heal(int amount) {
     }
 
     health_ = std::min(max_health_, health_ + amount);
-    LOG_INFO("Player " + name_ + " healed " + std::to_string(amount) + " health. Health: " + std::to_string(health_));
+    mark_dirty(PLAYER_DIRTY_VITALS);
+    LOG_INFO("Player " + get_name() + " healed " + std::to_string(amount) + " health. Health: " + std::to_string(health_));
 }
 
 bool Player::is_alive() const {
@@ -67,16 +69,23 @@ void Player::gain_experience(int amount) {
     }
 
     experience_ += amount;
-    LOG_INFO("Player " + name_ + " gained " + std::to_string(amount) + " experience. Total: " + std::to_string(experience_));
+    mark_dirty(PLAYER_DIRTY_VITALS);
+    LOG_INFO("Player " + get_name() + " gained " + std::to_string(amount) + " experience. Total: " + std::to_string(experience_));
 
     // Check for level up
     while (experience_ >= experience_to_next_level_) {
         level_up();
     }
+    if (observer_) {
+        observer_->on_progress_changed(*this);
+    }
 }
 
 void Player::level_up() {
     level_++;
+    if (observer_) {
+        observer_->on_level_changed(*this, level_ - 1);
+    }
     experience_ -= experience_to_next_level_;
 
     // Increase stats
@@ -84,11 +93,30 @@ void Player::level_up() {
     health_ = max_health_; // Full heal on level up
 
     calculate_experience_to_next_level();
+    mark_dirty(PLAYER_DIRTY_VITALS);
+    if (observer_) {
+        observer_->on_progress_changed(*this);
+    }
 
-    LOG_INFO("Player " + name_ + " reached level " + std::to_string(level_) + "!");
+    LOG_INFO("Player " + get_name() + " reached level " + std::to_string(level_) + "!");
 }
 
 
+void Player::restore_progress(int level, int experience, int health, int max_health) {
+    int old_level = level_;
+    level_ = std::max(1, level);
+    if (observer_ && level_ != old_level) {
+        observer_->on_level_changed(*this, old_level);
+    }
+    experience_ = std::max(0, experience);
+    max_health_ = std::max(1, max_health);
+    health_ = std::max(0, std::min(health, max_health_));
+    calculate_experience_to_next_level();
+    mark_dirty(PLAYER_DIRTY_VITALS);
+    if (observer_) {
+        observer_->on_progress_changed(*this);
+    }
+}
 
 void Player::calculate_experience_to_next_level() {
     // Simple exponential experience curve
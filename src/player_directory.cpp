@@ -0,0 +1,77 @@
+#include "player_directory.hpp"
+#include "tokenizer.hpp"
+
+namespace dungeon_merc {
+
+void PlayerDirectory::add(PlayerId id, const Player& player) {
+    std::string_view name = player.get_name();
+    by_name_.insert(NameEntry{name, &player, id});
+
+    WhoEntry entry{player.get_level(), name, &player, id};
+    who_.insert(entry);
+    who_by_class_[class_slot(player.get_character_class())].insert(entry);
+    ++version_;
+}
+
+void PlayerDirectory::remove(PlayerId id, const Player& player) {
+    std::string_view name = player.get_name();
+    by_name_.erase(NameEntry{name, &player, id});
+
+    WhoEntry entry{player.get_level(), name, &player, id};
+    who_.erase(entry);
+    who_by_class_[class_slot(player.get_character_class())].erase(entry);
+    ++version_;
+}
+
+PlayerId PlayerDirectory::find(std::string_view name) const {
+    auto it = by_name_.lower_bound(NameProbe{name});
+    if (it == by_name_.end() || icompare(it->name, name) != 0) {
+        return PlayerId{};
+    }
+    return it->id;
+}
+
+PlayerId PlayerDirectory::id_of(const Player& player) const {
+    auto it = by_name_.find(NameEntry{player.get_name(), &player, PlayerId{}});
+    return it != by_name_.end() ? it->id : PlayerId{};
+}
+
+void PlayerDirectory::on_level_changed(const Player& player, int old_level) {
+    PlayerId id = id_of(player);
+    if (!id.is_valid()) {
+        return;
+    }
+
+    // Re-key the who entries: the level is part of the sort order
+    WhoSet& by_class = who_by_class_[class_slot(player.get_character_class())];
+    WhoEntry old_entry{old_level, player.get_name(), &player, id};
+    who_.erase(old_entry);
+    by_class.erase(old_entry);
+
+    WhoEntry entry{player.get_level(), player.get_name(), &player, id};
+    who_.insert(entry);
+    by_class.insert(entry);
+    ++version_;
+}
+
+bool parse_character_class(std::string_view text, CharacterClass& cls) {
+    static const std::pair<std::string_view, CharacterClass> classes[] = {
+        {"scout", CharacterClass::SCOUT},
+        {"enforcer", CharacterClass::ENFORCER},
+        {"tech", CharacterClass::TECH},
+        {"ghost", CharacterClass::GHOST},
+    };
+
+    if (text.empty()) {
+        return false;
+    }
+    for (const auto& [name, value] : classes) {
+        if (istarts_with(name, text)) {
+            cls = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,37 @@
+#include "player_table.hpp"
+
+namespace dungeon_merc {
+
+PlayerId PlayerTable::create(const std::string& name, CharacterClass character_class) {
+    uint32_t index;
+    if (!free_slots_.empty()) {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+
+    Slot& slot = slots_[index];
+    slot.player.emplace(name, character_class);
+    live_count_++;
+    return PlayerId{index, slot.generation};
+}
+
+bool PlayerTable::destroy(PlayerId id) {
+    if (!contains(id)) {
+        return false;
+    }
+
+    Slot& slot = slots_[id.index];
+    slot.player.reset();
+    // Skip 0 on wrap-around so a default-constructed handle never matches
+    if (++slot.generation == 0) {
+        slot.generation = 1;
+    }
+    free_slots_.push_back(id.index);
+    live_count_--;
+    return true;
+}
+
+} // namespace dungeon_merc
@@ -1,25 +1,29 @@
 #include "room.hpp"
 #include "player.hpp"
+#include "trace.hpp"
 #include <algorithm>
-#include <sstream>
 
 using namespace dungeon_merc;
 
-Room::Room(int id, const std::string& name, const std::string& description)
+Room::Room(int id, std::string_view name, std::string_view description)
+    : Room(id, StringPool::get_instance().intern(name), StringPool::get_instance().intern_text(description)) {
+}
+
+Room::Room(int id, StringId name, StringId description)
     : id_(id), name_(name), description_(description) {
+    exits_.fill(NO_EXIT);
 }
 
 void Room::add_exit(Direction dir, int target_room_id) {
-    exits_[dir] = target_room_id;
+    exits_[static_cast<size_t>(dir)] = target_room_id;
 }
 
 bool Room::has_exit(Direction dir) const {
-    return exits_.find(dir) != exits_.end();
+    return exits_[static_cast<size_t>(dir)] != NO_EXIT;
 }
 
 int Room::get_exit_room_id(Direction dir) const {
-    auto it = exits_.find(dir);
-    return (it != exits_.end()) ? it->second : -1;
+    return exits_[static_cast<size_t>(dir)];
 }
 
 std::string Room::get_exit_description(Direction dir) const {
@@ -33,62 +37,109 @@ std::string Room::get_exit_description(Direction dir) const {
 
 std::vector<std::string> Room::get_available_exits() const {
     std::vector<std::string> exits;
-    for (const auto& exit : exits_) {
+    for (const auto& exit : get_exits()) {
         exits.push_back(direction_to_string(exit.first));
     }
     return exits;
 }
 
-void Room::add_player(std::shared_ptr<Player> player) {
+void Room::add_player(PlayerId player) {
     // Check if player is already in this room
     auto it = std::find(players_.begin(), players_.end(), player);
     if (it == players_.end()) {
         players_.push_back(player);
+        ++players_version_;
     }
 }
 
-void Room::remove_player(std::shared_ptr<Player> player) {
+void Room::remove_player(PlayerId player) {
     auto it = std::find(players_.begin(), players_.end(), player);
     if (it != players_.end()) {
         players_.erase(it);
+        ++players_version_;
     }
 }
 
-std::string Room::get_full_description() const {
-    std::stringstream ss;
-    ss << name_ << "\n";
-    ss << description_ << "\n";
+size_t Room::get_memory_usage() const {
+    return sizeof(Room) + players_.capacity() * sizeof(PlayerId);
+}
+
+std::string Room::get_full_description(const PlayerTable& players) const {
+    Arena& arena = tick_arena();
+    Arena::Checkpoint checkpoint = arena.checkpoint();
+    ArenaString out(arena);
+    render_description(out, players);
+    std::string description = out.str();
+    arena.rewind(checkpoint);
+    return description;
+}
+
+std::string Room::get_exits_list() const {
+    Arena& arena = tick_arena();
+    Arena::Checkpoint checkpoint = arena.checkpoint();
+    ArenaString out(arena);
+    append_exits(out);
+    std::string exits = out.str();
+    arena.rewind(checkpoint);
+    return exits;
+}
+
+void Room::render_description(ArenaString& out, const PlayerTable& players) const {
+    TRACE_SCOPE("render.room");
+    const StringPool& pool = StringPool::get_instance();
+    out << pool.get(name_) << '\n';
+    pool.append(description_, out);
+    out << '\n';
 
     if (!players_.empty()) {
-        ss << "\nPlayers here: ";
-        for (size_t i = 0; i < players_.size(); ++i) {
-            if (i > 0) ss << ", ";
-            ss << players_[i]->get_name();
+        out << "\nPlayers here: ";
+        bool first = true;
+        for (PlayerId id : players_) {
+            const Player* player = players.get(id);
+            if (!player) {
+                continue;
+            }
+            if (!first) out << ", ";
+            out << player->get_name();
+            first = false;
         }
-        ss << "\n";
+        out << '\n';
     }
 
-    ss << get_exits_list();
-    return ss.str();
+    append_exits(out);
 }
 
-std::string Room::get_exits_list() const {
-    if (exits_.empty()) {
-        return "\nThere are no visible exits.";
+void Room::render_occupants(ArenaString& out, const PlayerTable& players) const {
+    if (players_.empty()) {
+        out << "You are alone here.";
+        return;
     }
 
-    std::stringstream ss;
-    ss << "\nExits: ";
-
-    std::vector<std::string> exit_names;
-    for (const auto& exit : exits_) {
-        exit_names.push_back(direction_to_string(exit.first));
+    out << "Players in this room: ";
+    bool first = true;
+    for (PlayerId id : players_) {
+        const Player* player = players.get(id);
+        if (!player) {
+            continue;
+        }
+        if (!first) out << ", ";
+        out << player->get_name();
+        first = false;
     }
+}
 
-    for (size_t i = 0; i < exit_names.size(); ++i) {
-        if (i > 0) ss << ", ";
-        ss << exit_names[i];
+void Room::append_exits(ArenaString& out) const {
+    RoomExits exits = get_exits();
+    if (exits.empty()) {
+        out << "\nThere are no visible exits.";
+        return;
     }
 
-    return ss.str();
+    out << "\nExits: ";
+    bool first = true;
+    for (const auto& exit : exits) {
+        if (!first) out << ", ";
+        out << direction_name(exit.first);
+        first = false;
+    }
 }
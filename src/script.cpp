@@ -0,0 +1,739 @@
+#include "script.hpp"
+#include "random.hpp"
+#include <cctype>
+#include <charconv>
+
+namespace dungeon_merc {
+
+namespace {
+
+enum class TokenKind {
+    NUMBER,
+    NAME,
+    STRING,
+    SYMBOL,
+    NEWLINE,
+    END,
+};
+
+struct Token {
+    TokenKind kind;
+    std::string_view text;
+    int32_t number = 0;
+    std::string value;  // Unescaped string literal
+    int line = 0;
+};
+
+struct NamedValue {
+    std::string_view name;
+    int32_t value;
+};
+
+const NamedValue BUILTINS[] = {
+    {"level", static_cast<int32_t>(ScriptBuiltin::LEVEL)},
+    {"health", static_cast<int32_t>(ScriptBuiltin::HEALTH)},
+    {"max_health", static_cast<int32_t>(ScriptBuiltin::MAX_HEALTH)},
+    {"xp", static_cast<int32_t>(ScriptBuiltin::XP)},
+    {"room", static_cast<int32_t>(ScriptBuiltin::ROOM)},
+    {"players", static_cast<int32_t>(ScriptBuiltin::PLAYERS)},
+    {"class", static_cast<int32_t>(ScriptBuiltin::CLASS)},
+};
+
+const NamedValue CONSTANTS[] = {
+    {"true", 1},
+    {"false", 0},
+    {"scout", static_cast<int32_t>(CharacterClass::SCOUT)},
+    {"enforcer", static_cast<int32_t>(CharacterClass::ENFORCER)},
+    {"tech", static_cast<int32_t>(CharacterClass::TECH)},
+    {"ghost", static_cast<int32_t>(CharacterClass::GHOST)},
+};
+
+const std::string_view KEYWORDS[] = {
+    "let", "if", "elif", "else", "end", "while", "and", "or", "not", "random",
+    "send", "echo", "heal", "damage", "xp", "teleport", "loot", "block", "stop",
+};
+
+template<size_t N>
+const NamedValue* find_named(const NamedValue (&table)[N], std::string_view name) {
+    for (const auto& entry : table) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool is_reserved(std::string_view name) {
+    for (auto keyword : KEYWORDS) {
+        if (keyword == name) {
+            return true;
+        }
+    }
+    return find_named(BUILTINS, name) || find_named(CONSTANTS, name);
+}
+
+// Single-pass compiler: the source is lexed up front, then statements are
+// parsed by recursive descent and emitted straight to bytecode. Named
+// variables get fixed registers; expression temporaries are stacked above
+// them and released at the end of each expression.
+class ScriptCompiler {
+public:
+    ScriptCompiler(std::string_view source, int first_line, CompiledScript& script, std::string& error)
+        : source_(source), line_(first_line), script_(script), error_(error) {}
+
+    bool compile() {
+        script_ = CompiledScript();
+        if (!lex()) {
+            return false;
+        }
+
+        std::string_view ended_by;
+        if (!block(ended_by)) {
+            return false;
+        }
+        if (!ended_by.empty()) {
+            return fail(tokens_[pos_ - 1], "'" + std::string(ended_by) + "' without a matching block");
+        }
+        emit(ScriptOp::HALT);
+        if (script_.code.size() > UINT16_MAX) {
+            return fail(tokens_.back(), "script too long");
+        }
+        return true;
+    }
+
+private:
+    std::string_view source_;
+    int line_;
+    CompiledScript& script_;
+    std::string& error_;
+
+    std::vector<Token> tokens_;
+    size_t pos_ = 0;
+
+    std::vector<std::pair<std::string_view, uint8_t>> locals_;
+    size_t temp_top_ = 0;
+    size_t depth_ = 0;  // The parser recurses, so hostile input must not nest without bound
+
+    bool fail(const Token& token, const std::string& message) {
+        error_ = "line " + std::to_string(token.line) + ": " + message;
+        return false;
+    }
+
+    // Pair with leave() on success; a failed compile stops where it is
+    bool enter(const Token& token) {
+        if (++depth_ > SCRIPT_MAX_NESTING) {
+            return fail(token, "nested too deeply");
+        }
+        return true;
+    }
+
+    bool leave(bool ok) {
+        --depth_;
+        return ok;
+    }
+
+    // Lexing
+
+    bool lex() {
+        size_t i = 0;
+        while (i < source_.size()) {
+            char c = source_[i];
+            if (c == '\n') {
+                push(TokenKind::NEWLINE, i, 1);
+                ++line_;
+                ++i;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                ++i;
+            } else if (c == '#') {
+                while (i < source_.size() && source_[i] != '\n') {
+                    ++i;
+                }
+            } else if (std::isdigit(static_cast<unsigned char>(c))) {
+                size_t start = i;
+                while (i < source_.size() && std::isdigit(static_cast<unsigned char>(source_[i]))) {
+                    ++i;
+                }
+                Token& token = push(TokenKind::NUMBER, start, i - start);
+                auto parsed = std::from_chars(source_.data() + start, source_.data() + i, token.number);
+                if (parsed.ec != std::errc()) {
+                    return fail(token, "number out of range");
+                }
+            } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                size_t start = i;
+                while (i < source_.size() &&
+                       (std::isalnum(static_cast<unsigned char>(source_[i])) || source_[i] == '_')) {
+                    ++i;
+                }
+                push(TokenKind::NAME, start, i - start);
+            } else if (c == '"') {
+                size_t start = i++;
+                std::string value;
+                while (i < source_.size() && source_[i] != '"' && source_[i] != '\n') {
+                    if (source_[i] == '\\' && i + 1 < source_.size() && source_[i + 1] != '\n') {
+                        ++i;
+                    }
+                    value.push_back(source_[i++]);
+                }
+                if (i >= source_.size() || source_[i] != '"') {
+                    Token token{TokenKind::STRING, source_.substr(start, 1), 0, "", line_};
+                    return fail(token, "unterminated string");
+                }
+                ++i;
+                push(TokenKind::STRING, start, i - start).value = std::move(value);
+            } else {
+                static const std::string_view two_char[] = {"==", "!=", "<=", ">="};
+                size_t length = 1;
+                for (auto symbol : two_char) {
+                    if (source_.substr(i, 2) == symbol) {
+                        length = 2;
+                    }
+                }
+                if (length == 1 && std::string_view("+-*/%()<>=,").find(c) == std::string_view::npos) {
+                    Token token{TokenKind::SYMBOL, source_.substr(i, 1), 0, "", line_};
+                    return fail(token, "unexpected character '" + std::string(1, c) + "'");
+                }
+                push(TokenKind::SYMBOL, i, length);
+                i += length;
+            }
+        }
+        push(TokenKind::NEWLINE, source_.size(), 0);
+        push(TokenKind::END, source_.size(), 0);
+        return true;
+    }
+
+    Token& push(TokenKind kind, size_t start, size_t length) {
+        tokens_.push_back(Token{kind, source_.substr(start, length), 0, "", line_});
+        return tokens_.back();
+    }
+
+    const Token& peek() const { return tokens_[pos_]; }
+    const Token& advance() { return tokens_[pos_ < tokens_.size() - 1 ? pos_++ : pos_]; }
+
+    bool check(std::string_view text) const {
+        return (peek().kind == TokenKind::SYMBOL || peek().kind == TokenKind::NAME) && peek().text == text;
+    }
+
+    bool match(std::string_view text) {
+        if (check(text)) {
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(std::string_view text) {
+        if (match(text)) {
+            return true;
+        }
+        return fail(peek(), "expected '" + std::string(text) + "'");
+    }
+
+    bool end_of_statement() {
+        if (peek().kind != TokenKind::NEWLINE) {
+            return fail(peek(), "unexpected '" + std::string(peek().text) + "'");
+        }
+        advance();
+        return true;
+    }
+
+    // Emission
+
+    size_t emit(ScriptOp op, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0) {
+        script_.code.push_back(ScriptInstruction{op, a, b, c});
+        return script_.code.size() - 1;
+    }
+
+    size_t emit_bx(ScriptOp op, uint8_t a, size_t bx) {
+        return emit(op, a, static_cast<uint8_t>(bx >> 8), static_cast<uint8_t>(bx & 0xff));
+    }
+
+    void patch(size_t at, size_t target) {
+        script_.code[at].b = static_cast<uint8_t>(target >> 8);
+        script_.code[at].c = static_cast<uint8_t>(target & 0xff);
+    }
+
+    bool fits(const Token& token, size_t index, const char* what) {
+        if (index > UINT16_MAX) {
+            return fail(token, std::string("too many ") + what);
+        }
+        return true;
+    }
+
+    bool load_constant(const Token& token, uint8_t dest, int32_t value) {
+        size_t index = 0;
+        while (index < script_.constants.size() && script_.constants[index] != value) {
+            ++index;
+        }
+        if (index == script_.constants.size()) {
+            script_.constants.push_back(value);
+        }
+        if (!fits(token, index, "constants")) {
+            return false;
+        }
+        emit_bx(ScriptOp::LOADK, dest, index);
+        return true;
+    }
+
+    bool add_string(const Token& token, size_t& index) {
+        index = script_.strings.size();
+        script_.strings.push_back(token.value);
+        return fits(token, index, "strings");
+    }
+
+    bool alloc_temp(const Token& token, uint8_t& reg) {
+        if (temp_top_ >= SCRIPT_REGISTERS) {
+            return fail(token, "expression too complex or too many variables");
+        }
+        reg = static_cast<uint8_t>(temp_top_++);
+        return true;
+    }
+
+    const std::pair<std::string_view, uint8_t>* find_local(std::string_view name) const {
+        for (const auto& local : locals_) {
+            if (local.first == name) {
+                return &local;
+            }
+        }
+        return nullptr;
+    }
+
+    // Statements
+
+    // Compile statements until end of input or a block keyword (end, elif,
+    // else), which is consumed and reported through ended_by
+    bool block(std::string_view& ended_by) {
+        return enter(peek()) && leave(block_body(ended_by));
+    }
+
+    bool block_body(std::string_view& ended_by) {
+        ended_by = {};
+        while (peek().kind != TokenKind::END) {
+            if (peek().kind == TokenKind::NEWLINE) {
+                advance();
+                continue;
+            }
+            if (check("end") || check("elif") || check("else")) {
+                ended_by = advance().text;
+                return true;
+            }
+            if (!statement()) {
+                return false;
+            }
+            temp_top_ = locals_.size();
+        }
+        return true;
+    }
+
+    bool statement() {
+        const Token& token = advance();
+        if (token.kind != TokenKind::NAME) {
+            return fail(token, "expected a statement");
+        }
+        std::string_view word = token.text;
+
+        if (word == "let") {
+            const Token& name = advance();
+            if (name.kind != TokenKind::NAME || is_reserved(name.text)) {
+                return fail(name, "expected a variable name");
+            }
+            if (find_local(name.text)) {
+                return fail(name, "'" + std::string(name.text) + "' is already defined");
+            }
+            uint8_t reg = 0;
+            if (!alloc_temp(name, reg) || !expect("=") || !expression(reg)) {
+                return false;
+            }
+            locals_.emplace_back(name.text, reg);
+            return end_of_statement();
+        }
+        if (word == "if") {
+            return if_statement();
+        }
+        if (word == "while") {
+            return while_statement();
+        }
+        if (word == "send" || word == "echo" || word == "loot") {
+            const Token& text = advance();
+            if (text.kind != TokenKind::STRING) {
+                return fail(text, "expected a quoted string");
+            }
+            size_t index;
+            if (!add_string(text, index)) {
+                return false;
+            }
+            emit_bx(word == "send" ? ScriptOp::SEND : word == "echo" ? ScriptOp::ECHO : ScriptOp::LOOT, 0, index);
+            return end_of_statement();
+        }
+        if (word == "heal" || word == "damage" || word == "xp" || word == "teleport") {
+            ScriptOp op = word == "heal" ? ScriptOp::HEAL
+                        : word == "damage" ? ScriptOp::DAMAGE
+                        : word == "xp" ? ScriptOp::XP : ScriptOp::TELEPORT;
+            uint8_t reg = 0;
+            if (!alloc_temp(token, reg) || !expression(reg)) {
+                return false;
+            }
+            emit(op, reg);
+            return end_of_statement();
+        }
+        if (word == "block") {
+            emit(ScriptOp::BLOCK);
+            return end_of_statement();
+        }
+        if (word == "stop") {
+            emit(ScriptOp::HALT);
+            return end_of_statement();
+        }
+
+        // Assignment goes through a temporary: 'x = 1 + x' must not clobber x early
+        auto local = find_local(word);
+        if (local && match("=")) {
+            uint8_t value = 0;
+            if (!alloc_temp(token, value) || !expression(value)) {
+                return false;
+            }
+            emit(ScriptOp::MOVE, local->second, value);
+            return end_of_statement();
+        }
+        return fail(token, "unknown statement '" + std::string(word) + "'");
+    }
+
+    bool if_statement() {
+        std::vector<size_t> exits;
+        while (true) {
+            uint8_t cond = 0;
+            if (!alloc_temp(peek(), cond) || !expression(cond) || !end_of_statement()) {
+                return false;
+            }
+            temp_top_ = locals_.size();
+            size_t skip = emit_bx(ScriptOp::JMPF, cond, 0);
+
+            std::string_view ended_by;
+            if (!block(ended_by)) {
+                return false;
+            }
+            if (ended_by.empty()) {
+                return fail(peek(), "'if' without 'end'");
+            }
+            if (ended_by == "end") {
+                patch(skip, script_.code.size());
+                break;
+            }
+
+            exits.push_back(emit_bx(ScriptOp::JMP, 0, 0));
+            patch(skip, script_.code.size());
+            if (ended_by == "else") {
+                if (!end_of_statement() || !block(ended_by)) {
+                    return false;
+                }
+                if (ended_by != "end") {
+                    return fail(tokens_[pos_ - 1], "'else' must be closed with 'end'");
+                }
+                break;
+            }
+            // elif: loop round for the next condition
+        }
+
+        for (size_t jump : exits) {
+            patch(jump, script_.code.size());
+        }
+        return end_of_statement();
+    }
+
+    bool while_statement() {
+        size_t top = script_.code.size();
+        uint8_t cond = 0;
+        if (!alloc_temp(peek(), cond) || !expression(cond) || !end_of_statement()) {
+            return false;
+        }
+        temp_top_ = locals_.size();
+        size_t exit = emit_bx(ScriptOp::JMPF, cond, 0);
+
+        std::string_view ended_by;
+        if (!block(ended_by)) {
+            return false;
+        }
+        if (ended_by != "end") {
+            return fail(peek(), "'while' without 'end'");
+        }
+        emit_bx(ScriptOp::JMP, 0, top);
+        patch(exit, script_.code.size());
+        return end_of_statement();
+    }
+
+    // Expressions, lowest precedence first. Each leaves its value in dest.
+
+    bool expression(uint8_t dest) { return or_expression(dest); }
+
+    bool binary_rhs(uint8_t dest, ScriptOp op, bool (ScriptCompiler::*operand)(uint8_t), bool swap = false) {
+        const Token& token = peek();
+        uint8_t rhs = 0;
+        if (!alloc_temp(token, rhs) || !(this->*operand)(rhs)) {
+            return false;
+        }
+        if (swap) {
+            emit(op, dest, rhs, dest);
+        } else {
+            emit(op, dest, dest, rhs);
+        }
+        --temp_top_;
+        return true;
+    }
+
+    bool or_expression(uint8_t dest) {
+        if (!and_expression(dest)) {
+            return false;
+        }
+        while (match("or")) {
+            if (!binary_rhs(dest, ScriptOp::OR, &ScriptCompiler::and_expression)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool and_expression(uint8_t dest) {
+        if (!comparison(dest)) {
+            return false;
+        }
+        while (match("and")) {
+            if (!binary_rhs(dest, ScriptOp::AND, &ScriptCompiler::comparison)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool comparison(uint8_t dest) {
+        if (!additive(dest)) {
+            return false;
+        }
+        while (true) {
+            if (match("==")) {
+                if (!binary_rhs(dest, ScriptOp::EQ, &ScriptCompiler::additive)) return false;
+            } else if (match("!=")) {
+                if (!binary_rhs(dest, ScriptOp::NE, &ScriptCompiler::additive)) return false;
+            } else if (match("<")) {
+                if (!binary_rhs(dest, ScriptOp::LT, &ScriptCompiler::additive)) return false;
+            } else if (match("<=")) {
+                if (!binary_rhs(dest, ScriptOp::LE, &ScriptCompiler::additive)) return false;
+            } else if (match(">")) {
+                if (!binary_rhs(dest, ScriptOp::LT, &ScriptCompiler::additive, true)) return false;
+            } else if (match(">=")) {
+                if (!binary_rhs(dest, ScriptOp::LE, &ScriptCompiler::additive, true)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool additive(uint8_t dest) {
+        if (!term(dest)) {
+            return false;
+        }
+        while (true) {
+            if (match("+")) {
+                if (!binary_rhs(dest, ScriptOp::ADD, &ScriptCompiler::term)) return false;
+            } else if (match("-")) {
+                if (!binary_rhs(dest, ScriptOp::SUB, &ScriptCompiler::term)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool term(uint8_t dest) {
+        if (!unary(dest)) {
+            return false;
+        }
+        while (true) {
+            if (match("*")) {
+                if (!binary_rhs(dest, ScriptOp::MUL, &ScriptCompiler::unary)) return false;
+            } else if (match("/")) {
+                if (!binary_rhs(dest, ScriptOp::DIV, &ScriptCompiler::unary)) return false;
+            } else if (match("%")) {
+                if (!binary_rhs(dest, ScriptOp::MOD, &ScriptCompiler::unary)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool unary(uint8_t dest) {
+        return enter(peek()) && leave(unary_body(dest));
+    }
+
+    bool unary_body(uint8_t dest) {
+        if (match("-")) {
+            if (!unary(dest)) return false;
+            emit(ScriptOp::NEG, dest, dest);
+            return true;
+        }
+        if (match("not")) {
+            if (!unary(dest)) return false;
+            emit(ScriptOp::NOT, dest, dest);
+            return true;
+        }
+        return primary(dest);
+    }
+
+    bool primary(uint8_t dest) {
+        const Token& token = advance();
+        if (token.kind == TokenKind::NUMBER) {
+            return load_constant(token, dest, token.number);
+        }
+        if (token.kind == TokenKind::SYMBOL && token.text == "(") {
+            return expression(dest) && expect(")");
+        }
+        if (token.kind != TokenKind::NAME) {
+            return fail(token, "expected a value");
+        }
+
+        if (token.text == "random") {
+            uint8_t high = 0;
+            if (!expect("(") || !expression(dest) || !expect(",") ||
+                !alloc_temp(token, high) || !expression(high) || !expect(")")) {
+                return false;
+            }
+            emit(ScriptOp::RANDOM, dest, dest, high);
+            --temp_top_;
+            return true;
+        }
+        if (auto local = find_local(token.text)) {
+            if (local->second != dest) {
+                emit(ScriptOp::MOVE, dest, local->second);
+            }
+            return true;
+        }
+        if (auto builtin = find_named(BUILTINS, token.text)) {
+            emit_bx(ScriptOp::GET, dest, static_cast<size_t>(builtin->value));
+            return true;
+        }
+        if (auto constant = find_named(CONSTANTS, token.text)) {
+            return load_constant(token, dest, constant->value);
+        }
+        return fail(token, "unknown name '" + std::string(token.text) + "'");
+    }
+};
+
+} // namespace
+
+bool compile_script(std::string_view source, int first_line, CompiledScript& script, std::string& error) {
+    ScriptCompiler compiler(source, first_line, script, error);
+    return compiler.compile();
+}
+
+ScriptResult run_script(const CompiledScript& script, ScriptHost& host, uint32_t budget) {
+    int32_t r[SCRIPT_REGISTERS] = {};
+    const ScriptInstruction* code = script.code.data();
+    size_t size = script.code.size();
+    size_t pc = 0;
+    ScriptResult result;
+
+    // Arithmetic is done in 64 bits and truncated, so overflow wraps instead of being undefined
+    auto wrap = [](int64_t value) { return static_cast<int32_t>(static_cast<uint32_t>(value)); };
+
+    while (pc < size) {
+        if (result.instructions == budget) {
+            result.budget_exceeded = true;
+            return result;
+        }
+        ++result.instructions;
+
+        const ScriptInstruction& in = code[pc++];
+        switch (in.op) {
+            case ScriptOp::HALT:
+                return result;
+            case ScriptOp::LOADK:
+                r[in.a] = script.constants[in.bx()];
+                break;
+            case ScriptOp::MOVE:
+                r[in.a] = r[in.b];
+                break;
+            case ScriptOp::ADD:
+                r[in.a] = wrap(int64_t(r[in.b]) + r[in.c]);
+                break;
+            case ScriptOp::SUB:
+                r[in.a] = wrap(int64_t(r[in.b]) - r[in.c]);
+                break;
+            case ScriptOp::MUL:
+                r[in.a] = wrap(int64_t(r[in.b]) * r[in.c]);
+                break;
+            case ScriptOp::DIV:
+            case ScriptOp::MOD:
+                if (r[in.c] == 0) {
+                    result.failed = true;
+                    return result;
+                }
+                r[in.a] = wrap(in.op == ScriptOp::DIV ? int64_t(r[in.b]) / r[in.c] : int64_t(r[in.b]) % r[in.c]);
+                break;
+            case ScriptOp::EQ:
+                r[in.a] = r[in.b] == r[in.c];
+                break;
+            case ScriptOp::NE:
+                r[in.a] = r[in.b] != r[in.c];
+                break;
+            case ScriptOp::LT:
+                r[in.a] = r[in.b] < r[in.c];
+                break;
+            case ScriptOp::LE:
+                r[in.a] = r[in.b] <= r[in.c];
+                break;
+            case ScriptOp::AND:
+                r[in.a] = r[in.b] && r[in.c];
+                break;
+            case ScriptOp::OR:
+                r[in.a] = r[in.b] || r[in.c];
+                break;
+            case ScriptOp::NOT:
+                r[in.a] = !r[in.b];
+                break;
+            case ScriptOp::NEG:
+                r[in.a] = wrap(-int64_t(r[in.b]));
+                break;
+            case ScriptOp::GET:
+                r[in.a] = host.get(static_cast<ScriptBuiltin>(in.bx()));
+                break;
+            case ScriptOp::RANDOM: {
+                int32_t low = r[in.b];
+                int32_t high = r[in.c];
+                r[in.a] = low < high ? RandomGenerator::get_instance().random_int(low, high) : low;
+                break;
+            }
+            case ScriptOp::JMP:
+                pc = in.bx();
+                break;
+            case ScriptOp::JMPF:
+                if (r[in.a] == 0) {
+                    pc = in.bx();
+                }
+                break;
+            case ScriptOp::SEND:
+                host.send(script.strings[in.bx()]);
+                break;
+            case ScriptOp::ECHO:
+                host.echo(script.strings[in.bx()]);
+                break;
+            case ScriptOp::HEAL:
+                host.heal(r[in.a]);
+                break;
+            case ScriptOp::DAMAGE:
+                host.damage(r[in.a]);
+                break;
+            case ScriptOp::XP:
+                host.add_experience(r[in.a]);
+                break;
+            case ScriptOp::TELEPORT:
+                host.teleport(r[in.a]);
+                break;
+            case ScriptOp::LOOT:
+                host.loot(script.strings[in.bx()]);
+                break;
+            case ScriptOp::BLOCK:
+                result.blocked = true;
+                break;
+        }
+    }
+    return result;
+}
+
+} // namespace dungeon_merc
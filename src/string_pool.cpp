@@ -0,0 +1,259 @@
+#include "string_pool.hpp"
+#include "common.hpp"
+#include <functional>
+#include <stdexcept>
+
+#if defined(DUNGEON_MERC_ZSTD) && __has_include(<zstd.h>) && __has_include(<zdict.h>)
+#define DUNGEON_MERC_STRING_POOL_ZSTD 1
+#include <zdict.h>
+#include <zstd.h>
+#include <list>
+#include <vector>
+#endif
+
+namespace dungeon_merc {
+
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+
+namespace {
+
+constexpr size_t MIN_COMPRESSED_TEXT = 64;  // Shorter text is not worth a frame
+constexpr size_t DICTIONARY_SAMPLES = 256;  // Texts seen before the first training
+constexpr size_t DICTIONARY_BYTES = 16 * 1024;
+constexpr int COMPRESSION_LEVEL = 9;        // Compressed once, read many times
+constexpr size_t RECENT_TEXTS = 64;         // Decompressed texts kept around
+
+} // namespace
+
+struct StringPool::Compression {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+
+    // Text stored plain until there is a dictionary to compress it with
+    std::vector<StringId> pending;
+    size_t next_training = DICTIONARY_SAMPLES;
+
+    // Most recently used first
+    std::list<std::pair<StringId, std::string>> recent;
+    std::unordered_map<StringId, std::list<std::pair<StringId, std::string>>::iterator> recent_index;
+
+    Counter& decompressions = MetricsRegistry::get_instance().counter("strings.decompressions");
+
+    ~Compression() {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+};
+
+#else
+
+struct StringPool::Compression {};
+
+#endif
+
+StringPool::StringPool()
+    : compression_(std::make_unique<Compression>())
+    , dedup_hits_(MetricsRegistry::get_instance().counter("strings.dedup_hits"))
+    , strings_gauge_(MetricsRegistry::get_instance().gauge("strings.interned"))
+    , bytes_gauge_(MetricsRegistry::get_instance().gauge("strings.bytes")) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add("", false);
+}
+
+StringPool::~StringPool() {
+    for (auto& page : pages_) {
+        delete[] page.load(std::memory_order_relaxed);
+    }
+}
+
+bool StringPool::compression_available() {
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+StringId StringPool::intern(std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return add(text, false);
+}
+
+StringId StringPool::intern_text(std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return add(text, true);
+}
+
+const std::string& StringPool::get(StringId id) const {
+    return entry(id).data;
+}
+
+void StringPool::append(StringId id, ArenaString& out) const {
+    const Entry& found = entry(id);
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    if (found.text) {
+        // The compressor may swap the bytes out from under an unlocked read
+        std::lock_guard<std::mutex> lock(mutex_);
+        out << plain_text(id, found);
+        return;
+    }
+#endif
+    out << found.data;
+}
+
+std::string StringPool::copy(StringId id) const {
+    const Entry& found = entry(id);
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    if (found.text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return plain_text(id, found);
+    }
+#endif
+    return found.data;
+}
+
+StringPool::Entry& StringPool::entry(StringId id) const {
+    if (id >= count_.load(std::memory_order_acquire)) {
+        throw std::out_of_range("Unknown string id " + std::to_string(id));
+    }
+    return pages_[id >> PAGE_BITS].load(std::memory_order_acquire)[id & (PAGE_SIZE - 1)];
+}
+
+bool StringPool::matches(StringId id, const Entry& candidate, std::string_view text) const {
+    if (candidate.size != text.size()) {
+        return false;
+    }
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    if (candidate.compressed) {
+        return plain_text(id, candidate) == text;
+    }
+#else
+    (void)id;
+#endif
+    return candidate.data == text;
+}
+
+StringId StringPool::add(std::string_view text, bool is_text) {
+    size_t hash = std::hash<std::string_view>{}(text);
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Entry& candidate = entry(it->second);
+        if (candidate.text == is_text && matches(it->second, candidate, text)) {
+            dedup_hits_.add();
+            return it->second;
+        }
+    }
+
+    size_t count = count_.load(std::memory_order_relaxed);
+    if (count >= PAGE_SIZE * MAX_PAGES) {
+        throw std::length_error("String pool is full");
+    }
+    StringId id = static_cast<StringId>(count);
+    Entry* page = pages_[id >> PAGE_BITS].load(std::memory_order_relaxed);
+    if (!page) {
+        page = new Entry[PAGE_SIZE];
+        pages_[id >> PAGE_BITS].store(page, std::memory_order_release);
+    }
+
+    Entry& added = page[id & (PAGE_SIZE - 1)];
+    added.data.assign(text.data(), text.size());
+    added.size = static_cast<uint32_t>(text.size());
+    added.text = is_text;
+    index_.emplace(hash, id);
+    // Publishes the entry to lock-free readers
+    count_.store(count + 1, std::memory_order_release);
+    stored_bytes_.fetch_add(added.data.capacity(), std::memory_order_relaxed);
+
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    if (is_text && text.size() >= MIN_COMPRESSED_TEXT) {
+        Compression& zstd = *compression_;
+        zstd.pending.push_back(id);
+        if (zstd.cdict || zstd.pending.size() >= zstd.next_training) {
+            if (!zstd.cdict) {
+                // Train on everything seen so far; a failed training is retried on twice as much
+                std::string samples;
+                std::vector<size_t> sizes;
+                for (StringId sample : zstd.pending) {
+                    samples += entry(sample).data;
+                    sizes.push_back(entry(sample).data.size());
+                }
+                std::vector<char> dictionary(DICTIONARY_BYTES);
+                size_t dictionary_size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(),
+                                                               sizes.data(), static_cast<unsigned>(sizes.size()));
+                if (ZDICT_isError(dictionary_size)) {
+                    LOG_WARNING("String pool dictionary training failed: " +
+                                std::string(ZDICT_getErrorName(dictionary_size)));
+                    zstd.next_training = zstd.pending.size() * 2;
+                } else {
+                    zstd.cdict = ZSTD_createCDict(dictionary.data(), dictionary_size, COMPRESSION_LEVEL);
+                    zstd.ddict = ZSTD_createDDict(dictionary.data(), dictionary_size);
+                    LOG_INFO("String pool trained a " + std::to_string(dictionary_size) + " byte dictionary on " +
+                             std::to_string(sizes.size()) + " texts");
+                }
+            }
+            if (zstd.cdict) {
+                for (StringId pending : zstd.pending) {
+                    Entry& plain = entry(pending);
+                    std::string frame(ZSTD_compressBound(plain.data.size()), '\0');
+                    size_t length = ZSTD_compress_usingCDict(zstd.cctx, frame.data(), frame.size(), plain.data.data(),
+                                                             plain.data.size(), zstd.cdict);
+                    if (ZSTD_isError(length) || length >= plain.data.size()) {
+                        continue;  // Keep it plain
+                    }
+                    frame.resize(length);
+                    frame.shrink_to_fit();
+                    stored_bytes_.fetch_sub(plain.data.capacity(), std::memory_order_relaxed);
+                    stored_bytes_.fetch_add(frame.capacity(), std::memory_order_relaxed);
+                    plain.data.swap(frame);
+                    plain.compressed = true;
+                }
+                zstd.pending.clear();
+            }
+        }
+    }
+#endif
+
+    strings_gauge_.set(static_cast<int64_t>(count + 1));
+    bytes_gauge_.set(static_cast<int64_t>(stored_bytes_.load(std::memory_order_relaxed)));
+    return id;
+}
+
+const std::string& StringPool::plain_text(StringId id, const Entry& found) const {
+#ifdef DUNGEON_MERC_STRING_POOL_ZSTD
+    if (!found.compressed) {
+        return found.data;
+    }
+    Compression& zstd = *compression_;
+    auto cached = zstd.recent_index.find(id);
+    if (cached != zstd.recent_index.end()) {
+        zstd.recent.splice(zstd.recent.begin(), zstd.recent, cached->second);
+        return cached->second->second;
+    }
+
+    std::string text(found.size, '\0');
+    size_t length = ZSTD_decompress_usingDDict(zstd.dctx, text.data(), text.size(), found.data.data(),
+                                               found.data.size(), zstd.ddict);
+    if (ZSTD_isError(length) || length != found.size) {
+        LOG_ERROR("String pool failed to decompress string " + std::to_string(id));
+        text.clear();
+    }
+    zstd.decompressions.add();
+
+    zstd.recent.emplace_front(id, std::move(text));
+    zstd.recent_index[id] = zstd.recent.begin();
+    if (zstd.recent.size() > RECENT_TEXTS) {
+        zstd.recent_index.erase(zstd.recent.back().first);
+        zstd.recent.pop_back();
+    }
+    return zstd.recent.front().second;
+#else
+    (void)id;
+    return found.data;
+#endif
+}
+
+} // namespace dungeon_merc
@@ -1,8 +1,13 @@
 #include "telnet_server.hpp"
 #include "player.hpp"
 #include "game_world.hpp"
+#include "trace.hpp"
+#include "zone_gateway.hpp"
+#include "tls.hpp"
+#include "io_uring.hpp"
 #include <iostream>
 #include <cstring>
+#include <sys/uio.h>
 #include <openssl/evp.h>
 #include <iomanip>
 #include <sstream>
@@ -11,10 +16,18 @@ namespace dungeon_merc {
 
 // TelnetConnection implementation
 TelnetConnection::TelnetConnection(int socket_fd, const std::string& client_ip)
-    : socket_fd_(socket_fd)
+    : id_(0)
+    , socket_fd_(socket_fd)
     , client_ip_(client_ip)
     , state_(TelnetConnectionState::CONNECTING)
-    , receive_buffer_(1024) {
+    , welcome_sent_(false)
+    , is_admin_(false)
+    , input_consumed_(0)
+    , denied_this_tick_(false)
+    , throttled_since_()
+    , uring_(nullptr) {
+
+    set_flood_limits(FloodLimits());
 
     LOG_INFO("New telnet connection from " + client_ip_);
 }
@@ -43,7 +56,16 @@ void TelnetConnection::close() {
 
     LOG_INFO("Closing telnet connection from " + client_ip_);
 
-    if (socket_fd_ >= 0) {
+    if (tls_) {
+        tls_->shutdown();
+    }
+    if (uring_) {
+        // Queued output still goes out; the ring closes the socket after it
+        uring_->release(id_);
+        socket_fd_ = -1;
+    } else if (socket_fd_ >= 0) {
+        // Last chance for output the client has not taken yet, such as a goodbye
+        flush_pending_output();
         ::close(socket_fd_);
         socket_fd_ = -1;
     }
@@ -76,21 +98,47 @@ bool TelnetConnection::is_authenticated() const {
     return state_ == TelnetConnectionState::AUTHENTICATED || state_ == TelnetConnectionState::PLAYING;
 }
 
-bool TelnetConnection::send_message(const std::string& message) {
+bool TelnetConnection::send_message(std::string_view message) {
+    return send_lines(&message, 1);
+}
+
+bool TelnetConnection::send_lines(const std::string_view* lines, size_t count) {
     if (!is_authenticated()) {
         LOG_DEBUG("Cannot send message - not authenticated");
         return false;
     }
 
-    std::string formatted_message = message + "\r\n";
-    ssize_t written = send(socket_fd_, formatted_message.c_str(), formatted_message.length(), 0);
+    TRACE_SCOPE("io.send");
+    static Counter& bytes_out = MetricsRegistry::get_instance().counter("net.bytes_out");
+    static const char line_end[] = "\r\n";
+
+    // Frame each line with CRLF through the iovec list instead of copying,
+    // batching as many lines per writev as fit
+    struct iovec iov[SEND_BATCH_LINES * 2];
+    size_t next = 0;
+    while (next < count) {
+        size_t batch = std::min(count - next, SEND_BATCH_LINES);
+        for (size_t i = 0; i < batch; ++i) {
+            iov[i * 2].iov_base = const_cast<char*>(lines[next + i].data());
+            iov[i * 2].iov_len = lines[next + i].size();
+            iov[i * 2 + 1].iov_base = const_cast<char*>(line_end);
+            iov[i * 2 + 1].iov_len = 2;
+        }
 
-    if (written < 0) {
-        LOG_ERROR("Failed to send message to telnet client: " + std::to_string(written));
-        return false;
-    }
+        ssize_t written = write_iov(iov, static_cast<int>(batch * 2));
+        if (written < 0) {
+            LOG_ERROR("Failed to send message to telnet client: " + std::to_string(written));
+            return false;
+        }
+        bytes_out.add(static_cast<uint64_t>(written));
 
-    LOG_DEBUG("Sent message: " + message);
+        if (Logger::get_instance().is_enabled(LogLevel::DEBUG)) {
+            for (size_t i = 0; i < batch; ++i) {
+                LOG_DEBUG("Sent message: " + std::string(lines[next + i]));
+            }
+        }
+        next += batch;
+    }
     return true;
 }
 
@@ -125,15 +173,266 @@ bool TelnetConnection::has_data() const {
     return result > 0;
 }
 
-void TelnetConnection::set_player(std::shared_ptr<Player> player) {
+void TelnetConnection::set_flood_limits(const FloodLimits& limits) {
+    flood_limits_ = limits;
+    command_tokens_.configure(limits.commands_per_second, limits.command_burst);
+    byte_tokens_.configure(limits.bytes_per_second, limits.byte_burst);
+}
+
+ssize_t TelnetConnection::read_input(FloodClock::time_point now) {
+    command_tokens_.refill(now);
+    byte_tokens_.refill(now);
+
+    // Drop executed lines before reading more; earlier views die here
+    if (input_consumed_ > 0) {
+        input_.erase(0, input_consumed_);
+        input_consumed_ = 0;
+    }
+
+    size_t space = INPUT_BUFFER_LIMIT - std::min(input_.size(), INPUT_BUFFER_LIMIT);
+    size_t budget = byte_tokens_.available(space);
+    if (budget == 0) {
+        // Leave the bytes in the kernel; TCP flow control pushes back on the client
+        if (space > 0) {
+            denied_this_tick_ = true;
+        }
+        return 0;
+    }
+
+    size_t old_size = input_.size();
+    input_.resize(old_size + budget);
+    ssize_t bytes_read;
+    {
+        TRACE_SCOPE("io.recv");
+        if (tls_ || uring_) {
+            // Both report "nothing yet" as 0 and a closed peer as -1
+            bytes_read = tls_ ? tls_->read(&input_[old_size], budget) : uring_->read(id_, &input_[old_size], budget);
+            if (bytes_read <= 0) {
+                input_.resize(old_size);
+                return bytes_read;
+            }
+        } else {
+            bytes_read = recv(socket_fd_, &input_[old_size], budget, MSG_DONTWAIT);
+        }
+    }
+
+    if (bytes_read > 0) {
+        // Negotiation still counts against the byte bucket, but never reaches the line buffer
+        size_t kept = telnet_filter_.filter(&input_[old_size], static_cast<size_t>(bytes_read), *this);
+        input_.resize(old_size + kept);
+        byte_tokens_.try_take(static_cast<double>(bytes_read));
+        return bytes_read;
+    }
+
+    input_.resize(old_size);
+    if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        return -1;
+    }
+    return 0;
+}
+
+bool TelnetConnection::next_line(std::string_view& line) {
+    size_t newline = input_.find('\n', input_consumed_);
+    if (newline == std::string::npos) {
+        return false;
+    }
+
+    line = std::string_view(input_).substr(input_consumed_, newline - input_consumed_);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    input_consumed_ = newline + 1;
+    return true;
+}
+
+bool TelnetConnection::take_command_token() {
+    if (command_tokens_.try_take()) {
+        return true;
+    }
+    denied_this_tick_ = true;
+    return false;
+}
+
+bool TelnetConnection::update_flood_state(FloodClock::time_point now) {
+    bool denied = denied_this_tick_;
+    denied_this_tick_ = false;
+
+    if (!denied) {
+        throttled_since_ = FloodClock::time_point{};
+        return true;
+    }
+    if (throttled_since_ == FloodClock::time_point{}) {
+        throttled_since_ = now;
+        send_message("You are sending too fast; slow down.");
+        return true;
+    }
+    return now - throttled_since_ < flood_limits_.abuse_grace;
+}
+
+bool TelnetConnection::flush_queued_lines() {
+    if (queued_lines_.empty()) {
+        return true;
+    }
+    queued_lines_.push_back("> ");
+    bool sent = send_lines(queued_lines_.data(), queued_lines_.size());
+    queued_lines_.clear();
+    return sent;
+}
+
+void TelnetConnection::offer_gmcp() {
+    static const char offer[] = {static_cast<char>(telnet::IAC), static_cast<char>(telnet::WILL),
+                                 static_cast<char>(telnet::GMCP)};
+    send_raw(std::string_view(offer, sizeof(offer)));
+}
+
+bool TelnetConnection::send_raw(std::string_view data) {
+    if (!is_connected()) {
+        return false;
+    }
+
+    static Counter& bytes_out = MetricsRegistry::get_instance().counter("net.bytes_out");
+    struct iovec iov = {const_cast<char*>(data.data()), data.size()};
+    ssize_t written = write_iov(&iov, 1);
+    if (written < 0) {
+        LOG_ERROR("Failed to send telnet data: " + std::to_string(written));
+        return false;
+    }
+    bytes_out.add(static_cast<uint64_t>(written));
+    return true;
+}
+
+void TelnetConnection::on_option(uint8_t command, uint8_t option) {
+    if (option == telnet::GMCP && (command == telnet::DO || command == telnet::DONT)) {
+        bool enable = command == telnet::DO;
+        if (enable != gmcp_.is_enabled()) {
+            gmcp_.set_enabled(enable);
+            LOG_DEBUG(std::string("GMCP ") + (enable ? "enabled" : "disabled") + " for " + client_ip_);
+        }
+        return;
+    }
+
+    // Refuse everything else. Refusals are never answered, so this can't loop.
+    char reply[3] = {static_cast<char>(telnet::IAC), 0, static_cast<char>(option)};
+    if (command == telnet::DO) {
+        reply[1] = static_cast<char>(telnet::WONT);
+    } else if (command == telnet::WILL) {
+        reply[1] = static_cast<char>(telnet::DONT);
+    } else {
+        return;
+    }
+    send_raw(std::string_view(reply, sizeof(reply)));
+}
+
+void TelnetConnection::on_subnegotiation(uint8_t option, std::string_view data) {
+    if (option == telnet::GMCP && gmcp_.is_enabled()) {
+        gmcp_.handle_message(data);
+    }
+}
+
+void TelnetConnection::set_player(PlayerId player) {
     player_ = player;
-    if (player) {
+    if (player.is_valid()) {
         state_ = TelnetConnectionState::PLAYING;
     }
 }
 
-std::shared_ptr<Player> TelnetConnection::get_player() const {
-    return player_;
+void TelnetConnection::set_tls(std::unique_ptr<TlsSession> tls) {
+    tls_ = std::move(tls);
+}
+
+void TelnetConnection::attach_uring(IoUring* ring) {
+    uring_ = ring;
+    uring_->attach(id_, socket_fd_);
+
+    // Output the socket could not take yet now queues in the ring instead
+    if (!pending_output_.empty()) {
+        struct iovec iov = {pending_output_.data(), pending_output_.size()};
+        uring_->write(id_, &iov, 1);
+        pending_output_.clear();
+    }
+}
+
+ssize_t TelnetConnection::write_iov(const struct iovec* iov, int count) {
+    if (tls_) {
+        return tls_->write(iov, count);
+    }
+    if (uring_) {
+        return uring_->write(id_, iov, count);
+    }
+    return write_socket(iov, count);
+}
+
+ssize_t TelnetConnection::write_socket(const struct iovec* iov, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        total += iov[i].iov_len;
+    }
+
+    // Anything still queued has to leave first, or lines would arrive out of order
+    if (!flush_pending_output()) {
+        return -1;
+    }
+    size_t written = 0;
+    if (pending_output_.empty()) {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = const_cast<struct iovec*>(iov);
+        message.msg_iovlen = static_cast<size_t>(count);
+        ssize_t result = sendmsg(socket_fd_, &message, MSG_NOSIGNAL);
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return -1;
+        }
+        written = result > 0 ? static_cast<size_t>(result) : 0;
+        if (written == total) {
+            return static_cast<ssize_t>(total);
+        }
+    } else if (pending_output_.size() + total > SOCKET_OUTPUT_LIMIT) {
+        // Refuse the whole write rather than cut a line in half
+        LOG_WARNING("Telnet client " + client_ip_ + " is not reading its output");
+        errno = EAGAIN;
+        return -1;
+    }
+
+    // Keep the unsent tail, skipping whatever the kernel already took
+    for (int i = 0; i < count; ++i) {
+        size_t length = iov[i].iov_len;
+        size_t skip = std::min(written, length);
+        written -= skip;
+        pending_output_.append(static_cast<const char*>(iov[i].iov_base) + skip, length - skip);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+bool TelnetConnection::flush_pending_output() {
+    size_t sent = 0;
+    while (sent < pending_output_.size()) {
+        ssize_t result = ::send(socket_fd_, pending_output_.data() + sent, pending_output_.size() - sent,
+                                MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                pending_output_.clear();
+                return false;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    pending_output_.erase(0, sent);
+    return true;
+}
+
+size_t TelnetConnection::get_queued_output_bytes() const {
+    size_t total = pending_output_.size();
+    if (tls_) {
+        total += tls_->pending_bytes();
+    }
+    if (uring_) {
+        total += uring_->get_queued_bytes(id_);
+    }
+    return total;
 }
 
 bool TelnetConnection::set_nonblocking() {
@@ -149,8 +448,27 @@ bool TelnetConnection::set_nonblocking() {
 TelnetServer::TelnetServer(int port)
     : port_(port)
     , server_socket_(-1)
-    , running_(false) {
-
+    , running_(false)
+    , gateway_(nullptr)
+    , next_connection_id_(1)
+    , round_robin_start_(0)
+    , tls_port_(0)
+    , tls_socket_(-1)
+    , admitted_this_tick_(0)
+    , bytes_in_(MetricsRegistry::get_instance().counter("net.bytes_in"))
+    , connections_accepted_(MetricsRegistry::get_instance().counter("net.connections_accepted"))
+    , connections_gauge_(MetricsRegistry::get_instance().gauge("net.connections"))
+    , throttled_(MetricsRegistry::get_instance().counter("net.throttled"))
+    , flood_disconnects_(MetricsRegistry::get_instance().counter("net.flood_disconnects"))
+    , login_queue_gauge_(MetricsRegistry::get_instance().gauge("net.login_queue"))
+    , logins_rejected_(MetricsRegistry::get_instance().counter("net.logins_rejected"))
+    , gmcp_bytes_(MetricsRegistry::get_instance().counter("net.gmcp_bytes"))
+    , tls_handshakes_done_(MetricsRegistry::get_instance().counter("tls.handshakes"))
+    , tls_resumed_(MetricsRegistry::get_instance().counter("tls.resumed"))
+    , tls_kernel_offload_(MetricsRegistry::get_instance().counter("tls.kernel_offload"))
+    , tls_failures_(MetricsRegistry::get_instance().counter("tls.handshake_failures")) {
+
+    register_server_commands();
     LOG_INFO("Telnet Server initialized on port " + std::to_string(port_));
 }
 
@@ -191,12 +509,20 @@ void TelnetServer::shutdown() {
         }
         connections_.clear();
     }
+    for (auto& pending : tls_handshakes_) {
+        pending.connection->close();
+    }
+    tls_handshakes_.clear();
 
     // Close server socket
     if (server_socket_ >= 0) {
         ::close(server_socket_);
         server_socket_ = -1;
     }
+    if (tls_socket_ >= 0) {
+        ::close(tls_socket_);
+        tls_socket_ = -1;
+    }
 
     LOG_INFO("Telnet Server shutdown complete");
 }
@@ -210,38 +536,325 @@ void TelnetServer::accept_connections() {
         return;
     }
 
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
+    TRACE_SCOPE("io.accept");
+    admitted_this_tick_ = 0;
 
-    int client_socket = accept(server_socket_, (struct sockaddr*)&client_addr, &client_len);
-    if (client_socket >= 0) {
-        std::string client_ip = inet_ntoa(client_addr.sin_addr);
+    // People already waiting go first
+    service_login_queue();
 
-        auto connection = std::make_shared<TelnetConnection>(client_socket, client_ip);
-        if (connection->initialize()) {
-            // Create a player for this connection
-            auto player = std::make_shared<Player>("Player_" + std::to_string(client_socket), CharacterClass::SCOUT);
-            connection->set_player(player);
+    if (uring_) {
+        accept_uring_connections();
+    }
 
-            // Add player to game world
-            if (game_world_) {
-                game_world_->add_player(player);
-            }
+    // Drain the whole backlog so a connection burst doesn't trickle in one per tick
+    while (!uring_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
 
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            connections_.push_back(connection);
+        // Close-on-exec until a hot reboot hands the socket on explicitly
+        int client_socket = accept4(server_socket_, (struct sockaddr*)&client_addr, &client_len, SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            break;
+        }
 
-            if (connection_callback_) {
-                connection_callback_(connection);
-            }
-        } else {
+        adopt_connection(client_socket, inet_ntoa(client_addr.sin_addr));
+    }
+
+    if (tls_socket_ >= 0) {
+        accept_tls_connections();
+    }
+
+    login_queue_gauge_.set(static_cast<int64_t>(login_queue_.size()));
+}
+
+void TelnetServer::register_connection(const std::shared_ptr<TelnetConnection>& connection) {
+    connection->set_id(next_connection_id_++);
+    connection->set_flood_limits(flood_limits_);
+    connections_accepted_.add();
+    if (uring_ && !connection->is_encrypted()) {
+        connection->attach_uring(uring_.get());
+    }
+
+    if (login_queue_.empty() && can_admit()) {
+        admit_connection(connection);
+    } else {
+        enqueue_login(connection);
+    }
+}
+
+void TelnetServer::accept_uring_connections() {
+    // Completions for every socket arrive together; accepts are handled here
+    // and input waits in the ring for read_input()
+    uring_->poll();
+    for (int client_socket : uring_->take_accepted()) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        std::string client_ip = "unknown";
+        if (getpeername(client_socket, (struct sockaddr*)&client_addr, &client_len) == 0) {
+            client_ip = inet_ntoa(client_addr.sin_addr);
+        }
+        adopt_connection(client_socket, client_ip);
+    }
+}
+
+bool TelnetServer::adopt_connection(int socket_fd, const std::string& client_ip) {
+    auto connection = std::make_shared<TelnetConnection>(socket_fd, client_ip);
+    if (!connection->initialize()) {
+        connection->close();
+        return false;
+    }
+    register_connection(connection);
+    return true;
+}
+
+bool TelnetServer::set_io_backend(IoBackend backend) {
+    if (backend == get_io_backend()) {
+        return true;
+    }
+    if (backend == IoBackend::SOCKETS) {
+        LOG_ERROR("Connections can't leave io_uring once attached");
+        return false;
+    }
+
+    auto ring = std::make_unique<IoUring>();
+    if (!ring->initialize()) {
+        return false;
+    }
+    uring_ = std::move(ring);
+    uring_->watch_listener(server_socket_);
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto& connection : connections_) {
+        if (connection->is_connected() && !connection->is_encrypted()) {
+            connection->attach_uring(uring_.get());
+        }
+    }
+    for (auto& connection : login_queue_) {
+        if (connection->is_connected() && !connection->is_encrypted()) {
+            connection->attach_uring(uring_.get());
+        }
+    }
+    uring_->submit();
+    LOG_INFO("Telnet I/O through io_uring");
+    return true;
+}
+
+void TelnetServer::flush_output() {
+    if (uring_) {
+        TRACE_SCOPE("io.submit");
+        uring_->submit();
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (const auto& connection : connections_) {
+        if (connection->has_pending_output() && !connection->flush_pending_output()) {
+            connection->close();
+        }
+    }
+}
+
+bool TelnetServer::enable_tls(int port, const std::string& cert_file, const std::string& key_file) {
+    auto context = std::make_unique<TlsContext>();
+    if (!context->load(cert_file, key_file)) {
+        return false;
+    }
+
+    // Close-on-exec: encrypted sessions can't be handed to a new image, so
+    // the listener isn't either. SO_REUSEADDR lets the next image rebind it.
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create TLS socket");
+        return false;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        LOG_ERROR("Failed to listen for TLS on port " + std::to_string(port));
+        ::close(fd);
+        return false;
+    }
+
+    if (tls_socket_ >= 0) {
+        ::close(tls_socket_);
+    }
+    tls_socket_ = fd;
+    tls_port_ = port;
+    tls_context_ = std::move(context);
+    LOG_INFO("TLS listening on port " + std::to_string(port) +
+             (TlsContext::kernel_offload_available() ? " (kernel offload when the kernel supports it)" : ""));
+    return true;
+}
+
+void TelnetServer::accept_tls_connections() {
+    while (true) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+
+        int client_socket = accept4(tls_socket_, (struct sockaddr*)&client_addr, &client_len, SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            break;
+        }
+
+        auto connection = std::make_shared<TelnetConnection>(client_socket, inet_ntoa(client_addr.sin_addr));
+        auto session = connection->initialize() ? tls_context_->accept(client_socket) : nullptr;
+        if (!session) {
             connection->close();
+            continue;
+        }
+        connection->set_tls(std::move(session));
+        tls_handshakes_.push_back({connection, FloodClock::now() + TLS_HANDSHAKE_TIMEOUT});
+    }
+    advance_tls_handshakes();
+}
+
+void TelnetServer::advance_tls_handshakes() {
+    auto now = FloodClock::now();
+    size_t kept = 0;
+    for (size_t i = 0; i < tls_handshakes_.size(); ++i) {
+        PendingHandshake& pending = tls_handshakes_[i];
+        TlsSession* session = pending.connection->get_tls();
+        TlsHandshake result = session->handshake();
+        if (result == TlsHandshake::PENDING && now < pending.deadline) {
+            if (kept != i) {
+                tls_handshakes_[kept] = std::move(pending);
+            }
+            kept++;
+            continue;
+        }
+        if (result != TlsHandshake::DONE) {
+            tls_failures_.add();
+            pending.connection->close();
+            continue;
+        }
+
+        tls_handshakes_done_.add();
+        if (session->is_resumed()) {
+            tls_resumed_.add();
+        }
+        if (session->kernel_send()) {
+            tls_kernel_offload_.add();
         }
+        LOG_INFO("TLS established with " + pending.connection->get_client_ip() + ": " + session->describe());
+        register_connection(pending.connection);
+    }
+    tls_handshakes_.erase(tls_handshakes_.begin() + static_cast<std::ptrdiff_t>(kept), tls_handshakes_.end());
+}
+
+size_t TelnetServer::get_queued_output_bytes() const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    size_t total = 0;
+    for (const auto& connection : connections_) {
+        total += connection->get_queued_output_bytes();
     }
+    for (const auto& connection : login_queue_) {
+        total += connection->get_queued_output_bytes();
+    }
+    return total;
+}
+
+void TelnetServer::record_tick(std::chrono::microseconds tick_time, size_t output_bytes) {
+    admission_.record_tick(tick_time, output_bytes);
+}
+
+bool TelnetServer::can_admit() const {
+    size_t players = game_world_ ? game_world_->get_players().size() : connections_.size();
+    return admitted_this_tick_ < admission_.get_limits().admits_per_tick && admission_.has_capacity(players);
+}
+
+void TelnetServer::admit_connection(const std::shared_ptr<TelnetConnection>& connection) {
+    if (gateway_) {
+        // The character is created by the zone server hosting the starting room
+        gateway_->attach(connection, "Player_" + std::to_string(connection->get_socket_fd()),
+                         CharacterClass::SCOUT);
+    } else if (game_world_) {
+        // Create a player for this connection in the game world
+        std::string name = "Player_" + std::to_string(connection->get_socket_fd());
+        PlayerId player = game_world_->create_player(name, CharacterClass::SCOUT);
+        bind_player(connection.get(), player);
+
+        if (recorder_) {
+            recorder_->record_connect(connection->get_id(), name, CharacterClass::SCOUT,
+                                      game_world_->get_player(player)->get_current_room_id());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections_.push_back(connection);
+    connections_gauge_.set(static_cast<int64_t>(connections_.size()));
+    admitted_this_tick_++;
+
+    if (connection_callback_) {
+        connection_callback_(connection);
+    }
+}
+
+void TelnetServer::enqueue_login(const std::shared_ptr<TelnetConnection>& connection) {
+    if (login_queue_.size() >= admission_.get_limits().max_queue) {
+        connection->send_message("Dungeon Merc is full. Please try again later.");
+        connection->close();
+        logins_rejected_.add();
+        return;
+    }
+
+    if (login_queue_.empty()) {
+        next_queue_notice_ = FloodClock::now() + admission_.get_limits().notice_interval;
+    }
+    login_queue_.push_back(connection);
+    std::string notice = "Dungeon Merc is full right now. You are number " +
+                         std::to_string(login_queue_.size()) + " in line.";
+    connection->send_message(notice);
+}
+
+void TelnetServer::service_login_queue() {
+    if (login_queue_.empty()) {
+        return;
+    }
+
+    while (!login_queue_.empty() && can_admit()) {
+        auto connection = login_queue_.front();
+        login_queue_.pop_front();
+        if (connection->is_connected()) {
+            connection->send_message("A spot opened up. Entering the city...");
+            admit_connection(connection);
+        }
+    }
+
+    auto now = FloodClock::now();
+    if (now < next_queue_notice_) {
+        return;
+    }
+    next_queue_notice_ = now + admission_.get_limits().notice_interval;
+
+    // Drop clients that gave up, throw away what the rest typed and tell
+    // them where they stand
+    size_t position = 0;
+    std::string notice;
+    auto alive = std::remove_if(login_queue_.begin(), login_queue_.end(),
+        [&](const std::shared_ptr<TelnetConnection>& connection) {
+            if (connection->read_input(now) < 0 || !connection->is_connected() || connection->input_overflowed()) {
+                connection->close();
+                return true;
+            }
+            std::string_view line;
+            while (connection->next_line(line)) {
+            }
+            notice = "You are number " + std::to_string(++position) + " in line.";
+            connection->send_message(notice);
+            return false;
+        });
+    login_queue_.erase(alive, login_queue_.end());
 }
 
 void TelnetServer::process_connections() {
+    TRACE_SCOPE("io.process");
     std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto now = FloodClock::now();
 
     for (auto& connection : connections_) {
         if (!connection->is_connected()) {
@@ -249,92 +862,196 @@ void TelnetServer::process_connections() {
         }
 
         // Send welcome message if first time
-        static std::unordered_map<int, bool> sent_welcome;
-        if (!sent_welcome[connection->get_socket_fd()]) {
-            connection->send_message("Welcome to Dungeon Merc!");
-            connection->send_message("Type 'help' for available commands.");
-            connection->send_message("> ");
-            sent_welcome[connection->get_socket_fd()] = true;
-        }
-
-        // Process incoming messages - use the same approach as the working simple server
-        char buffer[1024];
-        ssize_t bytes_read = recv(connection->get_socket_fd(), buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
-
-        if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            std::string message(buffer);
-
-            // Remove \r\n (like the working simple server)
-            if (message.back() == '\n') message.pop_back();
-            if (message.back() == '\r') message.pop_back();
-
-            LOG_DEBUG("Game message from " + connection->get_client_ip() + ": " + message);
-
-            // Handle game commands
-            if (message == "help") {
-                LOG_DEBUG("Sending help response");
-                connection->send_message("Available commands:");
-                connection->send_message("  help - Show this help");
-                connection->send_message("  look - Look around the current room");
-                connection->send_message("  north/south/east/west/up/down - Move in that direction");
-                connection->send_message("  players - Show players in current room");
-                connection->send_message("  quit - Disconnect from server");
-                connection->send_message("  status - Show your status");
-                connection->send_message("> "); // Add prompt
-            } else if (message == "quit") {
-                LOG_DEBUG("User requested quit");
-                connection->send_message("Goodbye!");
-                connection->close();
-            } else if (message == "status") {
-                LOG_DEBUG("Sending status response");
-                connection->send_message("You are connected to Dungeon Merc!");
-                connection->send_message("Game features coming soon...");
-                connection->send_message("> "); // Add prompt
-            } else if (message == "look") {
-                LOG_DEBUG("User requested look");
-                if (game_world_ && connection->get_player()) {
-                    std::string room_desc = game_world_->handle_look_command(connection->get_player());
-                    connection->send_message(room_desc);
-                } else {
-                    connection->send_message("You are lost in the void...");
-                }
-                connection->send_message("> "); // Add prompt
-            } else if (message == "players") {
-                LOG_DEBUG("User requested players list");
-                if (game_world_ && connection->get_player()) {
-                    std::string players_list = game_world_->handle_players_command(connection->get_player());
-                    connection->send_message(players_list);
-                } else {
-                    connection->send_message("You are alone.");
-                }
-                connection->send_message("> "); // Add prompt
-            } else if (is_valid_direction(message)) {
-                LOG_DEBUG("User requested movement: " + message);
-                if (game_world_ && connection->get_player()) {
-                    std::string move_result = game_world_->handle_move_command(connection->get_player(), message);
-                    connection->send_message(move_result);
-                } else {
-                    connection->send_message("You can't move right now.");
-                }
-                connection->send_message("> "); // Add prompt
-            } else {
-                LOG_DEBUG("Unknown command: " + message);
-                connection->send_message("Unknown command: " + message);
-                connection->send_message("Type 'help' for available commands.");
-                connection->send_message("> "); // Add prompt
+        if (!connection->is_welcome_sent()) {
+            static const std::string_view welcome[] = {
+                "Welcome to Dungeon Merc!",
+                "Type 'help' for available commands.",
+                "> "
+            };
+            connection->offer_gmcp();
+            connection->send_lines(welcome, 3);
+            connection->mark_welcome_sent();
+        }
+
+        ssize_t bytes_read = connection->read_input(now);
+        if (bytes_read < 0) {
+            connection->close();
+            continue;
+        }
+        bytes_in_.add(static_cast<uint64_t>(bytes_read));
+
+        if (connection->input_overflowed()) {
+            connection->send_message("Line too long.");
+            connection->close();
+        }
+    }
+
+    // Execute one line per connection per round, starting at a different
+    // connection each tick, until input or the tick's budget runs out. A
+    // flooding client only ever gets its fair share.
+    size_t count = connections_.size();
+    size_t budget = MAX_COMMANDS_PER_TICK;
+    size_t start = count > 0 ? round_robin_start_++ % count : 0;
+    bool progress = true;
+    while (progress && budget > 0) {
+        progress = false;
+        for (size_t i = 0; i < count && budget > 0; ++i) {
+            const auto& connection = connections_[(start + i) % count];
+            if (!connection->is_connected() || !connection->has_line()) {
+                continue;
             }
+            if (!connection->take_command_token()) {
+                continue;
+            }
+
+            std::string_view line;
+            connection->next_line(line);
+            execute_line(connection, line);
+            progress = true;
+            --budget;
+        }
+    }
+
+    for (auto& connection : connections_) {
+        if (!connection->is_connected()) {
+            continue;
+        }
+        if (connection->is_throttled()) {
+            throttled_.add();
+        }
+        if (!connection->update_flood_state(now)) {
+            LOG_WARNING("Disconnecting " + connection->get_client_ip() + " for flooding");
+            connection->send_message("Flood limit exceeded. Goodbye.");
+            connection->close();
+            flood_disconnects_.add();
+        }
+    }
+
+    flush_chat();
+    flush_gmcp();
+}
+
+void TelnetServer::execute_line(const std::shared_ptr<TelnetConnection>& connection, std::string_view line) {
+    LOG_DEBUG("Game message from " + connection->get_client_ip() + ": " + std::string(redact_command(line)));
+
+    if (gateway_) {
+        // The zone server replies with output and a prompt in a later tick
+        gateway_->forward(connection->get_id(), line);
+        return;
+    }
+
+    if (recorder_) {
+        // Never write admin passwords to disk
+        recorder_->record_command(connection->get_id(), redact_command(line));
+    }
+
+    CommandContext ctx;
+    ctx.player = connection->get_player();
+    ctx.connection = connection.get();
+    ctx.is_admin = connection->is_admin();
+    dispatcher_.dispatch(ctx, line);
+
+    // Output and prompt go out in a single writev
+    if (!ctx.disconnect) {
+        ctx.output.push_back("> ");
+    }
+    connection->send_lines(ctx.output.data(), ctx.output.size());
+
+    if (ctx.disconnect) {
+        connection->close();
+    }
+}
+
+void TelnetServer::bind_player(TelnetConnection* connection, PlayerId player) {
+    connection->set_player(player);
+    if (player.index >= player_connections_.size()) {
+        player_connections_.resize(player.index + 1, nullptr);
+    }
+    player_connections_[player.index] = connection;
+}
+
+TelnetConnection* TelnetServer::find_player_connection(PlayerId player) const {
+    if (player.index >= player_connections_.size()) {
+        return nullptr;
+    }
+    TelnetConnection* connection = player_connections_[player.index];
+    // The slot may have been reused by a newer player
+    return (connection && connection->get_player() == player) ? connection : nullptr;
+}
+
+void TelnetServer::flush_chat() {
+    if (!game_world_) {
+        return;
+    }
+
+    game_world_->get_chat().flush([this](PlayerId player, std::string_view line) {
+        TelnetConnection* connection = find_player_connection(player);
+        if (!connection || !connection->is_connected()) {
+            return;
+        }
+        if (!connection->has_queued_lines()) {
+            chat_recipients_.push_back(connection);
+        }
+        connection->queue_line(line);
+    });
+
+    for (TelnetConnection* connection : chat_recipients_) {
+        connection->flush_queued_lines();
+    }
+    chat_recipients_.clear();
+}
+
+void TelnetServer::flush_gmcp() {
+    if (!game_world_) {
+        return;
+    }
+
+    TRACE_SCOPE("io.gmcp");
+    ArenaString out;
+    for (auto& connection : connections_) {
+        if (!connection->is_connected() || !connection->get_gmcp().is_enabled()) {
+            continue;
+        }
+        PlayerId id = connection->get_player();
+        Player* player = game_world_->get_player(id);
+        if (!player) {
+            continue;
+        }
+
+        // Everything that changed this tick goes out in one write
+        out.clear();
+        const Room* room = game_world_->find_room(player->get_current_room_id());
+        if (connection->get_gmcp().collect(id, *player, room, game_world_->get_players(), out)) {
+            connection->send_raw(out.view());
+            gmcp_bytes_.add(out.size());
         }
+        player->clear_dirty(PLAYER_DIRTY_GMCP);
     }
 }
 
 void TelnetServer::remove_disconnected_connections() {
+    TRACE_SCOPE("io.cleanup");
     std::lock_guard<std::mutex> lock(connections_mutex_);
 
     connections_.erase(
         std::remove_if(connections_.begin(), connections_.end(),
             [this](const std::shared_ptr<TelnetConnection>& conn) {
                 if (!conn->is_connected()) {
+                    // Take the player out of the world so rooms don't fill with ghosts
+                    PlayerId player = conn->get_player();
+                    if (game_world_ && player.is_valid()) {
+                        game_world_->remove_player(player);
+                    }
+                    if (gateway_) {
+                        gateway_->detach(conn->get_id());
+                    }
+                    if (player.index < player_connections_.size() &&
+                        player_connections_[player.index] == conn.get()) {
+                        player_connections_[player.index] = nullptr;
+                    }
+                    if (recorder_) {
+                        recorder_->record_disconnect(conn->get_id());
+                    }
                     if (disconnection_callback_) {
                         disconnection_callback_(conn);
                     }
@@ -344,6 +1061,138 @@ void TelnetServer::remove_disconnected_connections() {
             }),
         connections_.end()
     );
+    connections_gauge_.set(static_cast<int64_t>(connections_.size()));
+}
+
+CopyoverState TelnetServer::prepare_copyover() {
+    CopyoverState state;
+    state.server_socket = server_socket_;
+    state.next_connection_id = next_connection_id_;
+    clear_close_on_exec(server_socket_);
+    {
+        // Only the hash is kept, and it travels in the handoff file rather than argv
+        std::lock_guard<std::mutex> lock(users_mutex_);
+        auto admin = users_.find("admin");
+        if (admin != users_.end()) {
+            state.admin_password_hash = admin->second;
+        }
+    }
+
+    // Players still waiting to get in start over after the reboot
+    for (auto& connection : login_queue_) {
+        connection->send_message("The server is rebooting. Please reconnect in a moment.");
+        connection->close();
+    }
+    login_queue_.clear();
+    for (auto& pending : tls_handshakes_) {
+        pending.connection->close();
+    }
+    tls_handshakes_.clear();
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto& connection : connections_) {
+        if (!connection->is_connected()) {
+            continue;
+        }
+
+        // Anything not handed on is closed here, or the new image would
+        // inherit a socket it knows nothing about. Cipher state lives in
+        // this process; a TLS client resumes its session on reconnect.
+        const Player* player = game_world_ ? game_world_->get_player(connection->get_player()) : nullptr;
+        bool handed_on = player && !connection->is_encrypted();
+        if (handed_on && !clear_close_on_exec(connection->get_socket_fd())) {
+            LOG_WARNING("Connection from " + connection->get_client_ip() + " will not survive the reboot");
+            handed_on = false;
+        }
+        if (!handed_on) {
+            connection->send_message("The server is rebooting. Please reconnect in a moment.");
+            connection->close();
+            continue;
+        }
+
+        CopyoverConnection entry;
+        entry.connection_id = connection->get_id();
+        entry.socket_fd = connection->get_socket_fd();
+        entry.client_ip = connection->get_client_ip();
+        entry.player_name = player->get_name();
+        entry.character_class = player->get_character_class();
+        entry.health = player->get_health();
+        entry.max_health = player->get_max_health();
+        entry.level = player->get_level();
+        entry.experience = player->get_experience();
+        entry.room_id = player->get_current_room_id();
+        entry.channels = game_world_->get_chat().get_channels(connection->get_player());
+        entry.gmcp = connection->get_gmcp().is_enabled();
+        entry.gmcp_modules = connection->get_gmcp().get_modules();
+        game_world_->copy_inventory(connection->get_player(), entry.items);
+        state.connections.push_back(entry);
+
+        connection->send_message("The world shimmers as the server reboots. Please wait...");
+    }
+
+    // Send the notices and stop the ring touching the sockets before exec
+    for (const auto& connection : connections_) {
+        connection->flush_pending_output();
+    }
+    if (uring_) {
+        uring_->quiesce(std::chrono::seconds(1));
+    }
+
+    return state;
+}
+
+bool TelnetServer::restore_from_copyover(const CopyoverState& state) {
+    if (state.server_socket < 0) {
+        LOG_ERROR("Copyover state has no server socket");
+        return false;
+    }
+
+    // The listening socket was inherited, so skip create_server_socket()
+    server_socket_ = state.server_socket;
+    next_connection_id_ = state.next_connection_id;
+    running_ = true;
+    if (!state.admin_password_hash.empty()) {
+        add_user("admin", state.admin_password_hash);
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (const auto& entry : state.connections) {
+        auto connection = std::make_shared<TelnetConnection>(entry.socket_fd, entry.client_ip);
+        if (!connection->initialize()) {
+            connection->close();
+            continue;
+        }
+        connection->set_id(entry.connection_id);
+        connection->set_flood_limits(flood_limits_);
+        connection->mark_welcome_sent();
+        if (entry.gmcp) {
+            // The client already agreed; resend everything from the new image
+            connection->get_gmcp().set_enabled(true);
+            connection->get_gmcp().set_modules(entry.gmcp_modules);
+        }
+
+        if (game_world_) {
+            PlayerId id = game_world_->create_player(entry.player_name, entry.character_class, entry.room_id);
+            Player* player = game_world_->get_player(id);
+            player->restore_progress(entry.level, entry.experience, entry.health, entry.max_health);
+            game_world_->restore_inventory(id, entry.items);
+            bind_player(connection.get(), id);
+            game_world_->get_chat().set_channels(id, entry.channels);
+
+            if (recorder_) {
+                recorder_->record_connect(connection->get_id(), player->get_name(),
+                                          player->get_character_class(), player->get_current_room_id());
+            }
+        }
+
+        connection->send_message("Reboot complete.");
+        connection->send_message("> ");
+        connections_.push_back(connection);
+    }
+
+    connections_gauge_.set(static_cast<int64_t>(connections_.size()));
+    LOG_INFO("Restored " + std::to_string(connections_.size()) + " connections after hot reboot");
+    return true;
 }
 
 bool TelnetServer::add_user(const std::string& username, const std::string& password_hash) {
@@ -366,6 +1215,7 @@ bool TelnetServer::remove_user(const std::string& username) {
 
 void TelnetServer::set_game_world(std::shared_ptr<GameWorld> game_world) {
     game_world_ = game_world;
+    dispatcher_.set_game_world(game_world);
 }
 
 std::shared_ptr<GameWorld> TelnetServer::get_game_world() const {
@@ -383,6 +1233,92 @@ bool TelnetServer::validate_credentials(const std::string& username, const std::
     return verify_password(password, it->second);
 }
 
+void TelnetServer::set_admin_password(const std::string& password) {
+    add_user("admin", hash_password(password));
+}
+
+void TelnetServer::register_server_commands() {
+    dispatcher_.register_command("admin", "admin <password> - Unlock admin commands",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (ctx.connection && validate_credentials("admin", std::string(args))) {
+                ctx.connection->set_admin(true);
+                ctx.reply("Admin commands unlocked.");
+                LOG_INFO("Admin access granted to " + ctx.connection->get_client_ip());
+            } else {
+                ctx.reply("Invalid admin password.");
+            }
+        });
+
+    dispatcher_.register_command("stats", "stats - Show server metrics",
+        [](CommandContext& ctx, std::string_view) {
+            ctx.reply("Server statistics:");
+            for (const auto& line : MetricsRegistry::get_instance().format_report()) {
+                ctx.reply(line);
+            }
+        }, true);
+
+    dispatcher_.register_command("triggers", "triggers [reload] - Show or reload room triggers",
+        [this](CommandContext& ctx, std::string_view args) {
+            if (!game_world_) {
+                ctx.reply("No game world loaded.");
+                return;
+            }
+
+            TriggerRegistry& triggers = game_world_->get_triggers();
+            ArenaString out(*ctx.output.get_allocator().arena());
+            if (iequals(trim_view(args), "reload")) {
+                std::string error;
+                if (triggers.get_path().empty()) {
+                    ctx.reply("No trigger file was loaded at startup.");
+                    return;
+                }
+                if (!game_world_->load_triggers(triggers.get_path(), error)) {
+                    ctx.reply("Reload failed, keeping the old triggers: " + error);
+                    return;
+                }
+            }
+
+            out << static_cast<uint64_t>(triggers.size()) << " triggers loaded";
+            if (!triggers.get_path().empty()) {
+                out << " from " << triggers.get_path();
+            }
+            out << '.';
+            ctx.reply(out);
+        }, true);
+
+    register_trace_command();
+}
+
+void TelnetServer::register_trace_command() {
+    dispatcher_.register_command("trace", "trace start|stop|dump [file] - Record a timeline of server phases",
+        [](CommandContext& ctx, std::string_view args) {
+            auto& recorder = TraceRecorder::get_instance();
+            Tokenizer tokenizer(args);
+            std::string_view action = tokenizer.next();
+            std::string_view file = tokenizer.next();
+            std::string path = file.empty() ? std::string(DEFAULT_TRACE_FILE) : std::string(file);
+
+            if (iequals(action, "start")) {
+                recorder.start();
+                ctx.reply("Trace recording started.");
+            } else if (iequals(action, "stop")) {
+                recorder.stop();
+                ctx.reply("Trace recording stopped.");
+            } else if (iequals(action, "dump")) {
+                long events = recorder.dump(path);
+                if (events < 0) {
+                    ctx.reply("Failed to write " + path + ".");
+                } else {
+                    ctx.reply("Wrote " + std::to_string(events) + " events to " + path +
+                              " (open in chrome://tracing or ui.perfetto.dev).");
+                }
+            } else {
+                ctx.reply(std::string("Tracing is ") + (recorder.is_enabled() ? "on" : "off") +
+                          ". Usage: trace start|stop|dump [file]");
+            }
+        }, true);
+}
+
 bool TelnetServer::create_server_socket() {
     server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
     if (server_socket_ < 0) {
@@ -401,7 +1337,7 @@ bool TelnetServer::create_server_socket() {
         return false;
     }
 
-    if (listen(server_socket_, 10) < 0) {
+    if (listen(server_socket_, SOMAXCONN) < 0) {
         LOG_ERROR("Failed to listen on server socket");
         return false;
     }
@@ -0,0 +1,270 @@
+#include "tls.hpp"
+#include "common.hpp"
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace dungeon_merc {
+
+namespace {
+
+constexpr long TLS_SESSION_CACHE_SIZE = 20000;
+constexpr long TLS_SESSION_LIFETIME = 2 * 60 * 60;  // Seconds a session or ticket stays resumable
+const unsigned char TLS_SESSION_ID_CONTEXT[] = "dungeon_merc";
+
+// Drain OpenSSL's error queue into one line for the log
+std::string openssl_error() {
+    std::string message;
+    unsigned long error;
+    while ((error = ERR_get_error()) != 0) {
+        char buffer[256];
+        ERR_error_string_n(error, buffer, sizeof(buffer));
+        if (!message.empty()) {
+            message += "; ";
+        }
+        message += buffer;
+    }
+    return message.empty() ? "unknown error" : message;
+}
+
+} // namespace
+
+TlsContext::TlsContext()
+    : ctx_(nullptr) {
+}
+
+TlsContext::~TlsContext() {
+    SSL_CTX_free(ctx_);
+}
+
+bool TlsContext::kernel_offload_available() {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TlsContext::load(const std::string& cert_file, const std::string& key_file) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        LOG_ERROR("Failed to create TLS context: " + openssl_error());
+        return false;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    // The kernel cannot renegotiate, and we never need to
+    SSL_CTX_set_options(ctx, SSL_OP_NO_RENEGOTIATION);
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+    // Sockets are non-blocking and unsent output is retried from a buffer that moves
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    // Resumption: tickets for clients that take them, the server cache for the rest
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, TLS_SESSION_CACHE_SIZE);
+    SSL_CTX_set_timeout(ctx, TLS_SESSION_LIFETIME);
+    SSL_CTX_set_session_id_context(ctx, TLS_SESSION_ID_CONTEXT, sizeof(TLS_SESSION_ID_CONTEXT) - 1);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert_file.c_str()) != 1) {
+        LOG_ERROR("Failed to load TLS certificate " + cert_file + ": " + openssl_error());
+        SSL_CTX_free(ctx);
+        return false;
+    }
+    if (SSL_CTX_use_PrivateKey_file(ctx, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        LOG_ERROR("Failed to load TLS key " + key_file + ": " + openssl_error());
+        SSL_CTX_free(ctx);
+        return false;
+    }
+
+    SSL_CTX_free(ctx_);
+    ctx_ = ctx;
+    return true;
+}
+
+std::unique_ptr<TlsSession> TlsContext::accept(int socket_fd) {
+    if (!ctx_) {
+        return nullptr;
+    }
+    SSL* ssl = SSL_new(ctx_);
+    if (!ssl) {
+        LOG_ERROR("Failed to create TLS session: " + openssl_error());
+        return nullptr;
+    }
+    if (SSL_set_fd(ssl, socket_fd) != 1) {
+        LOG_ERROR("Failed to attach TLS session: " + openssl_error());
+        SSL_free(ssl);
+        return nullptr;
+    }
+    SSL_set_accept_state(ssl);
+    return std::make_unique<TlsSession>(ssl, socket_fd);
+}
+
+TlsSession::TlsSession(SSL* ssl, int socket_fd)
+    : ssl_(ssl), socket_fd_(socket_fd) {
+}
+
+TlsSession::~TlsSession() {
+    SSL_free(ssl_);
+}
+
+TlsHandshake TlsSession::handshake() {
+    if (established_) {
+        return TlsHandshake::DONE;
+    }
+
+    int result = SSL_do_handshake(ssl_);
+    if (result == 1) {
+        established_ = true;
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        kernel_send_ = BIO_get_ktls_send(SSL_get_wbio(ssl_)) > 0;
+        kernel_recv_ = BIO_get_ktls_recv(SSL_get_rbio(ssl_)) > 0;
+#endif
+        return TlsHandshake::DONE;
+    }
+
+    int error = SSL_get_error(ssl_, result);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+        return TlsHandshake::PENDING;
+    }
+    LOG_DEBUG("TLS handshake failed: " + openssl_error());
+    ERR_clear_error();
+    return TlsHandshake::FAILED;
+}
+
+bool TlsSession::is_resumed() const {
+    return SSL_session_reused(ssl_) == 1;
+}
+
+std::string TlsSession::describe() const {
+    std::string text = std::string(SSL_get_version(ssl_)) + " " + SSL_get_cipher_name(ssl_);
+    if (is_resumed()) {
+        text += ", resumed";
+    }
+    if (kernel_send_ || kernel_recv_) {
+        text += std::string(", kernel ") + (kernel_send_ ? "tx" : "") + (kernel_send_ && kernel_recv_ ? "/" : "") +
+                (kernel_recv_ ? "rx" : "");
+    }
+    return text;
+}
+
+ssize_t TlsSession::read(char* buffer, size_t length) {
+    if (!pending_.empty() && !flush(pending_)) {
+        return -1;
+    }
+
+    // With kernel receive OpenSSL reads records straight off the socket; it
+    // still has to see them for alerts and post-handshake messages
+    int result = SSL_read(ssl_, buffer, static_cast<int>(std::min(length, static_cast<size_t>(INT_MAX))));
+    if (result > 0) {
+        return result;
+    }
+
+    int error = SSL_get_error(ssl_, result);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+        return 0;
+    }
+    if (error != SSL_ERROR_ZERO_RETURN) {
+        LOG_DEBUG("TLS read failed: " + openssl_error());
+    }
+    ERR_clear_error();
+    return -1;
+}
+
+ssize_t TlsSession::write(const struct iovec* iov, int count) {
+    if (kernel_send_ && pending_.empty()) {
+        return write_kernel(iov, count);
+    }
+
+    // OpenSSL wants one contiguous buffer per record. Queue behind anything
+    // still pending so the retry sees the same leading bytes.
+    thread_local std::string scratch;
+    std::string& buffer = pending_.empty() ? scratch : pending_;
+    if (&buffer == &scratch) {
+        scratch.clear();
+    }
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        buffer.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        total += iov[i].iov_len;
+    }
+
+    if (!flush(buffer)) {
+        return -1;
+    }
+    if (&buffer == &scratch && !scratch.empty()) {
+        pending_ = scratch;
+    }
+    if (pending_.size() > TLS_PENDING_LIMIT) {
+        LOG_WARNING("TLS client is not reading its output");
+        return -1;
+    }
+    return static_cast<ssize_t>(total);
+}
+
+ssize_t TlsSession::write_kernel(const struct iovec* iov, int count) {
+    // The kernel frames and encrypts: no copy, no userspace crypto
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = const_cast<struct iovec*>(iov);
+    message.msg_iovlen = static_cast<size_t>(count);
+    ssize_t result = sendmsg(socket_fd_, &message, MSG_NOSIGNAL);
+    if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        return -1;
+    }
+
+    // Keep what the socket could not take; it goes out through OpenSSL,
+    // which hands it to the kernel as well, ahead of the next write
+    size_t written = result > 0 ? static_cast<size_t>(result) : 0;
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        size_t length = iov[i].iov_len;
+        size_t skip = std::min(written, length);
+        written -= skip;
+        pending_.append(static_cast<const char*>(iov[i].iov_base) + skip, length - skip);
+        total += length;
+    }
+    if (pending_.size() > TLS_PENDING_LIMIT) {
+        LOG_WARNING("TLS client is not reading its output");
+        return -1;
+    }
+    return static_cast<ssize_t>(total);
+}
+
+bool TlsSession::flush(std::string& buffer) {
+    size_t sent = 0;
+    while (sent < buffer.size()) {
+        int result = SSL_write(ssl_, buffer.data() + sent,
+                               static_cast<int>(std::min(buffer.size() - sent, static_cast<size_t>(INT_MAX))));
+        if (result > 0) {
+            sent += static_cast<size_t>(result);
+            continue;
+        }
+        int error = SSL_get_error(ssl_, result);
+        if (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ) {
+            break;
+        }
+        LOG_DEBUG("TLS write failed: " + openssl_error());
+        ERR_clear_error();
+        buffer.clear();
+        return false;
+    }
+    buffer.erase(0, sent);
+    return true;
+}
+
+void TlsSession::shutdown() {
+    if (established_) {
+        SSL_shutdown(ssl_);
+        ERR_clear_error();
+        established_ = false;
+    }
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,129 @@
+#include "trace.hpp"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+
+namespace dungeon_merc {
+
+std::atomic<bool> g_trace_enabled(false);
+
+namespace {
+
+void write_json_string(std::FILE* out, const char* text) {
+    std::fputc('"', out);
+    for (const char* p = text; *p; ++p) {
+        unsigned char byte = static_cast<unsigned char>(*p);
+        if (*p == '"' || *p == '\\') {
+            std::fputc('\\', out);
+            std::fputc(*p, out);
+        } else if (byte < 0x20) {
+            std::fprintf(out, "\\u%04x", byte);
+        } else {
+            std::fputc(*p, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+} // namespace
+
+ThreadTraceBuffer::ThreadTraceBuffer(uint32_t thread_id)
+    : thread_id_(thread_id)
+    , slots_(new Slot[TRACE_BUFFER_EVENTS]) {
+}
+
+void ThreadTraceBuffer::snapshot(std::vector<TraceEvent>& out) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t first = std::max(tail, head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0);
+
+    size_t start = out.size();
+    for (uint64_t i = first; i < head; ++i) {
+        const Slot& slot = slots_[i % TRACE_BUFFER_EVENTS];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        TraceEvent event{slot.name.load(std::memory_order_relaxed),
+                         slot.start_ns.load(std::memory_order_relaxed),
+                         slot.duration_ns.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+
+        if (before != i + 1 || after != i + 1) {
+            // The owner rewrote this slot under us. Drop what came before it
+            // too, so the events returned stay a contiguous run.
+            out.resize(start);
+            continue;
+        }
+        out.push_back(event);
+    }
+}
+
+ThreadTraceBuffer& TraceRecorder::thread_buffer() {
+    thread_local ThreadTraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.push_back(std::make_unique<ThreadTraceBuffer>(static_cast<uint32_t>(syscall(SYS_gettid))));
+        buffer = buffers_.back().get();
+    }
+    return *buffer;
+}
+
+void TraceRecorder::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& buffer : buffers_) {
+            buffer->clear();
+        }
+    }
+    g_trace_enabled.store(true, std::memory_order_relaxed);
+    LOG_INFO("Trace recording started");
+}
+
+void TraceRecorder::stop() {
+    g_trace_enabled.store(false, std::memory_order_relaxed);
+    LOG_INFO("Trace recording stopped");
+}
+
+long TraceRecorder::dump(const std::string& path) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        LOG_ERROR("Failed to open trace file: " + path);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TraceEvent> events;
+    long written = 0;
+    uint32_t pid = static_cast<uint32_t>(getpid());
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+    for (const auto& buffer : buffers_) {
+        events.clear();
+        buffer->snapshot(events);
+        for (const auto& event : events) {
+            std::fputs(written == 0 ? "\n" : ",\n", out);
+            std::fputs("{\"name\":", out);
+            write_json_string(out, event.name);
+            std::fprintf(out, ",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         pid, buffer->get_thread_id(),
+                         event.start_ns / 1000.0, event.duration_ns / 1000.0);
+            written++;
+        }
+    }
+    std::fputs("\n]}\n", out);
+
+    bool ok = std::fclose(out) == 0;
+    if (!ok) {
+        LOG_ERROR("Failed to write trace file: " + path);
+        return -1;
+    }
+
+    LOG_INFO("Wrote " + std::to_string(written) + " trace events to " + path);
+    return written;
+}
+
+const char* TraceRecorder::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return interned_names_.insert(name).first->c_str();
+}
+
+} // namespace dungeon_merc
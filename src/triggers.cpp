@@ -0,0 +1,205 @@
+#include "triggers.hpp"
+#include "tokenizer.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace dungeon_merc {
+
+namespace {
+
+bool parse_event(std::string_view word, TriggerEvent& event) {
+    if (word == "enter") { event = TriggerEvent::ENTER; return true; }
+    if (word == "exit") { event = TriggerEvent::EXIT; return true; }
+    if (word == "command") { event = TriggerEvent::COMMAND; return true; }
+    if (word == "timer") { event = TriggerEvent::TIMER; return true; }
+    return false;
+}
+
+bool is_header(std::string_view line) {
+    Tokenizer tokenizer(line);
+    return tokenizer.next() == "on";
+}
+
+// on <event> <room> [argument] [budget N]
+bool parse_header(std::string_view line, Trigger& trigger, std::string& error) {
+    Tokenizer tokenizer(line);
+    tokenizer.next();
+
+    std::string_view event = tokenizer.next();
+    if (!parse_event(event, trigger.event)) {
+        error = "unknown event '" + std::string(event) + "'";
+        return false;
+    }
+    if (!parse_int(tokenizer.next(), trigger.room_id)) {
+        error = "expected a room number";
+        return false;
+    }
+
+    std::string_view token = tokenizer.next();
+    if (!token.empty() && token != "budget") {
+        trigger.argument = to_lower(std::string(token));
+        token = tokenizer.next();
+    }
+    if (token == "budget") {
+        int budget;
+        if (!parse_int(tokenizer.next(), budget) || budget <= 0) {
+            error = "expected an instruction budget";
+            return false;
+        }
+        trigger.budget = static_cast<uint32_t>(budget);
+        token = tokenizer.next();
+    }
+    if (!token.empty()) {
+        error = "unexpected '" + std::string(token) + "'";
+        return false;
+    }
+
+    switch (trigger.event) {
+        case TriggerEvent::COMMAND:
+            if (trigger.argument.empty()) {
+                error = "command triggers need a verb";
+                return false;
+            }
+            break;
+        case TriggerEvent::EXIT: {
+            Direction dir;
+            if (!trigger.argument.empty()) {
+                if (!parse_direction(trigger.argument, dir)) {
+                    error = "unknown direction '" + trigger.argument + "'";
+                    return false;
+                }
+                trigger.argument = std::string(direction_name(dir));
+            }
+            break;
+        }
+        case TriggerEvent::TIMER: {
+            int seconds;
+            if (!parse_int(trigger.argument, seconds) || seconds <= 0) {
+                error = "timer triggers need an interval in seconds";
+                return false;
+            }
+            trigger.interval = std::chrono::seconds(seconds);
+            trigger.argument.clear();
+            break;
+        }
+        case TriggerEvent::ENTER:
+            if (!trigger.argument.empty()) {
+                error = "enter triggers take no argument";
+                return false;
+            }
+            break;
+    }
+    return true;
+}
+
+} // namespace
+
+bool TriggerRegistry::load_file(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream contents;
+    contents << in.rdbuf();
+
+    if (!load(contents.str(), path, error)) {
+        return false;
+    }
+    path_ = path;
+    return true;
+}
+
+bool TriggerRegistry::load(std::string_view text, const std::string& source_name, std::string& error) {
+    std::vector<Trigger> loaded;
+
+    // Header line numbers and where each body starts and ends in the text
+    struct Section {
+        int header_line;
+        std::string_view header;
+        size_t body_start;
+        size_t body_end;
+    };
+    std::vector<Section> sections;
+
+    size_t pos = 0;
+    int line_number = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(pos, end - pos);
+        ++line_number;
+
+        if (is_header(line)) {
+            if (!sections.empty()) {
+                sections.back().body_end = pos;
+            }
+            sections.push_back(Section{line_number, line, end, text.size()});
+        } else if (sections.empty() && !trim_view(line).empty() && trim_view(line)[0] != '#') {
+            error = source_name + ":" + std::to_string(line_number) + ": expected 'on <event> <room>'";
+            return false;
+        }
+        pos = end + 1;
+    }
+
+    for (const auto& section : sections) {
+        Trigger trigger;
+        trigger.location = source_name + ":" + std::to_string(section.header_line);
+        std::string message;
+        if (!parse_header(section.header, trigger, message)) {
+            error = trigger.location + ": " + message;
+            return false;
+        }
+
+        std::string_view body = text.substr(section.body_start, section.body_end - section.body_start);
+        if (!compile_script(body, section.header_line, trigger.script, message)) {
+            error = source_name + ": " + message;
+            return false;
+        }
+        loaded.push_back(std::move(trigger));
+    }
+
+    clear();
+    triggers_ = std::move(loaded);
+    for (uint32_t i = 0; i < triggers_.size(); ++i) {
+        rooms_[triggers_[i].room_id][static_cast<size_t>(triggers_[i].event)].push_back(i);
+    }
+    return true;
+}
+
+void TriggerRegistry::clear() {
+    triggers_.clear();
+    rooms_.clear();
+    timers_ = decltype(timers_)();
+    timers_scheduled_ = false;
+}
+
+void TriggerRegistry::run_due_timers(TriggerClock::time_point now, const std::function<void(const Trigger&)>& fn) {
+    if (!timers_scheduled_) {
+        for (uint32_t i = 0; i < triggers_.size(); ++i) {
+            if (triggers_[i].event == TriggerEvent::TIMER) {
+                timers_.push(TimerEntry{now + triggers_[i].interval, i});
+            }
+        }
+        timers_scheduled_ = true;
+    }
+
+    while (!timers_.empty() && timers_.top().due <= now) {
+        TimerEntry entry = timers_.top();
+        timers_.pop();
+        const Trigger& trigger = triggers_[entry.trigger];
+        fn(trigger);
+
+        // Schedule from the planned time so intervals don't drift, but never
+        // try to catch up on runs missed while the server was stalled
+        entry.due += trigger.interval;
+        if (entry.due <= now) {
+            entry.due = now + trigger.interval;
+        }
+        timers_.push(entry);
+    }
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,164 @@
+#include "world_region.hpp"
+#include "random.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+namespace {
+
+// One kind of site per region, so a region reads as one place
+struct SiteTheme {
+    const char* name;
+    const char* intro;
+    const char* rooms[6];
+    const char* details[4];
+};
+
+const SiteTheme SITE_THEMES[] = {
+    {"Ruined Lab",
+     "Emergency lighting paints the wrecked lab in red. Benches lie overturned and the vents breathe a chemical chill.",
+     {"Collapsed Corridor", "Specimen Hall", "Cold Storage", "Clean Room", "Server Closet", "Decon Shower"},
+     {"Shattered glass crunches underfoot.",
+      "A cracked tank still hums, its fluid long gone dark.",
+      "Warning placards flicker on a backup circuit.",
+      "Something has been chewing on the cable runs."}},
+    {"Haunted Bunker",
+     "Concrete walls sweat in the dark of the old bunker. Your footsteps come back to you a moment too late.",
+     {"Blast Door", "Barracks", "Signal Room", "Mess Hall", "Armory Cage", "Air Shaft"},
+     {"The air tastes of rust and old smoke.",
+      "A radio crackles with a voice that is not quite there.",
+      "Bunks stand made, as if the crew stepped out a minute ago.",
+      "Scratches on the wall count days nobody finished counting."}},
+    {"Alien Mine",
+     "The tunnel was cut by something that did not need light. Strange geometric veins run through the rock.",
+     {"Ore Gallery", "Crystal Seam", "Drill Head", "Sump", "Lift Cage", "Resonance Cavern"},
+     {"The rock glows faintly where it was cut.",
+      "A low hum rises from somewhere beneath the floor.",
+      "Abandoned drill bits lie fused into the stone.",
+      "The walls are warm to the touch."}},
+    {"Corporate Facility",
+     "Polished floors and dead screens stretch away under flickering panels. The company logo watches from every wall.",
+     {"Lobby", "Cubicle Farm", "Executive Suite", "Loading Dock", "Security Office", "Data Vault"},
+     {"Motivational posters peel from the walls.",
+      "A dead camera turret tracks nothing.",
+      "The coffee machine still blinks, waiting for an order.",
+      "Shredded documents drift across the floor."}},
+};
+
+template<typename T, size_t N>
+const T& pick(RandomGenerator& rng, const T (&table)[N]) {
+    return table[rng.random_int(0, static_cast<int>(N) - 1)];
+}
+
+} // namespace
+
+WorldGenerator::WorldGenerator(int generated_rooms, uint64_t seed)
+    : generated_rooms_(std::clamp(generated_rooms, 0, MAX_GENERATED_ROOMS)), seed_(seed) {
+}
+
+bool WorldGenerator::has_room(int room_id) const {
+    if (room_id >= 1 && room_id <= 5) {
+        return true;
+    }
+    return room_id >= FIRST_GENERATED_ROOM && room_id - FIRST_GENERATED_ROOM < generated_rooms_;
+}
+
+bool WorldGenerator::load_region(int region, std::vector<std::shared_ptr<Room>>& rooms) {
+    if (region == 0) {
+        create_starting_area(rooms);
+        return true;
+    }
+
+    // Count offsets rather than ids: the last region ends right at INT_MAX
+    int first = region * WORLD_REGION_ROOMS;
+    bool any = false;
+    for (int offset = 0; offset < WORLD_REGION_ROOMS; ++offset) {
+        int room_id = first + offset;
+        if (has_room(room_id)) {
+            rooms.push_back(generate_room(room_id));
+            any = true;
+        }
+    }
+    return any;
+}
+
+void WorldGenerator::create_starting_area(std::vector<std::shared_ptr<Room>>& rooms) const {
+    // Room 1: Town Square
+    auto town_square = std::make_shared<Room>(1, "Town Square",
+        "You stand in the bustling town square of Dungeon Merc. The cobblestone streets are worn smooth by countless adventurers who have passed through here. A fountain bubbles in the center, and you can see various shops and inns lining the square.");
+
+    // Room 2: Tavern
+    auto tavern = std::make_shared<Room>(2, "The Rusty Sword Tavern",
+        "The warm glow of candlelight fills this cozy tavern. The air is thick with the smell of ale and roasted meat. Adventurers gather here to share tales of their exploits and plan their next dungeon dive.");
+
+    // Room 3: Blacksmith
+    auto blacksmith = std::make_shared<Room>(3, "Ironforge Blacksmith",
+        "The clang of hammer on anvil echoes through this workshop. The blacksmith's forge glows red-hot, and weapons and armor of all kinds hang from the walls. The air is thick with the smell of burning coal and hot metal.");
+
+    // Room 4: Dungeon Entrance
+    auto dungeon_entrance = std::make_shared<Room>(4, "Dungeon Entrance",
+        "A dark opening in the earth yawns before you. Ancient stone steps lead down into the depths, and a cold breeze carries the scent of damp earth and mystery from below. This is where the real adventure begins.");
+
+    // Room 5: First Dungeon Chamber
+    auto dungeon_chamber = std::make_shared<Room>(5, "Ancient Chamber",
+        "You find yourself in a large, circular chamber carved from solid stone. Torches flicker on the walls, casting dancing shadows. Ancient runes are carved into the walls, telling tales of forgotten heroes and lost treasures.");
+
+    // Connect the rooms
+    town_square->add_exit(Direction::NORTH, 2);  // To tavern
+    town_square->add_exit(Direction::EAST, 3);   // To blacksmith
+    town_square->add_exit(Direction::SOUTH, 4);  // To dungeon entrance
+
+    tavern->add_exit(Direction::SOUTH, 1);       // Back to town square
+
+    blacksmith->add_exit(Direction::WEST, 1);    // Back to town square
+
+    dungeon_entrance->add_exit(Direction::NORTH, 1);  // Back to town square
+    dungeon_entrance->add_exit(Direction::DOWN, 5);   // To dungeon chamber
+
+    dungeon_chamber->add_exit(Direction::UP, 4);      // Back to dungeon entrance
+    if (generated_rooms_ > 0) {
+        dungeon_chamber->add_exit(Direction::DOWN, FIRST_GENERATED_ROOM);  // Into the deep levels
+    }
+
+    rooms.push_back(town_square);
+    rooms.push_back(tavern);
+    rooms.push_back(blacksmith);
+    rooms.push_back(dungeon_entrance);
+    rooms.push_back(dungeon_chamber);
+}
+
+std::shared_ptr<Room> WorldGenerator::generate_room(int room_id) const {
+    int index = room_id - FIRST_GENERATED_ROOM;
+    int x = index % GRID_WIDTH;
+    int y = index / GRID_WIDTH;
+
+    RandomGenerator theme_rng(RandomGenerator::stream_seed(seed_, static_cast<uint64_t>(region_of(room_id))));
+    const SiteTheme& theme = pick(theme_rng, SITE_THEMES);
+    RandomGenerator rng(RandomGenerator::stream_seed(seed_ ^ 0x726f6f6d, static_cast<uint64_t>(room_id)));
+
+    // Names and descriptions come from small tables, so the string pool
+    // stores each combination once however large the world is
+    std::string name = std::string(theme.name) + " - " + pick(rng, theme.rooms);
+    std::string description = std::string(theme.intro) + " " + pick(rng, theme.details);
+    auto room = std::make_shared<Room>(room_id, name, description);
+
+    // A grid, so neighbours are found by arithmetic and never need loading to know they exist
+    if (index == 0) {
+        room->add_exit(Direction::UP, 5);
+    }
+    if (x > 0) {
+        room->add_exit(Direction::WEST, room_id - 1);
+    }
+    if (x + 1 < GRID_WIDTH && has_room(room_id + 1)) {
+        room->add_exit(Direction::EAST, room_id + 1);
+    }
+    if (y > 0) {
+        room->add_exit(Direction::NORTH, room_id - GRID_WIDTH);
+    }
+    if (has_room(room_id + GRID_WIDTH)) {
+        room->add_exit(Direction::SOUTH, room_id + GRID_WIDTH);
+    }
+    return room;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,209 @@
+#include "world_snapshot.hpp"
+#include "room.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace dungeon_merc {
+
+const RoomView* WorldSnapshot::find_room(int room_id) const {
+    const std::shared_ptr<const RoomView>* entry = find_room_entry(room_id);
+    return entry ? entry->get() : nullptr;
+}
+
+const std::shared_ptr<const RoomView>* WorldSnapshot::find_room_entry(int room_id) const {
+    auto it = std::lower_bound(rooms_.begin(), rooms_.end(), room_id,
+                               [](const std::shared_ptr<const RoomView>& room, int id) { return room->id < id; });
+    return (it != rooms_.end() && (*it)->id == room_id) ? &*it : nullptr;
+}
+
+const PlayerView* WorldSnapshot::find_player(PlayerId player) const {
+    size_t chunk = player.index / SNAPSHOT_CHUNK_SIZE;
+    if (!player.is_valid() || chunk >= chunks_.size()) {
+        return nullptr;
+    }
+    const PlayerView& view = chunks_[chunk]->players[player.index % SNAPSHOT_CHUNK_SIZE];
+    return (view.generation_ != 0 && view.generation_ == player.generation) ? &view : nullptr;
+}
+
+void WorldSnapshot::render_look(PlayerId player, ArenaString& out) const {
+    const PlayerView* view = find_player(player);
+    const RoomView* room = view ? find_room(view->room_id_) : nullptr;
+    if (!room) {
+        out << "You are lost in the void...";
+        return;
+    }
+    out << room->description;
+}
+
+void WorldSnapshot::render_players(PlayerId player, ArenaString& out) const {
+    const PlayerView* view = find_player(player);
+    const RoomView* room = view ? find_room(view->room_id_) : nullptr;
+    if (!room) {
+        out << "You are lost in the void...";
+        return;
+    }
+    out << room->occupants;
+}
+
+void WorldSnapshot::render_who(const WhoFilter& filter, ArenaString& out) const {
+    out << "Mercs online: " << static_cast<uint64_t>(get_player_count());
+    if (!who_) {
+        out << "\nNobody matches.";
+        return;
+    }
+
+    // Highest level first, so the page starts at the first entry at or below max_level
+    const std::vector<WhoEntry>& list =
+        filter.any_class ? who_->all : who_->by_class[static_cast<size_t>(filter.character_class)];
+    auto it = std::partition_point(list.begin(), list.end(),
+                                   [&filter](const WhoEntry& entry) { return entry.level > filter.max_level; });
+
+    size_t shown = 0;
+    bool truncated = false;
+    for (; it != list.end() && it->level >= filter.min_level; ++it) {
+        if (shown == WHO_PAGE_SIZE) {
+            truncated = true;
+            break;
+        }
+        const PlayerView* view = find_player(it->id);
+        if (!view) {
+            continue;
+        }
+        out << "\n  [" << view->get_level() << ' ' << class_to_string(view->get_character_class())
+            << "] " << view->get_name();
+        ++shown;
+    }
+
+    if (shown == 0) {
+        out << "\nNobody matches.";
+    } else if (truncated) {
+        out << "\n  ...and more. Narrow it down with 'who <class> <level>'.";
+    }
+}
+
+void WorldSnapshot::render_status(PlayerId player, ArenaString& out) const {
+    const PlayerView* view = find_player(player);
+    if (!view) {
+        out << "You are lost in the void...";
+        return;
+    }
+    dungeon_merc::render_status(*view, out);
+}
+
+void WorldSnapshotBuilder::note_removed(PlayerId player) {
+    size_t chunk = player.index / SNAPSHOT_CHUNK_SIZE;
+    if (chunk >= stale_chunks_.size()) {
+        stale_chunks_.resize(chunk + 1, 0);
+    }
+    stale_chunks_[chunk] = 1;
+}
+
+std::unique_ptr<const WorldSnapshot> WorldSnapshotBuilder::build(const std::vector<const Room*>& rooms,
+                                                                 PlayerTable& players,
+                                                                 const PlayerDirectory& directory,
+                                                                 const WorldSnapshot* previous) {
+    TRACE_SCOPE("world.snapshot");
+    auto snapshot = std::make_unique<WorldSnapshot>();
+    bool changed = previous == nullptr;
+
+    // Rooms nobody entered or left keep their rendered text
+    snapshot->rooms_.reserve(rooms.size());
+    changed |= previous && previous->rooms_.size() != rooms.size();
+    for (const Room* room : rooms) {
+        const std::shared_ptr<const RoomView>* old = previous ? previous->find_room_entry(room->get_id()) : nullptr;
+        if (old && (*old)->players_version == room->get_players_version()) {
+            snapshot->rooms_.push_back(*old);
+        } else {
+            snapshot->rooms_.push_back(build_room(*room, players));
+            changed = true;
+        }
+    }
+
+    // Players: a chunk is rebuilt if anyone in it changed, joined or left
+    size_t chunk_count = (players.capacity() + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE;
+    snapshot->chunks_.reserve(chunk_count);
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        bool stale = !previous || chunk >= previous->chunks_.size() ||
+                     (chunk < stale_chunks_.size() && stale_chunks_[chunk]);
+        size_t end = std::min(players.capacity(), (chunk + 1) * SNAPSHOT_CHUNK_SIZE);
+        for (size_t index = chunk * SNAPSHOT_CHUNK_SIZE; !stale && index < end; ++index) {
+            const Player* player = players.get(players.id_at(static_cast<uint32_t>(index)));
+            stale = player && (player->get_dirty() & PLAYER_DIRTY_SNAPSHOT);
+        }
+        if (stale) {
+            snapshot->chunks_.push_back(build_chunk(chunk, players));
+            changed = true;
+        } else {
+            snapshot->chunks_.push_back(previous->chunks_[chunk]);
+        }
+    }
+    stale_chunks_.assign(stale_chunks_.size(), 0);
+
+    snapshot->directory_version_ = directory.get_version();
+    if (previous && previous->directory_version_ == directory.get_version()) {
+        snapshot->who_ = previous->who_;
+    } else {
+        snapshot->who_ = build_who(directory);
+        changed = true;
+    }
+
+    if (!changed) {
+        return nullptr;
+    }
+    snapshot->sequence_ = ++sequence_;
+    return snapshot;
+}
+
+std::shared_ptr<const RoomView> WorldSnapshotBuilder::build_room(const Room& room, const PlayerTable& players) const {
+    auto view = std::make_shared<RoomView>();
+    view->id = room.get_id();
+    view->players_version = room.get_players_version();
+
+    Arena& arena = tick_arena();
+    Arena::Checkpoint checkpoint = arena.checkpoint();
+    ArenaString text(arena);
+    room.render_description(text, players);
+    view->description.assign(text.view());
+    text.clear();
+    room.render_occupants(text, players);
+    view->occupants.assign(text.view());
+    arena.rewind(checkpoint);
+    return view;
+}
+
+std::shared_ptr<const WorldSnapshot::PlayerChunk> WorldSnapshotBuilder::build_chunk(size_t chunk,
+                                                                                   PlayerTable& players) const {
+    auto views = std::make_shared<WorldSnapshot::PlayerChunk>();
+    for (size_t slot = 0; slot < SNAPSHOT_CHUNK_SIZE; ++slot) {
+        PlayerId id = players.id_at(static_cast<uint32_t>(chunk * SNAPSHOT_CHUNK_SIZE + slot));
+        Player* player = players.get(id);
+        if (!player) {
+            continue;
+        }
+        PlayerView& view = views->players[slot];
+        view.generation_ = id.generation;
+        view.name_ = player->get_name();
+        view.character_class_ = player->get_character_class();
+        view.level_ = player->get_level();
+        view.health_ = player->get_health();
+        view.max_health_ = player->get_max_health();
+        view.experience_ = player->get_experience();
+        view.room_id_ = player->get_current_room_id();
+        player->clear_dirty(PLAYER_DIRTY_SNAPSHOT);
+    }
+    return views;
+}
+
+std::shared_ptr<const WorldSnapshot::WhoIndex> WorldSnapshotBuilder::build_who(const PlayerDirectory& directory) const {
+    auto who = std::make_shared<WorldSnapshot::WhoIndex>();
+    who->all.reserve(directory.size());
+    directory.for_each_who(WhoFilter(), [&who](PlayerId id, const Player& player) {
+        WorldSnapshot::WhoEntry entry{player.get_level(), id};
+        who->all.push_back(entry);
+        who->by_class[static_cast<size_t>(player.get_character_class())].push_back(entry);
+        return true;
+    });
+    return who;
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,253 @@
+#include "zone_gateway.hpp"
+#include "telnet_server.hpp"
+#include "trace.hpp"
+
+namespace dungeon_merc {
+
+namespace {
+
+// New characters start where GameWorld::create_player puts them
+constexpr int STARTING_ROOM_ID = 1;
+
+} // namespace
+
+ZoneGateway::ZoneGateway(const ZoneMap& map)
+    : map_(map)
+    , handoffs_(MetricsRegistry::get_instance().counter("zone.handoffs"))
+    , sessions_gauge_(MetricsRegistry::get_instance().gauge("zone.sessions")) {
+}
+
+bool ZoneGateway::connect_zones(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        int fd = connect_unix_socket(path);
+        if (fd < 0) {
+            return false;
+        }
+        add_zone_link(fd);
+        LOG_INFO("Connected to zone " + std::to_string(zones_.size() - 1) + " at " + path);
+    }
+    return true;
+}
+
+void ZoneGateway::add_zone_link(int fd) {
+    zones_.push_back(std::make_unique<ZoneLink>(fd));
+}
+
+ZoneLink* ZoneGateway::zone_link(int zone) const {
+    if (zone < 0 || static_cast<size_t>(zone) >= zones_.size() || !zones_[zone]->is_open()) {
+        return nullptr;
+    }
+    return zones_[zone].get();
+}
+
+void ZoneGateway::attach(const std::shared_ptr<TelnetConnection>& connection, const std::string& name,
+                         CharacterClass character_class) {
+    uint64_t session = connection->get_id();
+    int zone = map_.zone_of(STARTING_ROOM_ID);
+    sessions_[session] = Session{connection, zone};
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+
+    ZoneLink* link = zone_link(zone);
+    if (!link) {
+        drop_session(session, "The world is unavailable right now. Please try again later.");
+        return;
+    }
+
+    CopyoverConnection record;
+    record.player_name = name;
+    record.character_class = character_class;
+    record.room_id = STARTING_ROOM_ID;
+    FrameWriter writer(link->output(), ZoneMessage::ATTACH, session);
+    writer.u8(ZONE_ATTACH_NEW);
+    write_player_record(writer, record);
+    writer.finish();
+}
+
+void ZoneGateway::forward(uint64_t session, std::string_view line) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        return;
+    }
+    ZoneLink* link = zone_link(it->second.zone);
+    if (!link) {
+        drop_session(session, "The world around you dissolves. Please reconnect in a moment.");
+        return;
+    }
+
+    FrameWriter writer(link->output(), ZoneMessage::COMMAND, session);
+    writer.str(line);
+    writer.finish();
+}
+
+void ZoneGateway::detach(uint64_t session) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        return;
+    }
+    if (ZoneLink* link = zone_link(it->second.zone)) {
+        FrameWriter(link->output(), ZoneMessage::DETACH, session).finish();
+    }
+    sessions_.erase(it);
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+}
+
+void ZoneGateway::poll() {
+    TRACE_SCOPE("gateway.poll");
+    for (size_t zone = 0; zone < zones_.size(); ++zone) {
+        ZoneLink& link = *zones_[zone];
+        if (!link.is_open()) {
+            continue;
+        }
+        if (!link.read()) {
+            zone_lost(static_cast<int>(zone));
+            continue;
+        }
+        ZoneFrame frame;
+        while (link.next_frame(frame)) {
+            handle_frame(frame);
+        }
+        if (!link.is_open()) {
+            zone_lost(static_cast<int>(zone));
+        }
+    }
+
+    // Notices end with a single prompt per client
+    for (TelnetConnection* connection : notice_recipients_) {
+        connection->flush_queued_lines();
+    }
+    notice_recipients_.clear();
+
+    for (size_t zone = 0; zone < zones_.size(); ++zone) {
+        if (zones_[zone]->is_open() && !zones_[zone]->flush()) {
+            zone_lost(static_cast<int>(zone));
+        }
+    }
+}
+
+void ZoneGateway::handle_frame(const ZoneFrame& frame) {
+    FrameReader reader(frame.payload);
+    switch (frame.type) {
+        case ZoneMessage::OUTPUT:
+            relay_output(frame.session, reader);
+            break;
+        case ZoneMessage::HANDOFF:
+            hand_off(frame.session, reader);
+            break;
+        case ZoneMessage::REROUTE: {
+            std::string_view line;
+            if (reader.str(line)) {
+                forward(frame.session, line);
+            }
+            break;
+        }
+        default:
+            LOG_WARNING("Unexpected message " + std::to_string(static_cast<int>(frame.type)) + " from zone");
+            break;
+    }
+}
+
+void ZoneGateway::relay_output(uint64_t session, FrameReader& reader) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        return;
+    }
+    auto connection = it->second.connection.lock();
+    if (!connection || !connection->is_connected()) {
+        return;
+    }
+
+    uint8_t flags = 0;
+    uint32_t count = 0;
+    reader.u8(flags);
+    reader.u32(count);
+    lines_.clear();
+    for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+        std::string_view line;
+        if (reader.str(line)) {
+            lines_.push_back(line);
+        }
+    }
+    if (!reader.ok()) {
+        LOG_ERROR("Malformed output from zone " + std::to_string(it->second.zone));
+        return;
+    }
+
+    if (flags & ZONE_OUTPUT_NOTICE) {
+        // Frames stay in the link buffer until the next read, which is after the flush
+        if (!connection->has_queued_lines()) {
+            notice_recipients_.push_back(connection.get());
+        }
+        for (std::string_view line : lines_) {
+            connection->queue_line(line);
+        }
+        return;
+    }
+
+    if (flags & ZONE_OUTPUT_PROMPT) {
+        lines_.push_back("> ");
+    }
+    connection->send_lines(lines_.data(), lines_.size());
+    if (flags & ZONE_OUTPUT_DISCONNECT) {
+        // The zone already dropped the player
+        connection->close();
+        sessions_.erase(it);
+        sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+    }
+}
+
+void ZoneGateway::hand_off(uint64_t session, FrameReader& reader) {
+    CopyoverConnection record;
+    if (!read_player_record(reader, record)) {
+        LOG_ERROR("Malformed handoff for session " + std::to_string(session));
+        return;
+    }
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        // The client left while the handoff was in flight
+        return;
+    }
+
+    int zone = map_.zone_of(record.room_id);
+    ZoneLink* link = zone_link(zone);
+    if (!link) {
+        drop_session(session, "The way ahead has collapsed. Please reconnect in a moment.");
+        return;
+    }
+
+    it->second.zone = zone;
+    FrameWriter writer(link->output(), ZoneMessage::ATTACH, session);
+    writer.u8(ZONE_ATTACH_ARRIVAL);
+    write_player_record(writer, record);
+    writer.finish();
+    handoffs_.add();
+}
+
+void ZoneGateway::drop_session(uint64_t session, std::string_view reason) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        return;
+    }
+    if (auto connection = it->second.connection.lock()) {
+        connection->send_message(reason);
+        connection->close();
+    }
+    sessions_.erase(it);
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+}
+
+void ZoneGateway::zone_lost(int zone) {
+    LOG_ERROR("Lost connection to zone " + std::to_string(zone));
+    zones_[zone]->close();
+
+    std::vector<uint64_t> stranded;
+    for (const auto& entry : sessions_) {
+        if (entry.second.zone == zone) {
+            stranded.push_back(entry.first);
+        }
+    }
+    for (uint64_t session : stranded) {
+        drop_session(session, "The world around you dissolves. Please reconnect in a moment.");
+    }
+}
+
+} // namespace dungeon_merc
@@ -0,0 +1,78 @@
+#include "zone_map.hpp"
+#include "tokenizer.hpp"
+
+namespace dungeon_merc {
+
+namespace {
+
+// Split on 'separator' without allocating
+template<typename Fn>
+void for_each_part(std::string_view text, char separator, Fn&& fn) {
+    while (true) {
+        size_t end = text.find(separator);
+        fn(text.substr(0, end));
+        if (end == std::string_view::npos) {
+            return;
+        }
+        text.remove_prefix(end + 1);
+    }
+}
+
+} // namespace
+
+bool ZoneMap::parse(std::string_view spec, std::string& error) {
+    std::vector<Range> ranges;
+    int zone = 0;
+    bool ok = true;
+
+    for_each_part(spec, ',', [&](std::string_view zone_spec) {
+        for_each_part(zone_spec, '+', [&](std::string_view range) {
+            if (!ok) {
+                return;
+            }
+            range = trim_view(range);
+            size_t dash = range.find('-');
+            Range parsed{0, 0, zone};
+            bool valid;
+            if (dash == std::string_view::npos) {
+                valid = parse_int(range, parsed.first);
+                parsed.last = parsed.first;
+            } else {
+                valid = parse_int(range.substr(0, dash), parsed.first) &&
+                        parse_int(range.substr(dash + 1), parsed.last);
+            }
+            if (!valid || parsed.first > parsed.last) {
+                error = "bad room range '" + std::string(range) + "' for zone " + std::to_string(zone);
+                ok = false;
+                return;
+            }
+            for (const Range& other : ranges) {
+                if (parsed.first <= other.last && other.first <= parsed.last) {
+                    error = "room range '" + std::string(range) + "' overlaps zone " + std::to_string(other.zone);
+                    ok = false;
+                    return;
+                }
+            }
+            ranges.push_back(parsed);
+        });
+        ++zone;
+    });
+
+    if (!ok) {
+        return false;
+    }
+    ranges_ = std::move(ranges);
+    zone_count_ = static_cast<size_t>(zone);
+    return true;
+}
+
+int ZoneMap::zone_of(int room_id) const {
+    for (const Range& range : ranges_) {
+        if (room_id >= range.first && room_id <= range.last) {
+            return range.zone;
+        }
+    }
+    return 0;
+}
+
+} // namespace dungeon_merc
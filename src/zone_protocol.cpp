@@ -0,0 +1,341 @@
+#include "zone_protocol.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <cstring>
+
+namespace dungeon_merc {
+
+namespace {
+
+void put_u32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+uint32_t get_u32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (i * 8);
+    }
+    return value;
+}
+
+uint64_t get_u64(const char* in) {
+    return static_cast<uint64_t>(get_u32(in)) | (static_cast<uint64_t>(get_u32(in + 4)) << 32);
+}
+
+bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool make_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        LOG_ERROR("Unix socket path too long: " + path);
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+FrameWriter::FrameWriter(std::string& buffer, ZoneMessage type, uint64_t session)
+    : buffer_(buffer), start_(buffer.size()) {
+    buffer_.append(4, '\0');
+    u8(static_cast<uint8_t>(type));
+    u64(session);
+}
+
+FrameWriter& FrameWriter::u8(uint8_t value) {
+    buffer_.push_back(static_cast<char>(value));
+    return *this;
+}
+
+FrameWriter& FrameWriter::u32(uint32_t value) {
+    char bytes[4];
+    put_u32(bytes, value);
+    buffer_.append(bytes, 4);
+    return *this;
+}
+
+FrameWriter& FrameWriter::u64(uint64_t value) {
+    u32(static_cast<uint32_t>(value));
+    return u32(static_cast<uint32_t>(value >> 32));
+}
+
+FrameWriter& FrameWriter::str(std::string_view value) {
+    u32(static_cast<uint32_t>(value.size()));
+    buffer_.append(value.data(), value.size());
+    return *this;
+}
+
+void FrameWriter::finish() {
+    put_u32(&buffer_[start_], static_cast<uint32_t>(buffer_.size() - start_ - 4));
+}
+
+bool FrameReader::take(size_t size, std::string_view& bytes) {
+    if (!ok_ || data_.size() < size) {
+        ok_ = false;
+        return false;
+    }
+    bytes = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return true;
+}
+
+bool FrameReader::u8(uint8_t& value) {
+    std::string_view bytes;
+    if (!take(1, bytes)) {
+        return false;
+    }
+    value = static_cast<uint8_t>(bytes[0]);
+    return true;
+}
+
+bool FrameReader::u32(uint32_t& value) {
+    std::string_view bytes;
+    if (!take(4, bytes)) {
+        return false;
+    }
+    value = get_u32(bytes.data());
+    return true;
+}
+
+bool FrameReader::i32(int32_t& value) {
+    uint32_t raw;
+    if (!u32(raw)) {
+        return false;
+    }
+    value = static_cast<int32_t>(raw);
+    return true;
+}
+
+bool FrameReader::u64(uint64_t& value) {
+    std::string_view bytes;
+    if (!take(8, bytes)) {
+        return false;
+    }
+    value = get_u64(bytes.data());
+    return true;
+}
+
+bool FrameReader::str(std::string_view& value) {
+    uint32_t size;
+    return u32(size) && take(size, value);
+}
+
+void write_player_record(FrameWriter& writer, const CopyoverConnection& record) {
+    writer.str(record.player_name)
+          .u8(static_cast<uint8_t>(record.character_class))
+          .i32(record.health)
+          .i32(record.max_health)
+          .i32(record.level)
+          .i32(record.experience)
+          .i32(record.room_id)
+          .u8(record.gmcp ? 1 : 0)
+          .u8(record.gmcp_modules)
+          .u32(static_cast<uint32_t>(record.channels.size()));
+    for (const auto& channel : record.channels) {
+        writer.str(channel);
+    }
+    writer.u32(static_cast<uint32_t>(record.items.size()));
+    for (const auto& stack : record.items) {
+        writer.u32(stack.item).u32(stack.count).u32(stack.mods);
+    }
+}
+
+bool read_player_record(FrameReader& reader, CopyoverConnection& record) {
+    std::string_view name;
+    uint8_t character_class = 0;
+    uint8_t gmcp = 0;
+    uint32_t channel_count = 0;
+    reader.str(name);
+    reader.u8(character_class);
+    reader.i32(record.health);
+    reader.i32(record.max_health);
+    reader.i32(record.level);
+    reader.i32(record.experience);
+    reader.i32(record.room_id);
+    reader.u8(gmcp);
+    reader.u8(record.gmcp_modules);
+    reader.u32(channel_count);
+    if (!reader.ok() || character_class > static_cast<uint8_t>(CharacterClass::GHOST)) {
+        return false;
+    }
+
+    record.player_name = std::string(name);
+    record.character_class = static_cast<CharacterClass>(character_class);
+    record.gmcp = gmcp != 0;
+    record.channels.clear();
+    for (uint32_t i = 0; i < channel_count; ++i) {
+        std::string_view channel;
+        if (!reader.str(channel)) {
+            return false;
+        }
+        record.channels.emplace_back(channel);
+    }
+
+    uint32_t item_count = 0;
+    if (!reader.u32(item_count) || item_count > INVENTORY_SLOTS) {
+        return false;
+    }
+    record.items.resize(item_count);
+    for (auto& stack : record.items) {
+        uint32_t item = 0;
+        uint32_t count = 0;
+        reader.u32(item);
+        reader.u32(count);
+        reader.u32(stack.mods);
+        stack.item = static_cast<ItemId>(item);
+        stack.count = static_cast<uint16_t>(count);
+    }
+    return reader.ok();
+}
+
+ZoneLink::ZoneLink(int fd)
+    : fd_(fd)
+    , input_consumed_(0)
+    , output_sent_(0) {
+    if (fd_ >= 0 && !set_nonblocking(fd_)) {
+        LOG_ERROR("Failed to make zone link non-blocking");
+        close();
+    }
+}
+
+ZoneLink::~ZoneLink() {
+    close();
+}
+
+void ZoneLink::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ZoneLink::flush() {
+    while (is_open() && has_output()) {
+        ssize_t written = ::send(fd_, output_.data() + output_sent_, output_.size() - output_sent_, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                // The peer is behind; keep the rest unless it has fallen hopelessly so
+                if (output_.size() - output_sent_ > ZONE_MAX_BACKLOG) {
+                    LOG_ERROR("Zone link backlog exceeded, closing");
+                    close();
+                    return false;
+                }
+                break;
+            }
+            close();
+            return false;
+        }
+        output_sent_ += static_cast<size_t>(written);
+    }
+
+    if (output_sent_ == output_.size()) {
+        output_.clear();
+        output_sent_ = 0;
+    }
+    return is_open();
+}
+
+bool ZoneLink::read() {
+    if (!is_open()) {
+        return false;
+    }
+
+    // Frames handed out by the last round are done with
+    if (input_consumed_ > 0) {
+        input_.erase(0, input_consumed_);
+        input_consumed_ = 0;
+    }
+
+    char buffer[65536];
+    while (true) {
+        ssize_t bytes_read = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes_read > 0) {
+            input_.append(buffer, static_cast<size_t>(bytes_read));
+            continue;
+        }
+        if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+}
+
+bool ZoneLink::next_frame(ZoneFrame& frame) {
+    size_t available = input_.size() - input_consumed_;
+    if (available < 4) {
+        return false;
+    }
+
+    const char* start = input_.data() + input_consumed_;
+    uint32_t length = get_u32(start);
+    if (length < ZONE_FRAME_HEADER - 4 || length > ZONE_MAX_FRAME) {
+        LOG_ERROR("Corrupt frame on zone link, closing");
+        close();
+        return false;
+    }
+    if (available < 4 + static_cast<size_t>(length)) {
+        return false;
+    }
+
+    frame.type = static_cast<ZoneMessage>(static_cast<uint8_t>(start[4]));
+    frame.session = get_u64(start + 5);
+    frame.payload = std::string_view(start + ZONE_FRAME_HEADER, length - (ZONE_FRAME_HEADER - 4));
+    input_consumed_ += 4 + length;
+    return true;
+}
+
+int listen_unix_socket(const std::string& path) {
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create Unix socket: " + std::string(strerror(errno)));
+        return -1;
+    }
+
+    // A socket file left by an earlier run would make bind() fail
+    ::unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 16) < 0 ||
+        !set_nonblocking(fd)) {
+        LOG_ERROR("Failed to listen on " + path + ": " + std::string(strerror(errno)));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connect_unix_socket(const std::string& path) {
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create Unix socket: " + std::string(strerror(errno)));
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        LOG_ERROR("Failed to connect to " + path + ": " + std::string(strerror(errno)));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace dungeon_merc
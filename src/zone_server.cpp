@@ -0,0 +1,291 @@
+#include "zone_server.hpp"
+#include "player.hpp"
+#include "trace.hpp"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace dungeon_merc {
+
+ZoneServer::ZoneServer(std::shared_ptr<GameWorld> game_world, int zone)
+    : game_world_(game_world)
+    , dispatcher_(game_world)
+    , zone_(zone)
+    , listen_fd_(-1)
+    , handoffs_out_(MetricsRegistry::get_instance().counter("zone.handoffs_out"))
+    , handoffs_in_(MetricsRegistry::get_instance().counter("zone.handoffs_in"))
+    , sessions_gauge_(MetricsRegistry::get_instance().gauge("zone.sessions")) {
+}
+
+ZoneServer::~ZoneServer() {
+    shutdown();
+}
+
+bool ZoneServer::listen(const std::string& path) {
+    listen_fd_ = listen_unix_socket(path);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    socket_path_ = path;
+    LOG_INFO("Zone " + std::to_string(zone_) + " listening on " + path);
+    return true;
+}
+
+void ZoneServer::shutdown() {
+    for (auto& link : links_) {
+        drop_link(*link);
+        link->close();
+    }
+    links_.clear();
+
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        ::unlink(socket_path_.c_str());
+    }
+}
+
+void ZoneServer::add_link(int fd) {
+    links_.push_back(std::make_unique<ZoneLink>(fd));
+}
+
+void ZoneServer::accept_links() {
+    if (listen_fd_ < 0) {
+        return;
+    }
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        LOG_INFO("Gateway connected to zone " + std::to_string(zone_));
+        add_link(fd);
+    }
+}
+
+void ZoneServer::poll(std::chrono::milliseconds timeout) {
+    poll_fds_.clear();
+    if (listen_fd_ >= 0) {
+        poll_fds_.push_back(pollfd{listen_fd_, POLLIN, 0});
+    }
+    for (auto& link : links_) {
+        poll_fds_.push_back(pollfd{link->get_fd(), POLLIN, 0});
+    }
+    ::poll(poll_fds_.data(), poll_fds_.size(), static_cast<int>(timeout.count()));
+
+    TRACE_SCOPE("zone.poll");
+    accept_links();
+
+    for (auto& link : links_) {
+        if (!link->read()) {
+            drop_link(*link);
+            continue;
+        }
+        ZoneFrame frame;
+        while (link->next_frame(frame)) {
+            handle_frame(*link, frame);
+        }
+        if (!link->is_open()) {
+            drop_link(*link);
+        }
+    }
+
+    for (auto& link : links_) {
+        link->flush();
+    }
+    links_.erase(std::remove_if(links_.begin(), links_.end(),
+                                [](const std::unique_ptr<ZoneLink>& link) { return !link->is_open(); }),
+                 links_.end());
+}
+
+void ZoneServer::flush_notices() {
+    game_world_->get_chat().flush([this](PlayerId player, std::string_view line) {
+        uint64_t session;
+        if (Session* target = find_player_session(player, session)) {
+            send_output(*target->link, session, ZONE_OUTPUT_NOTICE, &line, 1);
+        }
+    });
+
+    // Timers never move anyone today, but a script could
+    game_world_->take_departures(departures_);
+    hand_off_departures();
+
+    for (auto& link : links_) {
+        link->flush();
+    }
+}
+
+void ZoneServer::handle_frame(ZoneLink& link, const ZoneFrame& frame) {
+    FrameReader reader(frame.payload);
+    switch (frame.type) {
+        case ZoneMessage::ATTACH:
+            attach(link, frame.session, reader);
+            break;
+        case ZoneMessage::COMMAND: {
+            std::string_view line;
+            if (reader.str(line)) {
+                execute(link, frame.session, line);
+            }
+            break;
+        }
+        case ZoneMessage::DETACH:
+            detach(frame.session);
+            break;
+        default:
+            LOG_WARNING("Unexpected message " + std::to_string(static_cast<int>(frame.type)) + " from gateway");
+            break;
+    }
+}
+
+void ZoneServer::attach(ZoneLink& link, uint64_t session, FrameReader& reader) {
+    uint8_t flags = 0;
+    CopyoverConnection record;
+    if (!reader.u8(flags) || !read_player_record(reader, record)) {
+        LOG_ERROR("Malformed attach from gateway");
+        return;
+    }
+    if (!game_world_->is_local_room(record.room_id)) {
+        LOG_WARNING(record.player_name + " attached to zone " + std::to_string(zone_) +
+                    " in a room it does not own: " + std::to_string(record.room_id));
+    }
+    if (sessions_.count(session)) {
+        detach(session);
+    }
+
+    PlayerId id = game_world_->create_player(record.player_name, record.character_class, record.room_id);
+    if (!(flags & ZONE_ATTACH_NEW)) {
+        Player* player = game_world_->get_player(id);
+        player->restore_progress(record.level, record.experience, record.health, record.max_health);
+        game_world_->restore_inventory(id, record.items);
+        game_world_->get_chat().set_channels(id, record.channels);
+    }
+
+    sessions_[session] = Session{&link, id};
+    if (id.index >= player_sessions_.size()) {
+        player_sessions_.resize(id.index + 1, 0);
+    }
+    player_sessions_[id.index] = session;
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+
+    if (flags & ZONE_ATTACH_ARRIVAL) {
+        handoffs_in_.add();
+        ArenaString out;
+        game_world_->handle_arrival(id, out);
+        // The blank line the old zone would have put after "You move ..."
+        std::string_view lines[] = {"", out.view()};
+        send_output(link, session, ZONE_OUTPUT_PROMPT, lines, 2);
+    }
+}
+
+void ZoneServer::execute(ZoneLink& link, uint64_t session, std::string_view line) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        // Typed before the gateway saw our handoff; by the time this comes
+        // back it knows where the player went
+        FrameWriter writer(link.output(), ZoneMessage::REROUTE, session);
+        writer.str(line);
+        writer.finish();
+        return;
+    }
+
+    PlayerId player = it->second.player;
+    CommandContext ctx;
+    ctx.player = player;
+    dispatcher_.dispatch(ctx, line);
+
+    // Whoever left for another zone gets no prompt here; the next zone sends it
+    game_world_->take_departures(departures_);
+    bool departed = std::find(departures_.begin(), departures_.end(), player) != departures_.end();
+    uint8_t flags = ctx.disconnect ? ZONE_OUTPUT_DISCONNECT : departed ? 0 : ZONE_OUTPUT_PROMPT;
+    send_output(link, session, flags, ctx.output.data(), ctx.output.size());
+
+    if (ctx.disconnect) {
+        detach(session);
+    }
+    hand_off_departures();
+}
+
+void ZoneServer::send_output(ZoneLink& link, uint64_t session, uint8_t flags,
+                             const std::string_view* lines, size_t count) {
+    FrameWriter writer(link.output(), ZoneMessage::OUTPUT, session);
+    writer.u8(flags).u32(static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        writer.str(lines[i]);
+    }
+    writer.finish();
+}
+
+ZoneServer::Session* ZoneServer::find_player_session(PlayerId player, uint64_t& session) {
+    if (player.index >= player_sessions_.size()) {
+        return nullptr;
+    }
+    auto it = sessions_.find(player_sessions_[player.index]);
+    // The slot may belong to an older player that has since left
+    if (it == sessions_.end() || it->second.player != player) {
+        return nullptr;
+    }
+    session = it->first;
+    return &it->second;
+}
+
+void ZoneServer::hand_off_departures() {
+    for (PlayerId id : departures_) {
+        uint64_t session;
+        Session* target = find_player_session(id, session);
+        const Player* player = game_world_->get_player(id);
+        if (!target || !player) {
+            continue;
+        }
+
+        CopyoverConnection record;
+        record.connection_id = session;
+        record.player_name = player->get_name();
+        record.character_class = player->get_character_class();
+        record.health = player->get_health();
+        record.max_health = player->get_max_health();
+        record.level = player->get_level();
+        record.experience = player->get_experience();
+        record.room_id = player->get_current_room_id();
+        record.channels = game_world_->get_chat().get_channels(id);
+        game_world_->copy_inventory(id, record.items);
+
+        FrameWriter writer(target->link->output(), ZoneMessage::HANDOFF, session);
+        write_player_record(writer, record);
+        writer.finish();
+        handoffs_out_.add();
+
+        detach(session);
+    }
+    departures_.clear();
+}
+
+void ZoneServer::detach(uint64_t session) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) {
+        return;
+    }
+    game_world_->remove_player(it->second.player);
+    sessions_.erase(it);
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+}
+
+void ZoneServer::drop_link(ZoneLink& link) {
+    // Without its gateway nobody can see these players any more
+    size_t dropped = 0;
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->second.link == &link) {
+            game_world_->remove_player(it->second.player);
+            it = sessions_.erase(it);
+            ++dropped;
+        } else {
+            ++it;
+        }
+    }
+    if (dropped > 0) {
+        LOG_WARNING("Gateway link lost; removed " + std::to_string(dropped) + " players from zone " +
+                    std::to_string(zone_));
+    }
+    sessions_gauge_.set(static_cast<int64_t>(sessions_.size()));
+}
+
+} // namespace dungeon_merc
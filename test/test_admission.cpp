@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include "admission.hpp"
+#include "telnet_server.hpp"
+#include <sys/socket.h>
+
+using namespace dungeon_merc;
+
+TEST(AdmissionTest, PlayerLimit) {
+    AdmissionLimits limits;
+    limits.max_players = 2;
+    AdmissionController admission(limits);
+
+    EXPECT_TRUE(admission.has_capacity(0));
+    EXPECT_TRUE(admission.has_capacity(1));
+    EXPECT_FALSE(admission.has_capacity(2));
+    EXPECT_STREQ(admission.saturation_reason(2), "player limit");
+}
+
+TEST(AdmissionTest, SlowTicksCloseTheDoorUntilTheyRecover) {
+    AdmissionLimits limits;
+    limits.max_tick_time = std::chrono::milliseconds(20);
+    AdmissionController admission(limits);
+
+    // One slow tick is smoothed away
+    admission.record_tick(std::chrono::milliseconds(100), 0);
+    EXPECT_TRUE(admission.has_capacity(0));
+
+    for (int i = 0; i < 100; ++i) {
+        admission.record_tick(std::chrono::milliseconds(100), 0);
+    }
+    EXPECT_FALSE(admission.has_capacity(0));
+    EXPECT_STREQ(admission.saturation_reason(0), "tick time");
+
+    for (int i = 0; i < 100; ++i) {
+        admission.record_tick(std::chrono::milliseconds(1), 0);
+    }
+    EXPECT_TRUE(admission.has_capacity(0));
+}
+
+TEST(AdmissionTest, OutputMemory) {
+    AdmissionLimits limits;
+    limits.max_output_bytes = 1024;
+    AdmissionController admission(limits);
+
+    admission.record_tick(std::chrono::microseconds(10), 4096);
+    EXPECT_STREQ(admission.saturation_reason(0), "output memory");
+    admission.record_tick(std::chrono::microseconds(10), 512);
+    EXPECT_EQ(admission.saturation_reason(0), nullptr);
+}
+
+namespace {
+
+// Everything the client end of a socketpair has been sent so far
+std::string drain(int fd) {
+    std::string text;
+    char buffer[1024];
+    ssize_t bytes;
+    while ((bytes = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    return text;
+}
+
+} // namespace
+
+TEST(AdmissionTest, LoginQueueAdmitsInOrder) {
+    TelnetServer server(0);
+    ASSERT_TRUE(server.initialize());
+
+    AdmissionLimits limits;
+    limits.max_output_bytes = 1024;
+    limits.admits_per_tick = 2;
+    limits.max_queue = 4;
+    limits.notice_interval = std::chrono::seconds(0);
+    server.set_admission_limits(limits);
+    std::vector<std::string> admitted;
+    server.set_connection_callback([&](std::shared_ptr<TelnetConnection> connection) {
+        admitted.push_back(connection->get_client_ip());
+    });
+
+    // Saturated: everyone queues, and the client past max_queue is turned away
+    server.record_tick(std::chrono::microseconds(10), 4096);
+    int clients[5];
+    for (int i = 0; i < 5; ++i) {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        clients[i] = fds[1];
+        ASSERT_TRUE(server.adopt_connection(fds[0], "client" + std::to_string(i)));
+    }
+    EXPECT_EQ(server.get_login_queue_length(), 4u);
+    EXPECT_TRUE(admitted.empty());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NE(drain(clients[i]).find("You are number " + std::to_string(i + 1) + " in line."),
+                  std::string::npos);
+    }
+    EXPECT_NE(drain(clients[4]).find("Please try again later."), std::string::npos);
+    char byte;
+    EXPECT_EQ(recv(clients[4], &byte, 1, MSG_DONTWAIT), 0);
+
+    // A client that hangs up leaves the queue, and the rest move up
+    ::close(clients[1]);
+    clients[1] = -1;
+    server.accept_connections();
+    EXPECT_EQ(server.get_login_queue_length(), 3u);
+    EXPECT_NE(drain(clients[0]).find("You are number 1 in line."), std::string::npos);
+    EXPECT_NE(drain(clients[2]).find("You are number 2 in line."), std::string::npos);
+    EXPECT_NE(drain(clients[3]).find("You are number 3 in line."), std::string::npos);
+
+    // Once there is room, admits_per_tick clients go in per tick, first come first served
+    server.record_tick(std::chrono::microseconds(10), 0);
+    server.accept_connections();
+    EXPECT_EQ(admitted, (std::vector<std::string>{"client0", "client2"}));
+    EXPECT_NE(drain(clients[0]).find("A spot opened up."), std::string::npos);
+    EXPECT_NE(drain(clients[3]).find("You are number 1 in line."), std::string::npos);
+
+    server.accept_connections();
+    EXPECT_EQ(admitted, (std::vector<std::string>{"client0", "client2", "client3"}));
+    EXPECT_EQ(server.get_login_queue_length(), 0u);
+
+    server.shutdown();
+    for (int fd : clients) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+TEST(AdmissionTest, OutputQueuedToSlowClientsClosesTheDoor) {
+    TelnetServer server(0);
+    ASSERT_TRUE(server.initialize());
+
+    AdmissionLimits limits;
+    limits.max_output_bytes = 16 * 1024;
+    limits.notice_interval = std::chrono::seconds(0);
+    server.set_admission_limits(limits);
+    std::vector<std::shared_ptr<TelnetConnection>> admitted;
+    server.set_connection_callback([&](std::shared_ptr<TelnetConnection> connection) {
+        admitted.push_back(connection);
+    });
+
+    // A client that doesn't read leaves output queued on the server
+    int slow[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, slow), 0);
+    int small = 4096;
+    setsockopt(slow[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    ASSERT_TRUE(server.adopt_connection(slow[0], "slow"));
+    ASSERT_EQ(admitted.size(), 1u);
+    drain(slow[1]);
+    ASSERT_TRUE(admitted[0]->send_raw(std::string(64 * 1024, 'x')));
+    EXPECT_GT(server.get_queued_output_bytes(), limits.max_output_bytes);
+
+    server.record_tick(std::chrono::microseconds(10), server.get_queued_output_bytes());
+    int next[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, next), 0);
+    ASSERT_TRUE(server.adopt_connection(next[0], "next"));
+    EXPECT_EQ(server.get_login_queue_length(), 1u);
+
+    // Once the slow client catches up the queue moves again
+    for (int i = 0; i < 1000 && server.get_queued_output_bytes() > 0; ++i) {
+        drain(slow[1]);
+        server.flush_output();
+    }
+    EXPECT_EQ(server.get_queued_output_bytes(), 0u);
+    server.record_tick(std::chrono::microseconds(10), server.get_queued_output_bytes());
+    server.accept_connections();
+    EXPECT_EQ(server.get_login_queue_length(), 0u);
+    EXPECT_EQ(admitted.size(), 2u);
+
+    server.shutdown();
+    ::close(slow[1]);
+    ::close(next[1]);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "arena.hpp"
+#include "command_dispatcher.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace dungeon_merc;
+
+// Count heap allocations made while a test has counting switched on.
+// GCC cannot see that this new and delete pair up and warns at inlined sites.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static std::atomic<bool> g_count_allocations(false);
+static std::atomic<size_t> g_allocation_count(0);
+
+void* operator new(size_t size) {
+    if (g_count_allocations.load(std::memory_order_relaxed)) {
+        g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+TEST(ArenaTest, StringBuilderGrowsAndFormats) {
+    Arena arena(128);
+    ArenaString out(arena);
+    out << "Exits: " << 42 << ' ' << -7 << ' ' << static_cast<size_t>(9);
+    EXPECT_EQ(out.view(), "Exits: 42 -7 9");
+
+    std::string long_text(1000, 'x');
+    out << long_text;
+    EXPECT_EQ(out.size(), 14u + 1000u);
+    EXPECT_EQ(out.view().substr(14), long_text);
+}
+
+TEST(ArenaTest, ResetMergesChunksAndRewindRestores) {
+    Arena arena(256);
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(200);
+    }
+    EXPECT_GT(arena.bytes_reserved(), 256u);
+    size_t reserved = arena.bytes_reserved();
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0u);
+    EXPECT_EQ(arena.bytes_reserved(), reserved);
+    EXPECT_GE(arena.high_water(), 2000u);
+
+    // The merged chunk now holds a whole tick without spilling
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(200);
+    }
+    EXPECT_EQ(arena.bytes_reserved(), reserved);
+
+    Arena::Checkpoint checkpoint = arena.checkpoint();
+    size_t used = arena.bytes_used();
+    arena.store("scratch");
+    arena.rewind(checkpoint);
+    EXPECT_EQ(arena.bytes_used(), used);
+}
+
+TEST(ArenaTest, OverAlignedAllocations) {
+    Arena arena(256);
+    auto aligned = [](void* ptr, size_t align) {
+        return reinterpret_cast<uintptr_t>(ptr) % align == 0;
+    };
+
+    arena.allocate(3, 1);
+    EXPECT_TRUE(aligned(arena.allocate(8, 64), 64));
+    // Spills into a new chunk, which is only 16-byte aligned by new[]
+    EXPECT_TRUE(aligned(arena.allocate(300, 128), 128));
+    EXPECT_TRUE(aligned(arena.allocate(16, 64), 64));
+}
+
+TEST(ArenaTest, SteadyStateCommandsDoNotAllocate) {
+    auto world = std::make_shared<GameWorld>();
+    CommandDispatcher dispatcher(world);
+    PlayerId player = world->create_player("Frugal", CharacterClass::SCOUT);
+
+    const char* commands[] = {"look", "north", "players", "south", "e", "w", "xyzzy", "help"};
+    auto run_tick = [&]() {
+        for (const char* line : commands) {
+            CommandContext ctx;
+            ctx.player = player;
+            dispatcher.dispatch(ctx, line);
+        }
+        tick_arena().reset();
+    };
+
+    // Warm up so the arena and room vectors reach their working size
+    run_tick();
+    run_tick();
+
+    g_allocation_count.store(0);
+    g_count_allocations.store(true);
+    for (int i = 0; i < 100; ++i) {
+        run_tick();
+    }
+    g_count_allocations.store(false);
+
+    EXPECT_EQ(g_allocation_count.load(), 0u);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "chat.hpp"
+#include "command_dispatcher.hpp"
+#include "game_world.hpp"
+#include <map>
+
+using namespace dungeon_merc;
+
+namespace {
+
+// Collects delivered lines per player
+struct Inbox {
+    std::map<PlayerId, std::vector<std::string>, bool (*)(PlayerId, PlayerId)> lines{
+        [](PlayerId a, PlayerId b) { return a.index < b.index; }};
+
+    ChatDelivery collector() {
+        return [this](PlayerId player, std::string_view line) { lines[player].emplace_back(line); };
+    }
+
+    size_t count(PlayerId player) const {
+        auto it = lines.find(player);
+        return it == lines.end() ? 0 : it->second.size();
+    }
+};
+
+} // namespace
+
+TEST(ChatTest, ChannelFanOutSkipsSender) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    PlayerId bob = world.create_player("Bob", CharacterClass::TECH);
+    PlayerId carol = world.create_player("Carol", CharacterClass::GHOST);
+
+    ChatHub& chat = world.get_chat();
+    ASSERT_TRUE(chat.join(alice, "Traders"));
+    ASSERT_TRUE(chat.join(bob, "traders"));
+    EXPECT_FALSE(chat.join(bob, "TRADERS"));
+    EXPECT_FALSE(chat.post(carol, "Carol", "traders", "let me in"));
+
+    EXPECT_TRUE(chat.post(alice, "Alice", "traders", "selling scrap"));
+    Inbox inbox;
+    chat.flush(inbox.collector());
+
+    EXPECT_EQ(inbox.count(alice), 0u);
+    EXPECT_EQ(inbox.count(carol), 0u);
+    ASSERT_EQ(inbox.count(bob), 1u);
+    EXPECT_EQ(inbox.lines[bob][0], "[traders] Alice: selling scrap");
+
+    // A second flush has nothing new to deliver
+    Inbox again;
+    chat.flush(again.collector());
+    EXPECT_TRUE(again.lines.empty());
+    tick_arena().reset();
+}
+
+TEST(ChatTest, ScrollbackKeepsMostRecentMessages) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    ChatHub& chat = world.get_chat();
+
+    for (size_t i = 0; i < CHAT_SCROLLBACK + 5; ++i) {
+        ASSERT_TRUE(chat.post(alice, "Alice", GLOBAL_CHANNEL, "msg " + std::to_string(i)));
+    }
+
+    ArenaLines lines{ArenaAllocator<std::string_view>(tick_arena())};
+    chat.get_scrollback(GLOBAL_CHANNEL, lines);
+    ASSERT_EQ(lines.size(), CHAT_SCROLLBACK);
+    EXPECT_EQ(lines.front(), "[global] Alice: msg 5");
+    EXPECT_EQ(lines.back(), "[global] Alice: msg " + std::to_string(CHAT_SCROLLBACK + 4));
+    tick_arena().reset();
+}
+
+TEST(ChatTest, BurstLongerThanScrollbackReachesEveryone) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    PlayerId bob = world.create_player("Bob", CharacterClass::TECH);
+    ChatHub& chat = world.get_chat();
+
+    const size_t burst = CHAT_SCROLLBACK * 3;
+    for (size_t i = 0; i < burst; ++i) {
+        ASSERT_TRUE(chat.post(alice, "Alice", GLOBAL_CHANNEL, "msg " + std::to_string(i)));
+    }
+
+    Inbox inbox;
+    chat.flush(inbox.collector());
+    ASSERT_EQ(inbox.count(bob), burst);
+    for (size_t i = 0; i < burst; ++i) {
+        EXPECT_EQ(inbox.lines[bob][i], "[global] Alice: msg " + std::to_string(i));
+    }
+    tick_arena().reset();
+}
+
+TEST(ChatTest, LeaveAndLogoutStopDelivery) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    PlayerId bob = world.create_player("Bob", CharacterClass::TECH);
+    PlayerId carol = world.create_player("Carol", CharacterClass::GHOST);
+    ChatHub& chat = world.get_chat();
+
+    EXPECT_TRUE(chat.leave(bob, GLOBAL_CHANNEL));
+    EXPECT_FALSE(chat.leave(bob, GLOBAL_CHANNEL));
+    world.remove_player(carol);
+    EXPECT_TRUE(chat.get_channels(carol).empty());
+
+    chat.post(alice, "Alice", GLOBAL_CHANNEL, "anyone?");
+    Inbox inbox;
+    chat.flush(inbox.collector());
+    EXPECT_TRUE(inbox.lines.empty());
+    tick_arena().reset();
+}
+
+TEST(ChatTest, ChannelsAreCappedAndDroppedWhenEmpty) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    PlayerId bob = world.create_player("Bob", CharacterClass::TECH);
+    ChatHub& chat = world.get_chat();
+    Inbox inbox;
+
+    // Global counts against the per-player cap like any other channel
+    size_t before = chat.channel_count();
+    for (size_t i = 1; i < CHAT_MAX_PLAYER_CHANNELS; ++i) {
+        ASSERT_TRUE(chat.join(alice, "x" + std::to_string(i)));
+    }
+    EXPECT_FALSE(chat.join(alice, "onemore"));
+    EXPECT_EQ(chat.channel_count(), before + CHAT_MAX_PLAYER_CHANNELS - 1);
+
+    // A channel outlives its last member until the flush, so a post queued
+    // just before leaving is still safe to deliver
+    ASSERT_TRUE(chat.join(bob, "x1"));
+    chat.post(alice, "Alice", "x1", "bye");
+    for (size_t i = 1; i < CHAT_MAX_PLAYER_CHANNELS; ++i) {
+        ASSERT_TRUE(chat.leave(alice, "x" + std::to_string(i)));
+    }
+    world.remove_player(bob);
+    EXPECT_EQ(chat.channel_count(), before + CHAT_MAX_PLAYER_CHANNELS - 1);
+    chat.flush(inbox.collector());
+    EXPECT_EQ(chat.channel_count(), before);
+    EXPECT_TRUE(chat.join(alice, "onemore"));
+    tick_arena().reset();
+
+    // The hub as a whole stops opening channels at its own cap
+    std::vector<PlayerId> players;
+    size_t opened = chat.channel_count();
+    for (size_t i = 0; opened < CHAT_MAX_CHANNELS; ++i) {
+        if (i % (CHAT_MAX_PLAYER_CHANNELS - 1) == 0) {
+            players.push_back(world.create_player("P" + std::to_string(i), CharacterClass::SCOUT));
+        }
+        ASSERT_TRUE(chat.join(players.back(), "c" + std::to_string(i)));
+        ++opened;
+    }
+    EXPECT_FALSE(chat.join(alice, "toomany"));
+    EXPECT_TRUE(chat.join(alice, "c0"));  // Existing channels still take members
+}
+
+TEST(ChatTest, RestoredChannelsReplaceDefaults) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT);
+    ChatHub& chat = world.get_chat();
+    ASSERT_TRUE(chat.is_member(alice, GLOBAL_CHANNEL));
+
+    // A player who had left global before a hot reboot stays out of it
+    chat.set_channels(alice, {"traders", "ops"});
+    EXPECT_FALSE(chat.is_member(alice, GLOBAL_CHANNEL));
+    EXPECT_TRUE(chat.is_member(alice, "traders"));
+    EXPECT_TRUE(chat.is_member(alice, "ops"));
+    EXPECT_EQ(chat.get_channels(alice).size(), 2u);
+
+    chat.set_channels(alice, {"ops", GLOBAL_CHANNEL});
+    EXPECT_FALSE(chat.is_member(alice, "traders"));
+    EXPECT_TRUE(chat.is_member(alice, GLOBAL_CHANNEL));
+    EXPECT_EQ(chat.get_channels(alice).size(), 2u);
+}
+
+TEST(ChatTest, SayReachesRoomAndTellReachesOnePlayer) {
+    GameWorld world;
+    PlayerId alice = world.create_player("Alice", CharacterClass::SCOUT, 1);
+    PlayerId bob = world.create_player("Bob", CharacterClass::TECH, 1);
+    PlayerId carol = world.create_player("Carol", CharacterClass::GHOST, 2);
+
+    ChatHub& chat = world.get_chat();
+    chat.post_room(1, alice, "Alice", "hello\x1b[2J");
+    chat.post_direct(carol, "Bob", "psst");
+
+    Inbox inbox;
+    chat.flush(inbox.collector());
+    EXPECT_EQ(inbox.count(alice), 0u);
+    ASSERT_EQ(inbox.count(bob), 1u);
+    EXPECT_EQ(inbox.lines[bob][0], "Alice says: hello[2J");
+    ASSERT_EQ(inbox.count(carol), 1u);
+    EXPECT_EQ(inbox.lines[carol][0], "Bob tells you: psst");
+    tick_arena().reset();
+}
+
+TEST(ChatTest, CommandsQueueMessages) {
+    auto world = std::make_shared<GameWorld>();
+    PlayerId alice = world->create_player("Alice", CharacterClass::SCOUT, 1);
+    PlayerId bob = world->create_player("Bob", CharacterClass::TECH, 2);
+    CommandDispatcher dispatcher(world);
+
+    CommandContext ctx;
+    ctx.player = alice;
+    dispatcher.dispatch(ctx, "tell bob meet at the gate");
+    ASSERT_FALSE(ctx.output.empty());
+    EXPECT_EQ(ctx.output[0], "You tell Bob: meet at the gate");
+
+    CommandContext missing;
+    missing.player = alice;
+    dispatcher.dispatch(missing, "tell nobody hi");
+    EXPECT_EQ(missing.output[0], "No player named nobody is online.");
+
+    Inbox inbox;
+    world->get_chat().flush(inbox.collector());
+    ASSERT_EQ(inbox.count(bob), 1u);
+    EXPECT_EQ(inbox.lines[bob][0], "Alice tells you: meet at the gate");
+    tick_arena().reset();
+}
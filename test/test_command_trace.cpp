@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "command_trace.hpp"
+#include <cstdio>
+
+using namespace dungeon_merc;
+
+TEST(CommandTraceTest, RecordsRoundTrip) {
+    std::string path = "test_command_trace.bin";
+    {
+        CommandRecorder recorder;
+        ASSERT_TRUE(recorder.open(path, 1234));
+        recorder.record_connect(1, "Player_5", CharacterClass::TECH, 4);
+        recorder.record_command(1, "look");
+        recorder.record_command(1, std::string(300, 'x'));
+        recorder.record_disconnect(1);
+    }
+
+    CommandTraceReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.get_seed(), 1234u);
+
+    TraceRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, TraceEventType::CONNECT);
+    EXPECT_EQ(record.connection_id, 1u);
+    EXPECT_EQ(record.text, "Player_5");
+    EXPECT_EQ(record.character_class, CharacterClass::TECH);
+    EXPECT_EQ(record.room_id, 4);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, TraceEventType::COMMAND);
+    EXPECT_EQ(record.text, "look");
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.text.size(), 300u);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, TraceEventType::DISCONNECT);
+
+    EXPECT_FALSE(reader.next(record));
+    std::remove(path.c_str());
+}
+
+TEST(CommandTraceTest, AppendedSegmentCarriesNewSeed) {
+    std::string path = "test_command_trace_segments.bin";
+    {
+        CommandRecorder recorder;
+        ASSERT_TRUE(recorder.open(path, 1));
+        recorder.record_command(3, "north");
+    }
+    {
+        CommandRecorder recorder;
+        ASSERT_TRUE(recorder.open(path, 2, true));
+        recorder.record_command(3, "south");
+    }
+
+    CommandTraceReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.get_seed(), 1u);
+
+    TraceRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.text, "north");
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.type, TraceEventType::SEGMENT);
+    EXPECT_EQ(record.seed, 2u);
+
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.connection_id, 3u);
+    EXPECT_EQ(record.text, "south");
+
+    EXPECT_FALSE(reader.next(record));
+    std::remove(path.c_str());
+}
+
+TEST(CommandTraceTest, RedactsAdminPasswords) {
+    EXPECT_EQ(redact_command("admin hunter2"), "admin");
+    EXPECT_EQ(redact_command("ADMIN hunter2"), "admin");
+    EXPECT_EQ(redact_command("  admin hunter2"), "admin");
+    EXPECT_EQ(redact_command("admin\thunter2"), "admin");
+    EXPECT_EQ(redact_command("\tadmin \"hunter 2\""), "admin");
+    EXPECT_EQ(redact_command("admin"), "admin");
+
+    // Only the verb counts
+    EXPECT_EQ(redact_command("say admin hunter2"), "say admin hunter2");
+    EXPECT_EQ(redact_command("administer"), "administer");
+}
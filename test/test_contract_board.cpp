@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "contract_board.hpp"
+#include "game_world.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace dungeon_merc;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+TEST(ContractBoardTest, RefreshReplacesClaimedAndExpiredOffers) {
+    ContractBoard board;
+    board.seed(7);
+    Clock::time_point now = Clock::now();
+    EXPECT_FALSE(board.read());
+
+    board.refresh(now);
+    auto first = board.read();
+    ASSERT_TRUE(first);
+    ASSERT_EQ(first->offers.size(), CONTRACT_BOARD_SIZE);
+    for (size_t i = 1; i < first->offers.size(); ++i) {
+        EXPECT_LT(first->offers[i - 1]->get_id(), first->offers[i]->get_id());
+    }
+    const Contract& offer = *first->offers[3];
+    EXPECT_EQ(offer.get_line().rfind("#" + std::to_string(offer.get_id()) + " [tier ", 0), 0u);
+    EXPECT_EQ(offer.get_min_level(), 1 + (offer.get_tier() - 1) * 2);
+    uint64_t version = first->version;
+    first = EpochPtr<ContractList>::Reader();
+
+    // Nothing claimed or expired: no new version
+    board.refresh(now);
+    EXPECT_EQ(board.read()->version, version);
+
+    std::shared_ptr<const Contract> claimed;
+    uint32_t id = offer.get_id();
+    EXPECT_EQ(board.claim(id, 99, claimed), ContractClaim::CLAIMED);
+    EXPECT_EQ(claimed->get_id(), id);
+    EXPECT_EQ(board.claim(id, 99, claimed), ContractClaim::TAKEN);
+    EXPECT_EQ(board.claim(999999, 99, claimed), ContractClaim::NOT_FOUND);
+
+    board.refresh(now);
+    auto second = board.read();
+    EXPECT_GT(second->version, version);
+    ASSERT_EQ(second->offers.size(), CONTRACT_BOARD_SIZE);
+    for (const auto& kept : second->offers) {
+        EXPECT_NE(kept->get_id(), id);
+        EXPECT_FALSE(kept->is_claimed());
+    }
+    EXPECT_TRUE(claimed->is_claimed());  // Still readable by whoever holds it
+    uint32_t newest = second->offers.back()->get_id();
+    second = EpochPtr<ContractList>::Reader();
+
+    // Past every offer's lifetime the whole board turns over
+    board.refresh(now + CONTRACT_LIFETIME + std::chrono::seconds(1));
+    auto third = board.read();
+    ASSERT_EQ(third->offers.size(), CONTRACT_BOARD_SIZE);
+    EXPECT_GT(third->offers.front()->get_id(), newest);
+}
+
+TEST(ContractBoardTest, RacingClaimsHaveOneWinner) {
+    ContractBoard board;
+    board.seed(11);
+    board.refresh(Clock::now());
+
+    std::vector<uint32_t> ids;
+    {
+        auto list = board.read();
+        for (const auto& offer : list->offers) {
+            ids.push_back(offer->get_id());
+        }
+    }
+
+    std::atomic<int> wins{0};
+    std::atomic<int> losses{0};
+    std::vector<std::thread> players;
+    for (int i = 0; i < 8; ++i) {
+        players.emplace_back([&] {
+            for (uint32_t id : ids) {
+                std::shared_ptr<const Contract> contract;
+                ContractClaim result = board.claim(id, 99, contract);
+                if (result == ContractClaim::CLAIMED) {
+                    ++wins;
+                } else if (result == ContractClaim::TAKEN) {
+                    ++losses;
+                }
+            }
+        });
+    }
+    for (auto& player : players) {
+        player.join();
+    }
+
+    EXPECT_EQ(wins.load(), static_cast<int>(ids.size()));
+    EXPECT_EQ(losses.load(), static_cast<int>(ids.size()) * 7);
+}
+
+TEST(ContractBoardTest, GeneratorRestocksAfterClaims) {
+    ContractBoard board;
+    board.start(5);
+    ASSERT_TRUE(board.is_running());
+
+    auto wait_for = [&board](auto condition) {
+        for (int i = 0; i < 200; ++i) {
+            auto list = board.read();
+            if (list && condition(*list)) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+    ASSERT_TRUE(wait_for([](const ContractList& list) { return list.offers.size() == CONTRACT_BOARD_SIZE; }));
+
+    uint32_t id = board.read()->offers.front()->get_id();
+    std::shared_ptr<const Contract> contract;
+    ASSERT_EQ(board.claim(id, 99, contract), ContractClaim::CLAIMED);
+
+    // The claim wakes the generator well before its refresh interval
+    EXPECT_TRUE(wait_for([id](const ContractList& list) {
+        return list.offers.size() == CONTRACT_BOARD_SIZE && list.offers.front()->get_id() != id;
+    }));
+    board.stop();
+    EXPECT_FALSE(board.is_running());
+}
+
+TEST(ContractBoardTest, WorldCommands) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 1);
+    Arena arena;
+    ArenaString out(arena);
+
+    world.handle_contracts_command(ada, out);
+    EXPECT_EQ(out.str(), "The contract board is empty. Check back soon.");
+
+    world.get_contracts().seed(3);
+    world.get_contracts().refresh(Clock::now());
+    uint32_t easy = 0;
+    uint32_t hard = 0;
+    for (const auto& offer : world.get_contracts().read()->offers) {
+        (offer->get_min_level() == 1 ? easy : hard) = offer->get_id();
+    }
+    ASSERT_NE(easy, 0u);
+    ASSERT_NE(hard, 0u);
+
+    out.clear();
+    world.handle_contracts_command(ada, out);
+    EXPECT_EQ(out.str().rfind("Contracts on offer:\n  #", 0), 0u);
+    EXPECT_NE(out.str().find("Take one with 'claim <number>'."), std::string::npos);
+
+    out.clear();
+    world.handle_claim_command(ada, hard, out);
+    EXPECT_EQ(out.str(), "The fixer looks you over. 'Come back when you have more experience.'");
+
+    out.clear();
+    world.handle_claim_command(ada, easy, out);
+    EXPECT_EQ(out.str().rfind("You take contract #" + std::to_string(easy) + ": ", 0), 0u);
+
+    out.clear();
+    world.handle_contracts_command(ada, out);
+    EXPECT_EQ(out.str().find("#" + std::to_string(easy) + " ["), out.str().find("Your contract: #") + 15);
+
+    PlayerId bo = world.create_player("Bo", CharacterClass::GHOST, 1);
+    out.clear();
+    world.handle_claim_command(bo, easy, out);
+    EXPECT_EQ(out.str(), "Someone beat you to contract #" + std::to_string(easy) + ".");
+    out.clear();
+    world.handle_claim_command(ada, hard, out);
+    EXPECT_EQ(out.str().rfind("You already have a contract: ", 0), 0u);
+
+    // Abandoning frees the slot for another claim
+    out.clear();
+    world.handle_abandon_command(ada, out);
+    EXPECT_EQ(out.str().rfind("You walk away from ", 0), 0u);
+    out.clear();
+    world.handle_abandon_command(ada, out);
+    EXPECT_EQ(out.str(), "You have no contract to abandon.");
+    std::vector<uint32_t> open;
+    for (const auto& offer : world.get_contracts().read()->offers) {
+        if (!offer->is_claimed() && offer->get_min_level() == 1) {
+            open.push_back(offer->get_id());
+        }
+    }
+    ASSERT_FALSE(open.empty());
+    out.clear();
+    world.handle_claim_command(ada, open[0], out);
+    EXPECT_EQ(out.str().rfind("You take contract #", 0), 0u);
+}
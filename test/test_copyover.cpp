@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "copyover.hpp"
+#include "game_world.hpp"
+#include "telnet_server.hpp"
+#include <cstdio>
+
+using namespace dungeon_merc;
+
+TEST(CopyoverTest, HandoffFileRoundTrip) {
+    CopyoverState state;
+    state.server_socket = 3;
+    state.admin_password_hash = TelnetServer::hash_password("hunter2");
+
+    CopyoverConnection conn;
+    conn.socket_fd = 7;
+    conn.client_ip = "127.0.0.1";
+    conn.player_name = "Player_7";
+    conn.character_class = CharacterClass::GHOST;
+    conn.health = 42;
+    conn.max_health = 95;
+    conn.level = 2;
+    conn.experience = 17;
+    conn.room_id = 5;
+    conn.gmcp = true;
+    conn.gmcp_modules = 2;
+    conn.items = {ItemStack{1, 250, 0}, ItemStack{6, 1, ITEM_MOD_SCOPE}};
+    state.connections.push_back(conn);
+
+    std::string path = "test_copyover_roundtrip.dat";
+    ASSERT_TRUE(write_copyover_file(path, state));
+
+    CopyoverState loaded;
+    ASSERT_TRUE(read_copyover_file(path, loaded));
+    std::remove(path.c_str());
+
+    EXPECT_EQ(loaded.server_socket, 3);
+    EXPECT_EQ(loaded.admin_password_hash, state.admin_password_hash);
+    ASSERT_EQ(loaded.connections.size(), 1u);
+    const auto& restored = loaded.connections[0];
+    EXPECT_EQ(restored.socket_fd, 7);
+    EXPECT_EQ(restored.client_ip, "127.0.0.1");
+    EXPECT_EQ(restored.player_name, "Player_7");
+    EXPECT_EQ(restored.character_class, CharacterClass::GHOST);
+    EXPECT_EQ(restored.health, 42);
+    EXPECT_EQ(restored.max_health, 95);
+    EXPECT_EQ(restored.level, 2);
+    EXPECT_EQ(restored.experience, 17);
+    EXPECT_EQ(restored.room_id, 5);
+    EXPECT_TRUE(restored.gmcp);
+    EXPECT_EQ(restored.gmcp_modules, 2);
+    ASSERT_EQ(restored.items.size(), 2u);
+    EXPECT_EQ(restored.items[0].count, 250);
+    EXPECT_EQ(restored.items[1].item, 6);
+    EXPECT_EQ(restored.items[1].mods, ITEM_MOD_SCOPE);
+}
+
+TEST(CopyoverTest, RejectsForeignFile) {
+    std::string path = "test_copyover_garbage.dat";
+    {
+        std::ofstream out(path);
+        out << "not a handoff file\n";
+    }
+
+    CopyoverState loaded;
+    EXPECT_FALSE(read_copyover_file(path, loaded));
+    std::remove(path.c_str());
+}
+
+TEST(CopyoverTest, RestoredPlayerKeepsProgress) {
+    Player player("Restored", CharacterClass::ENFORCER);
+    player.restore_progress(3, 50, 60, 140);
+
+    EXPECT_EQ(player.get_level(), 3);
+    EXPECT_EQ(player.get_experience(), 50);
+    EXPECT_EQ(player.get_health(), 60);
+    EXPECT_EQ(player.get_max_health(), 140);
+}
+
+TEST(CopyoverTest, WorldTracksPlayerRoom) {
+    GameWorld world;
+    PlayerId player = world.create_player("Walker", CharacterClass::SCOUT, 1);
+    ASSERT_TRUE(world.move_player(player, Direction::SOUTH));
+    EXPECT_EQ(world.get_player(player)->get_current_room_id(), 4);
+}
+
+TEST(CopyoverTest, ConnectionsNotHandedOnAreClosed) {
+    TelnetServer server(0);
+    ASSERT_TRUE(server.initialize());
+    server.set_game_world(std::make_shared<GameWorld>());
+
+    int clients[2];
+    for (int i = 0; i < 2; ++i) {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        clients[i] = fds[1];
+        ASSERT_TRUE(server.adopt_connection(fds[0], "client" + std::to_string(i)));
+    }
+    ASSERT_EQ(server.get_connection_count(), 2u);
+    // Still logging in: no character to hand on yet
+    server.get_connections()[1]->set_player(PlayerId());
+
+    server.set_admin_password("hunter2");
+    CopyoverState state = server.prepare_copyover();
+    EXPECT_EQ(state.admin_password_hash, TelnetServer::hash_password("hunter2"));
+    ASSERT_EQ(state.connections.size(), 1u);
+    EXPECT_EQ(state.connections[0].client_ip, "client0");
+
+    std::string text;
+    char buffer[1024];
+    ssize_t bytes;
+    while ((bytes = recv(clients[1], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    EXPECT_NE(text.find("Please reconnect in a moment."), std::string::npos);
+    EXPECT_EQ(recv(clients[1], buffer, sizeof(buffer), MSG_DONTWAIT), 0);
+
+    server.shutdown();
+    ::close(clients[0]);
+    ::close(clients[1]);
+}
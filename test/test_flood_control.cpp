@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "flood_control.hpp"
+#include "telnet_server.hpp"
+#include <sys/socket.h>
+
+using namespace dungeon_merc;
+
+TEST(FloodControlTest, TokenBucketRefillsUpToBurst) {
+    TokenBucket bucket(10.0, 3.0);
+    auto start = FloodClock::now();
+    bucket.refill(start);
+
+    EXPECT_TRUE(bucket.try_take());
+    EXPECT_TRUE(bucket.try_take());
+    EXPECT_TRUE(bucket.try_take());
+    EXPECT_FALSE(bucket.try_take());
+
+    bucket.refill(start + std::chrono::milliseconds(100));
+    EXPECT_TRUE(bucket.try_take());
+    EXPECT_FALSE(bucket.try_take());
+
+    // A long idle period never banks more than the burst
+    bucket.refill(start + std::chrono::seconds(60));
+    EXPECT_EQ(bucket.available(100), 3u);
+
+    TokenBucket unlimited;
+    EXPECT_TRUE(unlimited.unlimited());
+    EXPECT_EQ(unlimited.available(100), 100u);
+}
+
+TEST(FloodControlTest, CoalescedInputSplitsIntoLines) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TelnetConnection connection(fds[0], "test");
+    ASSERT_TRUE(connection.initialize());
+
+    const char input[] = "look\r\nsay hi\npartial";
+    ASSERT_EQ(send(fds[1], input, sizeof(input) - 1, 0), static_cast<ssize_t>(sizeof(input) - 1));
+    EXPECT_GT(connection.read_input(FloodClock::now()), 0);
+
+    std::string_view line;
+    ASSERT_TRUE(connection.next_line(line));
+    EXPECT_EQ(line, "look");
+    ASSERT_TRUE(connection.next_line(line));
+    EXPECT_EQ(line, "say hi");
+    EXPECT_FALSE(connection.next_line(line));
+
+    send(fds[1], "\n", 1, 0);
+    connection.read_input(FloodClock::now());
+    ASSERT_TRUE(connection.next_line(line));
+    EXPECT_EQ(line, "partial");
+
+    ::close(fds[1]);
+    EXPECT_EQ(connection.read_input(FloodClock::now()), -1);
+}
+
+TEST(FloodControlTest, FloodingStopsReadsAndEventuallyDisconnects) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TelnetConnection connection(fds[0], "test");
+    ASSERT_TRUE(connection.initialize());
+
+    FloodLimits limits;
+    limits.commands_per_second = 1.0;
+    limits.command_burst = 2.0;
+    limits.bytes_per_second = 16.0;
+    limits.byte_burst = 16.0;
+    limits.abuse_grace = std::chrono::seconds(2);
+    connection.set_flood_limits(limits);
+
+    std::string flood;
+    for (int i = 0; i < 20; ++i) {
+        flood += "n\n";
+    }
+    send(fds[1], flood.data(), flood.size(), 0);
+
+    // Only the byte burst is read; the rest stays in the socket
+    auto now = FloodClock::now();
+    EXPECT_EQ(connection.read_input(now), 16);
+    EXPECT_EQ(connection.read_input(now), 0);
+
+    EXPECT_TRUE(connection.take_command_token());
+    EXPECT_TRUE(connection.take_command_token());
+    EXPECT_FALSE(connection.take_command_token());
+    EXPECT_TRUE(connection.is_throttled());
+
+    EXPECT_TRUE(connection.update_flood_state(now));
+    connection.take_command_token();
+    EXPECT_TRUE(connection.update_flood_state(now + std::chrono::seconds(1)));
+    connection.take_command_token();
+    EXPECT_FALSE(connection.update_flood_state(now + std::chrono::seconds(3)));
+
+    // A quiet tick clears the throttle
+    EXPECT_TRUE(connection.update_flood_state(now + std::chrono::seconds(4)));
+    ::close(fds[1]);
+}
+
+TEST(FloodControlTest, SlowReaderKeepsOutputInOrder) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int small = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    TelnetConnection connection(fds[0], "test");
+    ASSERT_TRUE(connection.initialize());
+
+    // Far more than the socket buffer holds, in several writev batches
+    std::vector<std::string> text;
+    for (int i = 0; i < 2000; ++i) {
+        text.push_back("line " + std::to_string(i));
+    }
+    std::vector<std::string_view> lines(text.begin(), text.end());
+    ASSERT_TRUE(connection.send_lines(lines.data(), lines.size()));
+    EXPECT_TRUE(connection.has_pending_output());
+
+    // Whatever the kernel refused follows on later flushes, with no gap
+    std::string expected;
+    for (const auto& line : text) {
+        expected += line + "\r\n";
+    }
+    std::string received;
+    char buffer[4096];
+    for (int i = 0; i < 1000 && received.size() < expected.size(); ++i) {
+        ssize_t bytes = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes > 0) {
+            received.append(buffer, static_cast<size_t>(bytes));
+        }
+        ASSERT_TRUE(connection.flush_pending_output());
+    }
+    EXPECT_EQ(received, expected);
+    EXPECT_FALSE(connection.has_pending_output());
+
+    // A client that never reads runs into the limit instead of growing memory
+    std::string chunk(64 * 1024, 'x');
+    std::string_view big = chunk;
+    bool refused = false;
+    for (size_t sent = 0; sent <= 2 * SOCKET_OUTPUT_LIMIT && !refused; sent += chunk.size()) {
+        refused = !connection.send_lines(&big, 1);
+    }
+    EXPECT_TRUE(refused);
+
+    ::close(fds[1]);
+    EXPECT_FALSE(connection.flush_pending_output());
+}
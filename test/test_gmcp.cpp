@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "gmcp.hpp"
+#include "game_world.hpp"
+
+using namespace dungeon_merc;
+
+namespace {
+
+struct RecordingHandler : TelnetOptionHandler {
+    std::vector<std::pair<uint8_t, uint8_t>> options;
+    std::vector<std::string> messages;
+
+    void on_option(uint8_t command, uint8_t option) override { options.emplace_back(command, option); }
+    void on_subnegotiation(uint8_t option, std::string_view data) override {
+        if (option == telnet::GMCP) {
+            messages.emplace_back(data);
+        }
+    }
+};
+
+std::string filter(TelnetFilter& telnet_filter, std::string data, RecordingHandler& handler) {
+    data.resize(telnet_filter.filter(data.data(), data.size(), handler));
+    return data;
+}
+
+// Pull "Package json" bodies out of framed output
+std::vector<std::string> frames(std::string_view out) {
+    std::vector<std::string> result;
+    const std::string start = {char(telnet::IAC), char(telnet::SB), char(telnet::GMCP)};
+    const std::string end = {char(telnet::IAC), char(telnet::SE)};
+    size_t pos = 0;
+    while ((pos = out.find(start, pos)) != std::string_view::npos) {
+        size_t stop = out.find(end, pos);
+        result.emplace_back(out.substr(pos + 3, stop - pos - 3));
+        pos = stop + 2;
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(GmcpTest, FilterStripsNegotiationAcrossReads) {
+    TelnetFilter telnet_filter;
+    RecordingHandler handler;
+    const char iac = char(telnet::IAC);
+
+    std::string first = std::string("lo") + iac + char(telnet::DO) + char(telnet::GMCP) + "ok" + iac;
+    EXPECT_EQ(filter(telnet_filter, first, handler), "look");
+    ASSERT_EQ(handler.options.size(), 1u);
+    EXPECT_EQ(handler.options[0], std::make_pair(telnet::DO, telnet::GMCP));
+
+    // The trailing IAC above starts a subnegotiation that ends in the next read
+    std::string second = std::string(1, char(telnet::SB)) + char(telnet::GMCP) + "Core.Hello {}";
+    EXPECT_EQ(filter(telnet_filter, second, handler), "");
+    std::string third = std::string(1, iac) + char(telnet::SE) + "\r\n" + iac + iac;
+    EXPECT_EQ(filter(telnet_filter, third, handler), "\r\n\xff");
+    EXPECT_EQ(handler.messages, std::vector<std::string>{"Core.Hello {}"});
+}
+
+TEST(GmcpTest, SessionSendsOnlyChanges) {
+    GameWorld world;
+    PlayerId rook = world.create_player("Rook", CharacterClass::SCOUT, 1);
+    Player* player = world.get_player(rook);
+    GmcpSession session;
+    ArenaString out;
+
+    // Nothing until the client agrees to GMCP
+    EXPECT_FALSE(session.collect(rook, *player, world.find_room(1), world.get_players(), out));
+
+    session.set_enabled(true);
+    ASSERT_TRUE(session.collect(rook, *player, world.find_room(1), world.get_players(), out));
+    auto sent = frames(out.view());
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[0], "Char.Vitals {\"hp\":80,\"maxhp\":80,\"level\":1,\"xp\":0}");
+    EXPECT_EQ(sent[1].rfind("Room.Info {\"num\":1,\"name\":\"Town Square\",\"exits\":{", 0), 0u);
+    EXPECT_EQ(sent[2], "Room.Players []");
+    player->clear_dirty(PLAYER_DIRTY_GMCP);
+
+    out.clear();
+    EXPECT_FALSE(session.collect(rook, *player, world.find_room(1), world.get_players(), out));
+
+    player->take_damage(10);
+    PlayerId jinx = world.create_player("Jinx", CharacterClass::GHOST, 1);
+    ASSERT_TRUE(session.collect(rook, *player, world.find_room(1), world.get_players(), out));
+    sent = frames(out.view());
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[0], "Char.Vitals {\"hp\":70}");
+    EXPECT_EQ(sent[1], "Room.AddPlayer {\"name\":\"Jinx\"}");
+    player->clear_dirty(PLAYER_DIRTY_GMCP);
+
+    out.clear();
+    world.remove_player(jinx);
+    ASSERT_TRUE(session.collect(rook, *player, world.find_room(1), world.get_players(), out));
+    EXPECT_EQ(frames(out.view()), std::vector<std::string>{"Room.RemovePlayer \"Jinx\""});
+    tick_arena().reset();
+}
+
+TEST(GmcpTest, CoreSupportsSelectsModules) {
+    GameWorld world;
+    PlayerId rook = world.create_player("Rook", CharacterClass::SCOUT, 1);
+    Player* player = world.get_player(rook);
+    GmcpSession session;
+    session.set_enabled(true);
+    session.handle_message("Core.Supports.Set [\"Room 1\"]");
+    EXPECT_EQ(session.get_modules(), GMCP_ROOM);
+
+    ArenaString out;
+    session.collect(rook, *player, world.find_room(1), world.get_players(), out);
+    player->clear_dirty(PLAYER_DIRTY_GMCP);
+    EXPECT_EQ(frames(out.view()).size(), 2u);
+
+    // Adding a module sends its full state
+    out.clear();
+    session.handle_message("Core.Supports.Add [\"Char 1\"]");
+    session.collect(rook, *player, world.find_room(1), world.get_players(), out);
+    auto sent = frames(out.view());
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[0].rfind("Char.Vitals ", 0), 0u);
+
+    ArenaString escaped;
+    append_json_string(escaped, "a\"b\\\n");
+    EXPECT_EQ(escaped.view(), "\"a\\\"b\\\\\\u000a\"");
+    tick_arena().reset();
+}
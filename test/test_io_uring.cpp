@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include "io_uring.hpp"
+#include "telnet_server.hpp"
+#include <functional>
+#include <thread>
+
+using namespace dungeon_merc;
+
+namespace {
+
+// Completions land asynchronously; poll until 'done' or give up after a second
+bool poll_until(IoUring& ring, const std::function<bool()>& done) {
+    for (int i = 0; i < 200; ++i) {
+        ring.poll();
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+std::string recv_all(int fd) {
+    std::string text;
+    char buffer[4096];
+    for (int i = 0; i < 200; ++i) {
+        ssize_t bytes = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes > 0) {
+            text.append(buffer, static_cast<size_t>(bytes));
+        } else if (bytes == 0 || !text.empty()) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+TEST(IoUringTest, AcceptsReadsWritesAndCloses) {
+    IoUring ring;
+    if (!ring.initialize()) {
+        GTEST_SKIP() << "io_uring is not available on this kernel";
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 16), 0);
+    socklen_t length = sizeof(addr);
+    getsockname(listener, (struct sockaddr*)&addr, &length);
+    ring.watch_listener(listener);
+    ring.submit();
+
+    // One armed accept takes every client
+    int clients[2];
+    for (int& client : clients) {
+        client = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_EQ(connect(client, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    }
+    std::vector<int> accepted;
+    ASSERT_TRUE(poll_until(ring, [&] {
+        for (int fd : ring.take_accepted()) {
+            accepted.push_back(fd);
+        }
+        return accepted.size() == 2;
+    }));
+
+    ring.attach(1, accepted[0]);
+    ring.attach(2, accepted[1]);
+    ring.submit();
+    send(clients[0], "look\r\n", 6, 0);
+    send(clients[1], "who\r\n", 5, 0);
+
+    char buffer[64];
+    ssize_t bytes = 0;
+    ASSERT_TRUE(poll_until(ring, [&] { return (bytes = ring.read(1, buffer, sizeof(buffer))) > 0; }));
+    EXPECT_EQ(std::string(buffer, static_cast<size_t>(bytes)), "look\r\n");
+    ASSERT_TRUE(poll_until(ring, [&] { return (bytes = ring.read(2, buffer, sizeof(buffer))) > 0; }));
+    EXPECT_EQ(std::string(buffer, static_cast<size_t>(bytes)), "who\r\n");
+    EXPECT_EQ(ring.read(1, buffer, sizeof(buffer)), 0);
+
+    // Nothing leaves until submit(), then all of it at once
+    char line[] = "Town Square";
+    char crlf[] = "\r\n";
+    struct iovec iov[2] = {{line, 11}, {crlf, 2}};
+    EXPECT_EQ(ring.write(1, iov, 2), 13);
+    EXPECT_EQ(ring.write(1, iov, 2), 13);
+    EXPECT_EQ(recv(clients[0], buffer, sizeof(buffer), MSG_DONTWAIT), -1);
+    ring.submit();
+    EXPECT_EQ(recv_all(clients[0]), "Town Square\r\nTown Square\r\n");
+
+    // Released sockets still send what was queued, then close
+    char goodbye[] = "Goodbye!\r\n";
+    struct iovec last = {goodbye, 10};
+    EXPECT_EQ(ring.write(2, &last, 1), 10);
+    ring.release(2);
+    poll_until(ring, [&] { return ring.get_socket_count() == 1; });
+    EXPECT_EQ(recv_all(clients[1]), "Goodbye!\r\n");
+    EXPECT_EQ(recv(clients[1], buffer, sizeof(buffer), 0), 0);
+
+    // A peer hanging up reads as -1 once its input is drained
+    ::close(clients[0]);
+    ASSERT_TRUE(poll_until(ring, [&] { return ring.read(1, buffer, sizeof(buffer)) < 0; }));
+    ring.release(1);
+    ::close(listener);
+}
+
+TEST(IoUringTest, ConnectionUsesRing) {
+    IoUring ring;
+    if (!ring.initialize()) {
+        GTEST_SKIP() << "io_uring is not available on this kernel";
+    }
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    {
+        TelnetConnection connection(fds[0], "test");
+        ASSERT_TRUE(connection.initialize());
+        connection.set_id(7);
+        connection.attach_uring(&ring);
+
+        const std::string_view lines[] = {"You move north.", "> "};
+        ASSERT_TRUE(connection.send_lines(lines, 2));
+        ring.submit();
+        EXPECT_EQ(recv_all(fds[1]), "You move north.\r\n> \r\n");
+
+        send(fds[1], "say hi\r\n", 8, 0);
+        ASSERT_TRUE(poll_until(ring, [&] { return connection.read_input(FloodClock::now()) > 0; }));
+        std::string_view line;
+        ASSERT_TRUE(connection.next_line(line));
+        EXPECT_EQ(line, "say hi");
+
+        // A client that never reads runs into the same wall as a full socket buffer
+        std::string chunk(64 * 1024, 'x');
+        std::string_view big = chunk;
+        for (size_t sent = 0; sent < URING_OUTPUT_LIMIT; sent += chunk.size()) {
+            connection.send_lines(&big, 1);
+        }
+        EXPECT_FALSE(connection.send_lines(&big, 1));
+    }
+
+    // Destroying the connection hands the socket back to the ring to close
+    char buffer[64];
+    poll_until(ring, [&] { return ring.get_socket_count() == 0; });
+    EXPECT_EQ(ring.get_socket_count(), 0u);
+    while (recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+    }
+    EXPECT_EQ(recv(fds[1], buffer, sizeof(buffer), 0), 0);
+    ::close(fds[1]);
+}
+
+TEST(IoUringTest, ReleaseDuringSendKeepsFinalOutput) {
+    IoUring ring;
+    if (!ring.initialize()) {
+        GTEST_SKIP() << "io_uring is not available on this kernel";
+    }
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int small = 16 * 1024;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    ring.attach(3, fds[0]);
+    ring.submit();
+
+    // More than the socket buffer holds, so the send waits on the client
+    std::string body(200 * 1024, 'x');
+    struct iovec iov = {body.data(), body.size()};
+    ASSERT_EQ(ring.write(3, &iov, 1), static_cast<ssize_t>(body.size()));
+    ring.submit();
+    ring.poll();
+
+    char goodbye[] = "Goodbye!\r\n";
+    struct iovec last = {goodbye, 10};
+    EXPECT_EQ(ring.write(3, &last, 1), 10);
+    ring.release(3);
+
+    // The client reads at its own pace and still gets everything, in order
+    std::string received;
+    char buffer[16384];
+    bool closed = false;
+    for (int i = 0; i < 400 && !closed; ++i) {
+        ring.poll();
+        ring.submit();
+        ssize_t bytes = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes > 0) {
+            received.append(buffer, static_cast<size_t>(bytes));
+        } else if (bytes == 0) {
+            closed = true;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    EXPECT_TRUE(closed);
+    EXPECT_EQ(ring.get_socket_count(), 0u);
+    ASSERT_EQ(received.size(), body.size() + 10);
+    EXPECT_EQ(received.compare(0, body.size(), body), 0);
+    EXPECT_EQ(received.substr(body.size()), "Goodbye!\r\n");
+    ::close(fds[1]);
+}
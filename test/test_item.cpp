@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "item.hpp"
+#include "game_world.hpp"
+#include "triggers.hpp"
+#include <cmath>
+#include <fstream>
+
+using namespace dungeon_merc;
+
+TEST(LootTableTest, AliasRollsFollowWeights) {
+    LootTable table;
+    std::vector<LootEntry> entries = {
+        {1, 50, 1, 1, 0},
+        {2, 30, 1, 1, 0},
+        {3, 15, 1, 1, 0},
+        {4, 4, 1, 1, 0},
+        {5, 1, 1, 1, 0},
+    };
+    ASSERT_TRUE(table.build(entries));
+
+    RandomGenerator rng(2024);
+    const int rolls = 200000;
+    int counts[6] = {};
+    for (int i = 0; i < rolls; ++i) {
+        ++counts[table.roll(rng).item];
+    }
+    for (const auto& entry : entries) {
+        double expected = rolls * entry.weight / 100.0;
+        // Well inside five standard deviations for every entry
+        EXPECT_LT(std::abs(counts[entry.item] - expected), 5 * std::sqrt(expected) + 1) << "item " << entry.item;
+    }
+
+    // A zero weight never comes up; an all-zero table is refused
+    LootTable skewed;
+    ASSERT_TRUE(skewed.build({{1, 0, 1, 1, 0}, {2, 7, 1, 1, 0}}));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(skewed.roll(rng).item, 2);
+    }
+    LootTable empty;
+    EXPECT_FALSE(empty.build({{1, 0, 1, 1, 0}}));
+    EXPECT_FALSE(empty.build({}));
+    EXPECT_TRUE(empty.empty());
+}
+
+TEST(InventoryPoolTest, StacksMergeAndSlotsStayPacked) {
+    ItemCatalog catalog;
+    const ItemTemplate* rounds = catalog.find("9MM ROUNDS");
+    const ItemTemplate* sidearm = catalog.find("sidearm");
+    ASSERT_NE(rounds, nullptr);
+    ASSERT_NE(sidearm, nullptr);
+
+    InventoryPool pool;
+    EXPECT_EQ(pool.used(3), 0u);
+    EXPECT_EQ(pool.add(3, *rounds, 300), 300);
+    EXPECT_EQ(pool.add(3, *rounds, 300), 300);  // Tops up to 500, then a second stack
+    EXPECT_EQ(pool.used(3), 2u);
+    EXPECT_EQ(pool.slots(3)[0].count, rounds->max_stack);
+    EXPECT_EQ(pool.count_of(3, rounds->id), 600u);
+
+    // Same weapon with different mods takes its own slot
+    EXPECT_EQ(pool.add(3, *sidearm, 1, ITEM_MOD_SCOPE), 1);
+    EXPECT_EQ(pool.add(3, *sidearm, 1), 1);
+    EXPECT_EQ(pool.used(3), 4u);
+    EXPECT_EQ(pool.used(0), 0u);  // Other owners untouched
+
+    EXPECT_EQ(pool.take(3, rounds->id, 150), 150);
+    EXPECT_EQ(pool.count_of(3, rounds->id), 450u);
+    EXPECT_EQ(pool.used(3), 3u);
+    EXPECT_EQ(pool.slots(3)[1].item, sidearm->id);
+    EXPECT_EQ(pool.slots(3)[1].mods, ITEM_MOD_SCOPE);
+
+    // A full pack takes what it can
+    EXPECT_EQ(pool.add(3, *sidearm, 40), INVENTORY_SLOTS - 3);
+    EXPECT_EQ(pool.add(3, *sidearm, 1), 0);
+    EXPECT_EQ(pool.used(3), INVENTORY_SLOTS);
+
+    pool.clear(3);
+    EXPECT_EQ(pool.used(3), 0u);
+}
+
+TEST(ItemWorldTest, LootInventoryAndHandoff) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 5);
+    Arena arena;
+    ArenaString out(arena);
+
+    world.handle_inventory_command(ada, out);
+    EXPECT_EQ(out.str(), "You are carrying nothing.");
+
+    RandomGenerator rng(11);
+    for (int i = 0; i < 10; ++i) {
+        out.clear();
+        ASSERT_TRUE(world.grant_loot(ada, "dungeon", rng, out));
+        EXPECT_EQ(out.str().rfind("You find ", 0), 0u) << out.str();
+    }
+    EXPECT_FALSE(world.grant_loot(ada, "no such table", rng, out));
+
+    size_t used = world.get_inventories().used(ada.index);
+    EXPECT_GT(used, 0u);
+    out.clear();
+    world.handle_inventory_command(ada, out);
+    EXPECT_EQ(out.str().rfind("You are carrying:", 0), 0u);
+    EXPECT_NE(out.str().find(std::to_string(used) + " of 16 slots used"), std::string::npos);
+
+    // What a hot reboot or zone handoff carries over
+    std::vector<ItemStack> items;
+    world.copy_inventory(ada, items);
+    ASSERT_EQ(items.size(), used);
+    std::string before = out.str();
+    world.remove_player(ada);
+
+    PlayerId back = world.create_player("Ada", CharacterClass::TECH, 5);
+    EXPECT_EQ(world.get_inventories().used(back.index), 0u);
+    items.push_back(ItemStack{9999, 1, 0});  // From a newer build; dropped
+    world.restore_inventory(back, items);
+    out.clear();
+    world.handle_inventory_command(back, out);
+    EXPECT_EQ(out.str(), before);
+}
+
+TEST(ItemWorldTest, TriggersRollLoot) {
+    std::string path = "/tmp/dm_test_loot_triggers.dms";
+    {
+        std::ofstream file(path);
+        file << "on command 5 search\n"
+                "    loot \"dungeon\"\n"
+                "    loot \"missing\"\n"
+                "    block\n";
+    }
+    GameWorld world;
+    std::string error;
+    ASSERT_TRUE(world.load_triggers(path, error)) << error;
+    std::remove(path.c_str());
+
+    PlayerId ada = world.create_player("Ada", CharacterClass::SCOUT, 5);
+    Arena arena;
+    ArenaString out(arena);
+    EXPECT_TRUE(world.run_command_triggers(ada, "search", out));
+    EXPECT_EQ(out.str().rfind("You find ", 0), 0u) << out.str();
+    EXPECT_EQ(world.get_inventories().used(ada.index), 1u);
+}
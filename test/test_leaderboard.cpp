@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "leaderboard.hpp"
+#include "game_world.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+using namespace dungeon_merc;
+
+namespace {
+
+std::vector<std::string> page_names(const Leaderboard& board, size_t offset, size_t count) {
+    std::vector<std::string> names;
+    board.for_each_page(offset, count, [&](size_t rank, const Leaderboard::Entry& entry) {
+        EXPECT_EQ(rank, offset + names.size() + 1);
+        names.push_back(entry.name);
+    });
+    return names;
+}
+
+} // namespace
+
+TEST(LeaderboardTest, RanksByLevelThenExperienceThenName) {
+    Leaderboard board;
+    board.update("Cy", 2, 50);
+    board.update("ada", 3, 10);
+    board.update("Bo", 2, 50);
+    board.update("Di", 2, 80);
+
+    EXPECT_EQ(board.size(), 4u);
+    EXPECT_EQ(page_names(board, 0, 10), (std::vector<std::string>{"ada", "Di", "Bo", "Cy"}));
+    EXPECT_EQ(board.rank_of("ADA"), 1u);
+    EXPECT_EQ(board.rank_of("cy"), 4u);
+    EXPECT_EQ(board.rank_of("Nobody"), 0u);
+
+    // Progress moves a player without duplicating them
+    board.update("Cy", 4, 0);
+    EXPECT_EQ(board.size(), 4u);
+    EXPECT_EQ(board.rank_of("Cy"), 1u);
+    EXPECT_EQ(page_names(board, 1, 2), (std::vector<std::string>{"ada", "Di"}));
+    EXPECT_TRUE(page_names(board, 4, 10).empty());
+}
+
+TEST(LeaderboardTest, MatchesSortedReferenceUnderChurn) {
+    Leaderboard board;
+    std::vector<std::tuple<int, int, std::string>> players;
+    Xoshiro256StarStar rng(7);
+    for (int i = 0; i < 500; ++i) {
+        players.emplace_back(1, 0, "p" + std::to_string(i));
+    }
+    for (int step = 0; step < 5000; ++step) {
+        auto& player = players[rng() % players.size()];
+        std::get<0>(player) = 1 + static_cast<int>(rng() % 20);
+        std::get<1>(player) = static_cast<int>(rng() % 1000);
+        board.update(std::get<2>(player), std::get<0>(player), std::get<1>(player));
+    }
+
+    std::vector<std::tuple<int, int, std::string>> reference;
+    for (const auto& player : players) {
+        if (board.find(std::get<2>(player))) {
+            reference.emplace_back(-std::get<0>(player), -std::get<1>(player), std::get<2>(player));
+        }
+    }
+    std::sort(reference.begin(), reference.end());
+    ASSERT_EQ(board.size(), reference.size());
+
+    std::vector<std::string> expected;
+    for (const auto& entry : reference) {
+        expected.push_back(std::get<2>(entry));
+    }
+    EXPECT_EQ(page_names(board, 0, board.size()), expected);
+    EXPECT_EQ(page_names(board, 37, 10), std::vector<std::string>(expected.begin() + 37, expected.begin() + 47));
+    for (size_t i = 0; i < expected.size(); i += 17) {
+        EXPECT_EQ(board.rank_of(expected[i]), i + 1);
+    }
+}
+
+TEST(LeaderboardTest, SaveAndLoadKeepOrder) {
+    std::string path = "/tmp/dm_test_leaderboard.txt";
+    std::remove(path.c_str());
+
+    Leaderboard board;
+    EXPECT_TRUE(board.load(path));  // Missing file: empty board
+    EXPECT_EQ(board.size(), 0u);
+    for (int i = 0; i < 300; ++i) {
+        board.update("m" + std::to_string(i), 1 + i % 7, (i * 37) % 100);
+    }
+    EXPECT_TRUE(board.is_dirty());
+    ASSERT_TRUE(board.save(path));
+    EXPECT_FALSE(board.is_dirty());
+
+    Leaderboard loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), board.size());
+    EXPECT_EQ(page_names(loaded, 0, loaded.size()), page_names(board, 0, board.size()));
+    EXPECT_EQ(loaded.rank_of("m6"), board.rank_of("m6"));
+
+    // A loaded board takes updates like any other
+    loaded.update("m6", 50, 0);
+    EXPECT_EQ(loaded.rank_of("m6"), 1u);
+    EXPECT_EQ(loaded.size(), board.size());
+    std::remove(path.c_str());
+}
+
+TEST(LeaderboardTest, WorldTracksProgressAndKeepsLoggedOutPlayers) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 1);
+    PlayerId bo = world.create_player("Bo", CharacterClass::GHOST, 1);
+    world.get_player(bo)->gain_experience(150);  // Level 2, 50 xp
+
+    const Leaderboard& board = world.get_leaderboard();
+    EXPECT_EQ(board.rank_of("Bo"), 1u);
+    EXPECT_EQ(board.find("Bo")->level, 2);
+    EXPECT_EQ(board.find("Bo")->experience, 50);
+
+    Arena arena;
+    ArenaString out(arena);
+    world.handle_rank_command(ada, "", out);
+    EXPECT_EQ(out.str(), "You are #2 of 2 (level 1, 0 xp).");
+
+    world.remove_player(bo);
+    out.clear();
+    world.handle_rank_command(ada, "bo", out);
+    EXPECT_EQ(out.str(), "Bo is #1 of 2 (level 2, 50 xp).");
+
+    out.clear();
+    world.handle_top_command(1, out);
+    EXPECT_EQ(out.str(), "Top mercs, page 1 of 1:\n  #1 Bo - level 2, 50 xp\n  #2 Ada - level 1, 0 xp");
+
+    // Who still follows levels through the same observer
+    world.get_player(ada)->gain_experience(500);
+    out.clear();
+    world.handle_who_command(WhoFilter(), out);
+    EXPECT_NE(out.str().find("[3 Tech] Ada"), std::string::npos);
+    EXPECT_EQ(board.rank_of("Ada"), 1u);
+}
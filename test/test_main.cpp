@@ -1,8 +1,33 @@
 #include <gtest/gtest.h>
+#include "common.hpp"
+
+using namespace dungeon_merc;
+
+namespace {
+
+// Servers and worlds built by the tests log freely; only errors are worth
+// seeing in test output
+class QuietLogEnvironment : public ::testing::Environment {
+public:
+    void SetUp() override {
+        previous_ = Logger::get_instance().get_min_level();
+        Logger::get_instance().set_min_level(LogLevel::ERROR);
+    }
+
+    void TearDown() override {
+        Logger::get_instance().set_min_level(previous_);
+    }
+
+private:
+    LogLevel previous_ = LogLevel::DEBUG;
+};
+
+} // namespace
 
 // Main test entry point
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new QuietLogEnvironment);
     return RUN_ALL_TESTS();
 }
 
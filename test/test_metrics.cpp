@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "metrics.hpp"
+#include "command_dispatcher.hpp"
+
+using namespace dungeon_merc;
+
+TEST(MetricsTest, BucketBoundsAreContiguous) {
+    for (int i = 1; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        uint64_t lower = LatencyHistogram::bucket_lower_bound(i);
+        EXPECT_EQ(LatencyHistogram::bucket_index(lower), i);
+        EXPECT_EQ(LatencyHistogram::bucket_index(lower - 1), i - 1);
+    }
+}
+
+TEST(MetricsTest, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value * 1000);
+    }
+
+    EXPECT_EQ(histogram.count(), 10000u);
+    EXPECT_EQ(histogram.max(), 10000000u);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(50.0)), 5000000.0, 5000000.0 * 0.07);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(99.0)), 9900000.0, 9900000.0 * 0.07);
+}
+
+TEST(MetricsTest, CounterSumsAcrossThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 1000; ++i) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter.value(), 4000u);
+}
+
+TEST(MetricsTest, DispatcherTimesCommands) {
+    auto world = std::make_shared<GameWorld>();
+    CommandDispatcher dispatcher(world);
+    PlayerId player = world->create_player("Timed", CharacterClass::TECH);
+
+    auto& look_latency = MetricsRegistry::get_instance().histogram("command.look.latency");
+    uint64_t before = look_latency.count();
+
+    CommandContext ctx;
+    ctx.player = player;
+    EXPECT_TRUE(dispatcher.dispatch(ctx, "look"));
+    EXPECT_EQ(look_latency.count(), before + 1);
+    ASSERT_FALSE(ctx.output.empty());
+    EXPECT_EQ(ctx.output[0].rfind("Town Square", 0), 0u);
+}
+
+TEST(MetricsTest, AdminCommandsHiddenFromPlayers) {
+    CommandDispatcher dispatcher;
+    dispatcher.register_command("secret", "secret - Admin only",
+        [](CommandContext& ctx, std::string_view) { ctx.reply("ok"); }, true);
+
+    CommandContext player_ctx;
+    EXPECT_FALSE(dispatcher.dispatch(player_ctx, "secret"));
+
+    CommandContext admin_ctx;
+    admin_ctx.is_admin = true;
+    EXPECT_TRUE(dispatcher.dispatch(admin_ctx, "secret"));
+    ASSERT_EQ(admin_ctx.output.size(), 1u);
+    EXPECT_EQ(admin_ctx.output[0], "ok");
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "command_dispatcher.hpp"
+#include "game_world.hpp"
+
+using namespace dungeon_merc;
+
+namespace {
+
+std::vector<std::string> who_names(const GameWorld& world, const WhoFilter& filter) {
+    std::vector<std::string> names;
+    world.get_directory().for_each_who(filter, [&](PlayerId, const Player& player) {
+        names.push_back(player.get_name());
+        return true;
+    });
+    return names;
+}
+
+} // namespace
+
+TEST(PlayerDirectoryTest, FindsNamesIgnoringCase) {
+    GameWorld world;
+    PlayerId rook = world.create_player("Rook", CharacterClass::SCOUT);
+    world.create_player("Rookie", CharacterClass::TECH);
+
+    EXPECT_EQ(world.find_player_by_name("rook"), rook);
+    EXPECT_EQ(world.find_player_by_name("ROOK"), rook);
+    EXPECT_FALSE(world.find_player_by_name("roo").is_valid());
+
+    world.remove_player(rook);
+    EXPECT_FALSE(world.find_player_by_name("rook").is_valid());
+    EXPECT_EQ(world.get_directory().size(), 1u);
+}
+
+TEST(PlayerDirectoryTest, WhoOrderFollowsLevelChanges) {
+    GameWorld world;
+    PlayerId ash = world.create_player("Ash", CharacterClass::SCOUT);
+    world.create_player("bex", CharacterClass::GHOST);
+    world.create_player("Cole", CharacterClass::SCOUT);
+
+    EXPECT_EQ(who_names(world, WhoFilter{}), (std::vector<std::string>{"Ash", "bex", "Cole"}));
+
+    world.get_player(ash)->gain_experience(100);
+    world.get_player(ash)->gain_experience(200);
+    ASSERT_EQ(world.get_player(ash)->get_level(), 3);
+
+    PlayerId bex = world.find_player_by_name("bex");
+    world.get_player(bex)->restore_progress(2, 0, 50, 100);
+    EXPECT_EQ(who_names(world, WhoFilter{}), (std::vector<std::string>{"Ash", "bex", "Cole"}));
+
+    world.get_player(world.find_player_by_name("cole"))->restore_progress(5, 0, 50, 100);
+    EXPECT_EQ(who_names(world, WhoFilter{}), (std::vector<std::string>{"Cole", "Ash", "bex"}));
+
+    WhoFilter scouts;
+    scouts.any_class = false;
+    scouts.character_class = CharacterClass::SCOUT;
+    scouts.max_level = 4;
+    EXPECT_EQ(who_names(world, scouts), (std::vector<std::string>{"Ash"}));
+
+    WhoFilter low;
+    low.min_level = 2;
+    low.max_level = 2;
+    EXPECT_EQ(who_names(world, low), (std::vector<std::string>{"bex"}));
+}
+
+TEST(PlayerDirectoryTest, WhoAndFingerCommands) {
+    auto world = std::make_shared<GameWorld>();
+    PlayerId viewer = world->create_player("Viewer", CharacterClass::TECH);
+    world->create_player("Nyx", CharacterClass::GHOST);
+    CommandDispatcher dispatcher(world);
+
+    CommandContext who;
+    who.player = viewer;
+    dispatcher.dispatch(who, "who gh");
+    ASSERT_EQ(who.output.size(), 1u);
+    EXPECT_EQ(who.output[0], "Mercs online: 2\n  [1 Ghost] Nyx");
+
+    CommandContext bad;
+    dispatcher.dispatch(bad, "who 9-3");
+    EXPECT_EQ(bad.output[0], "Usage: who [class] [level|min-max]");
+
+    CommandContext finger;
+    dispatcher.dispatch(finger, "finger NYX");
+    ASSERT_EQ(finger.output.size(), 1u);
+    EXPECT_EQ(finger.output[0].substr(0, 22), "Nyx, level 1 Ghost, la");
+    tick_arena().reset();
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "player_table.hpp"
+#include "game_world.hpp"
+
+using namespace dungeon_merc;
+
+TEST(PlayerTableTest, StaleHandlesAreRejected) {
+    PlayerTable table;
+    PlayerId first = table.create("First", CharacterClass::SCOUT);
+    ASSERT_NE(table.get(first), nullptr);
+    EXPECT_EQ(table.get(first)->get_name(), "First");
+
+    EXPECT_TRUE(table.destroy(first));
+    EXPECT_FALSE(table.destroy(first));
+    EXPECT_EQ(table.get(first), nullptr);
+
+    // The slot is reused under a new generation; the old handle stays dead
+    PlayerId second = table.create("Second", CharacterClass::TECH);
+    EXPECT_EQ(second.index, first.index);
+    EXPECT_NE(second.generation, first.generation);
+    EXPECT_EQ(table.get(first), nullptr);
+    EXPECT_EQ(table.get(second)->get_name(), "Second");
+    EXPECT_EQ(table.size(), 1u);
+
+    EXPECT_EQ(table.get(PlayerId{}), nullptr);
+}
+
+TEST(PlayerTableTest, PointersSurviveGrowth) {
+    PlayerTable table;
+    PlayerId id = table.create("Anchor", CharacterClass::GHOST);
+    const Player* anchor = table.get(id);
+    for (int i = 0; i < 1000; ++i) {
+        table.create("Filler", CharacterClass::SCOUT);
+    }
+    EXPECT_EQ(table.get(id), anchor);
+}
+
+TEST(PlayerTableTest, RemovedPlayerLeavesRoom) {
+    GameWorld world;
+    PlayerId stays = world.create_player("Stays", CharacterClass::SCOUT, 1);
+    PlayerId leaves = world.create_player("Leaves", CharacterClass::SCOUT, 1);
+    world.remove_player(leaves);
+
+    auto room = world.get_room(1);
+    ASSERT_EQ(room->get_players().size(), 1u);
+    EXPECT_EQ(room->get_players()[0], stays);
+    EXPECT_EQ(world.get_player(leaves), nullptr);
+    EXPECT_FALSE(world.move_player(leaves, Direction::NORTH));
+    EXPECT_EQ(room->get_full_description(world.get_players()).find("Leaves"), std::string::npos);
+}
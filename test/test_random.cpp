@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "random.hpp"
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace dungeon_merc;
+
+TEST(RandomTest, SameSeedSameSequence) {
+    RandomGenerator a(42);
+    RandomGenerator b(42);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(a.random_int(1, 20), b.random_int(1, 20));
+    }
+
+    // Reference output of xoshiro256** seeded through splitmix64; guards
+    // against accidental changes that would break recorded replays
+    Xoshiro256StarStar engine(0);
+    EXPECT_EQ(engine(), 0x99ec5f36cb75f2b4ULL);
+}
+
+TEST(RandomTest, BoundedValuesStayInRange) {
+    RandomGenerator rng(7);
+    std::set<int> seen;
+    for (int i = 0; i < 10000; ++i) {
+        int roll = rng.random_int(-3, 3);
+        ASSERT_GE(roll, -3);
+        ASSERT_LE(roll, 3);
+        seen.insert(roll);
+
+        double d = rng.random_double(2.0, 4.0);
+        ASSERT_GE(d, 2.0);
+        ASSERT_LT(d, 4.0);
+    }
+    EXPECT_EQ(seen.size(), 7u);
+
+    // Full int range must not overflow
+    int wide = rng.random_int(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    (void)wide;
+    EXPECT_EQ(rng.random_int(5, 5), 5);
+}
+
+TEST(RandomTest, FillMatchesSingleRolls) {
+    RandomGenerator bulk(99);
+    RandomGenerator single(99);
+
+    std::vector<int> rolls(256);
+    bulk.fill_int(rolls.data(), rolls.size(), 1, 6);
+    for (int roll : rolls) {
+        EXPECT_EQ(roll, single.random_int(1, 6));
+    }
+}
+
+TEST(RandomTest, SplitStreamsDiffer) {
+    RandomGenerator parent(1234);
+    RandomGenerator child = parent.split();
+
+    int same = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (parent.next_u64() == child.next_u64()) {
+            same++;
+        }
+    }
+    EXPECT_EQ(same, 0);
+
+    // Splitting is deterministic
+    RandomGenerator parent2(1234);
+    RandomGenerator child2 = parent2.split();
+    RandomGenerator child3(1234);
+    EXPECT_EQ(child2.next_u64(), child3.next_u64());
+
+    EXPECT_NE(RandomGenerator::stream_seed(5, 1), RandomGenerator::stream_seed(5, 2));
+}
+
+TEST(RandomTest, ThreadsGetDistinctInstances) {
+    RandomGenerator* main_instance = &RandomGenerator::get_instance();
+    RandomGenerator* other_instance = nullptr;
+    std::thread worker([&other_instance]() {
+        other_instance = &RandomGenerator::get_instance();
+    });
+    worker.join();
+    EXPECT_NE(main_instance, other_instance);
+}
+
+TEST(RandomTest, ThreadStreamsDoNotDependOnStartOrder) {
+    RandomGenerator::set_global_seed(99);
+    auto first_roll = [](uint64_t stream) {
+        uint64_t roll = 0;
+        std::thread worker([&roll, stream]() {
+            RandomGenerator::get_instance().next_u64();  // Rolls before naming the stream don't matter
+            RandomGenerator::set_thread_stream(stream);
+            roll = RandomGenerator::get_instance().next_u64();
+        });
+        worker.join();
+        return roll;
+    };
+
+    uint64_t a = first_roll(7);
+    uint64_t b = first_roll(8);
+    EXPECT_EQ(first_roll(8), b);
+    EXPECT_EQ(first_roll(7), a);
+    EXPECT_EQ(a, RandomGenerator(RandomGenerator::stream_seed(99, 7)).next_u64());
+    EXPECT_NE(a, b);
+
+    // The seeding thread follows the seed itself
+    EXPECT_EQ(RandomGenerator::get_instance().next_u64(), RandomGenerator(99).next_u64());
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "script.hpp"
+#include "triggers.hpp"
+#include "command_dispatcher.hpp"
+#include "game_world.hpp"
+
+using namespace dungeon_merc;
+
+namespace {
+
+struct RecordingHost : ScriptHost {
+    int32_t level = 1;
+    std::vector<std::string> sent;
+    int32_t healed = 0;
+    std::vector<std::string> looted;
+
+    int32_t get(ScriptBuiltin builtin) override { return builtin == ScriptBuiltin::LEVEL ? level : 0; }
+    void send(std::string_view text) override { sent.emplace_back(text); }
+    void echo(std::string_view text) override { sent.emplace_back("echo:" + std::string(text)); }
+    void heal(int32_t amount) override { healed += amount; }
+    void damage(int32_t) override {}
+    void add_experience(int32_t) override {}
+    void teleport(int32_t) override {}
+    void loot(std::string_view table) override { looted.emplace_back(table); }
+};
+
+CompiledScript compile_ok(const std::string& source) {
+    CompiledScript script;
+    std::string error;
+    EXPECT_TRUE(compile_script(source, 0, script, error)) << error;
+    return script;
+}
+
+} // namespace
+
+TEST(ScriptTest, ArithmeticAndControlFlow) {
+    auto script = compile_ok(
+        "let total = 0\n"
+        "let i = 1\n"
+        "while i <= 10\n"
+        "    total = total + i\n"
+        "    i = 1 + i\n"
+        "end\n"
+        "heal total * 2 - 10 / 5 % 3\n"
+        "if level > 3\n"
+        "    send \"veteran\"\n"
+        "elif level == 1 and not (total != 55)\n"
+        "    send \"rookie\"\n"
+        "else\n"
+        "    send \"other\"\n"
+        "end\n");
+
+    RecordingHost host;
+    ScriptResult result = run_script(script, host, DEFAULT_SCRIPT_BUDGET);
+    EXPECT_FALSE(result.budget_exceeded);
+    EXPECT_FALSE(result.failed);
+    EXPECT_EQ(host.healed, 108);
+    EXPECT_EQ(host.sent, std::vector<std::string>{"rookie"});
+}
+
+TEST(ScriptTest, BudgetStopsRunawayLoops) {
+    auto script = compile_ok("while true\nend\nsend \"unreachable\"\n");
+    RecordingHost host;
+    ScriptResult result = run_script(script, host, 500);
+    EXPECT_TRUE(result.budget_exceeded);
+    EXPECT_EQ(result.instructions, 500u);
+    EXPECT_TRUE(host.sent.empty());
+
+    auto divide = compile_ok("let zero = 0\nheal 1 / zero\n");
+    EXPECT_TRUE(run_script(divide, host, 100).failed);
+}
+
+TEST(ScriptTest, CompileErrorsNameTheLine) {
+    CompiledScript script;
+    std::string error;
+    EXPECT_FALSE(compile_script("send \"hi\"\nif level >\nend\n", 10, script, error));
+    EXPECT_EQ(error, "line 11: expected a value");
+
+    EXPECT_FALSE(compile_script("if level\nsend \"x\"\n", 0, script, error));
+    EXPECT_FALSE(compile_script("let level = 3\n", 0, script, error));
+    EXPECT_FALSE(compile_script("fly\n", 0, script, error));
+    EXPECT_FALSE(compile_script("end\n", 0, script, error));
+}
+
+TEST(ScriptTest, DeepNestingIsACompileError) {
+    CompiledScript script;
+    std::string error;
+    std::string nested = "let x = " + std::string(SCRIPT_MAX_NESTING / 2, '(') + "1" +
+                         std::string(SCRIPT_MAX_NESTING / 2, ')') + "\n";
+    EXPECT_TRUE(compile_script(nested, 0, script, error)) << error;
+
+    std::string parens = "let x = " + std::string(100000, '(') + "1" + std::string(100000, ')') + "\n";
+    EXPECT_FALSE(compile_script(parens, 0, script, error));
+    EXPECT_EQ(error, "line 0: nested too deeply");
+
+    std::string negations = "let x = " + std::string(100000, '-') + "1\n";
+    EXPECT_FALSE(compile_script(negations, 0, script, error));
+    EXPECT_EQ(error, "line 0: nested too deeply");
+
+    std::string blocks;
+    for (int i = 0; i < 1000; ++i) {
+        blocks += "if true\n";
+    }
+    for (int i = 0; i < 1000; ++i) {
+        blocks += "end\n";
+    }
+    EXPECT_FALSE(compile_script(blocks, 0, script, error));
+    EXPECT_NE(error.find("nested too deeply"), std::string::npos);
+}
+
+TEST(ScriptTest, RegistryLoadIsAllOrNothing) {
+    TriggerRegistry registry;
+    std::string error;
+    ASSERT_TRUE(registry.load("# test\non enter 1\n  send \"hi\"\non timer 1 5 budget 50\n  echo \"tick\"\n",
+                              "test", error)) << error;
+    EXPECT_EQ(registry.size(), 2u);
+
+    EXPECT_FALSE(registry.load("on enter 1\n  send \"ok\"\non exit 1 sideways\n", "bad", error));
+    EXPECT_EQ(error, "bad:3: unknown direction 'sideways'");
+    EXPECT_EQ(registry.size(), 2u);
+
+    int fired = 0;
+    auto start = TriggerClock::now();
+    registry.run_due_timers(start, [&](const Trigger&) { ++fired; });
+    registry.run_due_timers(start + std::chrono::seconds(4), [&](const Trigger&) { ++fired; });
+    EXPECT_EQ(fired, 0);
+    registry.run_due_timers(start + std::chrono::seconds(5), [&](const Trigger& trigger) {
+        EXPECT_EQ(trigger.budget, 50u);
+        ++fired;
+    });
+    EXPECT_EQ(fired, 1);
+}
+
+TEST(ScriptTest, TriggersHookMovesAndCommands) {
+    auto world = std::make_shared<GameWorld>();
+    PlayerId player = world->create_player("Rook", CharacterClass::SCOUT, 4);
+    CommandDispatcher dispatcher(world);
+
+    std::string error;
+    ASSERT_TRUE(world->get_triggers().load(
+        "on exit 4 down\n"
+        "  if level < 2\n"
+        "    send \"A guard stops you, $n.\"\n"
+        "    block\n"
+        "  end\n"
+        "on enter 1\n"
+        "  send \"Pigeons scatter.\"\n"
+        "on command 1 look\n"
+        "  send \"You squint.\"\n",
+        "test", error)) << error;
+
+    CommandContext down;
+    down.player = player;
+    dispatcher.dispatch(down, "down");
+    ASSERT_EQ(down.output.size(), 1u);
+    EXPECT_EQ(down.output[0], "A guard stops you, Rook.");
+    EXPECT_EQ(world->get_player(player)->get_current_room_id(), 4);
+
+    CommandContext north;
+    north.player = player;
+    dispatcher.dispatch(north, "north");
+    ASSERT_EQ(north.output.size(), 1u);
+    std::string_view text = north.output[0];
+    EXPECT_EQ(text.substr(text.size() - 17), "\nPigeons scatter.");
+
+    // Not blocked, so the built-in look still runs after the trigger's line
+    CommandContext look;
+    look.player = player;
+    dispatcher.dispatch(look, "look");
+    ASSERT_EQ(look.output.size(), 2u);
+    EXPECT_EQ(look.output[0], "You squint.");
+    tick_arena().reset();
+}
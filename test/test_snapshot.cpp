@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "world_snapshot.hpp"
+#include "epoch.hpp"
+#include "game_world.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace dungeon_merc;
+
+namespace {
+
+struct Counted {
+    explicit Counted(int v, std::atomic<int>& live) : value(v), live_(live) { ++live_; }
+    ~Counted() { --live_; }
+    int value;
+    std::atomic<int>& live_;
+};
+
+std::string render(const std::function<void(ArenaString&)>& fn) {
+    Arena arena;
+    ArenaString out(arena);
+    fn(out);
+    return out.str();
+}
+
+} // namespace
+
+TEST(EpochTest, PinnedReaderKeepsRetiredValueAlive) {
+    std::atomic<int> live{0};
+    {
+        EpochPtr<Counted> ptr;
+        ptr.publish(std::make_unique<Counted>(1, live));
+
+        auto reader = ptr.read();
+        ASSERT_TRUE(reader);
+        EXPECT_EQ(reader->value, 1);
+
+        // Replaced while read: still there until the reader lets go
+        ptr.publish(std::make_unique<Counted>(2, live));
+        EXPECT_EQ(reader->value, 1);
+        EXPECT_EQ(live.load(), 2);
+        EXPECT_EQ(ptr.get_retired_count(), 1u);
+
+        reader = EpochPtr<Counted>::Reader();
+        ptr.publish(std::make_unique<Counted>(3, live));
+        EXPECT_EQ(live.load(), 1);
+        EXPECT_EQ(ptr.get_retired_count(), 0u);
+        EXPECT_EQ(ptr.read()->value, 3);
+    }
+    EXPECT_EQ(live.load(), 0);
+}
+
+TEST(EpochTest, ConcurrentReadersNeverSeeFreedValues) {
+    std::atomic<int> live{0};
+    EpochPtr<Counted> ptr;
+    ptr.publish(std::make_unique<Counted>(0, live));
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            int last = 0;
+            while (!stop.load()) {
+                auto reader = ptr.read();
+                if (!reader) {
+                    continue;
+                }
+                // Values only ever go up; a freed one would read as garbage
+                int value = reader->value;
+                if (value < last) {
+                    ++torn;
+                }
+                last = value;
+            }
+        });
+    }
+
+    for (int i = 1; i <= 20000; ++i) {
+        ptr.publish(std::make_unique<Counted>(i, live));
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+    ptr.publish(std::make_unique<Counted>(-1, live));
+    EXPECT_EQ(ptr.get_retired_count(), 0u);
+    EXPECT_EQ(live.load(), 1);
+}
+
+TEST(WorldSnapshotTest, MatchesLiveOutput) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 1);
+    PlayerId bo = world.create_player("Bo", CharacterClass::GHOST, 1);
+    world.get_player(bo)->gain_experience(500);
+    world.create_player("Cy", CharacterClass::SCOUT, 2);
+
+    std::string look = render([&](ArenaString& out) { world.handle_look_command(ada, out); });
+    std::string players = render([&](ArenaString& out) { world.handle_players_command(ada, out); });
+    std::string who = render([&](ArenaString& out) { world.handle_who_command(WhoFilter(), out); });
+    WhoFilter ghosts;
+    ghosts.any_class = false;
+    ghosts.character_class = CharacterClass::GHOST;
+    std::string who_ghosts = render([&](ArenaString& out) { world.handle_who_command(ghosts, out); });
+    std::string status = render([&](ArenaString& out) { world.handle_status_command(bo, out); });
+
+    world.publish_snapshot();
+    auto snapshot = world.read_snapshot();
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_look(ada, out); }), look);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_players(ada, out); }), players);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_who(WhoFilter(), out); }), who);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_who(ghosts, out); }), who_ghosts);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_status(bo, out); }), status);
+    EXPECT_NE(look.find("Players here: Ada, Bo"), std::string::npos);
+    EXPECT_EQ(snapshot->get_player_count(), 3u);
+
+    // The simulation thread's commands read the snapshot and say the same
+    EXPECT_EQ(render([&](ArenaString& out) { world.handle_look_command(ada, out); }), look);
+    EXPECT_EQ(render([&](ArenaString& out) { world.handle_who_command(WhoFilter(), out); }), who);
+}
+
+TEST(WorldSnapshotTest, UnchangedPartsAreShared) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 1);
+    world.create_player("Bo", CharacterClass::GHOST, 2);
+    world.publish_snapshot();
+
+    auto first = world.read_snapshot();
+    ASSERT_TRUE(first);
+    const RoomView* room1 = first->find_room(1);
+    const RoomView* room2 = first->find_room(2);
+    ASSERT_NE(room1, nullptr);
+    ASSERT_NE(room2, nullptr);
+    uint32_t room1_version = room1->players_version;
+    uint64_t sequence = first->get_sequence();
+    first = EpochPtr<WorldSnapshot>::Reader();
+
+    // An idle tick publishes nothing
+    world.publish_snapshot();
+    EXPECT_EQ(world.read_snapshot()->get_sequence(), sequence);
+
+    // A hit only touches Ada's chunk; both rooms keep their text
+    world.get_player(ada)->take_damage(10);
+    world.publish_snapshot();
+    auto second = world.read_snapshot();
+    EXPECT_GT(second->get_sequence(), sequence);
+    EXPECT_EQ(second->find_room(1), room1);
+    EXPECT_EQ(second->find_room(2), room2);
+    EXPECT_EQ(second->find_player(ada)->get_health(), world.get_player(ada)->get_health());
+    second = EpochPtr<WorldSnapshot>::Reader();
+
+    // Moving re-renders the room Ada left
+    const Room* room = world.find_room(1);
+    Direction exit = room->get_exits().begin()->first;
+    ASSERT_TRUE(world.move_player(ada, exit));
+    world.publish_snapshot();
+    auto third = world.read_snapshot();
+    EXPECT_NE(third->find_room(1)->players_version, room1_version);
+    EXPECT_EQ(third->find_room(1)->description.find("Ada"), std::string::npos);
+    EXPECT_EQ(third->find_player(ada)->get_current_room_id(), room->get_exit_room_id(exit));
+}
+
+TEST(WorldSnapshotTest, StaleSnapshotFallsBackToLiveWorld) {
+    GameWorld world;
+    PlayerId ada = world.create_player("Ada", CharacterClass::TECH, 1);
+    world.publish_snapshot();
+
+    // Someone arrives and someone leaves within the tick: the next 'look' and
+    // 'who' must not wait for the next publish
+    PlayerId bo = world.create_player("Bo", CharacterClass::GHOST, 1);
+    std::string look = render([&](ArenaString& out) { world.handle_look_command(ada, out); });
+    EXPECT_NE(look.find("Bo"), std::string::npos);
+    std::string who = render([&](ArenaString& out) { world.handle_who_command(WhoFilter(), out); });
+    EXPECT_NE(who.find("Mercs online: 2"), std::string::npos);
+
+    world.remove_player(bo);
+    world.publish_snapshot();
+    auto snapshot = world.read_snapshot();
+    EXPECT_EQ(snapshot->find_player(bo), nullptr);
+    EXPECT_EQ(snapshot->get_player_count(), 1u);
+    EXPECT_EQ(render([&](ArenaString& out) { snapshot->render_look(ada, out); }).find("Bo"), std::string::npos);
+}
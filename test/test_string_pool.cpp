@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "string_pool.hpp"
+#include "player.hpp"
+#include "world_region.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace dungeon_merc;
+
+TEST(StringPoolTest, InternDeduplicates) {
+    StringPool pool;
+    EXPECT_EQ(pool.get(EMPTY_STRING_ID), "");
+    EXPECT_EQ(pool.intern(""), EMPTY_STRING_ID);
+
+    StringId ada = pool.intern("Ada");
+    EXPECT_EQ(pool.intern(std::string("Ada")), ada);
+    EXPECT_NE(pool.intern("ada"), ada);
+    EXPECT_EQ(pool.get(ada), "Ada");
+    EXPECT_EQ(pool.size(), 3u);
+
+    // References handed out stay put however much is added later
+    const std::string& name = pool.get(ada);
+    for (int i = 0; i < 10000; ++i) {
+        pool.intern("Merc_" + std::to_string(i));
+    }
+    EXPECT_EQ(&pool.get(ada), &name);
+    EXPECT_EQ(pool.get(pool.intern("Merc_9999")), "Merc_9999");
+    EXPECT_EQ(pool.size(), 10003u);
+    EXPECT_THROW(pool.get(20000), std::out_of_range);
+}
+
+TEST(StringPoolTest, TextRoundTrips) {
+    StringPool pool;
+    const char* const fragments[] = {
+        "Rusted pipes drip onto cracked tiles. ",
+        "A flickering panel shows a map of levels nobody has mapped. ",
+        "Spent casings litter the floor around an overturned desk. ",
+        "The air smells of ozone and old coolant. ",
+    };
+
+    // Enough distinct texts to train a dictionary when zstd is built in
+    std::vector<std::string> texts;
+    std::vector<StringId> ids;
+    size_t raw_bytes = 0;
+    for (int i = 0; i < 600; ++i) {
+        std::string text = "Sector " + std::to_string(i) + ". ";
+        for (int j = 0; j < 6; ++j) {
+            text += fragments[(i + j * (i % 3 + 1)) % 4];
+        }
+        raw_bytes += text.size();
+        ids.push_back(pool.intern_text(text));
+        texts.push_back(std::move(text));
+    }
+
+    Arena arena;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        EXPECT_EQ(pool.copy(ids[i]), texts[i]);
+        EXPECT_EQ(pool.intern_text(texts[i]), ids[i]);
+        ArenaString out(arena);
+        pool.append(ids[i], out);
+        EXPECT_EQ(out.str(), texts[i]);
+        arena.reset();
+    }
+    if (StringPool::compression_available()) {
+        EXPECT_LT(pool.stored_bytes(), raw_bytes / 2);
+    }
+}
+
+TEST(StringPoolTest, ReadersRaceInterning) {
+    StringPool pool;
+    std::vector<StringId> early;
+    for (int i = 0; i < 100; ++i) {
+        early.push_back(pool.intern("early_" + std::to_string(i)));
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (int i = 0; i < 100; ++i) {
+                if (pool.get(early[i]) != "early_" + std::to_string(i)) {
+                    ++mismatches;
+                }
+            }
+        }
+    });
+    for (int i = 0; i < 50000; ++i) {
+        pool.intern("late_" + std::to_string(i));
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(StringPoolTest, GeneratedRoomsShareText) {
+    EXPECT_LE(sizeof(Room), 64u);
+
+    StringPool& pool = StringPool::get_instance();
+    size_t before = pool.size();
+    WorldGenerator generator(WORLD_REGION_ROOMS * 100);
+    std::vector<std::shared_ptr<Room>> rooms;
+    for (int region = 1; region <= 100; ++region) {
+        ASSERT_TRUE(generator.load_region(region, rooms));
+    }
+    ASSERT_EQ(rooms.size(), static_cast<size_t>(WORLD_REGION_ROOMS * 100));
+
+    // Six rooms and four details per theme: a few dozen strings for 6400 rooms
+    size_t interned = pool.size();
+    EXPECT_LE(interned - before, 40u);
+    for (int region = 1; region <= 100; ++region) {
+        generator.load_region(region, rooms);
+    }
+    EXPECT_EQ(pool.size(), interned);
+    EXPECT_EQ(rooms.front()->get_name_id(), rooms[WORLD_REGION_ROOMS * 100]->get_name_id());
+    EXPECT_LE(rooms.front()->get_memory_usage(), 64u);
+}
+
+TEST(StringPoolTest, PlayerNamesStayOutOfThePool) {
+    // Clients choose names, and nothing in the pool is ever freed
+    StringPool& pool = StringPool::get_instance();
+    size_t before = pool.size();
+    for (int i = 0; i < 100; ++i) {
+        Player player("Visitor" + std::to_string(i), CharacterClass::SCOUT);
+        EXPECT_EQ(player.get_name(), "Visitor" + std::to_string(i));
+    }
+    EXPECT_EQ(pool.size(), before);
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include "telnet_server.hpp"
+#include "tls.hpp"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <cstdio>
+
+using namespace dungeon_merc;
+
+namespace {
+
+// Self-signed P-256 certificate and key written to temporary PEM files
+class TestCertificate {
+public:
+    TestCertificate()
+        : cert_file_("/tmp/dungeon_merc_test_cert.pem"), key_file_("/tmp/dungeon_merc_test_key.pem") {
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 60 * 60);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+
+        FILE* out = fopen(cert_file_.c_str(), "w");
+        PEM_write_X509(out, cert);
+        fclose(out);
+        out = fopen(key_file_.c_str(), "w");
+        PEM_write_PrivateKey(out, key, nullptr, nullptr, 0, nullptr, nullptr);
+        fclose(out);
+
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+
+    ~TestCertificate() {
+        std::remove(cert_file_.c_str());
+        std::remove(key_file_.c_str());
+    }
+
+    const std::string& cert_file() const { return cert_file_; }
+    const std::string& key_file() const { return key_file_; }
+
+private:
+    std::string cert_file_;
+    std::string key_file_;
+};
+
+// Drive both ends of a non-blocking handshake until they finish
+bool complete_handshake(TlsSession& server, SSL* client) {
+    for (int round = 0; round < 100; ++round) {
+        TlsHandshake state = server.handshake();
+        int result = SSL_do_handshake(client);
+        if (state == TlsHandshake::FAILED) {
+            return false;
+        }
+        if (state == TlsHandshake::DONE && result == 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read whatever the client can decrypt right now; also picks up session tickets
+std::string client_read(SSL* client) {
+    std::string text;
+    char buffer[512];
+    int bytes;
+    while ((bytes = SSL_read(client, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(bytes));
+    }
+    return text;
+}
+
+struct ClientEnd {
+    int fds[2];
+    SSL* ssl;
+
+    explicit ClientEnd(SSL_CTX* ctx) {
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds);
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fds[1]);
+        SSL_set_connect_state(ssl);
+    }
+
+    ~ClientEnd() {
+        SSL_free(ssl);
+        ::close(fds[1]);
+    }
+};
+
+} // namespace
+
+TEST(TlsTest, RejectsMissingCertificate) {
+    TlsContext context;
+    EXPECT_FALSE(context.load("/nonexistent/cert.pem", "/nonexistent/key.pem"));
+    EXPECT_EQ(context.accept(0), nullptr);
+}
+
+TEST(TlsTest, ConnectionTalksThroughSession) {
+    TestCertificate certificate;
+    TlsContext context;
+    ASSERT_TRUE(context.load(certificate.cert_file(), certificate.key_file()));
+
+    SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+    ClientEnd client(client_ctx);
+    TelnetConnection connection(client.fds[0], "test");
+    ASSERT_TRUE(connection.initialize());
+    auto session = context.accept(client.fds[0]);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(complete_handshake(*session, client.ssl));
+    EXPECT_FALSE(session->is_resumed());
+    connection.set_tls(std::move(session));
+    EXPECT_TRUE(connection.is_encrypted());
+
+    // Lines leave as one framed batch, as they do over plain telnet
+    const std::string_view lines[] = {"Town Square", "Exits: north east south", "> "};
+    ASSERT_TRUE(connection.send_lines(lines, 3));
+    EXPECT_EQ(client_read(client.ssl), "Town Square\r\nExits: north east south\r\n> \r\n");
+
+    const char input[] = "look\r\nsay hi\r\n";
+    ASSERT_EQ(SSL_write(client.ssl, input, sizeof(input) - 1), static_cast<int>(sizeof(input) - 1));
+    EXPECT_GT(connection.read_input(FloodClock::now()), 0);
+    std::string_view line;
+    ASSERT_TRUE(connection.next_line(line));
+    EXPECT_EQ(line, "look");
+    ASSERT_TRUE(connection.next_line(line));
+    EXPECT_EQ(line, "say hi");
+
+    // Nothing waiting is not the same as gone
+    EXPECT_EQ(connection.read_input(FloodClock::now()), 0);
+    SSL_shutdown(client.ssl);
+    EXPECT_EQ(connection.read_input(FloodClock::now()), -1);
+
+    SSL_CTX_free(client_ctx);
+}
+
+TEST(TlsTest, ReturningClientResumes) {
+    TestCertificate certificate;
+    TlsContext context;
+    ASSERT_TRUE(context.load(certificate.cert_file(), certificate.key_file()));
+    SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+
+    SSL_SESSION* saved = nullptr;
+    {
+        ClientEnd client(client_ctx);
+        auto session = context.accept(client.fds[0]);
+        ASSERT_TRUE(complete_handshake(*session, client.ssl));
+        client_read(client.ssl);  // TLS 1.3 tickets arrive after the handshake
+        saved = SSL_get1_session(client.ssl);
+        ASSERT_NE(saved, nullptr);
+        SSL_shutdown(client.ssl);  // OpenSSL won't resume a session that was dropped without one
+        ::close(client.fds[0]);
+    }
+
+    ClientEnd client(client_ctx);
+    SSL_set_session(client.ssl, saved);
+    auto session = context.accept(client.fds[0]);
+    ASSERT_TRUE(complete_handshake(*session, client.ssl));
+    EXPECT_TRUE(session->is_resumed());
+    EXPECT_NE(session->describe().find("resumed"), std::string::npos);
+
+    // Raw writes take the same path as framed lines
+    char data[] = "\xff\xfb\xc9";
+    struct iovec iov = {data, 3};
+    EXPECT_EQ(session->write(&iov, 1), 3);
+    EXPECT_EQ(client_read(client.ssl), std::string(data, 3));
+    ::close(client.fds[0]);
+
+    SSL_SESSION_free(saved);
+    SSL_CTX_free(client_ctx);
+}
+
+TEST(TlsTest, KernelSendKeepsWhatTheSocketRefuses) {
+    TestCertificate certificate;
+    TlsContext context;
+    ASSERT_TRUE(context.load(certificate.cert_file(), certificate.key_file()));
+    char buffer[16384];
+
+    // A short write still accepts everything and keeps the tail
+    {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+        int small = 16 * 1024;
+        setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        auto session = context.accept(fds[0]);
+        ASSERT_NE(session, nullptr);
+        session->force_kernel_send();
+
+        std::string body(100 * 1024, 'x');
+        struct iovec iov = {body.data(), body.size()};
+        EXPECT_EQ(session->write(&iov, 1), static_cast<ssize_t>(body.size()));
+        size_t kept = session->pending_bytes();
+        EXPECT_GT(kept, 0u);
+
+        std::string received;
+        ssize_t bytes;
+        while ((bytes = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            received.append(buffer, static_cast<size_t>(bytes));
+        }
+        EXPECT_EQ(received.size() + kept, body.size());
+        EXPECT_EQ(received, body.substr(0, received.size()));
+        session.reset();
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+
+    // With the socket already full, a write is queued rather than refused
+    {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+        while (send(fds[0], buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+        }
+        auto session = context.accept(fds[0]);
+        ASSERT_NE(session, nullptr);
+        session->force_kernel_send();
+
+        char line[] = "Town Square\r\n";
+        struct iovec iov = {line, 13};
+        EXPECT_EQ(session->write(&iov, 1), 13);
+        EXPECT_EQ(session->pending_bytes(), 13u);
+        session.reset();
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "tokenizer.hpp"
+
+using namespace dungeon_merc;
+
+TEST(TokenizerTest, SplitsWordsAndQuotes) {
+    Tokenizer tokenizer("  give \"rusty key\" 'old  man'  \r\n");
+    EXPECT_EQ(tokenizer.next(), "give");
+    EXPECT_EQ(tokenizer.next(), "rusty key");
+    EXPECT_EQ(tokenizer.next(), "old  man");
+    std::string_view token;
+    EXPECT_FALSE(tokenizer.next(token));
+
+    // An unterminated quote runs to the end of the line
+    Tokenizer unterminated("say \"hello there");
+    EXPECT_EQ(unterminated.next(), "say");
+    EXPECT_EQ(unterminated.next(), "hello there");
+
+    Tokenizer blank("   ");
+    EXPECT_FALSE(blank.next(token));
+}
+
+TEST(TokenizerTest, RestKeepsFreeText) {
+    Tokenizer tokenizer("tell  Bob   meet me at the tavern  ");
+    EXPECT_EQ(tokenizer.next(), "tell");
+    EXPECT_EQ(tokenizer.next(), "Bob");
+    EXPECT_EQ(tokenizer.rest(), "meet me at the tavern");
+    EXPECT_FALSE(tokenizer.at_end());
+
+    Tokenizer empty("look");
+    EXPECT_EQ(empty.next(), "look");
+    EXPECT_TRUE(empty.at_end());
+    EXPECT_EQ(empty.rest(), "");
+    EXPECT_EQ(empty.next(), "");
+}
+
+TEST(TokenizerTest, StrictIntegers) {
+    int value = 0;
+    EXPECT_TRUE(parse_int("-12", value));
+    EXPECT_EQ(value, -12);
+    EXPECT_FALSE(parse_int("12a", value));
+    EXPECT_FALSE(parse_int("", value));
+}
+
+TEST(TokenizerTest, CaseInsensitiveMatching) {
+    EXPECT_TRUE(iequals("NoRtH", "north"));
+    EXPECT_FALSE(iequals("nort", "north"));
+    EXPECT_TRUE(istarts_with("Sword", "sw"));
+    EXPECT_FALSE(istarts_with("sw", "sword"));
+    EXPECT_EQ(icompare("Alice", "aLICE"), 0);
+    EXPECT_LT(icompare("alice", "Bob"), 0);
+    EXPECT_GT(icompare("bob", "Alice"), 0);
+    EXPECT_LT(icompare("Al", "alice"), 0);
+
+    Direction dir;
+    EXPECT_TRUE(parse_direction("D", dir));
+    EXPECT_EQ(dir, Direction::DOWN);
+    EXPECT_FALSE(parse_direction("northward", dir));
+}
@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+#include "trace.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace dungeon_merc;
+
+namespace {
+
+// Just enough of a JSON parser to check that a dump is well formed
+struct JsonValue {
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = Type::NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;       // ARRAY elements, or OBJECT values
+    std::vector<std::string> keys;      // OBJECT keys, parallel to items
+
+    const JsonValue* get(const std::string& key) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) {
+                return &items[i];
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(std::string_view text) : text_(text), pos_(0) {}
+
+    bool parse(JsonValue& value) {
+        return parse_value(value) && (skip_space(), pos_ == text_.size());
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_;
+
+    void skip_space() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' ||
+                                       text_[pos_] == '\r' || text_[pos_] == '\t')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        skip_space();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool literal(std::string_view word) {
+        if (text_.substr(pos_, word.size()) != word) {
+            return false;
+        }
+        pos_ += word.size();
+        return true;
+    }
+
+    bool parse_value(JsonValue& value) {
+        skip_space();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            value.type = JsonValue::Type::OBJECT;
+            ++pos_;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                value.keys.emplace_back();
+                value.items.emplace_back();
+                skip_space();
+                if (!parse_string(value.keys.back()) || !consume(':') || !parse_value(value.items.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::ARRAY;
+            ++pos_;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                value.items.emplace_back();
+                if (!parse_value(value.items.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            return parse_string(value.string);
+        }
+        if (c == 't' || c == 'f') {
+            value.type = JsonValue::Type::BOOL;
+            value.boolean = c == 't';
+            return literal(value.boolean ? "true" : "false");
+        }
+        if (c == 'n') {
+            return literal("null");
+        }
+        std::string number(text_.substr(pos_, 64));
+        char* end = nullptr;
+        value.type = JsonValue::Type::NUMBER;
+        value.number = std::strtod(number.c_str(), &end);
+        if (end == number.c_str()) {
+            return false;
+        }
+        pos_ += static_cast<size_t>(end - number.c_str());
+        return true;
+    }
+
+    bool parse_string(std::string& out) {
+        if (pos_ >= text_.size() || text_[pos_] != '"') {
+            return false;
+        }
+        ++pos_;
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return false;  // Raw control characters are not allowed in JSON strings
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            char escape = text_[pos_++];
+            switch (escape) {
+                case '"': case '\\': case '/': out += escape; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) {
+                        return false;
+                    }
+                    unsigned long code = std::strtoul(std::string(text_.substr(pos_, 4)).c_str(), nullptr, 16);
+                    if (code >= 0x80) {
+                        return false;  // The dumper only escapes ASCII
+                    }
+                    out += static_cast<char>(code);
+                    pos_ += 4;
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+TEST(TraceTest, WrappedBufferKeepsNewestEventsInOrder) {
+    ThreadTraceBuffer buffer(1);
+    const uint64_t total = TRACE_BUFFER_EVENTS + 100;
+    for (uint64_t i = 0; i < total; ++i) {
+        buffer.push("event", i, i * 3);
+    }
+
+    std::vector<TraceEvent> events;
+    buffer.snapshot(events);
+    ASSERT_EQ(events.size(), TRACE_BUFFER_EVENTS);
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].start_ns, 100 + i);
+        EXPECT_EQ(events[i].duration_ns, (100 + i) * 3);
+    }
+
+    // clear() hides everything so far; later events show up alone
+    buffer.clear();
+    events.clear();
+    buffer.snapshot(events);
+    EXPECT_TRUE(events.empty());
+    buffer.push("after", 7, 1);
+    buffer.snapshot(events);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_STREQ(events[0].name, "after");
+}
+
+TEST(TraceTest, SnapshotDropsEventsLappedWhileCopying) {
+    static const char* const names[] = {"even", "odd"};
+    ThreadTraceBuffer buffer(1);
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> pushed(0);
+
+    // Every field of an event is derived from its sequence number, so a slot
+    // read half-way through being rewritten shows up as a mismatch
+    std::thread owner([&] {
+        uint64_t i = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            buffer.push(names[i % 2], i, i * 3);
+            pushed.store(++i, std::memory_order_relaxed);
+        }
+    });
+    while (pushed.load(std::memory_order_relaxed) < 2 * TRACE_BUFFER_EVENTS) {
+        std::this_thread::yield();
+    }
+
+    std::vector<TraceEvent> events;
+    for (int round = 0; round < 20; ++round) {
+        events.clear();
+        buffer.snapshot(events);
+        ASSERT_LE(events.size(), TRACE_BUFFER_EVENTS);
+        for (size_t i = 0; i < events.size(); ++i) {
+            const TraceEvent& event = events[i];
+            ASSERT_EQ(event.duration_ns, event.start_ns * 3) << "torn event at " << i;
+            ASSERT_EQ(event.name, names[event.start_ns % 2]) << "torn event at " << i;
+            if (i > 0) {
+                ASSERT_EQ(event.start_ns, events[i - 1].start_ns + 1) << "gap at " << i;
+            }
+        }
+    }
+
+    stop.store(true);
+    owner.join();
+}
+
+TEST(TraceTest, DumpIsValidJson) {
+    TraceRecorder& recorder = TraceRecorder::get_instance();
+    const std::string awkward = "tab\there \"quoted\" back\\slash\x01\x1f";
+
+    recorder.start();
+    recorder.record("tick", 2000, 1500);
+    recorder.record(recorder.intern(awkward), 4000, 500);
+    recorder.stop();
+
+    std::string path = "test_trace_dump.json";
+    ASSERT_EQ(recorder.dump(path), 2);
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::remove(path.c_str());
+
+    JsonValue root;
+    ASSERT_TRUE(JsonParser(contents.str()).parse(root)) << contents.str();
+    const JsonValue* events = root.get("traceEvents");
+    ASSERT_NE(events, nullptr);
+    ASSERT_EQ(events->type, JsonValue::Type::ARRAY);
+    ASSERT_EQ(events->items.size(), 2u);
+
+    const JsonValue& tick = events->items[0];
+    ASSERT_NE(tick.get("name"), nullptr);
+    EXPECT_EQ(tick.get("name")->string, "tick");
+    EXPECT_EQ(tick.get("ph")->string, "X");
+    EXPECT_DOUBLE_EQ(tick.get("ts")->number, 2.0);
+    EXPECT_DOUBLE_EQ(tick.get("dur")->number, 1.5);
+
+    // Quotes, backslashes and control characters survive the round trip
+    EXPECT_EQ(events->items[1].get("name")->string, awkward);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "world_region.hpp"
+#include "game_world.hpp"
+#include "command_dispatcher.hpp"
+
+using namespace dungeon_merc;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Room* find_loaded(const std::vector<std::shared_ptr<Room>>& rooms, int room_id) {
+    for (const auto& room : rooms) {
+        if (room->get_id() == room_id) {
+            return room.get();
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(WorldGeneratorTest, RegionsAreRepeatableAndConnected) {
+    WorldGenerator generator(200);
+    EXPECT_TRUE(generator.has_room(1));
+    EXPECT_FALSE(generator.has_room(6));
+    EXPECT_TRUE(generator.has_room(WorldGenerator::FIRST_GENERATED_ROOM + 199));
+    EXPECT_FALSE(generator.has_room(WorldGenerator::FIRST_GENERATED_ROOM + 200));
+
+    std::vector<std::shared_ptr<Room>> start;
+    ASSERT_TRUE(generator.load_region(0, start));
+    ASSERT_EQ(start.size(), 5u);
+    EXPECT_EQ(find_loaded(start, 5)->get_exit_room_id(Direction::DOWN), WorldGenerator::FIRST_GENERATED_ROOM);
+
+    std::vector<std::shared_ptr<Room>> first;
+    std::vector<std::shared_ptr<Room>> again;
+    ASSERT_TRUE(generator.load_region(1, first));
+    ASSERT_TRUE(generator.load_region(1, again));
+    ASSERT_EQ(first.size(), static_cast<size_t>(WORLD_REGION_ROOMS));
+    for (size_t i = 0; i < first.size(); ++i) {
+        EXPECT_EQ(first[i]->get_name(), again[i]->get_name());
+        EXPECT_EQ(first[i]->get_description(), again[i]->get_description());
+    }
+    EXPECT_EQ(find_loaded(first, WorldGenerator::FIRST_GENERATED_ROOM)->get_exit_room_id(Direction::UP), 5);
+
+    // Every exit leads to a room that exists and has a way back
+    for (int region = 1; region <= region_of(WorldGenerator::FIRST_GENERATED_ROOM + 199); ++region) {
+        std::vector<std::shared_ptr<Room>> rooms;
+        ASSERT_TRUE(generator.load_region(region, rooms));
+        for (const auto& room : rooms) {
+            for (const auto& exit : room->get_exits()) {
+                EXPECT_TRUE(generator.has_room(exit.second)) << room->get_id();
+            }
+        }
+    }
+    std::vector<std::shared_ptr<Room>> beyond;
+    EXPECT_FALSE(generator.load_region(10, beyond));
+
+    // Without generated rooms the chamber is a dead end, as it always was
+    WorldGenerator plain;
+    std::vector<std::shared_ptr<Room>> hub;
+    ASSERT_TRUE(plain.load_region(0, hub));
+    EXPECT_FALSE(find_loaded(hub, 5)->has_exit(Direction::DOWN));
+}
+
+TEST(WorldGeneratorTest, LargestWorldStaysWithinRoomIds) {
+    WorldGenerator generator(INT_MAX);
+    EXPECT_EQ(generator.get_generated_rooms(), WorldGenerator::MAX_GENERATED_ROOMS);
+
+    int last = WorldGenerator::FIRST_GENERATED_ROOM + WorldGenerator::MAX_GENERATED_ROOMS - 1;
+    EXPECT_TRUE(generator.has_room(last));
+    EXPECT_FALSE(generator.has_room(last + 1));
+    std::vector<std::shared_ptr<Room>> rooms;
+    ASSERT_TRUE(generator.load_region(region_of(last), rooms));
+    ASSERT_NE(find_loaded(rooms, last), nullptr);
+    for (const auto& room : rooms) {
+        for (const auto& exit : room->get_exits()) {
+            EXPECT_TRUE(generator.has_room(exit.second)) << room->get_id();
+        }
+    }
+}
+
+TEST(WorldRegionTest, RegionsLoadOnFirstEntry) {
+    GameWorld world;
+    world.set_region_source(std::make_unique<WorldGenerator>(100000));
+    EXPECT_EQ(world.get_resident_regions(), 1u);
+    EXPECT_NE(world.find_room(1), nullptr);
+
+    const int deep = WorldGenerator::FIRST_GENERATED_ROOM;
+    EXPECT_TRUE(world.is_valid_room_id(deep + 99999));
+    EXPECT_EQ(world.find_room(deep), nullptr);
+
+    PlayerId ada = world.create_player("Ada", CharacterClass::SCOUT, 5);
+    ASSERT_TRUE(world.move_player(ada, Direction::DOWN));
+    EXPECT_EQ(world.get_resident_regions(), 2u);
+    ASSERT_NE(world.find_room(deep), nullptr);
+    EXPECT_EQ(world.find_player_room(ada)->get_id(), deep);
+
+    // Straight into the far end of the world, and back out of it
+    ASSERT_TRUE(world.place_player(ada, deep + 99999));
+    EXPECT_EQ(world.get_resident_regions(), 3u);
+    EXPECT_FALSE(world.place_player(ada, deep + 100000));
+    EXPECT_EQ(world.find_player_room(ada)->get_id(), deep + 99999);
+}
+
+TEST(WorldRegionTest, IdleRegionsEvictAndResume) {
+    GameWorld world;
+    world.set_region_source(std::make_unique<WorldGenerator>(1000));
+    world.set_region_limits(0, std::chrono::seconds(60));
+    const int deep = WorldGenerator::FIRST_GENERATED_ROOM;
+
+    PlayerId ada = world.create_player("Ada", CharacterClass::SCOUT, 5);
+    ASSERT_TRUE(world.move_player(ada, Direction::DOWN));
+    ASSERT_TRUE(world.move_player(ada, Direction::UP));
+    uint32_t version = world.find_room(deep)->get_players_version();
+    world.publish_snapshot();
+
+    // Not idle long enough yet
+    Clock::time_point now = Clock::now();
+    world.evict_idle_regions(now);
+    EXPECT_EQ(world.get_resident_regions(), 2u);
+
+    world.evict_idle_regions(now + std::chrono::seconds(61));
+    EXPECT_EQ(world.get_resident_regions(), 1u);  // The hub is occupied
+    EXPECT_EQ(world.find_room(deep), nullptr);
+    EXPECT_NE(world.find_room(5), nullptr);
+    world.publish_snapshot();
+    {
+        auto snapshot = world.read_snapshot();
+        EXPECT_EQ(snapshot->find_room(deep), nullptr);
+        EXPECT_NE(snapshot->find_room(5), nullptr);
+    }
+
+    // Coming back picks up the version where it left off
+    ASSERT_TRUE(world.move_player(ada, Direction::DOWN));
+    EXPECT_EQ(world.find_room(deep)->get_players_version(), version + 1);
+    EXPECT_EQ(world.find_room(deep)->get_players().size(), 1u);
+}
+
+TEST(WorldRegionTest, BudgetEvictsLeastRecentlyUsed) {
+    GameWorld world;
+    world.set_region_source(std::make_unique<WorldGenerator>(1000));
+    const int deep = WorldGenerator::FIRST_GENERATED_ROOM;
+    PlayerId ada = world.create_player("Ada", CharacterClass::SCOUT, 1);
+    size_t hub_bytes = world.get_resident_bytes();
+    EXPECT_GT(hub_bytes, 0u);
+
+    // Room for about one region, with no idle timeout to speak of
+    world.set_region_limits(hub_bytes * 2, std::chrono::seconds(3600));
+    for (int region = 1; region <= 5; ++region) {
+        ASSERT_TRUE(world.place_player(ada, region * WORLD_REGION_ROOMS));
+        // Loading never evicts; the end of the tick brings the world back under budget
+        EXPECT_TRUE(world.needs_region_eviction());
+        world.evict_idle_regions(Clock::now());
+        EXPECT_EQ(world.get_resident_regions(), 1u);
+    }
+    EXPECT_FALSE(world.needs_region_eviction());
+    EXPECT_NE(world.find_room(5 * WORLD_REGION_ROOMS), nullptr);
+    EXPECT_EQ(world.find_room(deep), nullptr);
+
+    // Hand-placed rooms are never evicted
+    world.add_room(std::make_shared<Room>(deep + 1, "Vault", "A vault."));
+    world.set_region_limits(1, std::chrono::seconds(0));
+    world.evict_idle_regions(Clock::now());
+    EXPECT_NE(world.find_room(deep + 1), nullptr);
+}
+
+TEST(WorldRegionTest, TriggerRoomOutlivesTeleportsOverBudget) {
+    auto world = std::make_shared<GameWorld>();
+    world->set_region_source(std::make_unique<WorldGenerator>(1000));
+    const int deep = WorldGenerator::FIRST_GENERATED_ROOM;
+    PlayerId ada = world->create_player("Ada", CharacterClass::SCOUT, deep);
+    PlayerId bo = world->create_player("Bo", CharacterClass::TECH, deep + 2 * WORLD_REGION_ROOMS);
+    world->set_region_limits(1, std::chrono::seconds(3600));
+
+    // The first teleport empties the trigger's region and the second loads
+    // another one over budget; the script still uses its own room afterwards
+    std::string error;
+    ASSERT_TRUE(world->get_triggers().load(
+        "on command " + std::to_string(deep) + " pray\n"
+        "  teleport " + std::to_string(deep + 2 * WORLD_REGION_ROOMS) + "\n"
+        "  teleport " + std::to_string(deep + 4 * WORLD_REGION_ROOMS) + "\n"
+        "  echo \"The altar hums.\"\n"
+        "  if players == 0\n"
+        "    send \"The altar falls silent behind you.\"\n"
+        "  end\n"
+        "  block\n",
+        "test", error)) << error;
+
+    CommandDispatcher dispatcher(world);
+    CommandContext pray;
+    pray.player = ada;
+    dispatcher.dispatch(pray, "pray");
+    EXPECT_EQ(world->get_player(ada)->get_current_room_id(), deep + 4 * WORLD_REGION_ROOMS);
+    ASSERT_EQ(pray.output.size(), 1u);
+    EXPECT_EQ(pray.output[0], "The altar falls silent behind you.");
+    EXPECT_NE(world->find_room(deep), nullptr);
+    EXPECT_TRUE(world->needs_region_eviction());
+    tick_arena().reset();
+
+    // Between ticks the emptied region goes; the occupied ones stay
+    world->evict_idle_regions(Clock::now());
+    EXPECT_EQ(world->find_room(deep), nullptr);
+    EXPECT_NE(world->find_room(deep + 2 * WORLD_REGION_ROOMS), nullptr);
+    EXPECT_NE(world->find_room(deep + 4 * WORLD_REGION_ROOMS), nullptr);
+    (void)bo;
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "zone_server.hpp"
+#include "zone_gateway.hpp"
+#include "telnet_server.hpp"
+#include <sys/socket.h>
+
+using namespace dungeon_merc;
+
+namespace {
+
+std::string read_all(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        text.append(buffer, static_cast<size_t>(n));
+    }
+    return text;
+}
+
+} // namespace
+
+TEST(ZoneTest, ZoneMapAssignsRooms) {
+    ZoneMap map;
+    std::string error;
+    ASSERT_TRUE(map.parse("1-3+9, 4-5", error)) << error;
+    EXPECT_EQ(map.zone_count(), 2u);
+    EXPECT_EQ(map.zone_of(2), 0);
+    EXPECT_EQ(map.zone_of(9), 0);
+    EXPECT_EQ(map.zone_of(4), 1);
+    EXPECT_EQ(map.zone_of(42), 0);
+
+    EXPECT_FALSE(map.parse("1-3,3-5", error));
+    EXPECT_FALSE(map.parse("5-1", error));
+    EXPECT_FALSE(map.parse("1-x", error));
+    EXPECT_EQ(map.zone_count(), 2u);
+}
+
+TEST(ZoneTest, FramesSurviveTheSocket) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ZoneLink sender(fds[0]);
+    ZoneLink receiver(fds[1]);
+
+    CopyoverConnection record;
+    record.player_name = "Rook";
+    record.character_class = CharacterClass::TECH;
+    record.health = 33;
+    record.max_health = 90;
+    record.level = 4;
+    record.experience = 250;
+    record.room_id = 5;
+    record.channels = {"ooc", "trade"};
+    record.items = {ItemStack{2, 48, 0}, ItemStack{6, 1, ITEM_MOD_SUPPRESSOR}};
+
+    FrameWriter handoff(sender.output(), ZoneMessage::HANDOFF, 0x1122334455667788ULL);
+    write_player_record(handoff, record);
+    handoff.finish();
+    FrameWriter command(sender.output(), ZoneMessage::COMMAND, 7);
+    command.str("say hi");
+    command.finish();
+    ASSERT_TRUE(sender.flush());
+
+    ASSERT_TRUE(receiver.read());
+    ZoneFrame frame;
+    ASSERT_TRUE(receiver.next_frame(frame));
+    EXPECT_EQ(frame.type, ZoneMessage::HANDOFF);
+    EXPECT_EQ(frame.session, 0x1122334455667788ULL);
+    FrameReader reader(frame.payload);
+    CopyoverConnection decoded;
+    ASSERT_TRUE(read_player_record(reader, decoded));
+    EXPECT_TRUE(reader.at_end());
+    EXPECT_EQ(decoded.player_name, "Rook");
+    EXPECT_EQ(decoded.character_class, CharacterClass::TECH);
+    EXPECT_EQ(decoded.health, 33);
+    EXPECT_EQ(decoded.experience, 250);
+    EXPECT_EQ(decoded.room_id, 5);
+    EXPECT_EQ(decoded.channels, record.channels);
+    ASSERT_EQ(decoded.items.size(), 2u);
+    EXPECT_EQ(decoded.items[0].count, 48);
+    EXPECT_EQ(decoded.items[1].mods, ITEM_MOD_SUPPRESSOR);
+
+    ASSERT_TRUE(receiver.next_frame(frame));
+    std::string_view line;
+    FrameReader command_reader(frame.payload);
+    ASSERT_TRUE(command_reader.str(line));
+    EXPECT_EQ(line, "say hi");
+    EXPECT_FALSE(receiver.next_frame(frame));
+
+    // A truncated payload fails instead of reading past the end
+    FrameReader short_reader(frame.payload.substr(0, 3));
+    EXPECT_FALSE(short_reader.str(line));
+    EXPECT_FALSE(short_reader.ok());
+}
+
+TEST(ZoneTest, GatewayHandsPlayersBetweenZones) {
+    ZoneMap map;
+    std::string error;
+    ASSERT_TRUE(map.parse("1-3,4-5", error));
+
+    std::shared_ptr<GameWorld> worlds[2];
+    std::unique_ptr<ZoneServer> zones[2];
+    ZoneGateway gateway(map);
+    for (int zone = 0; zone < 2; ++zone) {
+        worlds[zone] = std::make_shared<GameWorld>();
+        worlds[zone]->set_zone(map, zone);
+        zones[zone] = std::make_unique<ZoneServer>(worlds[zone], zone);
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        gateway.add_zone_link(fds[0]);
+        zones[zone]->add_link(fds[1]);
+    }
+
+    int client[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, client), 0);
+    auto connection = std::make_shared<TelnetConnection>(client[0], "test");
+    ASSERT_TRUE(connection->initialize());
+    connection->set_id(1);
+
+    auto pump = [&]() {
+        for (int round = 0; round < 4; ++round) {
+            gateway.poll();
+            zones[0]->poll(std::chrono::milliseconds(0));
+            zones[1]->poll(std::chrono::milliseconds(0));
+            zones[0]->flush_notices();
+            zones[1]->flush_notices();
+        }
+        tick_arena().reset();
+    };
+
+    gateway.attach(connection, "Rook", CharacterClass::SCOUT);
+    pump();
+    EXPECT_EQ(zones[0]->get_session_count(), 1u);
+
+    // Room 1 is zone 0 and room 4 is zone 1
+    gateway.forward(1, "south");
+    gateway.forward(1, "look");
+    pump();
+    EXPECT_EQ(zones[0]->get_session_count(), 0u);
+    EXPECT_EQ(zones[1]->get_session_count(), 1u);
+    EXPECT_EQ(worlds[0]->get_players().size(), 0u);
+    PlayerId rook = worlds[1]->find_player_by_name("Rook");
+    ASSERT_TRUE(rook.is_valid());
+    EXPECT_EQ(worlds[1]->get_player(rook)->get_current_room_id(), 4);
+
+    std::string text = read_all(client[1]);
+    size_t moved = text.find("You move south.");
+    ASSERT_NE(moved, std::string::npos);
+    size_t arrived = text.find("Dungeon Entrance", moved);
+    ASSERT_NE(arrived, std::string::npos);
+    // 'look' raced the handoff, was rerouted and still answered from the new zone
+    EXPECT_NE(text.find("Dungeon Entrance", arrived + 1), std::string::npos);
+
+    gateway.detach(1);
+    pump();
+    EXPECT_EQ(zones[1]->get_session_count(), 0u);
+    EXPECT_EQ(worlds[1]->get_players().size(), 0u);
+    close(client[1]);
+}
@@ -0,0 +1,370 @@
+// Headless bot swarm for end-to-end throughput and tail latency testing.
+//
+// Opens many concurrent telnet connections to a running server, waits for
+// the welcome prompt, then has every bot walk the room graph with a mix of
+// 'look', movement and 'players'. Latency is measured from the moment a
+// command is written until the "> " prompt for it arrives.
+
+#include "common.hpp"
+#include "metrics.hpp"
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <cstring>
+#include <iomanip>
+
+using namespace dungeon_merc;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// What the server sends after every response
+const std::string PROMPT = "> \r\n";
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = DEFAULT_PORT;
+    int bots = 100;
+    int connect_rate = 500;   // New connections per second
+    double duration = 30.0;   // Seconds of measured load after ramp-up
+    double warmup = 2.0;      // Seconds excluded from the results
+    int think_ms = 0;         // Pause between a prompt and the next command
+    uint32_t seed = 1;
+};
+
+enum class BotState {
+    CONNECTING,
+    WAITING_WELCOME,
+    WAITING_RESPONSE,
+    THINKING,
+    CLOSED
+};
+
+struct Bot {
+    int fd = -1;
+    BotState state = BotState::CONNECTING;
+    std::string input;
+    std::string pending_command;
+    std::vector<std::string> exits;
+    Clock::time_point sent_at;
+    Clock::time_point wake_at;
+    size_t step = 0;
+};
+
+struct LoadStats {
+    uint64_t commands = 0;
+    uint64_t connect_failures = 0;
+    uint64_t disconnects = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    LatencyHistogram latency;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Dungeon Merc load generator\n";
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -H, --host HOST        Server address (default: 127.0.0.1)\n";
+    std::cout << "  -p, --port PORT        Server port (default: " << DEFAULT_PORT << ")\n";
+    std::cout << "  -b, --bots NUM         Concurrent bots (default: 100)\n";
+    std::cout << "  -r, --rate NUM         New connections per second (default: 500)\n";
+    std::cout << "  -t, --duration SEC     Measured run time (default: 30)\n";
+    std::cout << "  -w, --warmup SEC       Time excluded from results (default: 2)\n";
+    std::cout << "  -k, --think MS         Pause between commands per bot (default: 0)\n";
+    std::cout << "  -s, --seed NUM         Random seed for bot behaviour (default: 1)\n";
+    std::cout << "  -h, --help             Show this help message\n";
+}
+
+LoadConfig parse_arguments(int argc, char* argv[]) {
+    LoadConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next_value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Value required after " << arg << "\n";
+                exit(1);
+            }
+            return argv[++i];
+        };
+
+        try {
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                exit(0);
+            } else if (arg == "-H" || arg == "--host") {
+                config.host = next_value();
+            } else if (arg == "-p" || arg == "--port") {
+                config.port = std::stoi(next_value());
+            } else if (arg == "-b" || arg == "--bots") {
+                config.bots = std::stoi(next_value());
+            } else if (arg == "-r" || arg == "--rate") {
+                config.connect_rate = std::max(1, std::stoi(next_value()));
+            } else if (arg == "-t" || arg == "--duration") {
+                config.duration = std::stod(next_value());
+            } else if (arg == "-w" || arg == "--warmup") {
+                config.warmup = std::stod(next_value());
+            } else if (arg == "-k" || arg == "--think") {
+                config.think_ms = std::stoi(next_value());
+            } else if (arg == "-s" || arg == "--seed") {
+                config.seed = static_cast<uint32_t>(std::stoul(next_value()));
+            } else {
+                std::cerr << "Unknown argument: " << arg << "\n";
+                exit(1);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << "\n";
+            exit(1);
+        }
+    }
+
+    return config;
+}
+
+// Thousands of sockets need more than the usual 1024 descriptors
+void raise_fd_limit(int wanted) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    rlim_t target = std::min<rlim_t>(limit.rlim_max, static_cast<rlim_t>(wanted) + 64);
+    if (limit.rlim_cur < target) {
+        limit.rlim_cur = target;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int start_connect(const sockaddr_in& address) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Pull the exit names out of the "Exits: north, down" line of a room description
+void update_exits(Bot& bot, const std::string& text) {
+    size_t pos = text.rfind("Exits: ");
+    if (pos == std::string::npos) {
+        return;
+    }
+    size_t end = text.find_first_of("\r\n", pos);
+    bot.exits = split(text.substr(pos + 7, end - pos - 7), ',');
+}
+
+std::string next_command(Bot& bot, std::mt19937& rng) {
+    // look, move, players, move, ... so every bot keeps wandering
+    size_t step = bot.step++;
+    if (step % 4 == 0) {
+        return "look";
+    }
+    if (step % 4 == 2) {
+        return "players";
+    }
+    if (bot.exits.empty()) {
+        return "look";
+    }
+    std::uniform_int_distribution<size_t> pick(0, bot.exits.size() - 1);
+    return bot.exits[pick(rng)];
+}
+
+bool send_command(Bot& bot, const std::string& command, LoadStats& stats) {
+    std::string line = command + "\r\n";
+    ssize_t written = send(bot.fd, line.data(), line.size(), MSG_NOSIGNAL);
+    if (written != static_cast<ssize_t>(line.size())) {
+        return false;
+    }
+    stats.bytes_out += static_cast<uint64_t>(written);
+    bot.pending_command = command;
+    bot.sent_at = Clock::now();
+    bot.state = BotState::WAITING_RESPONSE;
+    return true;
+}
+
+void close_bot(Bot& bot, int epoll_fd) {
+    if (bot.fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, bot.fd, nullptr);
+        ::close(bot.fd);
+        bot.fd = -1;
+    }
+    bot.state = BotState::CLOSED;
+}
+
+std::string format_us(uint64_t ns) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << (ns / 1000.0) << " us";
+    return ss.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadConfig config = parse_arguments(argc, argv);
+    raise_fd_limit(config.bots);
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+    if (inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Invalid host address: " << config.host << "\n";
+        return 1;
+    }
+
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        std::cerr << "epoll_create1 failed: " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::vector<Bot> bots(static_cast<size_t>(config.bots));
+    std::mt19937 rng(config.seed);
+    LoadStats stats;
+
+    auto start = Clock::now();
+    auto ramp_end = start + std::chrono::milliseconds(1000LL * config.bots / config.connect_rate);
+    auto measure_start = ramp_end + std::chrono::milliseconds(static_cast<int64_t>(config.warmup * 1000));
+    auto stop = measure_start + std::chrono::milliseconds(static_cast<int64_t>(config.duration * 1000));
+    size_t connected = 0;
+    size_t next_bot = 0;
+
+    std::cout << "Ramping " << config.bots << " bots to " << config.host << ":" << config.port
+              << " at " << config.connect_rate << "/s\n";
+
+    std::vector<epoll_event> events(1024);
+    char buffer[16384];
+
+    while (Clock::now() < stop) {
+        auto now = Clock::now();
+
+        // Open connections at the configured rate
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+        size_t due = std::min(bots.size(), static_cast<size_t>(elapsed_ms * config.connect_rate / 1000 + 1));
+        while (next_bot < due) {
+            Bot& bot = bots[next_bot];
+            bot.fd = start_connect(address);
+            if (bot.fd < 0) {
+                stats.connect_failures++;
+                bot.state = BotState::CLOSED;
+            } else {
+                epoll_event ev;
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+                ev.data.u64 = next_bot;
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bot.fd, &ev);
+            }
+            next_bot++;
+        }
+
+        // Wake bots whose think time is over
+        for (auto& bot : bots) {
+            if (bot.state == BotState::THINKING && now >= bot.wake_at) {
+                if (!send_command(bot, next_command(bot, rng), stats)) {
+                    stats.disconnects++;
+                    close_bot(bot, epoll_fd);
+                }
+            }
+        }
+
+        int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 1);
+        for (int i = 0; i < ready; ++i) {
+            Bot& bot = bots[events[i].data.u64];
+            if (bot.fd < 0) {
+                continue;
+            }
+
+            if (bot.state == BotState::CONNECTING) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(bot.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error != 0) {
+                    stats.connect_failures++;
+                    close_bot(bot, epoll_fd);
+                    continue;
+                }
+
+                // Connected; from now on only input matters
+                epoll_event ev;
+                ev.events = EPOLLIN | EPOLLRDHUP;
+                ev.data.u64 = events[i].data.u64;
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, bot.fd, &ev);
+                bot.state = BotState::WAITING_WELCOME;
+                connected++;
+            }
+
+            if (!(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                continue;
+            }
+
+            ssize_t bytes_read = recv(bot.fd, buffer, sizeof(buffer), 0);
+            if (bytes_read <= 0) {
+                if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    continue;
+                }
+                stats.disconnects++;
+                close_bot(bot, epoll_fd);
+                continue;
+            }
+            stats.bytes_in += static_cast<uint64_t>(bytes_read);
+            bot.input.append(buffer, static_cast<size_t>(bytes_read));
+
+            size_t prompt = bot.input.find(PROMPT);
+            if (prompt == std::string::npos) {
+                continue;
+            }
+
+            auto arrived = Clock::now();
+            if (bot.state == BotState::WAITING_RESPONSE) {
+                if (arrived >= measure_start) {
+                    stats.commands++;
+                    stats.latency.record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(arrived - bot.sent_at).count()));
+                }
+                update_exits(bot, bot.input.substr(0, prompt));
+            }
+            bot.input.erase(0, prompt + PROMPT.size());
+
+            if (config.think_ms > 0) {
+                bot.state = BotState::THINKING;
+                bot.wake_at = arrived + std::chrono::milliseconds(config.think_ms);
+            } else if (!send_command(bot, next_command(bot, rng), stats)) {
+                stats.disconnects++;
+                close_bot(bot, epoll_fd);
+            }
+        }
+    }
+
+    for (auto& bot : bots) {
+        close_bot(bot, epoll_fd);
+    }
+    ::close(epoll_fd);
+
+    double seconds = config.duration > 0 ? config.duration : 1.0;
+    std::cout << "Bots connected:     " << connected << " / " << config.bots << "\n";
+    std::cout << "Connect failures:   " << stats.connect_failures << "\n";
+    std::cout << "Disconnects:        " << stats.disconnects << "\n";
+    std::cout << "Commands measured:  " << stats.commands << "\n";
+    std::cout << "Throughput:         " << std::fixed << std::setprecision(1)
+              << (stats.commands / seconds) << " commands/s\n";
+    std::cout << "Bytes in/out:       " << stats.bytes_in << " / " << stats.bytes_out << "\n";
+    std::cout << "Latency p50:        " << format_us(stats.latency.percentile(50.0)) << "\n";
+    std::cout << "Latency p99:        " << format_us(stats.latency.percentile(99.0)) << "\n";
+    std::cout << "Latency p999:       " << format_us(stats.latency.percentile(99.9)) << "\n";
+    std::cout << "Latency max:        " << format_us(stats.latency.max()) << "\n";
+
+    return stats.connect_failures == 0 && stats.disconnects == 0 ? 0 : 2;
+}
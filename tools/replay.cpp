@@ -0,0 +1,219 @@
+// Offline replay of a command trace recorded with dungeon_merc --record.
+//
+// Feeds every recorded command straight into a GameWorld and the command
+// dispatcher with no sockets and no pacing, so the run is CPU bound and
+// repeatable. The random generator is seeded from the trace, and a digest of
+// all output is printed so two builds can be checked for identical behaviour.
+
+#include "common.hpp"
+#include "command_dispatcher.hpp"
+#include "command_trace.hpp"
+#include "game_world.hpp"
+#include "metrics.hpp"
+#include <iomanip>
+
+using namespace dungeon_merc;
+
+namespace {
+
+struct ReplayConfig {
+    std::string trace_file;
+    int repeat = 1;
+    bool print_output = false;
+    bool print_stats = false;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Dungeon Merc command trace replay\n";
+    std::cout << "Usage: " << program_name << " [OPTIONS] TRACE_FILE\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -n, --repeat NUM       Replay the trace NUM times (default: 1)\n";
+    std::cout << "  -o, --output           Print every response line\n";
+    std::cout << "  -s, --stats            Print per-command latency histograms\n";
+    std::cout << "  -h, --help             Show this help message\n";
+}
+
+ReplayConfig parse_arguments(int argc, char* argv[]) {
+    ReplayConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            exit(0);
+        } else if (arg == "-n" || arg == "--repeat") {
+            if (i + 1 >= argc) {
+                std::cerr << "Count required after " << arg << "\n";
+                exit(1);
+            }
+            config.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-o" || arg == "--output") {
+            config.print_output = true;
+        } else if (arg == "-s" || arg == "--stats") {
+            config.print_stats = true;
+        } else if (config.trace_file.empty()) {
+            config.trace_file = arg;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            exit(1);
+        }
+    }
+
+    if (config.trace_file.empty()) {
+        print_usage(argv[0]);
+        exit(1);
+    }
+    return config;
+}
+
+// FNV-1a over every response line, in order
+class OutputDigest {
+public:
+    void add(std::string_view line) {
+        for (unsigned char c : line) {
+            hash_ = (hash_ ^ c) * 1099511628211ULL;
+        }
+        hash_ = (hash_ ^ '\n') * 1099511628211ULL;
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 14695981039346656037ULL;
+};
+
+struct ReplayResult {
+    uint64_t commands = 0;
+    uint64_t digest = 0;
+};
+
+ReplayResult replay(const std::vector<TraceRecord>& records, uint64_t seed, bool print_output) {
+    RandomGenerator::set_global_seed(seed);
+
+    auto world = std::make_shared<GameWorld>();
+    CommandDispatcher dispatcher(world);
+    std::unordered_map<uint64_t, PlayerId> players;  // Connection id -> player
+    OutputDigest digest;
+    ReplayResult result;
+
+    for (const auto& record : records) {
+        switch (record.type) {
+            case TraceEventType::SEGMENT:
+                // The server was hot rebooted here and reseeded
+                RandomGenerator::set_global_seed(record.seed);
+                break;
+
+            case TraceEventType::CONNECT: {
+                // A hot reboot re-announces live connections; keep the existing player
+                if (players.count(record.connection_id)) {
+                    break;
+                }
+                players[record.connection_id] = world->create_player(record.text, record.character_class, record.room_id);
+                break;
+            }
+
+            case TraceEventType::COMMAND: {
+                auto it = players.find(record.connection_id);
+                if (it == players.end()) {
+                    break;
+                }
+
+                CommandContext ctx;
+                ctx.player = it->second;
+                dispatcher.dispatch(ctx, record.text);
+                result.commands++;
+
+                for (const auto& line : ctx.output) {
+                    digest.add(line);
+                    if (print_output) {
+                        std::cout << "[" << record.connection_id << "] " << line << "\n";
+                    }
+                }
+
+                // Chat reaches other players at the end of the server tick
+                world->get_chat().flush([&](PlayerId recipient, std::string_view line) {
+                    digest.add(line);
+                    if (print_output) {
+                        const Player* player = world->get_player(recipient);
+                        std::cout << "[to " << (player ? player->get_name() : "?") << "] " << line << "\n";
+                    }
+                });
+
+                if (ctx.disconnect) {
+                    world->remove_player(it->second);
+                    players.erase(it);
+                }
+
+                // One command per tick, as far as response buffers go
+                world->publish_snapshot();
+                tick_arena().reset();
+                break;
+            }
+
+            case TraceEventType::DISCONNECT: {
+                auto it = players.find(record.connection_id);
+                if (it != players.end()) {
+                    world->remove_player(it->second);
+                    players.erase(it);
+                }
+                break;
+            }
+        }
+    }
+
+    result.digest = digest.value();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayConfig config = parse_arguments(argc, argv);
+
+    // Player creation logs at INFO, which would dominate the timing
+    Logger::get_instance().set_min_level(LogLevel::WARNING);
+
+    // Load everything up front so file I/O stays out of the measurement
+    CommandTraceReader reader;
+    if (!reader.open(config.trace_file)) {
+        return 1;
+    }
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+
+    std::cout << "Loaded " << records.size() << " records (seed " << reader.get_seed() << ")\n";
+
+    uint64_t first_digest = 0;
+    bool deterministic = true;
+    for (int run = 0; run < config.repeat; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        ReplayResult result = replay(records, reader.get_seed(), config.print_output && run == 0);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 0) {
+            first_digest = result.digest;
+        } else if (result.digest != first_digest) {
+            deterministic = false;
+        }
+
+        std::cout << "Run " << (run + 1) << ": " << result.commands << " commands in "
+                  << std::fixed << std::setprecision(3) << (elapsed * 1000.0) << " ms ("
+                  << std::setprecision(0) << (elapsed > 0 ? result.commands / elapsed : 0.0) << " commands/s)"
+                  << ", output digest " << std::hex << result.digest << std::dec << "\n";
+    }
+
+    if (config.print_stats) {
+        for (const auto& line : MetricsRegistry::get_instance().format_report()) {
+            std::cout << line << "\n";
+        }
+    }
+
+    if (!deterministic) {
+        std::cerr << "Replay output differed between runs\n";
+        return 2;
+    }
+    return 0;
+}